@@ -17,6 +17,11 @@
 #define IDM_EXPORT_PROFILES		109
 #define IDM_IMPORT_PROFILE		110
 #define IDM_EXPORT_SELECTED_PROFILE	111
+#define IDM_LATENCY_TRACING		115
+#define IDM_LATENCY_STATISTICS	116
+#define IDM_LATENCY_DUMP		117
+#define IDM_IMPORT_PROFILE_FOLDER	118
+#define IDM_HEATMAP_MODE		119
 #define IDI_SMARTLOGILED			112
 #define IDI_SMALL				113
 #define IDC_SMARTLOGILED			114
@@ -55,6 +60,15 @@
 #define IDC_BOX_APPACTIONCOLOR 312
 #define IDC_LABEL_APPACTIONCOLOR 313
 #define IDC_CHECK_LOCK_KEYS_VISUALISATION 314
+#define IDC_LABEL_KEY_EFFECT 315
+#define IDC_COMBO_KEY_EFFECT 316
+#define IDC_LABEL_MODIFIER_LAYER 317
+#define IDC_LABEL_SHIFT_LAYER 318
+#define IDC_COMBO_SHIFT_LAYER 319
+#define IDC_LABEL_CTRL_LAYER 320
+#define IDC_COMBO_CTRL_LAYER 321
+#define IDC_LABEL_ALT_LAYER 322
+#define IDC_COMBO_ALT_LAYER 323
 
 // Keys Dialog controls
 #define IDC_EDIT_KEYS 400
@@ -15,6 +15,14 @@
 #include "SmartLogiLED_LockKeys.h"
 #include "SmartLogiLED_AppProfiles.h"
 #include "SmartLogiLED_ProcessMonitor.h"
+#include "SmartLogiLED_ProfileEngine.h"
+#include "SmartLogiLED_LatencyTrace.h"
+#include "SmartLogiLED_KeyboardHook.h"
+#include "SmartLogiLED_Heatmap.h"
+#include "SmartLogiLED_KeyEffects.h"
+#include "SmartLogiLED_ModifierLayer.h"
+#include "SmartLogiLED_PersistenceWorker.h"
+#include "SmartLogiLED_StartupTiming.h"
 #include "SmartLogiLED_KeyMapping.h"
 #include "SmartLogiLED_Version.h"
 #include "SmartLogiLED_Dialogs.h"
@@ -26,6 +34,7 @@
 #include <vector>
 #include <thread>
 #include <chrono>
+#include <future>
 
 #define MAX_LOADSTRING 100
 
@@ -34,7 +43,6 @@
 HINSTANCE hInst;                                // Current instance
 WCHAR szTitle[MAX_LOADSTRING];                  // Title bar text
 WCHAR szWindowClass[MAX_LOADSTRING];            // Main window class name
-HHOOK keyboardHook;                            // Keyboard hook handle
 NOTIFYICONDATA nid;                            // Tray icon data
 
 // Start minimized setting
@@ -86,6 +94,8 @@ void                UpdateButtonState(HWND hWnd, int buttonId, bool enableCondit
 void                UpdateMultipleButtonStates(HWND hWnd);
 void                UpdateAppProfileColorBoxes(HWND hWnd);
 void                UpdateLockKeysCheckbox(HWND hWnd);
+void                UpdateKeyEffectCombo(HWND hWnd);
+void                UpdateModifierLayerCombos(HWND hWnd);
 void                UpdateAllProfileUIElements(HWND hWnd);
 bool                WaitForLogitechGHub();
 void                InitializeLogitechLED(HWND hWnd);
@@ -97,7 +107,8 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
                      _In_ int       nCmdShow)
 {
     UNREFERENCED_PARAMETER(hPrevInstance);
-    UNREFERENCED_PARAMETER(lpCmdLine);
+
+    BeginStartupTiming();
 
     // Single instance check: prevent multiple instances
     HANDLE hMutex = CreateMutexW(nullptr, TRUE, SMARTLOGILED_SINGLE_INSTANCE_MUTEX);
@@ -114,11 +125,17 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
         return 0;
     }
 
-    // Load start minimized setting from registry
+    // Choose registry or file (portable) configuration
+    SelectConfigBackend(lpCmdLine);
+
+    // Keyboard hook, or a key recording to replay (/replay)
+    SelectInputEventSource(lpCmdLine);
+
+    // Load start minimized setting
     startMinimized = LoadStartMinimizedSetting();
 
-    // Load colors from registry
-    LoadLockKeyColorsFromRegistry();
+    // Load colors
+    LoadLockKeyColorsFromConfig();
 
     // Initialize global strings
     LoadStringW(hInstance, IDS_APP_TITLE, szTitle, MAX_LOADSTRING);
@@ -276,12 +293,10 @@ void InitializeLogitechLED(HWND hWnd) {
     
     // Save current lighting state
     LogiLedSaveCurrentLighting();
+    MarkStartupPhase(StartupPhase::LedInitialized);
 
-    // Set all keys to default color
-    SetDefaultColor(defaultColor);
-
-    // Set colors for lock keys based on current state
-    SetLockKeysColor();
+    // Push the displayed profile (or the default colors and lock keys if no profile is displayed)
+    ApplyDisplayedProfileColors();
     
     ledInitializationPending = false;
     gHubWaitingMessageShown = false;
@@ -317,6 +332,8 @@ void UpdateAllProfileUIElements(HWND hWnd) {
     UpdateMultipleButtonStates(hWnd);
     UpdateAppProfileColorBoxes(hWnd);
     UpdateLockKeysCheckbox(hWnd);
+    UpdateKeyEffectCombo(hWnd);
+    UpdateModifierLayerCombos(hWnd);
 }
 
 // Main window procedure (handles messages)
@@ -337,14 +354,14 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                             InvalidateRect(GetDlgItem(hWnd, IDC_BOX_NUMLOCK), nullptr, TRUE);
                             // Set color according to lock state and feature enabled state
                             if (IsLockKeysFeatureEnabled()) {
-                                if ((GetKeyState(VK_NUMLOCK) & 0x0001) == 0x0001)
+                                if (GetInputEventSource().ReadLockKeyStates() & LOCK_KEY_STATE_NUM)
                                     SetKeyColor(LogiLed::KeyName::NUM_LOCK, numLockColor);
                                 else
                                     SetKeyColor(LogiLed::KeyName::NUM_LOCK, defaultColor);
                             } else {
                                 SetKeyColor(LogiLed::KeyName::NUM_LOCK, defaultColor);
                             }
-                            SaveLockKeyColorsToRegistry();
+                            SaveLockKeyColorsToConfig();
                         }
                         break;
                     case IDC_BOX_CAPSLOCK:
@@ -353,14 +370,14 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                             InvalidateRect(GetDlgItem(hWnd, IDC_BOX_CAPSLOCK), nullptr, TRUE);
                             // Set color according to lock state and feature enabled state
                             if (IsLockKeysFeatureEnabled()) {
-                                if ((GetKeyState(VK_CAPITAL) & 0x0001) == 0x0001)
+                                if (GetInputEventSource().ReadLockKeyStates() & LOCK_KEY_STATE_CAPS)
                                     SetKeyColor(LogiLed::KeyName::CAPS_LOCK, capsLockColor);
                                 else
                                     SetKeyColor(LogiLed::KeyName::CAPS_LOCK, defaultColor);
                             } else {
                                 SetKeyColor(LogiLed::KeyName::CAPS_LOCK, defaultColor);
                             }
-                            SaveLockKeyColorsToRegistry();
+                            SaveLockKeyColorsToConfig();
                         }
                         break;
                     case IDC_BOX_SCROLLLOCK:
@@ -369,14 +386,14 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                             InvalidateRect(GetDlgItem(hWnd, IDC_BOX_SCROLLLOCK), nullptr, TRUE);
                             // Set color according to lock state and feature enabled state
                             if (IsLockKeysFeatureEnabled()) {
-                                if ((GetKeyState(VK_SCROLL) & 0x0001) == 0x0001)
+                                if (GetInputEventSource().ReadLockKeyStates() & LOCK_KEY_STATE_SCROLL)
                                     SetKeyColor(LogiLed::KeyName::SCROLL_LOCK, scrollLockColor);
                                 else
                                     SetKeyColor(LogiLed::KeyName::SCROLL_LOCK, defaultColor);
                             } else {
                                 SetKeyColor(LogiLed::KeyName::SCROLL_LOCK, defaultColor);
                             }
-                            SaveLockKeyColorsToRegistry();
+                            SaveLockKeyColorsToConfig();
                         }
                         break;
                     case IDC_BOX_DEFAULTCOLOR:
@@ -387,7 +404,7 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                             SetDefaultColor(defaultColor);
                             // set lock keys color
                             SetLockKeysColor();
-                            SaveLockKeyColorsToRegistry();
+                            SaveLockKeyColorsToConfig();
                         }
                         break;
                     case IDM_ABOUT:
@@ -403,11 +420,26 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                     case IDM_IMPORT_PROFILE:
                         ImportProfileFromIniFile(hWnd);
                         break;
+                    case IDM_IMPORT_PROFILE_FOLDER:
+                        ImportProfilesFromFolder(hWnd);
+                        break;
                     case IDM_EXPORT_SELECTED_PROFILE:
                         ExportSelectedProfileToIniFile(hWnd);
                         break;
                     case IDM_EXPORT_PROFILES:
-                        ExportAllProfilesToIniFiles();
+                        ExportAllProfilesToIniFiles(hWnd);
+                        break;
+                    case IDM_HEATMAP_MODE:
+                        SetHeatmapModeEnabled(hWnd, !IsHeatmapModeEnabled());
+                        break;
+                    case IDM_LATENCY_TRACING:
+                        SetLatencyTracingEnabled(!IsLatencyTracingEnabled());
+                        break;
+                    case IDM_LATENCY_STATISTICS:
+                        ShowLatencyStatistics(hWnd);
+                        break;
+                    case IDM_LATENCY_DUMP:
+                        DumpLatencyTraceWithDialog(hWnd);
                         break;
                     case IDM_EXIT:
                         DestroyWindow(hWnd);
@@ -441,6 +473,8 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                             UpdateMultipleButtonStates(hWnd);
                             UpdateAppProfileColorBoxes(hWnd);
                             UpdateLockKeysCheckbox(hWnd);
+                            UpdateKeyEffectCombo(hWnd);
+                            UpdateModifierLayerCombos(hWnd);
                         }
                         break;
                     case IDC_BOX_APPCOLOR:
@@ -472,8 +506,52 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                                     
                                     // Update the profile
                                     UpdateAppProfileLockKeysEnabled(appName, isChecked);
-                                    UpdateAppProfileLockKeysEnabledInRegistry(appName, isChecked);
+                                    UpdateAppProfileLockKeysEnabledInStore(appName, isChecked);
+                                }
+                            }
+                        }
+                        break;
+                    case IDC_COMBO_KEY_EFFECT:
+                        // Handle key effect selection
+                        if (HIWORD(wParam) == CBN_SELCHANGE) {
+                            HWND hCombo = GetDlgItem(hWnd, IDC_COMBO_APPPROFILE);
+                            int selectedIndex = static_cast<int>(SendMessage(hCombo, CB_GETCURSEL, 0, 0));
+                            int effectIndex = static_cast<int>(SendMessage(GetDlgItem(hWnd, IDC_COMBO_KEY_EFFECT), CB_GETCURSEL, 0, 0));
+                            if (selectedIndex > 0 && effectIndex >= 0 && effectIndex < KEY_EFFECT_COUNT) { // Not "NONE"
+                                WCHAR appName[256]{};
+                                SendMessageW(hCombo, CB_GETLBTEXT, selectedIndex, reinterpret_cast<LPARAM>(appName));
+                                UpdateAppProfileKeyEffect(appName, static_cast<DWORD>(effectIndex));
+                                UpdateAppProfileKeyEffectInStore(appName, static_cast<DWORD>(effectIndex));
+                            }
+                        }
+                        break;
+                    case IDC_COMBO_SHIFT_LAYER:
+                    case IDC_COMBO_CTRL_LAYER:
+                    case IDC_COMBO_ALT_LAYER:
+                        // Handle modifier layer selection (the three combo boxes make up one layer)
+                        if (HIWORD(wParam) == CBN_SELCHANGE) {
+                            HWND hCombo = GetDlgItem(hWnd, IDC_COMBO_APPPROFILE);
+                            int selectedIndex = static_cast<int>(SendMessage(hCombo, CB_GETCURSEL, 0, 0));
+                            if (selectedIndex > 0) { // Not "NONE"
+                                WCHAR appName[256]{};
+                                SendMessageW(hCombo, CB_GETLBTEXT, selectedIndex, reinterpret_cast<LPARAM>(appName));
+                                AppColorProfile profile;
+                                COLORREF modifierColor = GetResolvedAppProfileCopy(appName, profile) ? profile.appModifierColor : AppColorProfile().appModifierColor;
+
+                                DWORD modifierLayer = 0;
+                                const std::pair<int, DWORD> layerCombos[] = {
+                                    { IDC_COMBO_SHIFT_LAYER, MODIFIER_LAYER_SHIFT },
+                                    { IDC_COMBO_CTRL_LAYER, MODIFIER_LAYER_CTRL },
+                                    { IDC_COMBO_ALT_LAYER, MODIFIER_LAYER_ALT }
+                                };
+                                for (const auto& layerCombo : layerCombos) {
+                                    int groups = static_cast<int>(SendMessage(GetDlgItem(hWnd, layerCombo.first), CB_GETCURSEL, 0, 0));
+                                    if (groups > 0) {
+                                        modifierLayer |= static_cast<DWORD>(groups) << layerCombo.second;
+                                    }
                                 }
+                                UpdateAppProfileModifierLayer(appName, modifierLayer, modifierColor);
+                                UpdateAppProfileModifierLayerInStore(appName, modifierLayer, modifierColor);
                             }
                         }
                         break;
@@ -523,9 +601,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                     if (selectedIndex > 0) { // Not "NONE"
                         WCHAR appName[256]{};
                         SendMessageW(hCombo, CB_GETLBTEXT, selectedIndex, reinterpret_cast<LPARAM>(appName));
-                        AppColorProfile* profile = GetAppProfileByName(appName);
-                        if (profile) {
-                            appColor = profile->appColor;
+                        AppColorProfile profile;
+                        if (GetResolvedAppProfileCopy(appName, profile)) {
+                            appColor = profile.appColor;
                         }
                     }
                     
@@ -547,9 +625,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                     if (selectedIndex > 0) { // Not "NONE"
                         WCHAR appName[256]{};
                         SendMessageW(hCombo, CB_GETLBTEXT, selectedIndex, reinterpret_cast<LPARAM>(appName));
-                        AppColorProfile* profile = GetAppProfileByName(appName);
-                        if (profile) {
-                            appHighlightColor = profile->appHighlightColor;
+                        AppColorProfile profile;
+                        if (GetResolvedAppProfileCopy(appName, profile)) {
+                            appHighlightColor = profile.appHighlightColor;
                         }
                     }
                     
@@ -571,9 +649,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                     if (selectedIndex > 0) { // Not "NONE"
                         WCHAR appName[256]{};
                         SendMessageW(hCombo, CB_GETLBTEXT, selectedIndex, reinterpret_cast<LPARAM>(appName));
-                        AppColorProfile* profile = GetAppProfileByName(appName);
-                        if (profile) {
-                            appActionColor = profile->appActionColor;
+                        AppColorProfile profile;
+                        if (GetResolvedAppProfileCopy(appName, profile)) {
+                            appActionColor = profile.appActionColor;
                         }
                     }
                     
@@ -600,9 +678,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                         if (selectedIndex > 0) { // Not "NONE"
                             WCHAR appName[256]{};
                             SendMessageW(hCombo, CB_GETLBTEXT, selectedIndex, reinterpret_cast<LPARAM>(appName));
-                            AppColorProfile* profile = GetAppProfileByName(appName);
-                            if (profile) {
-                                appColor = profile->appColor;
+                            AppColorProfile profile;
+                            if (GetResolvedAppProfileCopy(appName, profile)) {
+                                appColor = profile.appColor;
                             }
                         }
                         
@@ -632,9 +710,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                         if (selectedIndex > 0) { // Not "NONE"
                             WCHAR appName[256]{};
                             SendMessageW(hCombo, CB_GETLBTEXT, selectedIndex, reinterpret_cast<LPARAM>(appName));
-                            AppColorProfile* profile = GetAppProfileByName(appName);
-                            if (profile) {
-                                appHighlightColor = profile->appHighlightColor;
+                            AppColorProfile profile;
+                            if (GetResolvedAppProfileCopy(appName, profile)) {
+                                appHighlightColor = profile.appHighlightColor;
                             }
                         }
                         
@@ -664,9 +742,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                         if (selectedIndex > 0) { // Not "NONE"
                             WCHAR appName[256]{};
                             SendMessageW(hCombo, CB_GETLBTEXT, selectedIndex, reinterpret_cast<LPARAM>(appName));
-                            AppColorProfile* profile = GetAppProfileByName(appName);
-                            if (profile) {
-                                appActionColor = profile->appActionColor;
+                            AppColorProfile profile;
+                            if (GetResolvedAppProfileCopy(appName, profile)) {
+                                appActionColor = profile.appActionColor;
                             }
                         }
                         
@@ -712,10 +790,20 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                 KillTimer(hWnd, gHubDelayTimer);
                 gHubDelayTimer = 0;
             }
+            KillTimer(hWnd, LOCK_KEY_RECONCILE_TIMER_ID);
             
             RemoveTrayIcon();
             CleanupAppMonitoring(); // Cleanup app monitoring before other cleanup
+            WaitForProfileExport(); // Stop writing INI files before the profiles go away
+            StopProfileEngine(); // Process remaining profile events
+            SaveAppProfilesToStore(); // Sync profiles changed in memory (unchanged profiles are skipped)
+            StopPersistenceWorker(); // Write pending profile edits and the activation history
+            ShutdownHeatmap(); // Save the heat values (the mode stays on for the next start)
+            ShutdownKeyEffects();
+            ShutdownModifierLayer();
+            ShutdownKeyboardLayouts();
             DisableKeyboardHook(); // Use managed hook cleanup
+            StopKeyboardHookWorker(); // After the hook is gone
             LogiLedRestoreLighting();
             LogiLedShutdown();
             PostQuitMessage(0);
@@ -752,33 +840,36 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             break;
         case WM_LOCK_KEY_PRESSED: // Custom message for lock key pressed
             {
-                DWORD vkCode = static_cast<DWORD>(wParam);
-                DWORD vkState = static_cast<DWORD>(lParam); // Get the new key state from lParam
-                HandleLockKeyPressed(vkCode, vkState);
+                DWORD vkCode = static_cast<DWORD>(wParam); // lParam carries the new state, already in the tracked states
+                HandleLockKeyPressed(vkCode);
             }
             break;
         case WM_UPDATE_PROFILE_COMBO: // Custom message to update profile combo box
             // Use generic function to update all UI elements at once
             UpdateAllProfileUIElements(hWnd);
             break;
-        case WM_APP_STARTED: // Custom message for app started
+        case WM_APPLY_PROFILE_FRAME: // Custom message from the profile engine - push the displayed profile's colors
+            ApplyPendingProfileColors();
+            break;
+        case WM_MODIFIER_LAYER_CHANGED: // Custom message from the hook worker - a layer modifier went down or up
+            OnModifierLayerChanged();
+            break;
+        case WM_INPUTLANGCHANGE: // Our input language changed - switch the key translation table
+            UpdateKeyboardLayout();
+            return DefWindowProc(hWnd, message, wParam, lParam);
+        case WM_PROFILE_EXPORT_PROGRESS: // Background export progress - shown in the title bar
             {
-                // Get app name from message parameter (allocated on heap by thread)
-                std::wstring* appName = reinterpret_cast<std::wstring*>(lParam);
-                if (appName) {
-                    HandleAppStarted(*appName);
-                    delete appName; // Clean up heap allocated string
-                }
+                std::wstring title = std::wstring(szTitle) + L" - Exporting profiles " +
+                    std::to_wstring(lParam > 0 ? static_cast<size_t>(wParam) * 100 / static_cast<size_t>(lParam) : 100) + L"%";
+                SetWindowTextW(hWnd, title.c_str());
             }
             break;
-        case WM_APP_STOPPED: // Custom message for app stopped
+        case WM_PROFILE_EXPORT_DONE: // Background export finished - show its report
             {
-                // Get app name from message parameter (allocated on heap by thread)
-                std::wstring* appName = reinterpret_cast<std::wstring*>(lParam);
-                if (appName) {
-                    HandleAppStopped(*appName);
-                    delete appName; // Clean up heap allocated string
-                }
+                std::wstring* report = reinterpret_cast<std::wstring*>(lParam);
+                SetWindowTextW(hWnd, szTitle);
+                MessageBoxW(hWnd, report->c_str(), L"Export Profiles", MB_OK | (wParam ? MB_ICONWARNING : MB_ICONINFORMATION));
+                delete report;
             }
             break;
         case WM_INITMENUPOPUP:
@@ -789,6 +880,10 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                     // Check/uncheck the "Start minimized" menu item
                     CheckMenuItem(hMenu, IDM_START_MINIMIZED, 
                         MF_BYCOMMAND | (startMinimized ? MF_CHECKED : MF_UNCHECKED));
+                    CheckMenuItem(hMenu, IDM_HEATMAP_MODE,
+                        MF_BYCOMMAND | (IsHeatmapModeEnabled() ? MF_CHECKED : MF_UNCHECKED));
+                    CheckMenuItem(hMenu, IDM_LATENCY_TRACING,
+                        MF_BYCOMMAND | (IsLatencyTracingEnabled() ? MF_CHECKED : MF_UNCHECKED));
                 }
             }
             break;
@@ -803,6 +898,21 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                 else if (wParam == 1002 && gHubDelayPending) { // G HUB delay timer
                     InitializeLogitechLED(hWnd); // This will complete the LED initialization
                 }
+                else if (wParam == LOCK_KEY_RECONCILE_TIMER_ID) { // Lock key state check
+                    ReconcileLockKeyStates();
+                }
+                else if (wParam == HEATMAP_FRAME_TIMER_ID) { // Typing heatmap frame
+                    OnHeatmapFrameTimer();
+                }
+                else if (wParam == KEY_EFFECT_FRAME_TIMER_ID) { // Reactive key effects frame
+                    OnKeyEffectFrameTimer();
+                }
+                else if (wParam == MODIFIER_LAYER_RECONCILE_TIMER_ID) { // Held modifier key check
+                    ReconcileModifierKeys();
+                }
+                else if (wParam == KEY_LAYOUT_CHECK_TIMER_ID) { // Foreground keyboard layout check
+                    UpdateKeyboardLayout();
+                }
             }
             break;
         default:
@@ -815,12 +925,28 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 BOOL InitInstance(HINSTANCE hInstance, int nCmdShow)
 {
    hInst = hInstance;
+
+   // Cold start: the process snapshot does not depend on the profiles, so it runs in parallel with
+   // window creation, the G HUB check and the profile load (running flags are resolved after both)
+   std::future<RunningProcessScan> runningProcessScan = std::async(std::launch::async, [] {
+       RunningProcessScan scan = ScanRunningProcesses();
+       MarkStartupPhase(StartupPhase::ProcessesScanned);
+       return scan;
+   });
+
    // Fixed window size - increased height to accommodate new App Profile section
    HWND hWnd = CreateWindowW(szWindowClass, szTitle,
       WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_MINIMIZEBOX,
-      CW_USEDEFAULT, 0, 440, 460, nullptr, nullptr, hInstance, nullptr);
+      CW_USEDEFAULT, 0, 440, 540, nullptr, nullptr, hInstance, nullptr);
    if (!hWnd) return FALSE;
 
+   // Key translation tables for every installed keyboard layout (before anything maps hook keys)
+   InitializeKeyboardLayouts(hWnd);
+
+   // Key effects run their frame timer on the main window (the first profile apply may start them)
+   InitializeKeyEffects(hWnd);
+   InitializeModifierLayer(hWnd);
+
    // Group Box for lock keys
    CreateWindowW(L"BUTTON", L"Lock Keys Color", WS_VISIBLE | WS_CHILD | BS_GROUPBOX,
       20, 10, 300, 140, hWnd, reinterpret_cast<HMENU>(IDC_GROUP_LOCKS), hInstance, nullptr);
@@ -838,7 +964,7 @@ BOOL InitInstance(HINSTANCE hInstance, int nCmdShow)
    CreateWindowW(L"STATIC", L"Default Color", WS_VISIBLE | WS_CHILD | SS_CENTER, 340, 95, 60, 40, hWnd, reinterpret_cast<HMENU>(IDC_LABEL_DEFAULTCOLOR), hInstance, nullptr);
 
    // Group Box for App Profiles
-   CreateWindowW(L"BUTTON", L"App Profile", WS_VISIBLE | WS_CHILD | BS_GROUPBOX, 20, 160, 380, 220, hWnd, reinterpret_cast<HMENU>(IDC_GROUP_APPPROFILE), hInstance, nullptr);
+   CreateWindowW(L"BUTTON", L"App Profile", WS_VISIBLE | WS_CHILD | BS_GROUPBOX, 20, 160, 380, 300, hWnd, reinterpret_cast<HMENU>(IDC_GROUP_APPPROFILE), hInstance, nullptr);
    // Current Profile Label
    CreateWindowW(L"STATIC", L"Profile in use: NONE", WS_VISIBLE | WS_CHILD, 40, 190, 210, 15, hWnd, reinterpret_cast<HMENU>(IDC_LABEL_CURRENT_PROFILE), hInstance, nullptr);
    // Combo Box for App Profiles
@@ -867,6 +993,28 @@ BOOL InitInstance(HINSTANCE hInstance, int nCmdShow)
    // Lock Keys Visualisation Checkbox
    CreateWindowW(L"BUTTON", L"Lock Keys", WS_VISIBLE | WS_CHILD | BS_AUTOCHECKBOX, 260, 190, 100, 20, hWnd, reinterpret_cast<HMENU>(IDC_CHECK_LOCK_KEYS_VISUALISATION), hInstance, nullptr);
 
+   // Key Effect Label and Combo Box
+   CreateWindowW(L"STATIC", L"Key Effect", WS_VISIBLE | WS_CHILD, 40, 370, 90, 20, hWnd, reinterpret_cast<HMENU>(IDC_LABEL_KEY_EFFECT), hInstance, nullptr);
+   HWND hEffectCombo = CreateWindowW(L"COMBOBOX", nullptr, WS_VISIBLE | WS_CHILD | CBS_DROPDOWNLIST, 140, 366, 100, 100, hWnd, reinterpret_cast<HMENU>(IDC_COMBO_KEY_EFFECT), hInstance, nullptr);
+   for (LPCWSTR effectName : { L"None", L"Fade", L"Ripple" }) { // Index = KEY_EFFECT_*
+       SendMessageW(hEffectCombo, CB_ADDSTRING, 0, reinterpret_cast<LPARAM>(effectName));
+   }
+
+   // Modifier layer: key groups lit while each modifier is held
+   CreateWindowW(L"STATIC", L"Modifier Layer (lit while held)", WS_VISIBLE | WS_CHILD, 40, 400, 200, 20, hWnd, reinterpret_cast<HMENU>(IDC_LABEL_MODIFIER_LAYER), hInstance, nullptr);
+   const struct { LPCWSTR label; int labelId; int comboId; int x; } layerControls[] = {
+       { L"Shift", IDC_LABEL_SHIFT_LAYER, IDC_COMBO_SHIFT_LAYER, 40 },
+       { L"Ctrl", IDC_LABEL_CTRL_LAYER, IDC_COMBO_CTRL_LAYER, 160 },
+       { L"Alt", IDC_LABEL_ALT_LAYER, IDC_COMBO_ALT_LAYER, 280 }
+   };
+   for (const auto& layerControl : layerControls) {
+       CreateWindowW(L"STATIC", layerControl.label, WS_VISIBLE | WS_CHILD, layerControl.x, 429, 30, 20, hWnd, reinterpret_cast<HMENU>(static_cast<INT_PTR>(layerControl.labelId)), hInstance, nullptr);
+       HWND hLayerCombo = CreateWindowW(L"COMBOBOX", nullptr, WS_VISIBLE | WS_CHILD | CBS_DROPDOWNLIST, layerControl.x + 32, 425, 80, 100, hWnd, reinterpret_cast<HMENU>(static_cast<INT_PTR>(layerControl.comboId)), hInstance, nullptr);
+       for (LPCWSTR groupName : { L"None", L"Highlight", L"Action", L"Both" }) { // Index = MODIFIER_LAYER_* key groups
+           SendMessageW(hLayerCombo, CB_ADDSTRING, 0, reinterpret_cast<LPARAM>(groupName));
+       }
+   }
+
    // Show window according to start minimized setting
    if (startMinimized) {
        ShowWindow(hWnd, SW_HIDE);
@@ -882,14 +1030,26 @@ BOOL InitInstance(HINSTANCE hInstance, int nCmdShow)
    // Set main window handle for UI updates
    SetMainWindowHandle(hWnd);
    
-   // Load app profiles from registry (includes highlight color and keys)
-   LoadAppProfilesFromRegistry();
+   // Load app profiles from the profile store (running state is not touched here)
+   LoadAppProfilesFromStore();
+   MarkStartupPhase(StartupPhase::ProfilesLoaded);
+   
+   // Restore the activation history so fallback order matches the previous session
+   LoadActivationHistoryFromConfig();
 
    // Populate the combo box with app profiles
    PopulateAppProfileCombo(hCombo);
    
-   // Check for already running apps and update colors
-   CheckRunningAppsAndUpdateColors();
+   // Start the profile engine (all profile changes and activation decisions run on its thread)
+   StartProfileEngine(hWnd);
+   
+   // Start the write-behind worker (profile edits are written to disk in the background)
+   StartPersistenceWorker();
+   
+   // Resolve the running flags of all profiles in bulk from the one process snapshot
+   RunningProcessScan runningProcesses = runningProcessScan.get();
+   CheckRunningAppsAndUpdateColors(runningProcesses.visibleProcesses);
+   MarkStartupPhase(StartupPhase::RunningAppsResolved);
    
    // Update the combo box to reflect any displayed profiles after checking running apps
    UpdateActiveProfileSelection(hWnd);
@@ -905,12 +1065,25 @@ BOOL InitInstance(HINSTANCE hInstance, int nCmdShow)
    
    // Update lock keys checkbox
    UpdateLockKeysCheckbox(hWnd);
+   UpdateKeyEffectCombo(hWnd);
+   UpdateModifierLayerCombos(hWnd);
 
-   // Initialize app monitoring
-   InitializeAppMonitoring(hWnd);
+   // Initialize app monitoring (apps from the startup snapshot are not reported as newly started)
+   InitializeAppMonitoring(hWnd, runningProcesses.visibleProcesses);
+
+   // Start the hook worker (the keyboard hook only records key events; the worker handles them)
+   StartKeyboardHookWorker();
 
    // Initialize keyboard hook based on lock keys feature status
    UpdateKeyboardHookStateUnsafe();
+
+   // Periodically check the tracked lock key states against the OS
+   SetTimer(hWnd, LOCK_KEY_RECONCILE_TIMER_ID, LOCK_KEY_RECONCILE_INTERVAL_MS, nullptr);
+
+   // Typing heatmap (paints the keyboard instead of the profile colors while on)
+   if (LoadHeatmapModeSetting()) {
+       SetHeatmapModeEnabled(hWnd, true);
+   }
    
    return TRUE;
 }
@@ -923,19 +1096,25 @@ void PopulateAppProfileCombo(HWND hCombo) {
     // Add "NONE" as the first item
     SendMessageW(hCombo, CB_ADDSTRING, 0, reinterpret_cast<LPARAM>(L"NONE"));
     
-    // Get current profiles
-    std::vector<AppColorProfile> profiles = GetAppColorProfilesCopy();
+    // Get the names of all stored profiles (profiles are not loaded just to list them)
+    std::vector<std::wstring> profileNames = GetAppProfileNames();
+    std::wstring displayedProfileName = GetDisplayedProfileName();
     
     int displayedProfileIndex = 0; // Default to "NONE" (index 0)
     
+    // Reserve list storage up front for large profile libraries
+    size_t totalChars = 0;
+    for (const auto& name : profileNames) {
+        totalChars += name.size() + 1;
+    }
+    SendMessageW(hCombo, CB_INITSTORAGE, profileNames.size() + 1, (totalChars + 5) * sizeof(WCHAR));
+    
     // Add each profile to the combo box
-    for (size_t i = 0; i < profiles.size(); i++) {
-        const auto& profile = profiles[i];
-        SendMessageW(hCombo, CB_ADDSTRING, 0, reinterpret_cast<LPARAM>(profile.appName.c_str()));
+    for (size_t i = 0; i < profileNames.size(); i++) {
+        SendMessageW(hCombo, CB_ADDSTRING, 0, reinterpret_cast<LPARAM>(profileNames[i].c_str()));
         
         // Check if this profile is currently displayed (controlling colors)
-        // Use the FIRST displayed profile found (should only be one now)
-        if (profile.isProfileCurrInUse && displayedProfileIndex == 0) {
+        if (displayedProfileIndex == 0 && !displayedProfileName.empty() && profileNames[i] == displayedProfileName) {
             displayedProfileIndex = static_cast<int>(i) + 1; // +1 because of "NONE" at index 0
         }
     }
@@ -964,7 +1143,7 @@ void RemoveSelectedProfile(HWND hWnd) {
     if (MessageBoxW(hWnd, message.c_str(), L"Confirm Removal", MB_YESNO) == IDYES) {
         // Remove the profile from memory and registry
         RemoveAppColorProfile(appName);
-        RemoveAppProfileFromRegistry(appName);
+        RemoveAppProfileFromStore(appName);
         
         // Refresh the combo box
         RefreshAppProfileCombo(hWnd);
@@ -976,13 +1155,12 @@ void UpdateActiveProfileSelection(HWND hWnd) {
     HWND hCombo = GetDlgItem(hWnd, IDC_COMBO_APPPROFILE);
     if (!hCombo) return;
     
-    std::vector<AppColorProfile> profiles = GetAppColorProfilesCopy();
-    
     // Find the currently displayed profile (the one controlling colors)
-    for (size_t i = 0; i < profiles.size(); i++) {
-        if (profiles[i].isProfileCurrInUse) {
-            // Select the displayed profile (index + 1 because of "NONE" at index 0)
-            SendMessage(hCombo, CB_SETCURSEL, static_cast<int>(i) + 1, 0);
+    std::wstring displayedProfileName = GetDisplayedProfileName();
+    if (!displayedProfileName.empty()) {
+        LRESULT index = SendMessageW(hCombo, CB_FINDSTRINGEXACT, 0, reinterpret_cast<LPARAM>(displayedProfileName.c_str()));
+        if (index != CB_ERR && index > 0) {
+            SendMessage(hCombo, CB_SETCURSEL, index, 0);
             return;
         }
     }
@@ -996,15 +1174,12 @@ void UpdateCurrentProfileLabel(HWND hWnd) {
     HWND hLabel = GetDlgItem(hWnd, IDC_LABEL_CURRENT_PROFILE);
     if (!hLabel) return;
     
-    std::vector<AppColorProfile> profiles = GetAppColorProfilesCopy();
-    
     // Find the currently displayed profile (the one controlling colors)
-    for (const auto& profile : profiles) {
-        if (profile.isProfileCurrInUse) {
-            std::wstring labelText = L"Profile in use: " + profile.appName;
-            SetWindowTextW(hLabel, labelText.c_str());
-            return;
-        }
+    std::wstring displayedProfileName = GetDisplayedProfileName();
+    if (!displayedProfileName.empty()) {
+        std::wstring labelText = L"Profile in use: " + displayedProfileName;
+        SetWindowTextW(hLabel, labelText.c_str());
+        return;
     }
     
     // If no profile is displayed, show "NONE"
@@ -1050,12 +1225,64 @@ void UpdateLockKeysCheckbox(HWND hWnd) {
         
         WCHAR appName[256]{};
         SendMessageW(hCombo, CB_GETLBTEXT, selectedIndex, reinterpret_cast<LPARAM>(appName));
-        AppColorProfile* profile = GetAppProfileByName(appName);
+        AppColorProfile profile;
         
-        if (profile) {
-            SendMessage(hCheckbox, BM_SETCHECK, profile->lockKeysEnabled ? BST_CHECKED : BST_UNCHECKED, 0);
+        if (GetResolvedAppProfileCopy(appName, profile)) {
+            SendMessage(hCheckbox, BM_SETCHECK, profile.lockKeysEnabled ? BST_CHECKED : BST_UNCHECKED, 0);
         } else {
             SendMessage(hCheckbox, BM_SETCHECK, BST_CHECKED, 0); // Default to checked
         }
     }
+}
+
+// Update the key effect combo box based on current profile selection
+void UpdateKeyEffectCombo(HWND hWnd) {
+    HWND hCombo = GetDlgItem(hWnd, IDC_COMBO_APPPROFILE);
+    HWND hEffectCombo = GetDlgItem(hWnd, IDC_COMBO_KEY_EFFECT);
+    
+    if (!hCombo || !hEffectCombo) return;
+    
+    int selectedIndex = static_cast<int>(SendMessage(hCombo, CB_GETCURSEL, 0, 0));
+    if (selectedIndex == CB_ERR || selectedIndex == 0) {
+        // "NONE" selected - disable the combo box
+        EnableWindow(hEffectCombo, FALSE);
+        SendMessage(hEffectCombo, CB_SETCURSEL, KEY_EFFECT_NONE, 0);
+        return;
+    }
+    
+    EnableWindow(hEffectCombo, TRUE);
+    WCHAR appName[256]{};
+    SendMessageW(hCombo, CB_GETLBTEXT, selectedIndex, reinterpret_cast<LPARAM>(appName));
+    AppColorProfile profile;
+    SendMessage(hEffectCombo, CB_SETCURSEL, GetResolvedAppProfileCopy(appName, profile) ? profile.keyEffect : KEY_EFFECT_NONE, 0);
+}
+
+// Update the modifier layer combo boxes based on current profile selection
+void UpdateModifierLayerCombos(HWND hWnd) {
+    HWND hCombo = GetDlgItem(hWnd, IDC_COMBO_APPPROFILE);
+    if (!hCombo) return;
+    
+    DWORD modifierLayer = 0;
+    int selectedIndex = static_cast<int>(SendMessage(hCombo, CB_GETCURSEL, 0, 0));
+    bool profileSelected = selectedIndex != CB_ERR && selectedIndex != 0; // "NONE" disables the combo boxes
+    if (profileSelected) {
+        WCHAR appName[256]{};
+        SendMessageW(hCombo, CB_GETLBTEXT, selectedIndex, reinterpret_cast<LPARAM>(appName));
+        AppColorProfile profile;
+        if (GetResolvedAppProfileCopy(appName, profile)) {
+            modifierLayer = profile.modifierLayer;
+        }
+    }
+    
+    const std::pair<int, DWORD> layerCombos[] = {
+        { IDC_COMBO_SHIFT_LAYER, MODIFIER_LAYER_SHIFT },
+        { IDC_COMBO_CTRL_LAYER, MODIFIER_LAYER_CTRL },
+        { IDC_COMBO_ALT_LAYER, MODIFIER_LAYER_ALT }
+    };
+    for (const auto& layerCombo : layerCombos) {
+        HWND hLayerCombo = GetDlgItem(hWnd, layerCombo.first);
+        if (!hLayerCombo) continue;
+        EnableWindow(hLayerCombo, profileSelected ? TRUE : FALSE);
+        SendMessage(hLayerCombo, CB_SETCURSEL, MODIFIER_LAYER_GROUPS(modifierLayer, layerCombo.second), 0);
+    }
 }
\ No newline at end of file
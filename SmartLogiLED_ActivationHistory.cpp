@@ -0,0 +1,270 @@
+// SmartLogiLED_ActivationHistory.cpp : Contains the profile activation history (LRU).
+//
+// The history decides which running profile takes over when the displayed one stops.
+// It is snapshotted to the registry so the same profile wins right after a restart.
+
+#include "framework.h"
+#include "SmartLogiLED_ActivationHistory.h"
+#include "SmartLogiLED_Constants.h"
+#include <algorithm>
+#include <cstring>
+#include <cwctype>
+#include <unordered_map>
+#include <sstream>
+
+// Sentinel for "no node"
+static const DWORD HISTORY_NO_NODE = 0xFFFFFFFF;
+
+// Intrusive list node for one interned profile name
+struct ActivationHistoryNode {
+    std::wstring name;              // Profile name as last activated
+    DWORD prev = HISTORY_NO_NODE;   // Newer entry
+    DWORD next = HISTORY_NO_NODE;   // Older entry
+    bool linked = false;            // Currently part of the history
+};
+
+// Module-specific variables
+static std::vector<ActivationHistoryNode> historyNodes;        // Indexed by interned profile ID
+static std::unordered_map<std::wstring, DWORD> internedIds;    // lower-case name -> profile ID
+static DWORD historyHead = HISTORY_NO_NODE;                    // Most recently activated
+static DWORD historyTail = HISTORY_NO_NODE;                    // Least recently activated
+static size_t historyCount = 0;
+static size_t historyDepth = DEFAULT_ACTIVATION_HISTORY_DEPTH;
+static bool historyDirty = false;
+
+// Helper function for case-insensitive history keys
+static std::wstring ToHistoryKey(const std::wstring& name) {
+    std::wstring key = name;
+    std::transform(key.begin(), key.end(), key.begin(), ::towlower);
+    return key;
+}
+
+// Get the ID of a profile name, interning it if needed (INTERNAL - NO LOCK)
+static DWORD InternProfileNameInternal(const std::wstring& profileName) {
+    auto result = internedIds.emplace(ToHistoryKey(profileName), static_cast<DWORD>(historyNodes.size()));
+    if (result.second) {
+        historyNodes.emplace_back();
+    }
+    historyNodes[result.first->second].name = profileName;
+    return result.first->second;
+}
+
+// Get the ID of a profile name without interning it (INTERNAL - NO LOCK)
+static DWORD FindProfileIdInternal(const std::wstring& profileName) {
+    auto it = internedIds.find(ToHistoryKey(profileName));
+    return (it != internedIds.end()) ? it->second : HISTORY_NO_NODE;
+}
+
+// Unlink a node from the list (INTERNAL - NO LOCK)
+static void UnlinkNodeInternal(DWORD id) {
+    ActivationHistoryNode& node = historyNodes[id];
+    if (node.prev != HISTORY_NO_NODE) {
+        historyNodes[node.prev].next = node.next;
+    } else {
+        historyHead = node.next;
+    }
+    if (node.next != HISTORY_NO_NODE) {
+        historyNodes[node.next].prev = node.prev;
+    } else {
+        historyTail = node.prev;
+    }
+    node.prev = node.next = HISTORY_NO_NODE;
+    node.linked = false;
+    --historyCount;
+}
+
+// Link a node at the front of the list (INTERNAL - NO LOCK)
+static void PushFrontInternal(DWORD id) {
+    ActivationHistoryNode& node = historyNodes[id];
+    node.prev = HISTORY_NO_NODE;
+    node.next = historyHead;
+    if (historyHead != HISTORY_NO_NODE) {
+        historyNodes[historyHead].prev = id;
+    } else {
+        historyTail = id;
+    }
+    historyHead = id;
+    node.linked = true;
+    ++historyCount;
+}
+
+// Drop the oldest entries beyond the configured depth (INTERNAL - NO LOCK)
+static void TrimToDepthInternal() {
+    while (historyCount > historyDepth && historyTail != HISTORY_NO_NODE) {
+        UnlinkNodeInternal(historyTail);
+        historyDirty = true;
+    }
+}
+
+// Move a profile to the front of the history (INTERNAL - NO LOCK)
+bool TouchActivationHistoryInternal(const std::wstring& profileName) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    DWORD id = InternProfileNameInternal(profileName);
+    if (historyHead == id) {
+        return false; // Already the most recent profile
+    }
+
+    if (historyNodes[id].linked) {
+        UnlinkNodeInternal(id);
+    }
+    PushFrontInternal(id);
+    TrimToDepthInternal();
+    historyDirty = true;
+
+#ifdef ENABLE_DEBUG_LOGGING
+    std::wstringstream debugMsg;
+    debugMsg << L"[DEBUG] Activation history updated. Current order: ";
+    for (DWORD node = historyHead; node != HISTORY_NO_NODE; node = historyNodes[node].next) {
+        debugMsg << historyNodes[node].name << L" -> ";
+    }
+    debugMsg << L"END\n";
+    OutputDebugStringW(debugMsg.str().c_str());
+#endif
+    return true;
+}
+
+// Remove a profile from the history (INTERNAL - NO LOCK)
+bool RemoveActivationHistoryEntryInternal(const std::wstring& profileName) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    DWORD id = FindProfileIdInternal(profileName);
+    if (id == HISTORY_NO_NODE || !historyNodes[id].linked) {
+        return false;
+    }
+    UnlinkNodeInternal(id);
+    historyDirty = true;
+    return true;
+}
+
+// Remove every history entry matching a predicate (INTERNAL - NO LOCK)
+void RemoveActivationHistoryEntriesInternal(const std::function<bool(const std::wstring&)>& shouldRemove) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    DWORD node = historyHead;
+    while (node != HISTORY_NO_NODE) {
+        DWORD next = historyNodes[node].next;
+        if (shouldRemove(historyNodes[node].name)) {
+#ifdef ENABLE_DEBUG_LOGGING
+            std::wstringstream debugMsg;
+            debugMsg << L"[DEBUG] Removing profile from activation history: " << historyNodes[node].name << L"\n";
+            OutputDebugStringW(debugMsg.str().c_str());
+#endif
+            UnlinkNodeInternal(node);
+            historyDirty = true;
+        }
+        node = next;
+    }
+}
+
+// Find the most recent history entry matching a predicate (INTERNAL - NO LOCK)
+const std::wstring* FindInActivationHistoryInternal(const std::function<bool(const std::wstring&)>& match) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    for (DWORD node = historyHead; node != HISTORY_NO_NODE; node = historyNodes[node].next) {
+        if (match(historyNodes[node].name)) {
+            return &historyNodes[node].name;
+        }
+    }
+    return nullptr;
+}
+
+// Get the history as a list of names, most recent first (INTERNAL - NO LOCK)
+std::vector<std::wstring> GetActivationHistoryNamesInternal() {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    std::vector<std::wstring> names;
+    names.reserve(historyCount);
+    for (DWORD node = historyHead; node != HISTORY_NO_NODE; node = historyNodes[node].next) {
+        names.push_back(historyNodes[node].name);
+    }
+    return names;
+}
+
+// Set how many profiles the history remembers (INTERNAL - NO LOCK)
+void SetActivationHistoryDepthInternal(size_t depth) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    historyDepth = (std::min)((std::max)(depth, static_cast<size_t>(1)), static_cast<size_t>(MAX_ACTIVATION_HISTORY_DEPTH));
+    TrimToDepthInternal();
+}
+
+// Get how many profiles the history remembers (INTERNAL - NO LOCK)
+size_t GetActivationHistoryDepthInternal() {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+    return historyDepth;
+}
+
+// Check whether the history changed since the last snapshot (INTERNAL - NO LOCK)
+bool IsActivationHistoryDirtyInternal() {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+    return historyDirty;
+}
+
+// Snapshot format: DWORD version, DWORD count, then count null-terminated UTF-16 names (most recent first)
+std::vector<BYTE> SerializeActivationHistoryInternal() {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    std::vector<wchar_t> names;
+    for (DWORD node = historyHead; node != HISTORY_NO_NODE; node = historyNodes[node].next) {
+        const std::wstring& name = historyNodes[node].name;
+        names.insert(names.end(), name.begin(), name.end());
+        names.push_back(L'\0');
+    }
+
+    DWORD header[2] = { ACTIVATION_HISTORY_SNAPSHOT_VERSION, static_cast<DWORD>(historyCount) };
+    std::vector<BYTE> data(sizeof(header) + names.size() * sizeof(wchar_t));
+    memcpy(data.data(), header, sizeof(header));
+    if (!names.empty()) {
+        memcpy(data.data() + sizeof(header), names.data(), names.size() * sizeof(wchar_t));
+    }
+
+    historyDirty = false;
+    return data;
+}
+
+// Restore the history from a snapshot (INTERNAL - NO LOCK)
+bool RestoreActivationHistoryInternal(const BYTE* data, size_t size) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    DWORD header[2] = {};
+    if (!data || size < sizeof(header)) {
+        return false;
+    }
+    memcpy(header, data, sizeof(header));
+    if (header[0] != ACTIVATION_HISTORY_SNAPSHOT_VERSION) {
+        return false; // Unknown snapshot - keep the empty history
+    }
+
+    const wchar_t* text = reinterpret_cast<const wchar_t*>(data + sizeof(header));
+    size_t textLength = (size - sizeof(header)) / sizeof(wchar_t);
+
+    // Names are stored most recent first; append each one at the back of the list
+    std::vector<std::wstring> names;
+    size_t start = 0;
+    for (size_t i = 0; i < textLength && names.size() < header[1]; ++i) {
+        if (text[i] == L'\0') {
+            if (i > start) {
+                names.emplace_back(text + start, i - start);
+            }
+            start = i + 1;
+        }
+    }
+
+    for (auto it = names.rbegin(); it != names.rend(); ++it) {
+        DWORD id = InternProfileNameInternal(*it);
+        if (historyNodes[id].linked) {
+            UnlinkNodeInternal(id);
+        }
+        PushFrontInternal(id);
+    }
+    TrimToDepthInternal();
+    historyDirty = false;
+
+#ifdef ENABLE_DEBUG_LOGGING
+    std::wstringstream debugMsg;
+    debugMsg << L"[DEBUG] Activation history restored: " << historyCount << L" profiles\n";
+    OutputDebugStringW(debugMsg.str().c_str());
+#endif
+    return true;
+}
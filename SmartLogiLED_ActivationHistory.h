@@ -0,0 +1,26 @@
+// SmartLogiLED_ActivationHistory.h : Header file for the profile activation history (LRU).
+//
+
+#pragma once
+
+#include "framework.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+// Activation history (most recently activated profile first)
+// Profile names are interned to small IDs; the history is an intrusive doubly linked list
+// over those IDs, so touching or removing a profile is O(1).
+// All functions here assume the appProfilesMutex is already locked by the caller.
+bool TouchActivationHistoryInternal(const std::wstring& profileName);          // Returns true if the order changed
+bool RemoveActivationHistoryEntryInternal(const std::wstring& profileName);    // Returns true if the profile was listed
+void RemoveActivationHistoryEntriesInternal(const std::function<bool(const std::wstring&)>& shouldRemove);
+const std::wstring* FindInActivationHistoryInternal(const std::function<bool(const std::wstring&)>& match);
+std::vector<std::wstring> GetActivationHistoryNamesInternal();
+
+// History depth and persistence
+void SetActivationHistoryDepthInternal(size_t depth);
+size_t GetActivationHistoryDepthInternal();
+bool IsActivationHistoryDirtyInternal();
+std::vector<BYTE> SerializeActivationHistoryInternal(); // Clears the dirty flag
+bool RestoreActivationHistoryInternal(const BYTE* data, size_t size);
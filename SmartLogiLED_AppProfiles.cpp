@@ -6,6 +6,16 @@
 #include "SmartLogiLED_AppProfiles.h"
 #include "SmartLogiLED_LockKeys.h"
 #include "SmartLogiLED_ProcessMonitor.h" // Include the new module
+#include "SmartLogiLED_ProfileInheritance.h"
+#include "SmartLogiLED_ProfileCatalog.h"
+#include "SmartLogiLED_ActivationHistory.h"
+#include "SmartLogiLED_ProfileEngine.h"
+#include "SmartLogiLED_Config.h"
+#include "SmartLogiLED_PersistenceWorker.h"
+#include "SmartLogiLED_StartupTiming.h"
+#include "SmartLogiLED_Heatmap.h"
+#include "SmartLogiLED_KeyEffects.h"
+#include "SmartLogiLED_ModifierLayer.h"
 #include "SmartLogiLED_Constants.h"
 #include "LogitechLEDLib.h"
 #include "Resource.h"
@@ -14,17 +24,21 @@
 #include <mutex>
 #include <chrono>
 #include <sstream>
-#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
 
 // External variables from main file
 extern COLORREF defaultColor;
 
 // App monitoring variables
-std::vector<AppColorProfile> appColorProfiles;
+// Only materialized profiles live here; every stored profile is listed in the profile catalog.
+// Each profile is its own heap node, so its address stays valid while other profiles are
+// materialized or removed; only pointers to a removed profile itself go stale.
+std::vector<std::unique_ptr<AppColorProfile>> appColorProfiles;
 std::mutex appProfilesMutex;
+static std::unordered_map<std::wstring, AppColorProfile*> profileIndexByName; // lower-case name -> materialized profile
 static HWND mainWindowHandle = nullptr;
-static std::deque<std::wstring> activationHistory; // Enhanced: Track activation history for better fallback
-static const size_t MAX_ACTIVATION_HISTORY = 10; // Maximum number of profiles to remember in history
 
 // Helper function to get default color
 COLORREF GetDefaultColor() {
@@ -47,37 +61,90 @@ inline std::wstring ToLowerCase(const std::wstring& str) {
     return lowerStr;
 }
 
-// Optimized helper function to find profile by name (INTERNAL - ASSUMES MUTEX LOCKED)
-AppColorProfile* FindProfileByNameInternal(const std::wstring& appName) {
+// Find a profile that is already in memory, without loading it from storage (INTERNAL - ASSUMES MUTEX LOCKED)
+AppColorProfile* FindMaterializedProfileInternal(const std::wstring& appName) {
     // Note: This function assumes the appProfilesMutex is already locked by the caller
     
-    std::wstring lowerAppName = ToLowerCase(appName);
+    auto it = profileIndexByName.find(ToLowerCase(appName));
+    return (it != profileIndexByName.end()) ? it->second : nullptr;
+}
+
+// Load a stored profile into memory on first use (INTERNAL - ASSUMES MUTEX LOCKED)
+static AppColorProfile* MaterializeProfileInternal(const std::wstring& appName) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
     
-    auto it = std::find_if(appColorProfiles.begin(), appColorProfiles.end(),
-        [&lowerAppName](const AppColorProfile& profile) {
-            return ToLowerCase(profile.appName) == lowerAppName;
-        });
+    // Stored profiles come first; the profile pack only fills in apps the user has no profile for
+    std::wstring storedName = GetStoredProfileNameInternal(appName);
+    AppColorProfile profile;
+    if (storedName.empty() ? !LoadAppProfileFromPack(appName, profile) : !LoadAppProfileFromStore(storedName, profile)) {
+        return nullptr;
+    }
+    
+    // Runtime flags are set by the caller (process snapshot or app monitor)
+    profile.isAppRunning = false;
+    profile.isProfileCurrInUse = false;
+    appColorProfiles.push_back(std::make_unique<AppColorProfile>(std::move(profile)));
     
-    return (it != appColorProfiles.end()) ? &(*it) : nullptr;
+    AppColorProfile* materialized = appColorProfiles.back().get();
+    profileIndexByName[ToLowerCase(materialized->appName)] = materialized;
+    LinkProfileToParentInternal(*materialized);
+    
+#ifdef ENABLE_DEBUG_LOGGING
+    std::wstringstream debugMsg;
+    debugMsg << L"[DEBUG] Materialized profile " << materialized->appName << L" ("
+             << appColorProfiles.size() << L" of " << GetProfileCatalogSizeInternal() << L" profiles in memory)\n";
+    OutputDebugStringW(debugMsg.str().c_str());
+#endif
+    return materialized;
+}
+
+// Make an edited profile from the profile pack a stored profile of its own (INTERNAL - ASSUMES MUTEX LOCKED)
+static void AdoptPackProfileInternal(AppColorProfile& profile) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+    
+    if (!profile.isPackProfile) {
+        return;
+    }
+    profile.isPackProfile = false;
+    AddProfileToCatalogInternal(profile.appName);
+    RequestProfileUiRefreshInternal();
+}
+
+// Optimized helper function to find profile by name, loading it from storage if needed (INTERNAL - ASSUMES MUTEX LOCKED)
+AppColorProfile* FindProfileByNameInternal(const std::wstring& appName) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+    
+    AppColorProfile* profile = FindMaterializedProfileInternal(appName);
+    return profile ? profile : MaterializeProfileInternal(appName);
 }
 
 // Optimized helper function to check if profile exists (INTERNAL - ASSUMES MUTEX LOCKED)
 bool ProfileExistsInternal(const std::wstring& appName) {
-    return FindProfileByNameInternal(appName) != nullptr;
+    return FindMaterializedProfileInternal(appName) != nullptr || CatalogContainsProfileInternal(appName);
 }
 
 // Optimized helper function to find profile iterator by name (INTERNAL - ASSUMES MUTEX LOCKED)
-std::vector<AppColorProfile>::iterator FindProfileIteratorInternal(const std::wstring& appName) {
+std::vector<std::unique_ptr<AppColorProfile>>::iterator FindProfileIteratorInternal(const std::wstring& appName) {
     // Note: This function assumes the appProfilesMutex is already locked by the caller
     
-    std::wstring lowerAppName = ToLowerCase(appName);
-    
+    AppColorProfile* profile = FindMaterializedProfileInternal(appName);
     return std::find_if(appColorProfiles.begin(), appColorProfiles.end(),
-        [&lowerAppName](const AppColorProfile& profile) {
-            return ToLowerCase(profile.appName) == lowerAppName;
+        [profile](const std::unique_ptr<AppColorProfile>& candidate) {
+            return candidate.get() == profile;
         });
 }
 
+// Replace the in-memory library with the names found in storage (INTERNAL - ASSUMES MUTEX LOCKED)
+// Profiles are materialized later, when a matching process runs or the profile is opened
+void ResetProfileLibraryInternal(const std::vector<std::wstring>& storedNames) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+    
+    appColorProfiles.clear();
+    profileIndexByName.clear();
+    ResetProfileCatalogInternal(storedNames);
+    RebuildInheritanceIndexInternal();
+}
+
 // ======================================================================
 // INTERNAL HELPER FUNCTIONS (ASSUME MUTEX IS ALREADY LOCKED)
 // ======================================================================
@@ -97,49 +164,26 @@ void RemoveKeysFromListInternal(std::vector<LogiLed::KeyName>& targetList, const
 }
 
 // Enhanced helper function to manage activation history (INTERNAL - NO LOCK)
-void UpdateActivationHistoryInternal(const std::wstring& profileName) {
+bool UpdateActivationHistoryInternal(const std::wstring& profileName) {
     // Note: This function assumes the appProfilesMutex is already locked by the caller
     
-    // Remove the profile from history if it already exists
-    auto it = std::find(activationHistory.begin(), activationHistory.end(), profileName);
-    if (it != activationHistory.end()) {
-        activationHistory.erase(it);
-    }
-    
-    // Add to front of history (most recent)
-    activationHistory.push_front(profileName);
-    
-    // Limit history size
-    if (activationHistory.size() > MAX_ACTIVATION_HISTORY) {
-        activationHistory.pop_back();
-    }
-    
-#ifdef ENABLE_DEBUG_LOGGING
-    // Debug logging
-    std::wstringstream debugMsg;
-    debugMsg << L"[DEBUG] Activation history updated. Current order: ";
-    for (const auto& name : activationHistory) {
-        debugMsg << name << L" -> ";
-    }
-    debugMsg << L"END\n";
-    OutputDebugStringW(debugMsg.str().c_str());
-#endif
+    // Move to the front (most recent); the history trims itself to the configured depth
+    return TouchActivationHistoryInternal(profileName);
 }
 
-void RemoveFromActivationHistoryInternal(const std::wstring& profileName) {
+bool RemoveFromActivationHistoryInternal(const std::wstring& profileName) {
     // Note: This function assumes the appProfilesMutex is already locked by the caller
     
-    auto it = std::find(activationHistory.begin(), activationHistory.end(), profileName);
-    if (it != activationHistory.end()) {
-        activationHistory.erase(it);
-        
+    bool removed = RemoveActivationHistoryEntryInternal(profileName);
 #ifdef ENABLE_DEBUG_LOGGING
+    if (removed) {
         // Debug logging
         std::wstringstream debugMsg;
         debugMsg << L"[DEBUG] Removed profile from activation history: " << profileName << L"\n";
         OutputDebugStringW(debugMsg.str().c_str());
-#endif
     }
+#endif
+    return removed;
 }
 
 // Enhanced function to find the best fallback profile (INTERNAL - NO LOCK)
@@ -153,19 +197,21 @@ AppColorProfile* FindBestFallbackProfileInternal(const std::wstring& excludeProf
 #endif
     
     // Go through activation history from most recent to oldest
-    for (const auto& historicalProfile : activationHistory) {
+    std::wstring lowerExclude = ToLowerCase(excludeProfile);
+    AppColorProfile* historyProfile = nullptr;
+    FindInActivationHistoryInternal([&](const std::wstring& historicalProfile) {
         // Skip the excluded profile (usually the one that just stopped)
-        if (!excludeProfile.empty() && ToLowerCase(historicalProfile) == ToLowerCase(excludeProfile)) {
+        if (!excludeProfile.empty() && ToLowerCase(historicalProfile) == lowerExclude) {
 #ifdef ENABLE_DEBUG_LOGGING
             std::wstringstream debugMsg2;
             debugMsg2 << L"[DEBUG] Skipping excluded profile from history: " << historicalProfile << L"\n";
             OutputDebugStringW(debugMsg2.str().c_str());
 #endif
-            continue;
+            return false;
         }
         
-        // Find this profile in our current profiles using optimized search
-        AppColorProfile* profile = FindProfileByNameInternal(historicalProfile);
+        // Find this profile in memory (profiles of running apps are always materialized)
+        AppColorProfile* profile = FindMaterializedProfileInternal(historicalProfile);
         if (profile) {
 #ifdef ENABLE_DEBUG_LOGGING
             std::wstringstream debugMsg2;
@@ -176,35 +222,41 @@ AppColorProfile* FindBestFallbackProfileInternal(const std::wstring& excludeProf
             
             if (profile->isAppRunning) {
                 // Found a running profile from our history - this is our best fallback
-#ifdef ENABLE_DEBUG_LOGGING
-                std::wstringstream debugMsg3;
-                debugMsg3 << L"[DEBUG] Best fallback profile found: " << profile->appName 
-                         << L" (from activation history)\n";
-                OutputDebugStringW(debugMsg3.str().c_str());
-#endif
-                return profile;
+                historyProfile = profile;
+                return true;
             }
         } 
 #ifdef ENABLE_DEBUG_LOGGING
         else {
 
             std::wstringstream debugMsg2;
-            debugMsg2 << L"[DEBUG] Profile from history no longer exists: " << historicalProfile << L"\n";
+            debugMsg2 << L"[DEBUG] Profile from history not in memory: " << historicalProfile << L"\n";
             OutputDebugStringW(debugMsg2.str().c_str());
         }
 #endif
+        return false;
+    });
+    
+    if (historyProfile) {
+#ifdef ENABLE_DEBUG_LOGGING
+        std::wstringstream debugMsg3;
+        debugMsg3 << L"[DEBUG] Best fallback profile found: " << historyProfile->appName 
+                 << L" (from activation history)\n";
+        OutputDebugStringW(debugMsg3.str().c_str());
+#endif
+        return historyProfile;
     }
     
     // If no profile from history is available, find any running profile
     for (auto& profile : appColorProfiles) {
-        if (profile.isAppRunning && 
-            (excludeProfile.empty() || ToLowerCase(profile.appName) != ToLowerCase(excludeProfile))) {
+        if (profile->isAppRunning && 
+            (excludeProfile.empty() || ToLowerCase(profile->appName) != ToLowerCase(excludeProfile))) {
 #ifdef ENABLE_DEBUG_LOGGING
             std::wstringstream debugMsg2;
-            debugMsg2 << L"[DEBUG] Fallback profile found (not in history): " << profile.appName << L"\n";
+            debugMsg2 << L"[DEBUG] Fallback profile found (not in history): " << profile->appName << L"\n";
             OutputDebugStringW(debugMsg2.str().c_str());
 #endif
-            return &profile;
+            return profile.get();
         }
     }
     
@@ -219,20 +271,9 @@ void CleanupActivationHistoryInternal() {
     // Note: This function assumes the appProfilesMutex is already locked by the caller
     
     // Remove profiles from history that are no longer configured
-    auto it = activationHistory.begin();
-    while (it != activationHistory.end()) {
-        // Use optimized search to check if profile exists
-        if (!ProfileExistsInternal(*it)) {
-#ifdef ENABLE_DEBUG_LOGGING
-            std::wstringstream debugMsg;
-            debugMsg << L"[DEBUG] Removing deleted profile from activation history: " << *it << L"\n";
-            OutputDebugStringW(debugMsg.str().c_str());
-#endif
-            it = activationHistory.erase(it);
-        } else {
-            ++it;
-        }
-    }
+    RemoveActivationHistoryEntriesInternal([](const std::wstring& profileName) {
+        return !ProfileExistsInternal(profileName);
+    });
 }
 
 // Get the currently displayed profile (INTERNAL - NO LOCK)
@@ -240,19 +281,42 @@ AppColorProfile* GetDisplayedProfileInternal() {
     // Note: This function assumes the appProfilesMutex is already locked by the caller
     
     for (auto& profile : appColorProfiles) {
-        if (profile.isProfileCurrInUse) {
-            return &profile;
+        if (profile->isProfileCurrInUse) {
+            return profile.get();
         }
     }
     
     return nullptr; // No profile is currently displayed
 }
 
-// Apply colors for a profile without holding mutex (INTERNAL - NO LOCK)
-void ApplyProfileColorsInternal(AppColorProfile* profile) {
+// Get the flattened frame of the displayed profile if a change to the named profile affects it (INTERNAL - NO LOCK)
+AppColorProfile* GetAffectedDisplayedFrameInternal(const std::wstring& changedProfileName) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+    
+    // The displayed profile is affected when it is the changed profile or inherits from it
+    AppColorProfile* displayed = GetDisplayedProfileInternal();
+    if (displayed && IsProfileInInheritanceChainInternal(displayed, changedProfileName)) {
+        return ResolveProfileInternal(displayed);
+    }
+    
+    return nullptr;
+}
+
+// Apply colors for a profile without holding mutex (UI THREAD - NO LOCK)
+void ApplyProfileColorsInternal(const AppColorProfile* profile) {
     // This function assumes mutex is NOT held and can be called safely
     // It will make necessary calls to LockKeys module
     
+    if (IsHeatmapModeEnabled()) {
+        // The typing heatmap owns the keyboard; its next frame repaints every key
+        RequestHeatmapFullFrame();
+        UpdateKeyboardHookState();
+        UpdateKeyEffectsForProfile(profile);
+        UpdateModifierLayerForProfile(profile);
+        NotifyStartupFramePushed();
+        return;
+    }
+    
     if (!profile) {
         // No profile - use default colors and enable lock keys
 #ifdef ENABLE_DEBUG_LOGGING
@@ -261,6 +325,9 @@ void ApplyProfileColorsInternal(AppColorProfile* profile) {
         SetDefaultColor(defaultColor);
         SetLockKeysColor(); // This will use safe version
         UpdateKeyboardHookState(); // This will use safe version
+        UpdateKeyEffectsForProfile(nullptr);
+        UpdateModifierLayerForProfile(nullptr);
+        NotifyStartupFramePushed();
         return;
     }
     
@@ -287,514 +354,764 @@ void ApplyProfileColorsInternal(AppColorProfile* profile) {
     
     // Update hook state
     UpdateKeyboardHookState();
+    UpdateKeyEffectsForProfile(profile);
+    UpdateModifierLayerForProfile(profile);
+    NotifyStartupFramePushed();
 }
 
-// Centralized function to determine and apply the active profile
-void UpdateAndApplyActiveProfile() {
-    AppColorProfile* profileToApply = nullptr;
-    bool changed = false;
-    std::wstring previousProfileName = L""; // Track the name instead of pointer
+// Push the full frame of the displayed profile, e.g. once the LED SDK is ready (UI THREAD - NO LOCK)
+void ApplyDisplayedProfileColors() {
+    ApplyProfileColorsInternal(GetDisplayedProfile().get());
+}
 
-    // Phase 1: Determine the correct active profile under lock
-    {
-        std::lock_guard<std::mutex> lock(appProfilesMutex);
 
-        // Get the currently displayed profile and remember its name
-        AppColorProfile* currentDisplayed = GetDisplayedProfileInternal();
-        if (currentDisplayed) {
-            previousProfileName = currentDisplayed->appName;
-        }
+// Apply the colors the profile engine asked for (UI THREAD - NO LOCK)
+void ApplyPendingProfileColors() {
+    LatencyTrace trace;
+    ULONGLONG publishedMicros = 0;
+    DWORD fields = TakePendingProfileApply(&trace, &publishedMicros);
+    if (fields == 0) {
+        return;
+    }
+    ULONGLONG applyStart = trace.id ? ReadTraceClock() : 0;
 
-        // Find the best fallback profile
-        AppColorProfile* bestFallback = FindBestFallbackProfileInternal(L"");
+    std::shared_ptr<const AppColorProfile> displayedProfile = GetDisplayedProfile(); // Held until every push is done
+    const AppColorProfile* frame = displayedProfile.get();
 
-        // Clear all isProfileCurrInUse flags
-        for (auto& p : appColorProfiles) {
-#ifdef ENABLE_DEBUG_LOGGING
-            if (p.isProfileCurrInUse) {
-                // Debug logging for flag changes
-                std::wstringstream debugMsg;
-                debugMsg << L"[DEBUG] Profile " << p.appName << L" - isProfileCurrInUse changed to FALSE (UpdateAndApplyActiveProfile)\n";
-                OutputDebugStringW(debugMsg.str().c_str());
-            }
-#endif
-            p.isProfileCurrInUse = false;
+    // Highlight and action color changes only touch their own keys; everything else needs a full update
+    // (the heatmap case is handled there as well)
+    if ((fields & ~(PROFILE_FIELD_HIGHLIGHT_COLOR | PROFILE_FIELD_ACTION_COLOR)) || IsHeatmapModeEnabled()) {
+        ApplyProfileColorsInternal(frame); // nullptr will trigger default colors
+    } else {
+        if (fields & PROFILE_FIELD_HIGHLIGHT_COLOR) {
+            SetHighlightKeysColorWithProfile(frame);
+        }
+        if (fields & PROFILE_FIELD_ACTION_COLOR) {
+            SetActionKeysColorWithProfile(frame);
         }
+    }
 
-        // Set the new displayed profile if we have one
-        if (bestFallback) {
-            bestFallback->isProfileCurrInUse = true;
+    if (trace.id) {
+        ULONGLONG applyEnd = ReadTraceClock();
+        RecordLatencySpan(LatencyStage::ApplyQueue, trace.id, publishedMicros, applyStart);
+        RecordLatencySpan(LatencyStage::LedPush, trace.id, applyStart, applyEnd);
+        RecordLatencySpan(LatencyStage::EndToEnd, trace.id, trace.startMicros, applyEnd);
+    }
+}
+
+// ======================================================================
+// PROFILE ENGINE EVENT HANDLERS (ASSUME MUTEX IS ALREADY LOCKED)
+// ======================================================================
+
+// Centralized function to determine the active profile (INTERNAL - NO LOCK)
+static void UpdateActiveProfileInternal() {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    bool changed = false;
+    std::wstring previousProfileName = L""; // Track the name instead of pointer
+
+    // Get the currently displayed profile and remember its name
+    AppColorProfile* currentDisplayed = GetDisplayedProfileInternal();
+    if (currentDisplayed) {
+        previousProfileName = currentDisplayed->appName;
+    }
+
+    // Find the best fallback profile
+    AppColorProfile* bestFallback = FindBestFallbackProfileInternal(L"");
+
+    // Clear all isProfileCurrInUse flags
+    for (auto& p : appColorProfiles) {
 #ifdef ENABLE_DEBUG_LOGGING
+        if (p->isProfileCurrInUse) {
             // Debug logging for flag changes
             std::wstringstream debugMsg;
-            debugMsg << L"[DEBUG] Profile " << bestFallback->appName << L" - isProfileCurrInUse changed to TRUE (UpdateAndApplyActiveProfile)\n";
+            debugMsg << L"[DEBUG] Profile " << p->appName << L" - isProfileCurrInUse changed to FALSE (UpdateActiveProfileInternal)\n";
             OutputDebugStringW(debugMsg.str().c_str());
-#endif
         }
+#endif
+        p->isProfileCurrInUse = false;
+    }
 
-        // Check if the displayed profile has changed by comparing names
-        std::wstring newProfileName = bestFallback ? bestFallback->appName : L"";
-        if (previousProfileName != newProfileName) {
-            changed = true;
-            profileToApply = bestFallback; // This can be nullptr, which is correct for default colors
-            
+    // Set the new displayed profile if we have one
+    if (bestFallback) {
+        bestFallback->isProfileCurrInUse = true;
 #ifdef ENABLE_DEBUG_LOGGING
-            // Debug logging
-            std::wstringstream debugMsg;
-            debugMsg << L"[DEBUG] Profile handoff: '" << previousProfileName 
-                     << L"' -> '" << newProfileName << L"'\n";
-            OutputDebugStringW(debugMsg.str().c_str());
+        // Debug logging for flag changes
+        std::wstringstream debugMsg;
+        debugMsg << L"[DEBUG] Profile " << bestFallback->appName << L" - isProfileCurrInUse changed to TRUE (UpdateActiveProfileInternal)\n";
+        OutputDebugStringW(debugMsg.str().c_str());
 #endif
-        }
-        
-        // Special case: If we have no active profile and no previous profile was set,
-        // we should still apply default colors on the first call
-        if (!bestFallback && previousProfileName.empty()) {
-            changed = true;
-            profileToApply = nullptr;
+    }
+
+    // Check if the displayed profile has changed by comparing names
+    std::wstring newProfileName = bestFallback ? bestFallback->appName : L"";
+    if (previousProfileName != newProfileName) {
+        changed = true;
+
 #ifdef ENABLE_DEBUG_LOGGING
-            OutputDebugStringW(L"[DEBUG] No profiles available - forcing default color application\n");
+        // Debug logging
+        std::wstringstream debugMsg;
+        debugMsg << L"[DEBUG] Profile handoff: '" << previousProfileName
+                 << L"' -> '" << newProfileName << L"'\n";
+        OutputDebugStringW(debugMsg.str().c_str());
 #endif
-        }
-    } // Mutex is released here
+    }
 
-    // Phase 2: Apply colors and notify UI if a change occurred
-    if (changed) {
+    // Special case: If we have no active profile and no previous profile was set,
+    // we should still apply default colors on the first call
+    if (!bestFallback && previousProfileName.empty()) {
+        changed = true;
 #ifdef ENABLE_DEBUG_LOGGING
-        if (profileToApply) {
-            std::wstringstream debugMsg;
-            debugMsg << L"[DEBUG] Applying profile: " << profileToApply->appName << L"\n";
-            OutputDebugStringW(debugMsg.str().c_str());
-        } else {
-            OutputDebugStringW(L"[DEBUG] Applying default colors (no active profile)\n");
-        }
+        OutputDebugStringW(L"[DEBUG] No profiles available - forcing default color application\n");
 #endif
-        ApplyProfileColorsInternal(profileToApply); // nullptr will trigger default colors
-        
-        if (mainWindowHandle) {
-            PostMessage(mainWindowHandle, WM_UPDATE_PROFILE_COMBO, 0, 0);
-        }
-    } 
+    }
+
+    // The UI thread pushes the new frame (or the default colors) once the snapshot is published
+    if (changed) {
+        RequestProfileApplyInternal(PROFILE_FIELD_ALL);
+        RequestProfileUiRefreshInternal();
+    }
 #ifdef ENABLE_DEBUG_LOGGING
     else {
-        OutputDebugStringW(L"[DEBUG] UpdateAndApplyActiveProfile - No change detected\n");
+        OutputDebugStringW(L"[DEBUG] UpdateActiveProfileInternal - No change detected\n");
     }
 #endif
 }
 
-// ======================================================================
-// PUBLIC API FUNCTIONS (SAFE MUTEX USAGE)
-// ======================================================================
+// Add or update a profile (INTERNAL - NO LOCK)
+static bool OnProfileAddedInternal(const ProfileEvent& event) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
 
-// PUBLIC wrapper functions (for external API compatibility)
-void UpdateActivationHistory(const std::wstring& profileName) {
-    std::lock_guard<std::mutex> lock(appProfilesMutex);
-    UpdateActivationHistoryInternal(profileName);
-}
+    const std::wstring& appName = event.appName;
 
-AppColorProfile* FindBestFallbackProfile(const std::wstring& excludeProfile) {
-    std::lock_guard<std::mutex> lock(appProfilesMutex);
-    return FindBestFallbackProfileInternal(excludeProfile);
-}
+    // Check if profile already exists using optimized search
+    AppColorProfile* existingProfile = FindProfileByNameInternal(appName);
+    if (existingProfile) {
+        // Update existing profile
+        AdoptPackProfileInternal(*existingProfile);
+        existingProfile->appColor = event.color;
+        existingProfile->lockKeysEnabled = event.value != 0;
+        existingProfile->overrideMask |= PROFILE_FIELD_APP_COLOR | PROFILE_FIELD_LOCK_KEYS_ENABLED;
+        InvalidateResolvedProfileInternal(appName);
+        existingProfile->isAppRunning = event.isAppRunning;
 
-void CleanupActivationHistory() {
-    std::lock_guard<std::mutex> lock(appProfilesMutex);
-    CleanupActivationHistoryInternal();
-}
+        // If app is running and profile is currently displayed, we need to update colors
+        bool shouldApplyColors = existingProfile->isAppRunning && existingProfile->isProfileCurrInUse;
+        if (shouldApplyColors) {
+            RequestProfileApplyInternal(PROFILE_FIELD_ALL);
+        }
 
-// Add an app color profile with lock keys feature control
-void AddAppColorProfile(const std::wstring& appName, COLORREF color, bool lockKeysEnabled) {
-    bool shouldApplyColors = false;
-    bool isNewProfile = false;
-    
-    // Phase 1: Add/update profile under lock
-    {
-        std::lock_guard<std::mutex> lock(appProfilesMutex);
-        
-        // Check if profile already exists using optimized search
-        AppColorProfile* existingProfile = FindProfileByNameInternal(appName);
-        if (existingProfile) {
-            // Update existing profile
-            existingProfile->appColor = color;
-            existingProfile->lockKeysEnabled = lockKeysEnabled;
-            bool wasRunning = existingProfile->isAppRunning;
-            existingProfile->isAppRunning = IsAppRunning(appName);
-            
-            // If app is running and profile is currently displayed, we need to update colors
-            if (existingProfile->isAppRunning && existingProfile->isProfileCurrInUse) {
-                shouldApplyColors = true;
-            }
-            
 #ifdef ENABLE_DEBUG_LOGGING
-            std::wstringstream debugMsg;
-            debugMsg << L"[DEBUG] Updated existing profile: " << appName 
-                     << L" (isAppRunning: " << (existingProfile->isAppRunning ? L"TRUE" : L"FALSE") 
-                     << L", shouldApplyColors: " << (shouldApplyColors ? L"TRUE" : L"FALSE") << L")\n";
-            OutputDebugStringW(debugMsg.str().c_str());
+        std::wstringstream debugMsg;
+        debugMsg << L"[DEBUG] Updated existing profile: " << appName
+                 << L" (isAppRunning: " << (existingProfile->isAppRunning ? L"TRUE" : L"FALSE")
+                 << L", shouldApplyColors: " << (shouldApplyColors ? L"TRUE" : L"FALSE") << L")\n";
+        OutputDebugStringW(debugMsg.str().c_str());
 #endif
-            
-            return;
-        }
-        
-        // Add new profile
-        AppColorProfile newProfile;
-        newProfile.appName = appName;
-        newProfile.appColor = color;
-        newProfile.lockKeysEnabled = lockKeysEnabled;
-        newProfile.isAppRunning = IsAppRunning(appName);
-        newProfile.isProfileCurrInUse = false; // Initialize as not displayed
-        
-        isNewProfile = true;
-        
-        // If the app is already running, this new profile should take control
-        if (newProfile.isAppRunning) {
-            // Clear all other isProfileCurrInUse flags
-            for (auto& p : appColorProfiles) {
-                if (p.isProfileCurrInUse) {
-                    p.isProfileCurrInUse = false;
+
+        return true;
+    }
+
+    // Add new profile
+    AppColorProfile newProfile;
+    newProfile.appName = appName;
+    newProfile.appColor = event.color;
+    newProfile.lockKeysEnabled = event.value != 0;
+    newProfile.isAppRunning = event.isAppRunning;
+    newProfile.isProfileCurrInUse = false; // Initialize as not displayed
+
+    // If the app is already running, this new profile should take control
+    if (newProfile.isAppRunning) {
+        // Clear all other isProfileCurrInUse flags
+        for (auto& p : appColorProfiles) {
+            if (p->isProfileCurrInUse) {
+                p->isProfileCurrInUse = false;
 #ifdef ENABLE_DEBUG_LOGGING
-                    std::wstringstream debugMsg;
-                    debugMsg << L"[DEBUG] Profile " << p.appName << L" - isProfileCurrInUse changed to FALSE (new profile taking over)\n";
-                    OutputDebugStringW(debugMsg.str().c_str());
+                std::wstringstream debugMsg;
+                debugMsg << L"[DEBUG] Profile " << p->appName << L" - isProfileCurrInUse changed to FALSE (new profile taking over)\n";
+                OutputDebugStringW(debugMsg.str().c_str());
 #endif
-                }
             }
-            
-            // Set this new profile as displayed
-            newProfile.isProfileCurrInUse = true;
-            
-            // Update activation history
-            UpdateActivationHistoryInternal(newProfile.appName);
-            
-            shouldApplyColors = true;
-            
+        }
+
+        // Set this new profile as displayed
+        newProfile.isProfileCurrInUse = true;
+
+        // Update activation history
+        UpdateActivationHistoryInternal(newProfile.appName);
+
+        RequestProfileApplyInternal(PROFILE_FIELD_ALL);
+        RequestProfileUiRefreshInternal();
+
 #ifdef ENABLE_DEBUG_LOGGING
-            std::wstringstream debugMsg;
-            debugMsg << L"[DEBUG] New profile added for running app: " << appName 
-                     << L" - taking control of colors\n";
-            OutputDebugStringW(debugMsg.str().c_str());
+        std::wstringstream debugMsg;
+        debugMsg << L"[DEBUG] New profile added for running app: " << appName
+                 << L" - taking control of colors\n";
+        OutputDebugStringW(debugMsg.str().c_str());
 #endif
-        }
+    }
 #ifdef ENABLE_DEBUG_LOGGING
-        else {
-            std::wstringstream debugMsg;
-            debugMsg << L"[DEBUG] New profile added for non-running app: " << appName << L"\n";
-            OutputDebugStringW(debugMsg.str().c_str());
-        }
+    else {
+        std::wstringstream debugMsg;
+        debugMsg << L"[DEBUG] New profile added for non-running app: " << appName << L"\n";
+        OutputDebugStringW(debugMsg.str().c_str());
+    }
 #endif
 
-        appColorProfiles.push_back(newProfile);
-    } // Mutex released here
-    
-    // Phase 2: Apply colors if needed and notify UI
-    if (shouldApplyColors) {
-        // Get the profile again (safely) to apply its colors
-        AppColorProfile* profileToApply = GetAppProfileByName(appName);
-        if (profileToApply) {
-            ApplyProfileColorsInternal(profileToApply);
-            
-            // Notify UI to update combo box
-            if (mainWindowHandle) {
-                PostMessage(mainWindowHandle, WM_UPDATE_PROFILE_COMBO, 0, 0);
-            }
-        }
-    }
+    appColorProfiles.push_back(std::make_unique<AppColorProfile>(std::move(newProfile)));
+    profileIndexByName[ToLowerCase(appName)] = appColorProfiles.back().get();
+    AddProfileToCatalogInternal(appName);
+
+    // Profiles that already name this one as their parent now inherit from it
+    InvalidateResolvedProfileInternal(appName);
+    return true;
 }
 
-// Remove an app color profile  
-void RemoveAppColorProfile(const std::wstring& appName) {
+// Remove a profile (INTERNAL - NO LOCK)
+static bool OnProfileRemovedInternal(const ProfileEvent& event) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    const std::wstring& appName = event.appName;
     bool wasDisplayedProfile = false;
-    
-    // Phase 1: Remove profile under lock and determine if a color update is needed
-    {
-        std::lock_guard<std::mutex> lock(appProfilesMutex);
-        
-        AppColorProfile* profileToRemove = FindProfileByNameInternal(appName);
-        if (profileToRemove && profileToRemove->isProfileCurrInUse) {
-            wasDisplayedProfile = true;
+    bool displayedInheritsRemoved = false;
+
+    // A displayed profile inheriting from the removed one loses its parent values
+    AppColorProfile* displayed = GetDisplayedProfileInternal();
+    if (displayed && !displayed->parentName.empty() && IsProfileInInheritanceChainInternal(displayed, appName)) {
+        displayedInheritsRemoved = true;
+    }
+
+    AppColorProfile* profileToRemove = FindMaterializedProfileInternal(appName);
+    if (profileToRemove && profileToRemove->isProfileCurrInUse) {
+        wasDisplayedProfile = true;
 #ifdef ENABLE_DEBUG_LOGGING
-            std::wstringstream debugMsg;
-            debugMsg << L"[DEBUG] Removing currently displayed profile: " << profileToRemove->appName << L"\n";
-            OutputDebugStringW(debugMsg.str().c_str());
+        std::wstringstream debugMsg;
+        debugMsg << L"[DEBUG] Removing currently displayed profile: " << profileToRemove->appName << L"\n";
+        OutputDebugStringW(debugMsg.str().c_str());
 #endif
-        }
-        
-        auto it = FindProfileIteratorInternal(appName);
-        if (it != appColorProfiles.end()) {
+    }
+
+    auto it = FindProfileIteratorInternal(appName);
+    if (it != appColorProfiles.end()) {
 #ifdef ENABLE_DEBUG_LOGGING
-            std::wstringstream debugMsg;
-            debugMsg << L"[DEBUG] Removing profile from memory: " << it->appName << L"\n";
-            OutputDebugStringW(debugMsg.str().c_str());
+        std::wstringstream debugMsg;
+        debugMsg << L"[DEBUG] Removing profile from memory: " << (*it)->appName << L"\n";
+        OutputDebugStringW(debugMsg.str().c_str());
 #endif
-            appColorProfiles.erase(it);
-        }
+        // Only the removed node is freed - pointers to the other profiles stay valid
+        profileIndexByName.erase(ToLowerCase((*it)->appName));
+        appColorProfiles.erase(it);
+        RemoveResolvedProfileInternal(appName);
+    }
 #ifdef ENABLE_DEBUG_LOGGING
-        else {
-            std::wstringstream debugMsg;
-            debugMsg << L"[DEBUG] Profile not found in memory for removal: " << appName << L"\n";
-            OutputDebugStringW(debugMsg.str().c_str());
-        }
+    else {
+        std::wstringstream debugMsg;
+        debugMsg << L"[DEBUG] Profile not found in memory for removal: " << appName << L"\n";
+        OutputDebugStringW(debugMsg.str().c_str());
+    }
 #endif
 
-        // Clean up activation history AFTER removing the profile
-        CleanupActivationHistoryInternal();
-        
+    RemoveProfileFromCatalogInternal(appName);
+
+    // Clean up activation history AFTER removing the profile
+    CleanupActivationHistoryInternal();
+
 #ifdef ENABLE_DEBUG_LOGGING
-        // Debug: Show remaining profiles
-        std::wstringstream debugMsg2;
-        debugMsg2 << L"[DEBUG] Remaining profiles after deletion (" << appColorProfiles.size() << L"): ";
-        for (const auto& p : appColorProfiles) {
-            debugMsg2 << p.appName << L"(running:" << (p.isAppRunning ? L"Y" : L"N") << L") ";
-        }
-        debugMsg2 << L"\n";
-        OutputDebugStringW(debugMsg2.str().c_str());
+    // Debug: Show remaining profiles
+    std::wstringstream debugMsg2;
+    debugMsg2 << L"[DEBUG] Remaining profiles after deletion (" << appColorProfiles.size() << L"): ";
+    for (const auto& p : appColorProfiles) {
+        debugMsg2 << p->appName << L"(running:" << (p->isAppRunning ? L"Y" : L"N") << L") ";
+    }
+    debugMsg2 << L"\n";
+    OutputDebugStringW(debugMsg2.str().c_str());
 #endif
-        
-    } // Mutex released here
-    
-    // Phase 2: If the displayed profile was removed, update the active profile
+
+    // If the displayed profile was removed, update the active profile
     if (wasDisplayedProfile) {
+        UpdateActiveProfileInternal();
+    } else if (displayedInheritsRemoved) {
+        // Same profile stays displayed, but its flattened colors changed
+        RequestProfileApplyInternal(PROFILE_FIELD_ALL);
+    }
+    return true;
+}
+
+// Update the running state of every profile from a process scan (INTERNAL - NO LOCK)
+static bool OnRunningAppsScannedInternal(const ProfileEvent& event) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    std::unordered_set<std::wstring> runningNames;
+    for (const auto& process : event.names) {
+        runningNames.insert(ToLowerCase(process));
+    }
+
+    for (auto& profile : appColorProfiles) {
+        profile->isAppRunning = runningNames.count(ToLowerCase(profile->appName)) > 0;
+    }
+
+    // Materialize stored profiles of running apps that are not in memory yet
+    for (const auto& process : event.names) {
+        if (!FindMaterializedProfileInternal(process)) {
+            AppColorProfile* profile = MaterializeProfileInternal(process);
+            if (profile) {
+                profile->isAppRunning = true;
+            }
+        }
+    }
+
+    // Determine the best active profile
+    UpdateActiveProfileInternal();
+    return true;
+}
+
+// Update one field of a profile (INTERNAL - NO LOCK)
+static bool OnProfileFieldChangedInternal(const ProfileEvent& event) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    AppColorProfile* profile = FindProfileByNameInternal(event.appName);
+    if (!profile) {
+        return false;
+    }
+    AdoptPackProfileInternal(*profile);
+
+    switch (event.field) {
+        case PROFILE_FIELD_APP_COLOR:
+            profile->appColor = event.color;
+            break;
+        case PROFILE_FIELD_HIGHLIGHT_COLOR:
+            profile->appHighlightColor = event.color;
+            break;
+        case PROFILE_FIELD_ACTION_COLOR:
+            profile->appActionColor = event.color;
+            break;
+        case PROFILE_FIELD_LOCK_KEYS_ENABLED:
+            profile->lockKeysEnabled = event.value != 0;
+            break;
+        case PROFILE_FIELD_HIGHLIGHT_KEYS:
+            profile->highlightKeys = event.keys;
+            // Remove any keys that are now in highlightKeys from actionKeys to prevent conflicts
+            // (inherited action keys are filtered the same way when the profile is flattened)
+            RemoveKeysFromListInternal(profile->actionKeys, event.keys);
+            break;
+        case PROFILE_FIELD_ACTION_KEYS:
+            profile->actionKeys = event.keys;
+            // Remove any keys that are now in actionKeys from highlightKeys to prevent conflicts
+            RemoveKeysFromListInternal(profile->highlightKeys, event.keys);
+            break;
+        case PROFILE_FIELD_KEY_EFFECT:
+            profile->keyEffect = event.value < KEY_EFFECT_COUNT ? event.value : KEY_EFFECT_NONE;
+            break;
+        case PROFILE_FIELD_MODIFIER_LAYER:
+            profile->modifierLayer = event.value & MODIFIER_LAYER_ALL;
+            profile->appModifierColor = event.color;
+            break;
+        default:
+            return false;
+    }
+    profile->overrideMask |= event.field;
+    InvalidateResolvedProfileInternal(profile->appName);
+
+    // If this profile (or a profile inheriting from it) is displayed, we need to update colors
+    if (GetAffectedDisplayedFrameInternal(profile->appName)) {
+        RequestProfileApplyInternal(event.field);
+    }
+    return true;
+}
+
+// Set the parent template of a profile (INTERNAL - NO LOCK)
+static bool OnProfileParentChangedInternal(const ProfileEvent& event) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    AppColorProfile* profile = FindProfileByNameInternal(event.appName);
+    if (!profile || WouldCreateInheritanceCycleInternal(event.appName, event.parentName)) {
 #ifdef ENABLE_DEBUG_LOGGING
         std::wstringstream debugMsg;
-        debugMsg << L"[DEBUG] Calling UpdateAndApplyActiveProfile due to profile removal\n";
+        debugMsg << L"[DEBUG] Rejected parent '" << event.parentName << L"' for profile " << event.appName << L"\n";
         OutputDebugStringW(debugMsg.str().c_str());
 #endif
-        UpdateAndApplyActiveProfile();
+        return false;
+    }
+
+    AdoptPackProfileInternal(*profile);
+    SetProfileParentInternal(*profile, event.parentName, event.value);
+
+    if (GetAffectedDisplayedFrameInternal(profile->appName)) {
+        RequestProfileApplyInternal(PROFILE_FIELD_ALL);
     }
+    return true;
+}
+
+// Add or replace a batch of imported profiles (INTERNAL - NO LOCK)
+static bool OnProfilesImportedInternal(const ProfileEvent& event) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    std::unordered_set<std::wstring> runningNames;
+    for (const auto& process : event.names) {
+        runningNames.insert(ToLowerCase(process));
+    }
+
+    // Store every profile first, so parents imported in the same batch exist when the links are set
+    std::vector<AppColorProfile*> importedProfiles;
+    importedProfiles.reserve(event.profiles.size());
+    for (const auto& imported : event.profiles) {
+        AppColorProfile* profile = FindProfileByNameInternal(imported.appName);
+        if (!profile) {
+            AppColorProfile newProfile;
+            newProfile.appName = imported.appName;
+            appColorProfiles.push_back(std::make_unique<AppColorProfile>(std::move(newProfile)));
+            profile = appColorProfiles.back().get();
+            profileIndexByName[ToLowerCase(profile->appName)] = profile;
+            AddProfileToCatalogInternal(profile->appName);
+
+            // A new profile of a running app takes control, as in OnProfileAddedInternal
+            if (runningNames.count(ToLowerCase(profile->appName)) > 0) {
+                UpdateActivationHistoryInternal(profile->appName);
+            }
+        }
+        AdoptPackProfileInternal(*profile);
+
+        profile->appColor = imported.appColor;
+        profile->appHighlightColor = imported.appHighlightColor;
+        profile->appActionColor = imported.appActionColor;
+        profile->lockKeysEnabled = imported.lockKeysEnabled;
+        profile->highlightKeys = imported.highlightKeys;
+        profile->actionKeys = imported.actionKeys;
+        profile->keyEffect = imported.keyEffect;
+        profile->modifierLayer = imported.modifierLayer;
+        profile->appModifierColor = imported.appModifierColor;
+        RemoveKeysFromListInternal(profile->highlightKeys, profile->actionKeys);
+        profile->overrideMask = PROFILE_FIELD_ALL; // Narrowed when the parent is linked below
+        profile->isAppRunning = runningNames.count(ToLowerCase(profile->appName)) > 0;
+        InvalidateResolvedProfileInternal(profile->appName);
+        importedProfiles.push_back(profile);
+    }
+
+    // Link parents in file order; a parent that would close a loop leaves the profile standalone
+    for (size_t i = 0; i < importedProfiles.size(); ++i) {
+        AppColorProfile* profile = importedProfiles[i];
+        const AppColorProfile& imported = event.profiles[i];
+        if (!imported.parentName.empty() && !WouldCreateInheritanceCycleInternal(profile->appName, imported.parentName)) {
+            SetProfileParentInternal(*profile, imported.parentName, imported.overrideMask);
+        } else {
+            SetProfileParentInternal(*profile, L"", PROFILE_FIELD_ALL);
+        }
+    }
+
+    // One decision for the whole batch; the displayed frame may have changed even if its profile did not
+    UpdateActiveProfileInternal();
+    RequestProfileApplyInternal(PROFILE_FIELD_ALL);
+    RequestProfileUiRefreshInternal();
+    return true;
+}
+
+// App monitor: an app with visible windows started (INTERNAL - NO LOCK)
+static bool OnAppStartedInternal(const ProfileEvent& event) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    AppColorProfile* profile = FindProfileByNameInternal(event.appName);
+    if (!profile) {
+        return false;
+    }
+
+    bool changed = false;
+    if (!profile->isAppRunning) {
+        profile->isAppRunning = true;
+        changed = true;
+    }
+    // Move to the front of the activation history regardless of running state
+    UpdateActivationHistoryInternal(profile->appName);
+
+    if (changed) {
+        UpdateActiveProfileInternal();
+    }
+    return true;
+}
+
+// App monitor: an app stopped (INTERNAL - NO LOCK)
+static bool OnAppStoppedInternal(const ProfileEvent& event) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    AppColorProfile* profile = FindMaterializedProfileInternal(event.appName); // Stopped apps are always in memory
+    if (!profile) {
+        return false;
+    }
+
+    // Remove from activation history
+    RemoveFromActivationHistoryInternal(profile->appName);
+    if (profile->isAppRunning) {
+        profile->isAppRunning = false;
 #ifdef ENABLE_DEBUG_LOGGING
-    else {
         std::wstringstream debugMsg;
-        debugMsg << L"[DEBUG] Profile removal complete - no active profile change needed\n";
+        debugMsg << L"[DEBUG] Profile " << profile->appName << L" - isAppRunning changed to FALSE (OnAppStoppedInternal)\n";
         OutputDebugStringW(debugMsg.str().c_str());
-    }
 #endif
+    }
+
+    UpdateActiveProfileInternal();
+    return true;
+}
+
+// Route an event to its handler (PROFILE ENGINE - ASSUMES MUTEX LOCKED)
+bool DispatchProfileEventInternal(const ProfileEvent& event) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
 
+    switch (event.type) {
+        case ProfileEventType::AppStarted:           return OnAppStartedInternal(event);
+        case ProfileEventType::AppStopped:           return OnAppStoppedInternal(event);
+        case ProfileEventType::RunningAppsScanned:   return OnRunningAppsScannedInternal(event);
+        case ProfileEventType::ProfileAdded:         return OnProfileAddedInternal(event);
+        case ProfileEventType::ProfileRemoved:       return OnProfileRemovedInternal(event);
+        case ProfileEventType::ProfileFieldChanged:  return OnProfileFieldChangedInternal(event);
+        case ProfileEventType::ProfileParentChanged: return OnProfileParentChangedInternal(event);
+        case ProfileEventType::ProfilesImported:     return OnProfilesImportedInternal(event);
+        case ProfileEventType::Barrier:              return true;
+    }
+    return false;
 }
 
-// Check running apps and update colors immediately
-void CheckRunningAppsAndUpdateColors() {
-    // Phase 1: Update all profiles' running status under lock
+// Fill the snapshot published after a batch of events (PROFILE ENGINE - ASSUMES MUTEX LOCKED)
+void BuildProfileStateSnapshotInternal(ProfileStateSnapshot& snapshot, const ProfileStateSnapshot& previous) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    AppColorProfile* frame = ResolveProfileInternal(GetDisplayedProfileInternal());
+    snapshot.hasDisplayedProfile = frame != nullptr;
+    if (frame) {
+        snapshot.displayedFrame = *frame;
+    }
+
+    // The name list is only copied when a profile was added or removed since the last snapshot
+    snapshot.catalogVersion = GetProfileCatalogVersion();
+    if (previous.profileNames && previous.catalogVersion == snapshot.catalogVersion) {
+        snapshot.profileNames = previous.profileNames;
+    } else {
+        snapshot.profileNames = std::make_shared<const std::vector<std::wstring>>(GetProfileCatalogNamesInternal());
+    }
+}
+
+// ======================================================================
+// PUBLIC API FUNCTIONS (SAFE MUTEX USAGE)
+// ======================================================================
+
+// PUBLIC wrapper functions (for external API compatibility)
+void UpdateActivationHistory(const std::wstring& profileName) {
     {
         std::lock_guard<std::mutex> lock(appProfilesMutex);
-        
-        for (auto& profile : appColorProfiles) {
-            profile.isAppRunning = IsAppRunning(profile.appName);
-        }
-    } // Mutex released here
-    
-    // Phase 2: Determine and apply the best active profile
-    UpdateAndApplyActiveProfile();
+        UpdateActivationHistoryInternal(profileName);
+    }
+    ScheduleActivationHistoryWrite();
 }
 
-// Get thread-safe copy of app color profiles
-std::vector<AppColorProfile> GetAppColorProfilesCopy() {
-    std::lock_guard<std::mutex> lock(appProfilesMutex);
-    return appColorProfiles;
+void CleanupActivationHistory() {
+    {
+        std::lock_guard<std::mutex> lock(appProfilesMutex);
+        CleanupActivationHistoryInternal();
+    }
+    ScheduleActivationHistoryWrite();
 }
 
-// Get the currently displayed profile (the one controlling colors)
-AppColorProfile* GetDisplayedProfile() {
-    std::lock_guard<std::mutex> lock(appProfilesMutex);
-    return GetDisplayedProfileInternal();
+// Add an app color profile with lock keys feature control
+void AddAppColorProfile(const std::wstring& appName, COLORREF color, bool lockKeysEnabled) {
+    ProfileEvent event;
+    event.type = ProfileEventType::ProfileAdded;
+    event.appName = appName;
+    event.color = color;
+    event.value = lockKeysEnabled ? 1 : 0;
+    event.isAppRunning = IsAppRunning(appName);
+    SendProfileEvent(std::move(event));
 }
 
-// Get app profile by name
-AppColorProfile* GetAppProfileByName(const std::wstring& appName) {
-    std::lock_guard<std::mutex> lock(appProfilesMutex);
-    return FindProfileByNameInternal(appName);
+// Remove an app color profile
+void RemoveAppColorProfile(const std::wstring& appName) {
+    ProfileEvent event;
+    event.type = ProfileEventType::ProfileRemoved;
+    event.appName = appName;
+    SendProfileEvent(std::move(event));
 }
 
-// Internal version that assumes mutex is already locked (DEPRECATED - use GetDisplayedProfileInternal)
-AppColorProfile* GetDisplayedProfileUnsafe() {
-    return GetDisplayedProfileInternal();
+// Resolve the running flags of all profiles from one process snapshot and update colors immediately
+void CheckRunningAppsAndUpdateColors(const std::vector<std::wstring>& visibleProcesses) {
+    ProfileEvent event;
+    event.type = ProfileEventType::RunningAppsScanned;
+    event.names = visibleProcesses;
+    SendProfileEvent(std::move(event));
 }
 
-// Enhanced: Get the activation history for debugging/UI purposes
-std::vector<std::wstring> GetActivationHistory() {
+// Get thread-safe copy of the app color profiles in memory (not every stored profile - see GetAppProfileNames)
+std::vector<AppColorProfile> GetAppColorProfilesCopy() {
     std::lock_guard<std::mutex> lock(appProfilesMutex);
-    return std::vector<std::wstring>(activationHistory.begin(), activationHistory.end());
+    std::vector<AppColorProfile> profiles;
+    profiles.reserve(appColorProfiles.size());
+    for (const auto& profile : appColorProfiles) {
+        profiles.push_back(*profile);
+    }
+    return profiles;
 }
 
-// Generic function to update any color property of an app profile
-void UpdateAppProfileColorProperty(const std::wstring& appName, COLORREF newColor, ColorUpdateType colorType) {
-    AppColorProfile* activeProfile = nullptr;
-    
-    // Phase 1: Update profile under lock
-    {
-        std::lock_guard<std::mutex> lock(appProfilesMutex);
-        
-        AppColorProfile* profile = FindProfileByNameInternal(appName);
-        if (profile) {
-            // Update the appropriate color property
-            switch (colorType) {
-                case ColorUpdateType::AppColor:
-                    profile->appColor = newColor;
-                    break;
-                case ColorUpdateType::HighlightColor:
-                    profile->appHighlightColor = newColor;
-                    break;
-                case ColorUpdateType::ActionColor:
-                    profile->appActionColor = newColor;
-                    break;
-            }
-            
-            // If this profile is currently displayed, we need to update colors
-            if (profile->isProfileCurrInUse) {
-                activeProfile = profile;
-            }
-        }
-    } // Mutex released here
-    
-    // Phase 2: Apply colors without holding mutex
-    if (activeProfile) {
-        // Apply different update strategies based on color type
-        switch (colorType) {
-            case ColorUpdateType::AppColor:
-                // App color changes require full profile color reapplication
-                ApplyProfileColorsInternal(activeProfile);
-                break;
-            case ColorUpdateType::HighlightColor:
-                // Only update highlight keys
-                SetHighlightKeysColorWithProfile(activeProfile);
-                break;
-            case ColorUpdateType::ActionColor:
-                // Only update action keys
-                SetActionKeysColorWithProfile(activeProfile);
-                break;
-        }
+// Get the names of all stored profiles, sorted case-insensitively
+// Read from the published snapshot without locking while it is current; the catalog also
+// changes outside the engine (loading the store), so a stale list falls back to the lock
+std::vector<std::wstring> GetAppProfileNames() {
+    std::shared_ptr<const ProfileStateSnapshot> snapshot = GetProfileStateSnapshot();
+    if (snapshot->profileNames && snapshot->catalogVersion == GetProfileCatalogVersion()) {
+        return *snapshot->profileNames;
     }
+    std::lock_guard<std::mutex> lock(appProfilesMutex);
+    return GetProfileCatalogNamesInternal();
 }
 
-// ======================================================================
-// GENERIC APP PROFILE UPDATE FUNCTION
-// ======================================================================
-
-// Enum to specify which property to update
-enum class ProfileUpdateType {
-    LockKeysEnabled,
-    HighlightKeys,
-    ActionKeys
-};
-
-void UpdateAppProfileProperty(const std::wstring& appName, bool value) {
-    AppColorProfile* activeProfile = nullptr;
+// Get the name of the currently displayed profile (empty if none)
+std::wstring GetDisplayedProfileName() {
+    std::shared_ptr<const ProfileStateSnapshot> snapshot = GetProfileStateSnapshot();
+    return snapshot->hasDisplayedProfile ? snapshot->displayedFrame.appName : std::wstring();
+}
 
-    // Phase 1: Update profile under lock
-    {
-        std::lock_guard<std::mutex> lock(appProfilesMutex);
+// Check whether a profile is stored for the app (does not load it)
+bool AppProfileExists(const std::wstring& appName) {
+    std::lock_guard<std::mutex> lock(appProfilesMutex);
+    return ProfileExistsInternal(appName);
+}
 
-        AppColorProfile* profile = FindProfileByNameInternal(appName);
-        if (profile) {
-            profile->lockKeysEnabled = value;
+// Get a copy of a stored profile; profiles not in memory are read from storage without being materialized
+bool GetAppProfileCopy(const std::wstring& appName, AppColorProfile& profile) {
+    std::lock_guard<std::mutex> lock(appProfilesMutex);
 
-            if (profile->isProfileCurrInUse) {
-                activeProfile = profile;
-            }
-        }
-    } // Mutex released here
+    AppColorProfile* materialized = FindMaterializedProfileInternal(appName);
+    if (materialized) {
+        profile = *materialized;
+        return true;
+    }
+    std::wstring storedName = GetStoredProfileNameInternal(appName);
+    return !storedName.empty() && LoadAppProfileFromStore(storedName, profile);
+}
 
-    // Phase 2: Apply changes without holding mutex
-    if (activeProfile) {
-        ApplyProfileColorsInternal(activeProfile);
+// Get the flattened frame of the currently displayed profile (the one controlling colors)
+// Reads the engine's published snapshot without locking; the returned pointer owns a
+// reference to that snapshot, so the frame stays valid for as long as the caller holds it
+std::shared_ptr<const AppColorProfile> GetDisplayedProfile() {
+    std::shared_ptr<const ProfileStateSnapshot> snapshot = GetProfileStateSnapshot();
+    if (!snapshot->hasDisplayedProfile) {
+        return nullptr;
     }
+    return std::shared_ptr<const AppColorProfile>(snapshot, &snapshot->displayedFrame);
 }
 
-void UpdateAppProfileProperty(const std::wstring& appName, const std::vector<LogiLed::KeyName>& value, ProfileUpdateType updateType) {
-    AppColorProfile* activeProfile = nullptr;
+// Copy the flattened frame of an app profile by name (effective colors and keys)
+// The cached frame may be rebuilt once the lock is released, so it is only ever handed out by value
+bool GetResolvedAppProfileCopy(const std::wstring& appName, AppColorProfile& frame) {
+    std::lock_guard<std::mutex> lock(appProfilesMutex);
 
-    // Phase 1: Update profile under lock
-    {
-        std::lock_guard<std::mutex> lock(appProfilesMutex);
+    AppColorProfile* resolved = ResolveProfileInternal(FindProfileByNameInternal(appName));
+    if (!resolved) {
+        return false;
+    }
+    frame = *resolved;
+    return true;
+}
 
-        AppColorProfile* profile = FindProfileByNameInternal(appName);
-        if (profile) {
-            switch (updateType) {
-            case ProfileUpdateType::HighlightKeys:
-                profile->highlightKeys = value;
-                // Remove any keys that are now in highlightKeys from actionKeys to prevent conflicts
-                RemoveKeysFromListInternal(profile->actionKeys, value);
-                break;
-            case ProfileUpdateType::ActionKeys:
-                profile->actionKeys = value;
-                // Remove any keys that are now in actionKeys from highlightKeys to prevent conflicts
-                RemoveKeysFromListInternal(profile->highlightKeys, value);
-                break;
-            }
+// Enhanced: Get the activation history for debugging/UI purposes
+std::vector<std::wstring> GetActivationHistory() {
+    std::lock_guard<std::mutex> lock(appProfilesMutex);
+    return GetActivationHistoryNamesInternal();
+}
 
-            if (profile->isProfileCurrInUse) {
-                activeProfile = profile;
-            }
-        }
-    } // Mutex released here
+// Helper function to build an event that changes one field of a profile
+static ProfileEvent MakeProfileFieldEvent(const std::wstring& appName, DWORD field) {
+    ProfileEvent event;
+    event.type = ProfileEventType::ProfileFieldChanged;
+    event.appName = appName;
+    event.field = field;
+    return event;
+}
 
-    // Phase 2: Apply changes without holding mutex
-    if (activeProfile) {
-        ApplyProfileColorsInternal(activeProfile);
+// Generic function to update any color property of an app profile
+void UpdateAppProfileColorProperty(const std::wstring& appName, COLORREF newColor, ColorUpdateType colorType) {
+    DWORD field = PROFILE_FIELD_APP_COLOR;
+    switch (colorType) {
+        case ColorUpdateType::AppColor:
+            field = PROFILE_FIELD_APP_COLOR;
+            break;
+        case ColorUpdateType::HighlightColor:
+            field = PROFILE_FIELD_HIGHLIGHT_COLOR;
+            break;
+        case ColorUpdateType::ActionColor:
+            field = PROFILE_FIELD_ACTION_COLOR;
+            break;
     }
+
+    ProfileEvent event = MakeProfileFieldEvent(appName, field);
+    event.color = newColor;
+    SendProfileEvent(std::move(event));
 }
 
+// ======================================================================
+// GENERIC APP PROFILE UPDATE FUNCTIONS
+// ======================================================================
+
 void UpdateAppProfileLockKeysEnabled(const std::wstring& appName, bool lockKeysEnabled) {
-    UpdateAppProfileProperty(appName, lockKeysEnabled);
+    ProfileEvent event = MakeProfileFieldEvent(appName, PROFILE_FIELD_LOCK_KEYS_ENABLED);
+    event.value = lockKeysEnabled ? 1 : 0;
+    SendProfileEvent(std::move(event));
 }
 
 void UpdateAppProfileHighlightKeys(const std::wstring& appName, const std::vector<LogiLed::KeyName>& highlightKeys) {
-    UpdateAppProfileProperty(appName, highlightKeys, ProfileUpdateType::HighlightKeys);
+    ProfileEvent event = MakeProfileFieldEvent(appName, PROFILE_FIELD_HIGHLIGHT_KEYS);
+    event.keys = highlightKeys;
+    SendProfileEvent(std::move(event));
 }
 
 void UpdateAppProfileActionKeys(const std::wstring& appName, const std::vector<LogiLed::KeyName>& actionKeys) {
-    UpdateAppProfileProperty(appName, actionKeys, ProfileUpdateType::ActionKeys);
+    ProfileEvent event = MakeProfileFieldEvent(appName, PROFILE_FIELD_ACTION_KEYS);
+    event.keys = actionKeys;
+    SendProfileEvent(std::move(event));
 }
 
-// Message handlers for app monitoring
-void HandleAppStarted(const std::wstring& appName) {
-    bool changed = false;
-    
-    // Phase 1: Update profile state under lock
-    {
-        std::lock_guard<std::mutex> lock(appProfilesMutex);
-        
-        AppColorProfile* profile = FindProfileByNameInternal(appName);
-        if (profile) {
-            if (!profile->isAppRunning) {
-                profile->isAppRunning = true;
-                changed = true;
-            }
-            // Move to the front of the activation history regardless of running state
-            UpdateActivationHistoryInternal(profile->appName);
-        }
-    } // Mutex released here
-    
-    // Phase 2: Update colors and UI if the state changed
-    if (changed) {
-        UpdateAndApplyActiveProfile();
-    }
+void UpdateAppProfileKeyEffect(const std::wstring& appName, DWORD keyEffect) {
+    ProfileEvent event = MakeProfileFieldEvent(appName, PROFILE_FIELD_KEY_EFFECT);
+    event.value = keyEffect;
+    SendProfileEvent(std::move(event));
+}
+
+void UpdateAppProfileModifierLayer(const std::wstring& appName, DWORD modifierLayer, COLORREF modifierColor) {
+    ProfileEvent event = MakeProfileFieldEvent(appName, PROFILE_FIELD_MODIFIER_LAYER);
+    event.value = modifierLayer;
+    event.color = modifierColor;
+    SendProfileEvent(std::move(event));
+}
+
+// Set the parent template of a profile (empty parentName makes it standalone again)
+// Returns false if the parent would create an inheritance loop or the profile does not exist
+bool UpdateAppProfileInheritance(const std::wstring& appName, const std::wstring& parentName, DWORD overrideMask) {
+    ProfileEvent event;
+    event.type = ProfileEventType::ProfileParentChanged;
+    event.appName = appName;
+    event.parentName = parentName;
+    event.value = overrideMask;
+    return SendProfileEvent(std::move(event));
+}
+
+// Add or replace many profiles in one engine event (bulk import)
+// visibleProcesses comes from one ScanRunningProcesses call for the whole batch
+void ImportAppColorProfiles(std::vector<AppColorProfile> profiles, const std::vector<std::wstring>& visibleProcesses) {
+    ProfileEvent event;
+    event.type = ProfileEventType::ProfilesImported;
+    event.profiles = std::move(profiles);
+    event.names = visibleProcesses;
+    SendProfileEvent(std::move(event));
+}
+
+// Message handlers for app monitoring (called on the app monitor thread - never blocks)
+void HandleAppStarted(const std::wstring& appName, const LatencyTrace& trace) {
+    ProfileEvent event;
+    event.type = ProfileEventType::AppStarted;
+    event.appName = appName;
+    event.trace = trace;
+    PostProfileEvent(std::move(event));
 }
 
 void HandleAppStopped(const std::wstring& appName) {
-    bool changed = false;
-    
-    // Phase 1: Update profile state under lock
-    {
-        std::lock_guard<std::mutex> lock(appProfilesMutex);
-        
-        AppColorProfile* profile = FindProfileByNameInternal(appName);
-        if (profile) {
-            changed = true;
-			// Remove from activation history
-			RemoveFromActivationHistoryInternal(profile->appName);
-            if (profile->isAppRunning) {
-                profile->isAppRunning = false;
-#ifdef ENABLE_DEBUG_LOGGING
-                std::wstringstream debugMsg;
-                debugMsg << L"[DEBUG] Profile " << profile->appName << L" - isAppRunning changed to FALSE (HandleAppStopped)\n";
-                OutputDebugStringW(debugMsg.str().c_str());
-#endif
-			}
-        }
-    } // Mutex released here
-    
-    // Phase 2: Update colors and UI if the state changed
-    if (changed) {
-        UpdateAndApplyActiveProfile();
-    }
-}
\ No newline at end of file
+    ProfileEvent event;
+    event.type = ProfileEventType::AppStopped;
+    event.appName = appName;
+    PostProfileEvent(std::move(event));
+}
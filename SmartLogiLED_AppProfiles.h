@@ -5,6 +5,8 @@
 
 #include "framework.h"
 #include "SmartLogiLED_Types.h"
+#include "SmartLogiLED_LatencyTrace.h"
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -18,10 +20,14 @@ enum class ColorUpdateType {
 // App profile management functions
 void AddAppColorProfile(const std::wstring& appName, COLORREF color, bool lockKeysEnabled);
 void RemoveAppColorProfile(const std::wstring& appName);
-void CheckRunningAppsAndUpdateColors();
-std::vector<AppColorProfile> GetAppColorProfilesCopy();
-AppColorProfile* GetDisplayedProfile();
-AppColorProfile* GetAppProfileByName(const std::wstring& appName);
+void CheckRunningAppsAndUpdateColors(const std::vector<std::wstring>& visibleProcesses); // From ScanRunningProcesses
+std::vector<AppColorProfile> GetAppColorProfilesCopy(); // Profiles in memory only
+std::vector<std::wstring> GetAppProfileNames();         // All stored profiles
+std::wstring GetDisplayedProfileName();
+bool AppProfileExists(const std::wstring& appName);
+bool GetAppProfileCopy(const std::wstring& appName, AppColorProfile& profile);
+std::shared_ptr<const AppColorProfile> GetDisplayedProfile(); // Keeps the published snapshot alive while held
+bool GetResolvedAppProfileCopy(const std::wstring& appName, AppColorProfile& frame); // Flattened frame including inherited fields
 
 // Generic function to update any color property of an app profile
 void UpdateAppProfileColorProperty(const std::wstring& appName, COLORREF newColor, ColorUpdateType colorType);
@@ -31,24 +37,33 @@ void UpdateAppProfileColorProperty(const std::wstring& appName, COLORREF newColo
 void UpdateAppProfileLockKeysEnabled(const std::wstring& appName, bool lockKeysEnabled);
 void UpdateAppProfileHighlightKeys(const std::wstring& appName, const std::vector<LogiLed::KeyName>& highlightKeys);
 void UpdateAppProfileActionKeys(const std::wstring& appName, const std::vector<LogiLed::KeyName>& actionKeys);
+void UpdateAppProfileKeyEffect(const std::wstring& appName, DWORD keyEffect); // KEY_EFFECT_*
+void UpdateAppProfileModifierLayer(const std::wstring& appName, DWORD modifierLayer, COLORREF modifierColor); // MODIFIER_LAYER_*
 
-// Message handlers for app monitoring
-void HandleAppStarted(const std::wstring& appName);
+// Profile inheritance (parent template + PROFILE_FIELD_* override mask)
+bool UpdateAppProfileInheritance(const std::wstring& appName, const std::wstring& parentName, DWORD overrideMask);
+
+// Bulk import: add or replace profiles in one step (parents may be in the same batch; a parent
+// that would create an inheritance loop leaves the profile standalone)
+void ImportAppColorProfiles(std::vector<AppColorProfile> profiles, const std::vector<std::wstring>& visibleProcesses);
+
+// Message handlers for app monitoring (queue an event for the profile engine and return immediately)
+void HandleAppStarted(const std::wstring& appName, const LatencyTrace& trace = LatencyTrace());
 void HandleAppStopped(const std::wstring& appName);
 
+// Push the colors requested by the profile engine to the keyboard (UI thread, WM_APPLY_PROFILE_FRAME)
+void ApplyPendingProfileColors();
+void ApplyDisplayedProfileColors(); // Full frame of the displayed profile (UI thread)
+
 // Activation history functions
 std::vector<std::wstring> GetActivationHistory();
 
 // Public API functions (for external compatibility)
 void UpdateActivationHistory(const std::wstring& profileName);
-AppColorProfile* FindBestFallbackProfile(const std::wstring& excludeProfile = L"");
 void CleanupActivationHistory();
 
 // Window handle management for app profiles
 void SetAppProfileMainWindowHandle(HWND hWnd);
 
 // Helper functions
-COLORREF GetDefaultColor();
-
-// DEPRECATED functions (for backward compatibility - will be removed in future versions)
-AppColorProfile* GetDisplayedProfileUnsafe(); // Use GetDisplayedProfile() instead
\ No newline at end of file
+COLORREF GetDefaultColor();
\ No newline at end of file
@@ -2,331 +2,608 @@
 #include "SmartLogiLED_KeyMapping.h"
 #include "SmartLogiLED_AppProfiles.h"
 #include "SmartLogiLED_ProcessMonitor.h"
+#include "SmartLogiLED_ProfileInheritance.h"
+#include "SmartLogiLED_ProfileCatalog.h"
+#include "SmartLogiLED_ActivationHistory.h"
+#include "SmartLogiLED_ProfileStore.h"
+#include "SmartLogiLED_ProfilePack.h"
+#include "SmartLogiLED_PersistenceWorker.h"
+#include "SmartLogiLED_Platform.h"
+#include "SmartLogiLED_IniFiles.h"
+#include "SmartLogiLED_ConfigBackend.h"
 #include "LogitechLEDLib.h"
 #include "Resource.h"
 #include <windows.h>
 #include <string>
 #include <vector>
+#include <memory>
+#include <unordered_set>
 #include <algorithm>
 #include <sstream>
 #include <iomanip>
 #include <shlobj.h>
+#include <shellapi.h>
 
 // ======================================================================
-// REGISTRY FUNCTIONS FOR START MINIMIZED SETTING
+// CONFIGURATION BACKEND SELECTION
 // ======================================================================
 
-// Registry functions for start minimized setting
-void SaveStartMinimizedSetting(bool minimized) {
-    HKEY hKey;
-    LONG result = RegCreateKeyExW(HKEY_CURRENT_USER, SMARTLOGILED_REGISTRY_ROOT, 0, NULL, 
-                                REG_OPTION_NON_VOLATILE, KEY_WRITE, NULL, &hKey, NULL);
-    if (result == ERROR_SUCCESS) {
-        DWORD value = minimized ? 1 : 0;
-        RegSetValueExW(hKey, REGISTRY_VALUE_START_MINIMIZED, 0, REG_DWORD, 
-                     (const BYTE*)&value, sizeof(value));
-        RegCloseKey(hKey);
+// True if one command line argument is exactly the given switch (a path merely containing it does not count)
+static bool HasCommandLineSwitch(LPCWSTR commandLine, LPCWSTR switchName) {
+    int argumentCount = 0;
+    LPWSTR* arguments = (commandLine && *commandLine) ? CommandLineToArgvW(commandLine, &argumentCount) : nullptr;
+    if (!arguments) {
+        return false;
+    }
+    bool found = false;
+    for (int index = 0; index < argumentCount && !found; ++index) {
+        found = _wcsicmp(arguments[index], switchName) == 0;
+    }
+    LocalFree(arguments);
+    return found;
+}
+
+// Choose where settings and profiles are kept: "/portable" on the command line, or a settings
+// file next to the executable, selects the file backend; otherwise the registry is used
+void SelectConfigBackend(LPCWSTR commandLine) {
+    std::wstring appDir = GetApplicationDirectory();
+    bool portable = HasCommandLineSwitch(commandLine, L"/portable") ||
+                    (!appDir.empty() && FileExists(appDir + L"\\" + CONFIG_SETTINGS_FILE_NAME));
+    if (portable && !appDir.empty()) {
+        SetConfigBackend(CreateFileConfigBackend(appDir));
+    } else {
+        SetConfigBackend(CreateRegistryConfigBackend());
     }
+    
+#ifdef ENABLE_DEBUG_LOGGING
+    std::wstringstream debugMsg;
+    debugMsg << L"[DEBUG] Configuration backend: " << GetConfigBackend().GetName() << L"\n";
+    OutputDebugStringW(debugMsg.str().c_str());
+#endif
+}
+
+// ======================================================================
+// START MINIMIZED SETTING
+// ======================================================================
+
+void SaveStartMinimizedSetting(bool minimized) {
+    GetConfigBackend().WriteNumber(REGISTRY_VALUE_START_MINIMIZED, minimized ? 1 : 0);
 }
 
 bool LoadStartMinimizedSetting() {
-    HKEY hKey;
-    LONG result = RegOpenKeyExW(HKEY_CURRENT_USER, SMARTLOGILED_REGISTRY_ROOT, 0, KEY_READ, &hKey);
-    if (result == ERROR_SUCCESS) {
-        DWORD value = 0;
-        DWORD size = sizeof(value);
-        DWORD type = REG_DWORD;
-        if (RegQueryValueExW(hKey, REGISTRY_VALUE_START_MINIMIZED, NULL, &type, 
-                           (BYTE*)&value, &size) == ERROR_SUCCESS) {
-            RegCloseKey(hKey);
-            return value != 0;
-        }
-        RegCloseKey(hKey);
-    }
-    return false; // Default to false if setting doesn't exist
-}
-
-// Registry functions for color settings
-void SaveColorToRegistry(LPCWSTR valueName, COLORREF color) {
-    HKEY hKey;
-    LONG result = RegCreateKeyExW(HKEY_CURRENT_USER, SMARTLOGILED_REGISTRY_ROOT, 0, NULL, 
-                                REG_OPTION_NON_VOLATILE, KEY_WRITE, NULL, &hKey, NULL);
-    if (result == ERROR_SUCCESS) {
-        DWORD colorValue = (DWORD)color;
-        RegSetValueExW(hKey, valueName, 0, REG_DWORD, 
-                     (const BYTE*)&colorValue, sizeof(colorValue));
-        RegCloseKey(hKey);
-    }
-}
-
-COLORREF LoadColorFromRegistry(LPCWSTR valueName, COLORREF defaultValue) {
-    HKEY hKey;
-    LONG result = RegOpenKeyExW(HKEY_CURRENT_USER, SMARTLOGILED_REGISTRY_ROOT, 0, KEY_READ, &hKey);
-    if (result == ERROR_SUCCESS) {
-        DWORD colorValue = 0;
-        DWORD size = sizeof(colorValue);
-        DWORD type = REG_DWORD;
-        if (RegQueryValueExW(hKey, valueName, NULL, &type, 
-                           (BYTE*)&colorValue, &size) == ERROR_SUCCESS) {
-            RegCloseKey(hKey);
-            return (COLORREF)colorValue;
-        }
-        RegCloseKey(hKey);
+    uint32_t value = 0;
+    return GetConfigBackend().ReadNumber(REGISTRY_VALUE_START_MINIMIZED, value) && value != 0; // Default to false if setting doesn't exist
+}
+
+// ======================================================================
+// TYPING HEATMAP SETTING
+// ======================================================================
+
+void SaveHeatmapModeSetting(bool enabled) {
+    GetConfigBackend().WriteNumber(REGISTRY_VALUE_HEATMAP_MODE, enabled ? 1 : 0);
+}
+
+bool LoadHeatmapModeSetting() {
+    uint32_t value = 0;
+    return GetConfigBackend().ReadNumber(REGISTRY_VALUE_HEATMAP_MODE, value) && value != 0; // Off by default
+}
+
+// ======================================================================
+// COLOR SETTINGS
+// ======================================================================
+
+void SaveColorToConfig(LPCWSTR valueName, COLORREF color) {
+    GetConfigBackend().WriteNumber(valueName, static_cast<uint32_t>(color));
+}
+
+COLORREF LoadColorFromConfig(LPCWSTR valueName, COLORREF defaultValue) {
+    uint32_t colorValue = 0;
+    if (GetConfigBackend().ReadNumber(valueName, colorValue)) {
+        return static_cast<COLORREF>(colorValue);
     }
     return defaultValue; // Return default if setting doesn't exist
 }
 
-// Save color settings to registry
-void SaveLockKeyColorsToRegistry() {
+// Save lock key color settings
+void SaveLockKeyColorsToConfig() {
     extern COLORREF numLockColor;
     extern COLORREF capsLockColor;
     extern COLORREF scrollLockColor;
     extern COLORREF defaultColor;
-    SaveColorToRegistry(REGISTRY_VALUE_NUMLOCK_COLOR, numLockColor);
-    SaveColorToRegistry(REGISTRY_VALUE_CAPSLOCK_COLOR, capsLockColor);
-    SaveColorToRegistry(REGISTRY_VALUE_SCROLLLOCK_COLOR, scrollLockColor);
-    SaveColorToRegistry(REGISTRY_VALUE_DEFAULT_COLOR, defaultColor);
+    SaveColorToConfig(REGISTRY_VALUE_NUMLOCK_COLOR, numLockColor);
+    SaveColorToConfig(REGISTRY_VALUE_CAPSLOCK_COLOR, capsLockColor);
+    SaveColorToConfig(REGISTRY_VALUE_SCROLLLOCK_COLOR, scrollLockColor);
+    SaveColorToConfig(REGISTRY_VALUE_DEFAULT_COLOR, defaultColor);
 }
 
-// Load color settings from registry
-void LoadLockKeyColorsFromRegistry() {
+// Load lock key color settings
+void LoadLockKeyColorsFromConfig() {
     extern COLORREF numLockColor;
     extern COLORREF capsLockColor;
     extern COLORREF scrollLockColor;
     extern COLORREF defaultColor;
-    numLockColor = LoadColorFromRegistry(REGISTRY_VALUE_NUMLOCK_COLOR, RGB(0, 179, 0));
-    capsLockColor = LoadColorFromRegistry(REGISTRY_VALUE_CAPSLOCK_COLOR, RGB(0, 179, 0));
-    scrollLockColor = LoadColorFromRegistry(REGISTRY_VALUE_SCROLLLOCK_COLOR, RGB(0, 179, 0));
-    defaultColor = LoadColorFromRegistry(REGISTRY_VALUE_DEFAULT_COLOR, RGB(0, 89, 89));
+    numLockColor = LoadColorFromConfig(REGISTRY_VALUE_NUMLOCK_COLOR, RGB(0, 179, 0));
+    capsLockColor = LoadColorFromConfig(REGISTRY_VALUE_CAPSLOCK_COLOR, RGB(0, 179, 0));
+    scrollLockColor = LoadColorFromConfig(REGISTRY_VALUE_SCROLLLOCK_COLOR, RGB(0, 179, 0));
+    defaultColor = LoadColorFromConfig(REGISTRY_VALUE_DEFAULT_COLOR, RGB(0, 89, 89));
 }
 
-// App profiles registry persistence
+// App profiles persistence
 #include <mutex>
-extern std::vector<AppColorProfile> appColorProfiles;
+extern std::vector<std::unique_ptr<AppColorProfile>> appColorProfiles;
+void ResetProfileLibraryInternal(const std::vector<std::wstring>& storedNames);
 extern std::mutex appProfilesMutex;
 
-void AddAppProfileToRegistry(const AppColorProfile& profile) {
-    HKEY hProfilesKey = nullptr;
-    if (RegCreateKeyExW(HKEY_CURRENT_USER, SMARTLOGILED_REGISTRY_PROFILES, 0, NULL,
-                        REG_OPTION_NON_VOLATILE, KEY_WRITE, NULL, &hProfilesKey, NULL) != ERROR_SUCCESS) {
-        return;
+// ======================================================================
+// PROFILE STORE (BINARY PROFILE FILE)
+// ======================================================================
+
+// Convert between the in-memory profile and its stored form
+static StoredProfile ToStoredProfile(const AppColorProfile& profile) {
+    StoredProfile stored;
+    stored.appName = profile.appName;
+    stored.parentName = profile.parentName;
+    stored.appColor = static_cast<uint32_t>(profile.appColor);
+    stored.highlightColor = static_cast<uint32_t>(profile.appHighlightColor);
+    stored.actionColor = static_cast<uint32_t>(profile.appActionColor);
+    stored.overrideMask = profile.parentName.empty() ? PROFILE_FIELD_ALL : profile.overrideMask;
+    stored.lockKeysEnabled = profile.lockKeysEnabled;
+    stored.keyEffect = profile.keyEffect;
+    stored.modifierLayer = profile.modifierLayer;
+    stored.modifierColor = static_cast<uint32_t>(profile.appModifierColor);
+    stored.highlightKeys.assign(profile.highlightKeys.begin(), profile.highlightKeys.end());
+    stored.actionKeys.assign(profile.actionKeys.begin(), profile.actionKeys.end());
+    return stored;
+}
+
+static void FromStoredProfile(const StoredProfile& stored, AppColorProfile& profile) {
+    profile = AppColorProfile();
+    profile.appName = stored.appName;
+    profile.parentName = stored.parentName;
+    profile.appColor = static_cast<COLORREF>(stored.appColor);
+    profile.appHighlightColor = static_cast<COLORREF>(stored.highlightColor);
+    profile.appActionColor = static_cast<COLORREF>(stored.actionColor);
+    profile.overrideMask = stored.parentName.empty() ? PROFILE_FIELD_ALL : (stored.overrideMask & PROFILE_FIELD_ALL);
+    profile.lockKeysEnabled = stored.lockKeysEnabled;
+    profile.keyEffect = stored.keyEffect < KEY_EFFECT_COUNT ? stored.keyEffect : KEY_EFFECT_NONE;
+    profile.modifierLayer = stored.modifierLayer & MODIFIER_LAYER_ALL;
+    profile.appModifierColor = static_cast<COLORREF>(stored.modifierColor);
+    
+    // Key lists inherited from a parent template are not loaded - they come from the parent when the profile is flattened
+    if (profile.overrideMask & PROFILE_FIELD_HIGHLIGHT_KEYS) {
+        profile.highlightKeys.reserve(stored.highlightKeys.size());
+        for (uint32_t k : stored.highlightKeys) profile.highlightKeys.push_back(static_cast<LogiLed::KeyName>(k));
+    }
+    if (profile.overrideMask & PROFILE_FIELD_ACTION_KEYS) {
+        profile.actionKeys.reserve(stored.actionKeys.size());
+        for (uint32_t k : stored.actionKeys) profile.actionKeys.push_back(static_cast<LogiLed::KeyName>(k));
+    }
+}
+
+// Location of the profile store file (chosen by the configuration backend)
+std::wstring GetProfileStorePath() {
+    return GetConfigBackend().GetProfileStorePath();
+}
+
+// Location of the profile pack (next to the profile store file)
+std::wstring GetProfilePackPath() {
+    std::wstring storePath = GetProfileStorePath();
+    size_t separator = storePath.find_last_of(L"\\/");
+    return (separator == std::wstring::npos ? std::wstring() : storePath.substr(0, separator + 1)) + PROFILE_PACK_FILE_NAME;
+}
+
+void AddAppProfileToStore(const AppColorProfile& profile) {
+    if (PutStoredProfile(ToStoredProfile(profile))) {
+        SchedulePendingProfileWrite();
+    }
+}
+
+// Put many profiles into the store and schedule a single write for all of them
+void AddAppProfilesToStore(const std::vector<AppColorProfile>& profiles) {
+    size_t changedCount = 0;
+    for (const auto& profile : profiles) {
+        if (PutStoredProfile(ToStoredProfile(profile))) {
+            ++changedCount;
+        }
+    }
+    if (changedCount > 0) {
+        SchedulePendingProfileWrite();
+    }
+}
+
+void RemoveAppProfileFromStore(const std::wstring& appName) {
+    if (RemoveStoredProfile(appName)) {
+        SchedulePendingProfileWrite();
+    }
+}
+
+// Case-insensitive key of a profile name
+static std::wstring ToLowerProfileName(const std::wstring& name) {
+    std::wstring lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::towlower);
+    return lower;
+}
+
+// Keep the stored values of inherited fields (they are not loaded into memory, so they must
+// not count as changes)
+static void KeepInheritedStoredValues(const StoredProfile& existing, StoredProfile& stored) {
+    if (!(stored.overrideMask & PROFILE_FIELD_APP_COLOR)) stored.appColor = existing.appColor;
+    if (!(stored.overrideMask & PROFILE_FIELD_HIGHLIGHT_COLOR)) stored.highlightColor = existing.highlightColor;
+    if (!(stored.overrideMask & PROFILE_FIELD_ACTION_COLOR)) stored.actionColor = existing.actionColor;
+    if (!(stored.overrideMask & PROFILE_FIELD_LOCK_KEYS_ENABLED)) stored.lockKeysEnabled = existing.lockKeysEnabled;
+    if (!(stored.overrideMask & PROFILE_FIELD_HIGHLIGHT_KEYS)) stored.highlightKeys = existing.highlightKeys;
+    if (!(stored.overrideMask & PROFILE_FIELD_ACTION_KEYS)) stored.actionKeys = existing.actionKeys;
+    if (!(stored.overrideMask & PROFILE_FIELD_KEY_EFFECT)) stored.keyEffect = existing.keyEffect;
+    if (!(stored.overrideMask & PROFILE_FIELD_MODIFIER_LAYER)) {
+        stored.modifierLayer = existing.modifierLayer;
+        stored.modifierColor = existing.modifierColor;
+    }
+}
+
+// Sync the profile store with the profiles in memory: only added, changed (by content hash)
+// and removed profiles are touched, and nothing is written if the store is already up to date
+void SaveAppProfilesToStore() {
+    std::vector<StoredProfile> profiles;
+    std::unordered_set<std::wstring> catalogedNames;
+    {
+        std::lock_guard<std::mutex> lock(appProfilesMutex);
+        profiles.reserve(appColorProfiles.size());
+        for (const auto& profile : appColorProfiles) {
+            if (!profile->isPackProfile) {
+                profiles.push_back(ToStoredProfile(*profile));
+            }
+        }
+        for (const auto& name : GetProfileCatalogNamesInternal()) {
+            catalogedNames.insert(ToLowerProfileName(name));
+        }
     }
     
-    HKEY hAppKey = nullptr;
-    if (RegCreateKeyExW(hProfilesKey, profile.appName.c_str(), 0, NULL,
-                        REG_OPTION_NON_VOLATILE, KEY_WRITE, NULL, &hAppKey, NULL) == ERROR_SUCCESS) {
-        DWORD d = static_cast<DWORD>(profile.appColor);
-        RegSetValueExW(hAppKey, REGISTRY_VALUE_APP_COLOR, 0, REG_DWORD,
-                       reinterpret_cast<const BYTE*>(&d), sizeof(d));
-        d = static_cast<DWORD>(profile.appHighlightColor);
-        RegSetValueExW(hAppKey, REGISTRY_VALUE_APP_HIGHLIGHT_COLOR, 0, REG_DWORD,
-                       reinterpret_cast<const BYTE*>(&d), sizeof(d));
-        d = static_cast<DWORD>(profile.appActionColor);
-        RegSetValueExW(hAppKey, REGISTRY_VALUE_APP_ACTION_COLOR, 0, REG_DWORD,
-                       reinterpret_cast<const BYTE*>(&d), sizeof(d));
-        d = profile.lockKeysEnabled ? 1u : 0u;
-        RegSetValueExW(hAppKey, REGISTRY_VALUE_LOCK_KEYS_ENABLED, 0, REG_DWORD,
-                       reinterpret_cast<const BYTE*>(&d), sizeof(d));
-        if (!profile.highlightKeys.empty()) {
-            std::vector<DWORD> data;
-            data.reserve(profile.highlightKeys.size());
-            for (auto k : profile.highlightKeys) data.push_back(static_cast<DWORD>(k));
-            RegSetValueExW(hAppKey, REGISTRY_VALUE_HIGHLIGHT_KEYS, 0, REG_BINARY,
-                           reinterpret_cast<const BYTE*>(data.data()),
-                           static_cast<DWORD>(data.size() * sizeof(DWORD)));
-        } else {
-            RegSetValueExW(hAppKey, REGISTRY_VALUE_HIGHLIGHT_KEYS, 0, REG_BINARY, nullptr, 0);
+    // Diff against the store without holding the profile lock
+    // (profiles that are only cataloged and not in memory are left untouched)
+    size_t changedCount = 0;
+    size_t removedCount = 0;
+    for (const auto& storedName : GetStoredProfileNames()) {
+        if (catalogedNames.find(ToLowerProfileName(storedName)) == catalogedNames.end() && RemoveStoredProfile(storedName)) {
+            ++removedCount;
         }
-        
-        // Save action keys
-        if (!profile.actionKeys.empty()) {
-            std::vector<DWORD> data;
-            data.reserve(profile.actionKeys.size());
-            for (auto k : profile.actionKeys) data.push_back(static_cast<DWORD>(k));
-            RegSetValueExW(hAppKey, REGISTRY_VALUE_ACTION_KEYS, 0, REG_BINARY,
-                           reinterpret_cast<const BYTE*>(data.data()),
-                           static_cast<DWORD>(data.size() * sizeof(DWORD)));
-        } else {
-            RegSetValueExW(hAppKey, REGISTRY_VALUE_ACTION_KEYS, 0, REG_BINARY, nullptr, 0);
+    }
+    for (auto& profile : profiles) {
+        StoredProfile existing;
+        if (!profile.parentName.empty() && GetStoredProfile(profile.appName, existing)) {
+            KeepInheritedStoredValues(existing, profile);
+        }
+        if (PutStoredProfile(profile)) {
+            ++changedCount;
         }
-        
-        RegCloseKey(hAppKey);
     }
-    RegCloseKey(hProfilesKey);
+    
+#ifdef ENABLE_DEBUG_LOGGING
+    std::wstringstream debugMsg;
+    debugMsg << L"[DEBUG] Profile store sync: " << changedCount << L" added/changed, " << removedCount
+             << L" removed, " << (profiles.size() - changedCount) << L" unchanged\n";
+    OutputDebugStringW(debugMsg.str().c_str());
+#endif
+    
+    // Written by the persistence worker, never while holding the profile lock
+    if (changedCount > 0 || removedCount > 0) {
+        SchedulePendingProfileWrite();
+    }
 }
 
-void RemoveAppProfileFromRegistry(const std::wstring& appName) {
-    HKEY hProfilesKey = nullptr;
-    if (RegOpenKeyExW(HKEY_CURRENT_USER, SMARTLOGILED_REGISTRY_PROFILES, 0, KEY_WRITE, &hProfilesKey) == ERROR_SUCCESS) {
-        // Delete the subkey for this app profile
-        RegDeleteKeyW(hProfilesKey, appName.c_str());
-        RegCloseKey(hProfilesKey);
+// Read one stored profile (called on first use of the profile)
+bool LoadAppProfileFromStore(const std::wstring& appName, AppColorProfile& profile) {
+    StoredProfile stored;
+    if (!GetStoredProfile(appName, stored)) {
+        return false;
     }
+    FromStoredProfile(stored, profile);
+    return true;
 }
 
-void SaveAppProfilesToRegistry() {
-    std::lock_guard<std::mutex> lock(appProfilesMutex);
+// Read one profile from the profile pack (called on first use of a profile that is not stored)
+bool LoadAppProfileFromPack(const std::wstring& appName, AppColorProfile& profile) {
+    StoredProfile packed;
+    if (!GetPackedProfile(appName, packed)) {
+        return false;
+    }
+    FromStoredProfile(packed, profile);
+    profile.isPackProfile = true;
+    return true;
+}
+
+// Copy the profiles stored in the registry by older versions into a new profile store
+// (the registry keys are left in place, so an older version still finds its profiles)
+static void MigrateAppProfilesFromRegistry(const std::wstring& storePath) {
+    ResetProfileStore(storePath);
     
-    // First, clear all existing profiles from registry
     HKEY hProfilesKey = nullptr;
-    if (RegOpenKeyExW(HKEY_CURRENT_USER, SMARTLOGILED_REGISTRY_PROFILES, 0, KEY_READ | KEY_WRITE, &hProfilesKey) == ERROR_SUCCESS) {
-        // Enumerate and delete all existing subkeys
-        DWORD subKeyCount = 0;
-        if (RegQueryInfoKeyW(hProfilesKey, NULL, NULL, NULL, &subKeyCount, NULL, NULL, NULL, NULL, NULL, NULL, NULL) == ERROR_SUCCESS) {
-            // Collect subkey names first (since we can't delete while enumerating)
-            std::vector<std::wstring> subKeyNames;
-            for (DWORD i = 0; i < subKeyCount; ++i) {
-                wchar_t subKeyName[260];
-                DWORD nameLen = static_cast<DWORD>(std::size(subKeyName));
-                if (RegEnumKeyExW(hProfilesKey, i, subKeyName, &nameLen, NULL, NULL, NULL, NULL) == ERROR_SUCCESS) {
-                    subKeyNames.push_back(subKeyName);
-                }
-            }
-            // Now delete all the subkeys
-            for (const auto& subKeyName : subKeyNames) {
-                RegDeleteKeyW(hProfilesKey, subKeyName.c_str());
+    if (RegOpenKeyExW(HKEY_CURRENT_USER, SMARTLOGILED_REGISTRY_PROFILES, 0, KEY_READ, &hProfilesKey) == ERROR_SUCCESS) {
+        for (const auto& appName : EnumerateAppProfileNamesInRegistry(hProfilesKey)) {
+            AppColorProfile profile;
+            if (LoadAppProfileFromRegistry(appName, profile)) {
+                PutStoredProfile(ToStoredProfile(profile));
             }
         }
         RegCloseKey(hProfilesKey);
     }
     
-    // Now add all current profiles
-    for (const auto& profile : appColorProfiles) {
-        AddAppProfileToRegistry(profile);
-    }
+    // An empty store is written as well, so the registry is only scanned once
+    CommitProfileStore();
+    
+#ifdef ENABLE_DEBUG_LOGGING
+    std::wstringstream debugMsg;
+    debugMsg << L"[DEBUG] Migrated " << GetStoredProfileCount() << L" registry profiles to " << storePath << L"\n";
+    OutputDebugStringW(debugMsg.str().c_str());
+#endif
 }
 
-void LoadAppProfilesFromRegistry() {
-    std::lock_guard<std::mutex> lock(appProfilesMutex);
+// Read one profile stored in the registry by older versions (appName must be the stored key name)
+bool LoadAppProfileFromRegistry(const std::wstring& appName, AppColorProfile& profile) {
     HKEY hProfilesKey = nullptr;
     if (RegOpenKeyExW(HKEY_CURRENT_USER, SMARTLOGILED_REGISTRY_PROFILES, 0, KEY_READ, &hProfilesKey) != ERROR_SUCCESS) {
-        return;
+        return false;
+    }
+    HKEY hAppKey = nullptr;
+    if (RegOpenKeyExW(hProfilesKey, appName.c_str(), 0, KEY_READ, &hAppKey) != ERROR_SUCCESS) {
+        RegCloseKey(hProfilesKey);
+        return false;
+    }
+    
+    profile = AppColorProfile();
+    profile.appName = appName;
+    DWORD type = 0; DWORD cb = sizeof(DWORD); DWORD d = 0;
+    
+    // Load inheritance (profiles without a parent override every field)
+    wchar_t parentName[260]{};
+    DWORD parentSize = sizeof(parentName) - sizeof(wchar_t);
+    if (RegQueryValueExW(hAppKey, REGISTRY_VALUE_PARENT_PROFILE, NULL, &type, reinterpret_cast<LPBYTE>(parentName), &parentSize) == ERROR_SUCCESS && type == REG_SZ) {
+        profile.parentName = parentName;
+        d = PROFILE_FIELD_ALL; cb = sizeof(DWORD); type = 0;
+        if (RegQueryValueExW(hAppKey, REGISTRY_VALUE_OVERRIDE_MASK, NULL, &type, reinterpret_cast<LPBYTE>(&d), &cb) == ERROR_SUCCESS && type == REG_DWORD)
+            profile.overrideMask = d & PROFILE_FIELD_ALL;
+    }
+    
+    d = 0; cb = sizeof(DWORD); type = 0;
+    if (RegQueryValueExW(hAppKey, REGISTRY_VALUE_APP_COLOR, NULL, &type, reinterpret_cast<LPBYTE>(&d), &cb) == ERROR_SUCCESS && type == REG_DWORD)
+        profile.appColor = static_cast<COLORREF>(d);
+    d = 0; cb = sizeof(DWORD); type = 0;
+    if (RegQueryValueExW(hAppKey, REGISTRY_VALUE_APP_HIGHLIGHT_COLOR, NULL, &type, reinterpret_cast<LPBYTE>(&d), &cb) == ERROR_SUCCESS && type == REG_DWORD)
+        profile.appHighlightColor = static_cast<COLORREF>(d);
+    d = 0; cb = sizeof(DWORD); type = 0;
+    if (RegQueryValueExW(hAppKey, REGISTRY_VALUE_APP_ACTION_COLOR, NULL, &type, reinterpret_cast<LPBYTE>(&d), &cb) == ERROR_SUCCESS && type == REG_DWORD)
+        profile.appActionColor = static_cast<COLORREF>(d);
+    d = 1; cb = sizeof(DWORD); type = 0;
+    if (RegQueryValueExW(hAppKey, REGISTRY_VALUE_LOCK_KEYS_ENABLED, NULL, &type, reinterpret_cast<LPBYTE>(&d), &cb) == ERROR_SUCCESS && type == REG_DWORD)
+        profile.lockKeysEnabled = (d != 0);
+    
+    // Key lists inherited from a parent template are not loaded - they come from the parent when the profile is flattened
+    DWORD dataSize = 0; type = 0;
+    if ((profile.overrideMask & PROFILE_FIELD_HIGHLIGHT_KEYS) &&
+        RegQueryValueExW(hAppKey, REGISTRY_VALUE_HIGHLIGHT_KEYS, NULL, &type, NULL, &dataSize) == ERROR_SUCCESS && type == REG_BINARY && dataSize > 0) {
+        std::vector<DWORD> data(dataSize / sizeof(DWORD));
+        if (RegQueryValueExW(hAppKey, REGISTRY_VALUE_HIGHLIGHT_KEYS, NULL, &type, reinterpret_cast<LPBYTE>(data.data()), &dataSize) == ERROR_SUCCESS) {
+            profile.highlightKeys.clear();
+            profile.highlightKeys.reserve(data.size());
+            for (DWORD v : data) profile.highlightKeys.push_back(static_cast<LogiLed::KeyName>(v));
+        }
     }
-    appColorProfiles.clear();
+    
+    // Load action keys
+    dataSize = 0; type = 0;
+    if ((profile.overrideMask & PROFILE_FIELD_ACTION_KEYS) &&
+        RegQueryValueExW(hAppKey, REGISTRY_VALUE_ACTION_KEYS, NULL, &type, NULL, &dataSize) == ERROR_SUCCESS && type == REG_BINARY && dataSize > 0) {
+        std::vector<DWORD> data(dataSize / sizeof(DWORD));
+        if (RegQueryValueExW(hAppKey, REGISTRY_VALUE_ACTION_KEYS, NULL, &type, reinterpret_cast<LPBYTE>(data.data()), &dataSize) == ERROR_SUCCESS) {
+            profile.actionKeys.clear();
+            profile.actionKeys.reserve(data.size());
+            for (DWORD v : data) profile.actionKeys.push_back(static_cast<LogiLed::KeyName>(v));
+        }
+    }
+    
+    RegCloseKey(hAppKey);
+    RegCloseKey(hProfilesKey);
+    return true;
+}
+
+// Enumerate the names of all profiles stored in the registry by older versions (one subkey per profile)
+std::vector<std::wstring> EnumerateAppProfileNamesInRegistry(HKEY hProfilesKey) {
+    std::vector<std::wstring> names;
     DWORD subKeyCount = 0;
     if (RegQueryInfoKeyW(hProfilesKey, NULL, NULL, NULL, &subKeyCount, NULL, NULL, NULL, NULL, NULL, NULL, NULL) != ERROR_SUCCESS) {
-        RegCloseKey(hProfilesKey);
-        return;
+        return names;
     }
+    names.reserve(subKeyCount);
     for (DWORD i = 0; i < subKeyCount; ++i) {
         wchar_t subKeyName[260];
         DWORD nameLen = static_cast<DWORD>(std::size(subKeyName));
         if (RegEnumKeyExW(hProfilesKey, i, subKeyName, &nameLen, NULL, NULL, NULL, NULL) == ERROR_SUCCESS) {
-            HKEY hAppKey = nullptr;
-            if (RegOpenKeyExW(hProfilesKey, subKeyName, 0, KEY_READ, &hAppKey) == ERROR_SUCCESS) {
-                AppColorProfile p;
-                p.appName = subKeyName;
-                DWORD type = 0; DWORD cb = sizeof(DWORD); DWORD d = 0;
-                if (RegQueryValueExW(hAppKey, REGISTRY_VALUE_APP_COLOR, NULL, &type, reinterpret_cast<LPBYTE>(&d), &cb) == ERROR_SUCCESS && type == REG_DWORD)
-                    p.appColor = static_cast<COLORREF>(d);
-                d = 0; cb = sizeof(DWORD); type = 0;
-                if (RegQueryValueExW(hAppKey, REGISTRY_VALUE_APP_HIGHLIGHT_COLOR, NULL, &type, reinterpret_cast<LPBYTE>(&d), &cb) == ERROR_SUCCESS && type == REG_DWORD)
-                    p.appHighlightColor = static_cast<COLORREF>(d);
-                d = 0; cb = sizeof(DWORD); type = 0;
-                if (RegQueryValueExW(hAppKey, REGISTRY_VALUE_APP_ACTION_COLOR, NULL, &type, reinterpret_cast<LPBYTE>(&d), &cb) == ERROR_SUCCESS && type == REG_DWORD)
-                    p.appActionColor = static_cast<COLORREF>(d);
-                d = 1; cb = sizeof(DWORD); type = 0;
-                if (RegQueryValueExW(hAppKey, REGISTRY_VALUE_LOCK_KEYS_ENABLED, NULL, &type, reinterpret_cast<LPBYTE>(&d), &cb) == ERROR_SUCCESS && type == REG_DWORD)
-                    p.lockKeysEnabled = (d != 0);
-                DWORD dataSize = 0; type = 0;
-                if (RegQueryValueExW(hAppKey, REGISTRY_VALUE_HIGHLIGHT_KEYS, NULL, &type, NULL, &dataSize) == ERROR_SUCCESS && type == REG_BINARY && dataSize > 0) {
-                    std::vector<DWORD> data(dataSize / sizeof(DWORD));
-                    if (RegQueryValueExW(hAppKey, REGISTRY_VALUE_HIGHLIGHT_KEYS, NULL, &type, reinterpret_cast<LPBYTE>(data.data()), &dataSize) == ERROR_SUCCESS) {
-                        p.highlightKeys.clear();
-                        p.highlightKeys.reserve(data.size());
-                        for (DWORD v : data) p.highlightKeys.push_back(static_cast<LogiLed::KeyName>(v));
-                    }
-                }
-                
-                // Load action keys
-                dataSize = 0; type = 0;
-                if (RegQueryValueExW(hAppKey, REGISTRY_VALUE_ACTION_KEYS, NULL, &type, NULL, &dataSize) == ERROR_SUCCESS && type == REG_BINARY && dataSize > 0) {
-                    std::vector<DWORD> data(dataSize / sizeof(DWORD));
-                    if (RegQueryValueExW(hAppKey, REGISTRY_VALUE_ACTION_KEYS, NULL, &type, reinterpret_cast<LPBYTE>(data.data()), &dataSize) == ERROR_SUCCESS) {
-                        p.actionKeys.clear();
-                        p.actionKeys.reserve(data.size());
-                        for (DWORD v : data) p.actionKeys.push_back(static_cast<LogiLed::KeyName>(v));
-                    }
-                }
-                
-                // Initialize runtime flags properly
-                p.isAppRunning = IsAppRunning(p.appName);
-                p.isProfileCurrInUse = false; // Will be set correctly by CheckRunningAppsAndUpdateColors()
-                appColorProfiles.push_back(std::move(p));
-                RegCloseKey(hAppKey);
-            }
+            names.emplace_back(subKeyName, nameLen);
         }
     }
-    RegCloseKey(hProfilesKey);
+    return names;
+}
+
+// Rebuild a damaged store file from the backup of the last commit plus the journal. The registry
+// copy of the profiles is never used here: it stopped following edits when the store was created.
+static void RecoverDamagedProfileStore(const std::wstring& storePath) {
+    // Keep the damaged file for inspection instead of overwriting it
+    std::wstring quarantinePath = storePath + PROFILE_STORE_QUARANTINE_SUFFIX;
+    bool storeFileFound = FileExists(storePath);
+    bool quarantined = storeFileFound &&
+        MoveFileExW(storePath.c_str(), quarantinePath.c_str(), MOVEFILE_REPLACE_EXISTING);
+
+    if (RecoverProfileStore(storePath)) {
+#ifdef ENABLE_DEBUG_LOGGING
+        std::wstringstream debugMsg;
+        debugMsg << L"[DEBUG] Profile store rebuilt from " << storePath << PROFILE_STORE_BACKUP_SUFFIX
+                 << L" and its journal (" << GetStoredProfileCount() << L" profiles)\n";
+        OutputDebugStringW(debugMsg.str().c_str());
+#endif
+        return;
+    }
+
+    // Nothing to rebuild from: keep the journal next to the damaged file, then start empty
+    std::wstring journalPath = storePath + PROFILE_JOURNAL_FILE_SUFFIX;
+    if (FileExists(journalPath)) {
+        MoveFileExW(journalPath.c_str(), (journalPath + PROFILE_STORE_QUARANTINE_SUFFIX).c_str(), MOVEFILE_REPLACE_EXISTING);
+    }
+    ResetProfileStore(storePath);
+
+    std::wstring message = L"The profile store could not be read and could not be rebuilt from its backup.\n\n";
+    if (quarantined) {
+        message += L"The damaged file was moved to:\n" + quarantinePath;
+    } else if (storeFileFound) {
+        message += L"The damaged file could not be moved and will be replaced:\n" + storePath;
+    } else {
+        message += L"The store file is missing:\n" + storePath;
+    }
+    message += L"\n\nSmartLogiLED starts with no app profiles.";
+    MessageBoxW(NULL, message.c_str(), L"Profile Store", MB_OK | MB_ICONERROR);
+}
+
+// Load the profile library: the store file is parsed in one pass, but profiles are only
+// materialized when they are first needed (see FindProfileByNameInternal)
+void LoadAppProfilesFromStore() {
+#ifdef ENABLE_DEBUG_LOGGING
+    ULONGLONG loadStart = GetTickCount64();
+#endif
+    std::wstring storePath = GetProfileStorePath();
+    if (!OpenProfileStore(storePath)) {
+        if (!FileExists(storePath) && !FileExists(storePath + PROFILE_STORE_BACKUP_SUFFIX)) {
+            MigrateAppProfilesFromRegistry(storePath); // First start of a store-based version
+        } else {
+            RecoverDamagedProfileStore(storePath);
+        }
+    }
+    std::vector<std::wstring> storedNames = GetStoredProfileNames();
+    OpenProfilePack(GetProfilePackPath()); // Optional - a missing or damaged pack is ignored
+    
+    {
+        std::lock_guard<std::mutex> lock(appProfilesMutex);
+        ResetProfileLibraryInternal(storedNames);
+    }
+    
+#ifdef ENABLE_DEBUG_LOGGING
+    std::wstringstream debugMsg;
+    debugMsg << L"[DEBUG] Profile library loaded: " << storedNames.size() << L" profiles ("
+             << GetPackedProfileCount() << L" more in the profile pack) in " << (GetTickCount64() - loadStart) << L" ms\n";
+    OutputDebugStringW(debugMsg.str().c_str());
+#endif
 }
 
 size_t GetAppProfilesCount() {
     std::lock_guard<std::mutex> lock(appProfilesMutex);
-    return appColorProfiles.size();
+    return GetProfileCatalogSizeInternal();
 }
 
-// Generic helper function to update DWORD values in app profile registry
-static void UpdateAppProfileDWordValueInRegistry(const std::wstring& appName, LPCWSTR valueName, DWORD value) {
-    HKEY hProfilesKey = nullptr;
-    if (RegOpenKeyExW(HKEY_CURRENT_USER, SMARTLOGILED_REGISTRY_PROFILES, 0, KEY_WRITE, &hProfilesKey) == ERROR_SUCCESS) {
-        HKEY hAppKey = nullptr;
-        if (RegOpenKeyExW(hProfilesKey, appName.c_str(), 0, KEY_WRITE, &hAppKey) == ERROR_SUCCESS) {
-            RegSetValueExW(hAppKey, valueName, 0, REG_DWORD,
-                           reinterpret_cast<const BYTE*>(&value), sizeof(value));
-            RegCloseKey(hAppKey);
+// ======================================================================
+// ACTIVATION HISTORY SETTINGS
+// ======================================================================
+
+// Write the activation history snapshot (only if it changed since the last save)
+void SaveActivationHistoryToConfig() {
+    std::vector<BYTE> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(appProfilesMutex);
+        if (!IsActivationHistoryDirtyInternal()) {
+            return;
         }
-        RegCloseKey(hProfilesKey);
+        snapshot = SerializeActivationHistoryInternal();
     }
+    
+    GetConfigBackend().WriteBinary(REGISTRY_VALUE_ACTIVATION_HISTORY, snapshot);
 }
 
-// Generic helper function to update key vector data in app profile registry
-static void UpdateAppProfileKeyVectorInRegistry(const std::wstring& appName, LPCWSTR valueName, const std::vector<LogiLed::KeyName>& keys) {
-    HKEY hProfilesKey = nullptr;
-    if (RegOpenKeyExW(HKEY_CURRENT_USER, SMARTLOGILED_REGISTRY_PROFILES, 0, KEY_WRITE, &hProfilesKey) == ERROR_SUCCESS) {
-        HKEY hAppKey = nullptr;
-        if (RegOpenKeyExW(hProfilesKey, appName.c_str(), 0, KEY_WRITE, &hAppKey) == ERROR_SUCCESS) {
-            if (!keys.empty()) {
-                std::vector<DWORD> data;
-                data.reserve(keys.size());
-                for (auto k : keys) data.push_back(static_cast<DWORD>(k));
-                RegSetValueExW(hAppKey, valueName, 0, REG_BINARY,
-                               reinterpret_cast<const BYTE*>(data.data()),
-                               static_cast<DWORD>(data.size() * sizeof(DWORD)));
-            } else {
-                RegSetValueExW(hAppKey, valueName, 0, REG_BINARY, nullptr, 0);
-            }
-            RegCloseKey(hAppKey);
+// Restore the activation history depth and snapshot from the last session
+void LoadActivationHistoryFromConfig() {
+    uint32_t depth = DEFAULT_ACTIVATION_HISTORY_DEPTH;
+    std::vector<BYTE> snapshot;
+    
+    IConfigBackend& backend = GetConfigBackend();
+    backend.ReadNumber(REGISTRY_VALUE_ACTIVATION_HISTORY_DEPTH, depth);
+    if (!backend.ReadBinary(REGISTRY_VALUE_ACTIVATION_HISTORY, snapshot)) {
+        snapshot.clear();
+    }
+    
+    std::lock_guard<std::mutex> lock(appProfilesMutex);
+    SetActivationHistoryDepthInternal(depth);
+    if (!snapshot.empty()) {
+        RestoreActivationHistoryInternal(snapshot.data(), snapshot.size());
+    }
+}
+
+// Update one field of a stored profile and mark it as overridden (no-op for standalone profiles)
+template<typename FieldUpdate>
+static void UpdateStoredProfileField(const std::wstring& appName, DWORD field, FieldUpdate update) {
+    StoredProfile stored;
+    if (!GetStoredProfile(appName, stored)) {
+        // A profile from the profile pack is stored as a whole on its first edit
+        AppColorProfile profile;
+        if (GetAppProfileCopy(appName, profile) && !profile.isPackProfile) {
+            AddAppProfileToStore(profile);
         }
-        RegCloseKey(hProfilesKey);
+        return;
+    }
+    update(stored);
+    stored.overrideMask |= field;
+    if (PutStoredProfile(stored)) {
+        SchedulePendingProfileWrite();
     }
 }
 
-// Update specific app profile color in registry
-void UpdateAppProfileColorInRegistry(const std::wstring& appName, COLORREF newAppColor) {
-    UpdateAppProfileDWordValueInRegistry(appName, REGISTRY_VALUE_APP_COLOR, static_cast<DWORD>(newAppColor));
+// Update specific app profile color in the profile store
+void UpdateAppProfileColorInStore(const std::wstring& appName, COLORREF newAppColor) {
+    UpdateStoredProfileField(appName, PROFILE_FIELD_APP_COLOR, [newAppColor](StoredProfile& stored) {
+        stored.appColor = static_cast<uint32_t>(newAppColor);
+    });
+}
+
+// Update specific app profile highlight color in the profile store
+void UpdateAppProfileHighlightColorInStore(const std::wstring& appName, COLORREF newHighlightColor) {
+    UpdateStoredProfileField(appName, PROFILE_FIELD_HIGHLIGHT_COLOR, [newHighlightColor](StoredProfile& stored) {
+        stored.highlightColor = static_cast<uint32_t>(newHighlightColor);
+    });
+}
+
+// Update specific app profile action color in the profile store
+void UpdateAppProfileActionColorInStore(const std::wstring& appName, COLORREF newActionColor) {
+    UpdateStoredProfileField(appName, PROFILE_FIELD_ACTION_COLOR, [newActionColor](StoredProfile& stored) {
+        stored.actionColor = static_cast<uint32_t>(newActionColor);
+    });
 }
 
-// Update specific app profile highlight color in registry
-void UpdateAppProfileHighlightColorInRegistry(const std::wstring& appName, COLORREF newHighlightColor) {
-    UpdateAppProfileDWordValueInRegistry(appName, REGISTRY_VALUE_APP_HIGHLIGHT_COLOR, static_cast<DWORD>(newHighlightColor));
+// Update specific app profile lock keys enabled setting in the profile store
+void UpdateAppProfileLockKeysEnabledInStore(const std::wstring& appName, bool lockKeysEnabled) {
+    UpdateStoredProfileField(appName, PROFILE_FIELD_LOCK_KEYS_ENABLED, [lockKeysEnabled](StoredProfile& stored) {
+        stored.lockKeysEnabled = lockKeysEnabled;
+    });
 }
 
-// Update specific app profile action color in registry
-void UpdateAppProfileActionColorInRegistry(const std::wstring& appName, COLORREF newActionColor) {
-    UpdateAppProfileDWordValueInRegistry(appName, REGISTRY_VALUE_APP_ACTION_COLOR, static_cast<DWORD>(newActionColor));
+// Update specific app profile highlight keys in the profile store
+void UpdateAppProfileHighlightKeysInStore(const std::wstring& appName, const std::vector<LogiLed::KeyName>& highlightKeys) {
+    UpdateStoredProfileField(appName, PROFILE_FIELD_HIGHLIGHT_KEYS, [&highlightKeys](StoredProfile& stored) {
+        stored.highlightKeys.assign(highlightKeys.begin(), highlightKeys.end());
+    });
 }
 
-// Update specific app profile lock keys enabled setting in registry
-void UpdateAppProfileLockKeysEnabledInRegistry(const std::wstring& appName, bool lockKeysEnabled) {
-    UpdateAppProfileDWordValueInRegistry(appName, REGISTRY_VALUE_LOCK_KEYS_ENABLED, lockKeysEnabled ? 1u : 0u);
+// Update specific app profile action keys in the profile store
+void UpdateAppProfileActionKeysInStore(const std::wstring& appName, const std::vector<LogiLed::KeyName>& actionKeys) {
+    UpdateStoredProfileField(appName, PROFILE_FIELD_ACTION_KEYS, [&actionKeys](StoredProfile& stored) {
+        stored.actionKeys.assign(actionKeys.begin(), actionKeys.end());
+    });
 }
 
-// Update specific app profile highlight keys in registry
-void UpdateAppProfileHighlightKeysInRegistry(const std::wstring& appName, const std::vector<LogiLed::KeyName>& highlightKeys) {
-    UpdateAppProfileKeyVectorInRegistry(appName, REGISTRY_VALUE_HIGHLIGHT_KEYS, highlightKeys);
+// Update specific app profile key effect in the profile store
+void UpdateAppProfileKeyEffectInStore(const std::wstring& appName, DWORD keyEffect) {
+    UpdateStoredProfileField(appName, PROFILE_FIELD_KEY_EFFECT, [keyEffect](StoredProfile& stored) {
+        stored.keyEffect = keyEffect;
+    });
 }
 
-// Update specific app profile action keys in registry
-void UpdateAppProfileActionKeysInRegistry(const std::wstring& appName, const std::vector<LogiLed::KeyName>& actionKeys) {
-    UpdateAppProfileKeyVectorInRegistry(appName, REGISTRY_VALUE_ACTION_KEYS, actionKeys);
+// Update specific app profile modifier layer in the profile store
+void UpdateAppProfileModifierLayerInStore(const std::wstring& appName, DWORD modifierLayer, COLORREF modifierColor) {
+    UpdateStoredProfileField(appName, PROFILE_FIELD_MODIFIER_LAYER, [modifierLayer, modifierColor](StoredProfile& stored) {
+        stored.modifierLayer = modifierLayer;
+        stored.modifierColor = static_cast<uint32_t>(modifierColor);
+    });
 }
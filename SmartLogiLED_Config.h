@@ -7,27 +7,49 @@
 #include "SmartLogiLED_Version.h"
 #include "SmartLogiLED_Constants.h"
 
-// Registry functions for start minimized setting
+// Configuration backend selection (call once at startup, before any setting is read)
+void SelectConfigBackend(LPCWSTR commandLine);
+
+// Start minimized setting
 void SaveStartMinimizedSetting(bool minimized);
 bool LoadStartMinimizedSetting();
 
-// Registry functions for color settings
-void SaveColorToRegistry(LPCWSTR valueName, COLORREF color);
-COLORREF LoadColorFromRegistry(LPCWSTR valueName, COLORREF defaultValue);
-void SaveLockKeyColorsToRegistry();
-void LoadLockKeyColorsFromRegistry();
-
-// Registry persistence for app profiles (including highlight color and keys)
-void AddAppProfileToRegistry(const AppColorProfile& profile);
-void RemoveAppProfileFromRegistry(const std::wstring& appName);
-void SaveAppProfilesToRegistry();
-void LoadAppProfilesFromRegistry();
+// Typing heatmap mode setting
+void SaveHeatmapModeSetting(bool enabled);
+bool LoadHeatmapModeSetting();
+
+// Color settings
+void SaveColorToConfig(LPCWSTR valueName, COLORREF color);
+COLORREF LoadColorFromConfig(LPCWSTR valueName, COLORREF defaultValue);
+void SaveLockKeyColorsToConfig();
+void LoadLockKeyColorsFromConfig();
+
+// App profile persistence (binary profile store file)
+void AddAppProfileToStore(const AppColorProfile& profile);
+void AddAppProfilesToStore(const std::vector<AppColorProfile>& profiles); // One scheduled write for the batch
+void RemoveAppProfileFromStore(const std::wstring& appName);
+void SaveAppProfilesToStore();
+void LoadAppProfilesFromStore();
+bool LoadAppProfileFromStore(const std::wstring& appName, AppColorProfile& profile);
+bool LoadAppProfileFromPack(const std::wstring& appName, AppColorProfile& profile); // Read-only profile pack
+std::wstring GetProfileStorePath();
+std::wstring GetProfilePackPath();
 size_t GetAppProfilesCount();
 
-// Update specific app profile colors in registry
-void UpdateAppProfileColorInRegistry(const std::wstring& appName, COLORREF newAppColor);
-void UpdateAppProfileHighlightColorInRegistry(const std::wstring& appName, COLORREF newHighlightColor);
-void UpdateAppProfileActionColorInRegistry(const std::wstring& appName, COLORREF newActionColor);
-void UpdateAppProfileLockKeysEnabledInRegistry(const std::wstring& appName, bool lockKeysEnabled);
-void UpdateAppProfileHighlightKeysInRegistry(const std::wstring& appName, const std::vector<LogiLed::KeyName>& highlightKeys);
-void UpdateAppProfileActionKeysInRegistry(const std::wstring& appName, const std::vector<LogiLed::KeyName>& actionKeys);
+// Profiles stored in the registry by older versions (read once to migrate them to the profile store)
+bool LoadAppProfileFromRegistry(const std::wstring& appName, AppColorProfile& profile);
+std::vector<std::wstring> EnumerateAppProfileNamesInRegistry(HKEY hProfilesKey);
+
+// Activation history persistence (fallback order survives restarts)
+void SaveActivationHistoryToConfig();
+void LoadActivationHistoryFromConfig();
+
+// Update specific app profile fields in the profile store (written to disk in the background)
+void UpdateAppProfileColorInStore(const std::wstring& appName, COLORREF newAppColor);
+void UpdateAppProfileHighlightColorInStore(const std::wstring& appName, COLORREF newHighlightColor);
+void UpdateAppProfileActionColorInStore(const std::wstring& appName, COLORREF newActionColor);
+void UpdateAppProfileLockKeysEnabledInStore(const std::wstring& appName, bool lockKeysEnabled);
+void UpdateAppProfileHighlightKeysInStore(const std::wstring& appName, const std::vector<LogiLed::KeyName>& highlightKeys);
+void UpdateAppProfileActionKeysInStore(const std::wstring& appName, const std::vector<LogiLed::KeyName>& actionKeys);
+void UpdateAppProfileKeyEffectInStore(const std::wstring& appName, DWORD keyEffect);
+void UpdateAppProfileModifierLayerInStore(const std::wstring& appName, DWORD modifierLayer, COLORREF modifierColor);
\ No newline at end of file
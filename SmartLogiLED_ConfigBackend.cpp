@@ -0,0 +1,210 @@
+// SmartLogiLED_ConfigBackend.cpp : Contains the file configuration backend and the active backend.
+//
+// The file backend keeps the settings in a small text file next to the profile store:
+//
+//   ; SmartLogiLED settings
+//   StartMinimized=dword:00000001
+//   ActivationHistory=hex:01,00,00,00
+//
+// It has no Win32 dependencies, so settings and profiles can be used on any platform.
+
+#include "SmartLogiLED_ConfigBackend.h"
+#include "SmartLogiLED_Platform.h"
+#include "SmartLogiLED_Constants.h"
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+
+// One stored setting
+struct FileConfigValue {
+    bool isNumber = true;
+    uint32_t number = 0;
+    std::vector<uint8_t> data;
+};
+
+// Settings file backend
+class FileConfigBackend : public IConfigBackend {
+public:
+    explicit FileConfigBackend(const std::wstring& directory)
+        : settingsPath(directory + PATH_SEPARATOR + CONFIG_SETTINGS_FILE_NAME),
+          profileStorePath(directory + PATH_SEPARATOR + PROFILE_STORE_FILE_NAME) {
+        CreateDirectoryIfMissing(directory);
+    }
+
+    const wchar_t* GetName() const override {
+        return L"File";
+    }
+
+    bool ReadNumber(const wchar_t* valueName, uint32_t& value) override {
+        std::lock_guard<std::mutex> lock(settingsMutex);
+        LoadSettingsInternal();
+        auto it = settings.find(ToSettingName(valueName));
+        if (it == settings.end() || !it->second.isNumber) {
+            return false;
+        }
+        value = it->second.number;
+        return true;
+    }
+
+    bool WriteNumber(const wchar_t* valueName, uint32_t value) override {
+        std::lock_guard<std::mutex> lock(settingsMutex);
+        LoadSettingsInternal();
+        FileConfigValue& setting = settings[ToSettingName(valueName)];
+        setting.isNumber = true;
+        setting.number = value;
+        setting.data.clear();
+        return SaveSettingsInternal();
+    }
+
+    bool ReadBinary(const wchar_t* valueName, std::vector<uint8_t>& data) override {
+        std::lock_guard<std::mutex> lock(settingsMutex);
+        LoadSettingsInternal();
+        auto it = settings.find(ToSettingName(valueName));
+        if (it == settings.end() || it->second.isNumber) {
+            return false;
+        }
+        data = it->second.data;
+        return true;
+    }
+
+    bool WriteBinary(const wchar_t* valueName, const std::vector<uint8_t>& data) override {
+        std::lock_guard<std::mutex> lock(settingsMutex);
+        LoadSettingsInternal();
+        FileConfigValue& setting = settings[ToSettingName(valueName)];
+        setting.isNumber = false;
+        setting.number = 0;
+        setting.data = data;
+        return SaveSettingsInternal();
+    }
+
+    std::wstring GetProfileStorePath() override {
+        return profileStorePath;
+    }
+
+private:
+#ifdef _WIN32
+    static constexpr const wchar_t* PATH_SEPARATOR = L"\\";
+#else
+    static constexpr const wchar_t* PATH_SEPARATOR = L"/";
+#endif
+
+    // Setting names are ASCII
+    static std::string ToSettingName(const wchar_t* valueName) {
+        std::string name;
+        for (const wchar_t* ch = valueName; *ch; ++ch) {
+            name.push_back((*ch > 0 && *ch < 0x80) ? static_cast<char>(*ch) : '_');
+        }
+        return name;
+    }
+
+    // Read the settings file once (INTERNAL - ASSUMES SETTINGS LOCKED)
+    void LoadSettingsInternal() {
+        if (settingsLoaded) {
+            return;
+        }
+        settingsLoaded = true;
+
+        MappedFile file;
+        if (!MapFileReadOnly(settingsPath, file)) {
+            return; // No settings yet
+        }
+        const char* text = reinterpret_cast<const char*>(file.data);
+        size_t lineStart = 0;
+        while (lineStart < file.size) {
+            size_t lineEnd = lineStart;
+            while (lineEnd < file.size && text[lineEnd] != '\n') {
+                ++lineEnd;
+            }
+            ParseSettingLine(std::string(text + lineStart, lineEnd - lineStart));
+            lineStart = lineEnd + 1;
+        }
+        UnmapFile(file);
+    }
+
+    // Parse one "Name=dword:XXXXXXXX" or "Name=hex:XX,XX,..." line (INTERNAL - ASSUMES SETTINGS LOCKED)
+    void ParseSettingLine(std::string line) {
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) {
+            line.pop_back();
+        }
+        size_t separator = line.find('=');
+        if (line.empty() || line[0] == ';' || separator == std::string::npos || separator == 0) {
+            return;
+        }
+
+        std::string name = line.substr(0, separator);
+        std::string value = line.substr(separator + 1);
+        FileConfigValue setting;
+        if (value.compare(0, 6, "dword:") == 0) {
+            setting.number = static_cast<uint32_t>(strtoul(value.c_str() + 6, nullptr, 16));
+        } else if (value.compare(0, 4, "hex:") == 0) {
+            setting.isNumber = false;
+            const char* cursor = value.c_str() + 4;
+            while (*cursor) {
+                char* end = nullptr;
+                unsigned long byte = strtoul(cursor, &end, 16);
+                if (end == cursor) {
+                    break;
+                }
+                setting.data.push_back(static_cast<uint8_t>(byte));
+                cursor = (*end == ',') ? end + 1 : end;
+            }
+        } else {
+            return; // Unknown value type
+        }
+        settings[name] = setting;
+    }
+
+    // Rewrite the settings file (INTERNAL - ASSUMES SETTINGS LOCKED)
+    bool SaveSettingsInternal() {
+        std::string text = "; SmartLogiLED settings\n";
+        char buffer[16];
+        for (const auto& setting : settings) {
+            text += setting.first;
+            if (setting.second.isNumber) {
+                snprintf(buffer, sizeof(buffer), "=dword:%08x", setting.second.number);
+                text += buffer;
+            } else {
+                text += "=hex:";
+                for (size_t i = 0; i < setting.second.data.size(); ++i) {
+                    snprintf(buffer, sizeof(buffer), i ? ",%02x" : "%02x", setting.second.data[i]);
+                    text += buffer;
+                }
+            }
+            text += "\n";
+        }
+        return WriteFileAtomically(settingsPath, text.data(), text.size());
+    }
+
+    std::wstring settingsPath;
+    std::wstring profileStorePath;
+    std::mutex settingsMutex;
+    std::map<std::string, FileConfigValue> settings;
+    bool settingsLoaded = false;
+};
+
+std::unique_ptr<IConfigBackend> CreateFileConfigBackend(const std::wstring& directory) {
+    return std::unique_ptr<IConfigBackend>(new FileConfigBackend(directory));
+}
+
+// ======================================================================
+// ACTIVE BACKEND
+// ======================================================================
+
+// Module-specific variables
+static std::unique_ptr<IConfigBackend> activeConfigBackend;
+
+void SetConfigBackend(std::unique_ptr<IConfigBackend> backend) {
+    activeConfigBackend = std::move(backend);
+}
+
+IConfigBackend& GetConfigBackend() {
+    if (!activeConfigBackend) {
+#ifdef _WIN32
+        activeConfigBackend = CreateRegistryConfigBackend();
+#else
+        activeConfigBackend = CreateFileConfigBackend(L".");
+#endif
+    }
+    return *activeConfigBackend;
+}
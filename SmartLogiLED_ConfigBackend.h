@@ -0,0 +1,44 @@
+// SmartLogiLED_ConfigBackend.h : Header file for the configuration storage backends.
+//
+// Settings (start minimized, lock key colors, activation history) are read and written
+// through the active backend. The registry backend is the default; the file backend keeps
+// everything in one directory and has no Win32 dependencies.
+//
+// Profiles are not read or written through the backend: both backends keep them in the
+// binary profile store (SmartLogiLED_ProfileStore.h), which is already portable and has its
+// own journal and recovery, so the backend only chooses where the store file lives.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Storage for named settings plus the location of the profile store file
+class IConfigBackend {
+public:
+    virtual ~IConfigBackend() = default;
+
+    virtual const wchar_t* GetName() const = 0;
+
+    // Settings (value names are ASCII, e.g. REGISTRY_VALUE_START_MINIMIZED)
+    virtual bool ReadNumber(const wchar_t* valueName, uint32_t& value) = 0;
+    virtual bool WriteNumber(const wchar_t* valueName, uint32_t value) = 0;
+    virtual bool ReadBinary(const wchar_t* valueName, std::vector<uint8_t>& data) = 0;
+    virtual bool WriteBinary(const wchar_t* valueName, const std::vector<uint8_t>& data) = 0;
+
+    // Profile store file used with this backend
+    virtual std::wstring GetProfileStorePath() = 0;
+};
+
+// Backends
+std::unique_ptr<IConfigBackend> CreateFileConfigBackend(const std::wstring& directory); // Settings file and profile store in one directory
+#ifdef _WIN32
+std::unique_ptr<IConfigBackend> CreateRegistryConfigBackend(); // HKCU\Software\SmartLogiLED, profile store in %LOCALAPPDATA%
+std::unique_ptr<IConfigBackend> CreateRegistryConfigBackend(const std::wstring& keyPath, const std::wstring& profileStoreDirectory); // Other HKCU key and store folder (tools)
+#endif
+
+// Active backend (the registry backend until another one is set)
+void SetConfigBackend(std::unique_ptr<IConfigBackend> backend);
+IConfigBackend& GetConfigBackend();
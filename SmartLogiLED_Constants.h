@@ -17,6 +17,130 @@
 #define REGISTRY_VALUE_LOCK_KEYS_ENABLED L"LockKeysEnabled"
 #define REGISTRY_VALUE_HIGHLIGHT_KEYS L"HighlightKeys"
 #define REGISTRY_VALUE_ACTION_KEYS L"ActionKeys"
+#define REGISTRY_VALUE_PARENT_PROFILE L"ParentProfile"
+#define REGISTRY_VALUE_OVERRIDE_MASK L"OverrideMask"
+#define REGISTRY_VALUE_ACTIVATION_HISTORY L"ActivationHistory"
+#define REGISTRY_VALUE_ACTIVATION_HISTORY_DEPTH L"ActivationHistoryDepth"
+#define REGISTRY_VALUE_HEATMAP_MODE L"HeatmapMode"
+
+// Settings file of the file configuration backend (its presence next to the executable selects portable mode)
+#define CONFIG_SETTINGS_FILE_NAME L"SmartLogiLED.cfg"
+
+// Profile INI files
+#define PROFILE_INI_SECTION "[SmartLogiLED Profile]" // UTF-8, matched against the trimmed line
+#define PROFILE_IMPORT_REPORT_MAX_LINES 25 // Per-file remarks shown after a folder import
+
+// Binary profile store (replaces the per-profile registry keys, which are only read to migrate)
+#define PROFILE_STORE_DIRECTORY L"SmartLogiLED"
+#define PROFILE_STORE_FILE_NAME L"Profiles.slp"
+#define PROFILE_STORE_MAGIC 0x53504C53 // "SLPS"
+#define PROFILE_STORE_VERSION 2 // 2: header names the journal records already folded into the file
+
+// Edit journal next to the store file: every profile edit is appended to it, and it is folded
+// into the store file (compacted) once it grows past PROFILE_JOURNAL_COMPACT_BYTES
+#define PROFILE_JOURNAL_FILE_SUFFIX L".journal"
+#define PROFILE_JOURNAL_MAGIC 0x4A504C53 // "SLPJ" (record)
+#define PROFILE_JOURNAL_FILE_MAGIC 0x484A4C53 // "SLJH" (file header, stamped with the store file it extends)
+#define PROFILE_JOURNAL_VERSION 1
+#define PROFILE_JOURNAL_COMPACT_BYTES (256 * 1024)
+
+// Copy of the last committed store file: a damaged store file is rebuilt from it plus the journal,
+// and a store file that cannot be recovered is kept for inspection with the quarantine suffix
+#define PROFILE_STORE_BACKUP_SUFFIX L".bak"
+#define PROFILE_STORE_QUARANTINE_SUFFIX L".bad"
+
+// Read-only profile pack next to the store file: profiles that are not in the store are
+// looked up in it by name (packs are built from profile INI files with Tools/PackTool)
+#define PROFILE_PACK_FILE_NAME L"Library.slpk"
+#define PROFILE_PACK_MAGIC 0x4B504C53 // "SLPK"
+#define PROFILE_PACK_VERSION 1
+
+// Write-behind of profile edits: the journal is flushed to disk (and compacted if due) after
+// this quiet period (and at the latest this long after the first unsynced edit)
+#define PROFILE_WRITE_DEBOUNCE_MS 750
+#define PROFILE_WRITE_MAX_DELAY_MS 5000
+
+// Maximum length of a profile inheritance chain (profile -> parent -> grandparent ...)
+#define MAX_PROFILE_INHERITANCE_DEPTH 8
+
+// Number of profiles remembered in the activation history (configurable via ActivationHistoryDepth)
+#define DEFAULT_ACTIVATION_HISTORY_DEPTH 10
+#define MAX_ACTIVATION_HISTORY_DEPTH 256
+
+// Version of the ActivationHistory registry snapshot
+#define ACTIVATION_HISTORY_SNAPSHOT_VERSION 1
+
+// Number of processed profile events kept for inspection and replay
+#define PROFILE_EVENT_LOG_CAPACITY 512
+
+// Profile switch latency tracing (switched on at runtime from the menu)
+// Comment out to compile the instrumentation out entirely
+#define ENABLE_LATENCY_TRACING
+#define LATENCY_TRACE_SPAN_CAPACITY 1024
+
+// Keyboard hook fast path: hook procedures record key events into a ring of this many
+// entries (power of two) for the hook worker thread. Windows silently removes a hook that
+// overruns LowLevelHooksTimeout; calls above KEYBOARD_HOOK_WARNING_PERCENT of it are logged
+#define KEYBOARD_HOOK_RING_CAPACITY 256
+#define KEYBOARD_HOOK_DEFAULT_TIMEOUT_MS 300 // Assumed when LowLevelHooksTimeout is not set
+#define KEYBOARD_HOOK_WARNING_PERCENT 50
+
+// Key press filter of inline hook handlers: one slot per virtual key plus 256 for extended keys;
+// the LED keys it reports are scan codes below KEYBOARD_HOOK_PRESS_KEY_COUNT
+#define KEYBOARD_HOOK_PRESS_SLOT_COUNT 512
+#define KEYBOARD_HOOK_PRESS_KEY_COUNT 0x200
+
+// Lock key states: one bit per lock key (GetLockKeyStates), tracked from hook events and
+// reconciled against the OS on a main window timer; a key must disagree on two checks in a row
+#define LOCK_KEY_STATE_NUM    0x1
+#define LOCK_KEY_STATE_CAPS   0x2
+#define LOCK_KEY_STATE_SCROLL 0x4
+#define LOCK_KEY_RECONCILE_TIMER_ID 1003
+#define LOCK_KEY_RECONCILE_INTERVAL_MS 1000
+
+// Typing heatmap: key presses are folded into heat values that halve every
+// HEATMAP_HALF_LIFE_SECONDS; the keyboard is repainted at a fixed frame rate and the heat
+// values are saved next to the profile store every HEATMAP_SAVE_INTERVAL_MS while typing
+#define HEATMAP_FILE_NAME L"Heatmap.dat"
+#define HEATMAP_FILE_MAGIC 0x4D484C53 // "SLHM"
+#define HEATMAP_FILE_VERSION 1
+#define HEATMAP_MAX_KEYS 160
+#define HEATMAP_FRAME_TIMER_ID 1004
+#define HEATMAP_FRAME_INTERVAL_MS 100 // 10 frames per second
+#define HEATMAP_HALF_LIFE_SECONDS 1800.0
+#define HEATMAP_SAVE_INTERVAL_MS 60000
+
+// Reactive key effects: the hook queues presses (KEY_EFFECT_QUEUE_CAPACITY, power of two) and
+// a frame timer runs at most KEY_EFFECT_MAX_ACTIVE effects while the displayed profile has one;
+// a new press beyond the cap replaces the oldest effect
+#define KEY_EFFECT_FRAME_TIMER_ID 1005
+#define KEY_EFFECT_FRAME_INTERVAL_MS 33 // 30 frames per second
+#define KEY_EFFECT_QUEUE_CAPACITY 64
+#define KEY_EFFECT_MAX_ACTIVE 24
+#define KEY_EFFECT_FADE_MS 450
+#define KEY_EFFECT_RIPPLE_MS 700
+#define KEY_EFFECT_RIPPLE_SPEED 16.0 // Key widths per second
+#define KEY_EFFECT_RIPPLE_WIDTH 1.25 // Key widths
+#define KEY_EFFECT_LAYOUT_KEYS 104 // Keys of the full-size layout effects are computed for
+
+// Modifier layer: modifier key events go from the hook worker straight to a minimal LED update
+// on the main window; while a modifier is held its state is checked against the OS (two
+// disagreeing checks clear a key up the hook missed)
+#define MODIFIER_LAYER_RECONCILE_TIMER_ID 1006
+#define MODIFIER_LAYER_RECONCILE_INTERVAL_MS 500
+#define MODIFIER_LAYER_LATENCY_BUDGET_MS 5 // Hook to LED target shown in the statistics
+
+// Keyboard layouts: the foreground window's layout is checked on window switches, on
+// WM_INPUTLANGCHANGE and on a timer (a switch inside another application is not announced)
+#define KEY_LAYOUT_CHECK_TIMER_ID 1007
+#define KEY_LAYOUT_CHECK_INTERVAL_MS 250
+
+// Input sources: the evdev source (Linux) reads at most INPUT_EVDEV_MAX_DEVICES keyboards; a
+// replay source (/replay <file>) plays a key recording instead of the keyboard, INPUT_REPLAY_DEFAULT_SPEED
+// times as fast as recorded unless /replayspeed <factor> is given (0 = as fast as possible)
+#define INPUT_EVDEV_DIRECTORY "/dev/input"
+#define INPUT_EVDEV_MAX_DEVICES 16
+#define INPUT_REPLAY_DEFAULT_SPEED 1.0
 
 // Monitoring interval for checking running applications (in milliseconds)
 #define APP_MONITOR_INTERVAL_MS 1000
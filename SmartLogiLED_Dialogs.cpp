@@ -15,9 +15,11 @@
 #include "SmartLogiLED_Config.h"
 #include "SmartLogiLED_Constants.h"
 #include "SmartLogiLED_LockKeys.h"
+#include "SmartLogiLED_KeyboardHook.h"
 #include "Resource.h"
 #include <commdlg.h>
 #include <algorithm>
+#include <atomic>
 #include <vector>
 
 // External variables
@@ -52,14 +54,12 @@ bool ShowColorPickerDialog(HWND hWnd, COLORREF& color) {
 // Global variables for Keys dialog
 static std::vector<LogiLed::KeyName> currentHighlightKeys;
 static std::wstring currentAppNameForKeys;
-static HHOOK keysDialogHook = nullptr;
-static AppColorProfile* savedActiveProfile = nullptr; // Store the active profile when dialog opens
+static std::atomic<HWND> keysDialogWindow{ nullptr }; // Receives WM_KEY_CAPTURED while capturing keys
 
 // Global variables for Action Keys dialog
 static std::vector<LogiLed::KeyName> currentActionKeys;
 static std::wstring currentAppNameForActionKeys;
-static HHOOK actionKeysDialogHook = nullptr;
-static AppColorProfile* savedActiveProfileForActionKeys = nullptr; // Store the active profile when dialog opens
+static std::atomic<HWND> actionKeysDialogWindow{ nullptr };
 
 // Forward declarations for main window UI functions (implemented in main file)
 extern void PopulateAppProfileCombo(HWND hCombo);
@@ -69,7 +69,7 @@ extern void UpdateLockKeysCheckbox(HWND hWnd);
 extern void UpdateAllProfileUIElements(HWND hWnd); // Updated to use new generic UI update function
 
 // Consolidated color application function with flexible behavior control
-void ApplyProfileColors(AppColorProfile* profile, bool updateHookState = true) {
+void ApplyProfileColors(const AppColorProfile* profile, bool updateHookState = true) {
     if (!profile) {
         // No profile - use default colors and enable lock keys
         extern COLORREF defaultColor;
@@ -95,8 +95,8 @@ void ApplyProfileColors(AppColorProfile* profile, bool updateHookState = true) {
 // Helper function to restore the original active profile colors
 void RestoreActiveProfileColors() {
     // Find the currently active profile and restore its colors
-    AppColorProfile* activeProfile = GetDisplayedProfile();
-    ApplyProfileColors(activeProfile, true);
+    std::shared_ptr<const AppColorProfile> activeProfile = GetDisplayedProfile();
+    ApplyProfileColors(activeProfile.get(), true);
 }
 
 // Callback function for the About dialog box
@@ -151,53 +151,59 @@ INT_PTR CALLBACK Help(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam)
     return (INT_PTR)FALSE;
 }
 
-// Low-level keyboard hook for the Keys dialog
-LRESULT CALLBACK KeysDialogKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam) {
-    if (nCode >= 0 && (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN)) {
-        KBDLLHOOKSTRUCT* pKeyStruct = (KBDLLHOOKSTRUCT*)lParam;
-        
-        // Convert virtual key to LogiLed key with flags for proper ENTER/NUM_ENTER distinction
-        LogiLed::KeyName logiKey = VirtualKeyToLogiLedKey(pKeyStruct->vkCode, pKeyStruct->flags);
-        
-        // Check if key is already in the list
-        auto it = std::find(currentHighlightKeys.begin(), currentHighlightKeys.end(), logiKey);
-        
-        if (it != currentHighlightKeys.end()) {
-            // Key is in list, remove it
-            currentHighlightKeys.erase(it);
-        } else {
-            // Key is not in list, add it
-            currentHighlightKeys.push_back(logiKey);
-        }
-        
-        // Update the text field
-        HWND hEditKeys = FindWindow(nullptr, L"Configure Highlight Keys");
-        if (hEditKeys) {
-            hEditKeys = GetDlgItem(hEditKeys, IDC_EDIT_KEYS);
-            if (hEditKeys) {
-                std::wstring keysText = FormatHighlightKeysForDisplay(currentHighlightKeys);
-                SetWindowTextW(hEditKeys, keysText.c_str());
-            }
-        }
-        
-        // Apply the current profile's colors temporarily to show the updated keys
-        if (!currentAppNameForKeys.empty()) {
-            AppColorProfile* profile = GetAppProfileByName(currentAppNameForKeys);
-            if (profile) {
-                // Create a temporary profile with current highlight keys for display
-                AppColorProfile tempProfile = *profile;
-                tempProfile.highlightKeys = currentHighlightKeys;
-                
-                // Use the consolidated function to apply colors consistently
-                ApplyProfileColors(&tempProfile, false); // Don't update hook state during temporary preview
+// Add or remove a captured key and preview the edited profile with the new key list (UI thread)
+static void ToggleCapturedKey(HWND hDlg, std::vector<LogiLed::KeyName>& keys, const std::wstring& appName, bool actionKeys, DWORD vkCode, DWORD flags) {
+    // Convert virtual key to LogiLed key with flags for proper ENTER/NUM_ENTER distinction
+    LogiLed::KeyName logiKey = VirtualKeyToLogiLedKey(vkCode, flags);
+    
+    // Check if key is already in the list
+    auto it = std::find(keys.begin(), keys.end(), logiKey);
+    
+    if (it != keys.end()) {
+        // Key is in list, remove it
+        keys.erase(it);
+    } else {
+        // Key is not in list, add it
+        keys.push_back(logiKey);
+    }
+    
+    // Update the text field
+    std::wstring keysText = FormatHighlightKeysForDisplay(keys);
+    SetDlgItemTextW(hDlg, IDC_EDIT_KEYS, keysText.c_str());
+    
+    // Apply the current profile's colors temporarily to show the updated keys
+    if (!appName.empty()) {
+        AppColorProfile tempProfile;
+        if (GetResolvedAppProfileCopy(appName, tempProfile)) {
+            // Swap the current key list into the copy for display
+            if (actionKeys) {
+                tempProfile.actionKeys = keys;
+            } else {
+                tempProfile.highlightKeys = keys;
             }
+            
+            // Use the consolidated function to apply colors consistently
+            ApplyProfileColors(&tempProfile, false); // Don't update hook state during temporary preview
         }
-        
-        // Prevent the key from being processed by other applications
-        return 1;
     }
-    
-    return CallNextHookEx(keysDialogHook, nCode, wParam, lParam);
+}
+
+// Capture key downs for a key dialog: other applications do not see them while it is open
+static void StartKeyCapture(KeyboardHookClient client, KeyboardHookEventHandler handler) {
+    KeyboardHookSubscriber subscriber;
+    subscriber.handler = handler;
+    subscriber.keyDownOnly = true;
+    subscriber.swallowKeyDown = true;
+    SubscribeKeyboardHook(client, subscriber);
+    SetKeyboardHookSubscriberEnabled(client, true);
+}
+
+// Hand a captured key to the Keys dialog (hook worker thread)
+static void OnKeysDialogHookEvent(const KeyboardHookEvent& event) {
+    HWND hDlg = keysDialogWindow.load();
+    if (hDlg) {
+        PostMessage(hDlg, WM_KEY_CAPTURED, event.vkCode, event.flags);
+    }
 }
 
 // Callback function for the Keys dialog box
@@ -207,9 +213,6 @@ INT_PTR CALLBACK KeysDialog(HWND hDlg, UINT message, WPARAM wParam, LPARAM lPara
     {
     case WM_INITDIALOG:
     {
-        // Store the currently active profile to restore later
-        savedActiveProfile = GetDisplayedProfile();
-        
         // Get the app name and current keys from the selected profile
         HWND hMainWnd = GetParent(hDlg);
         HWND hCombo = GetDlgItem(hMainWnd, IDC_COMBO_APPPROFILE);
@@ -222,12 +225,12 @@ INT_PTR CALLBACK KeysDialog(HWND hDlg, UINT message, WPARAM wParam, LPARAM lPara
                 currentAppNameForKeys = appName;
                 
                 // Get current highlight keys for this profile
-                AppColorProfile* profile = GetAppProfileByName(currentAppNameForKeys);
-                if (profile) {
-                    currentHighlightKeys = profile->highlightKeys;
+                AppColorProfile profile;
+                if (GetResolvedAppProfileCopy(currentAppNameForKeys, profile)) {
+                    currentHighlightKeys = profile.highlightKeys;
                     
                     // Apply the edited profile's colors temporarily
-                    ApplyProfileColors(profile, false); // Don't update hook state during editing
+                    ApplyProfileColors(&profile, false); // Don't update hook state during editing
                 } else {
                     currentHighlightKeys.clear();
                 }
@@ -236,13 +239,18 @@ INT_PTR CALLBACK KeysDialog(HWND hDlg, UINT message, WPARAM wParam, LPARAM lPara
                 std::wstring keysText = FormatHighlightKeysForDisplay(currentHighlightKeys);
                 SetDlgItemTextW(hDlg, IDC_EDIT_KEYS, keysText.c_str());
                 
-                // Set up keyboard hook to capture key presses
-                keysDialogHook = SetWindowsHookEx(WH_KEYBOARD_LL, KeysDialogKeyboardProc, GetModuleHandle(nullptr), 0);
+                // Capture key presses through the keyboard hook
+                keysDialogWindow = hDlg;
+                StartKeyCapture(KeyboardHookClient::HighlightKeysDialog, OnKeysDialogHookEvent);
             }
         }
         
         return (INT_PTR)TRUE;
     }
+    case WM_KEY_CAPTURED:
+        // Key recorded by the dialog's keyboard hook
+        ToggleCapturedKey(hDlg, currentHighlightKeys, currentAppNameForKeys, false, static_cast<DWORD>(wParam), static_cast<DWORD>(lParam));
+        return (INT_PTR)TRUE;
     case WM_COMMAND:
         switch (LOWORD(wParam))
         {
@@ -253,10 +261,9 @@ INT_PTR CALLBACK KeysDialog(HWND hDlg, UINT message, WPARAM wParam, LPARAM lPara
             
             // Apply the current profile's colors with no highlight keys
             if (!currentAppNameForKeys.empty()) {
-                AppColorProfile* profile = GetAppProfileByName(currentAppNameForKeys);
-                if (profile) {
-                    // Create a temporary profile with no highlight keys for display
-                    AppColorProfile tempProfile = *profile;
+                AppColorProfile tempProfile;
+                if (GetResolvedAppProfileCopy(currentAppNameForKeys, tempProfile)) {
+                    // Clear the highlight keys of the copy for display
                     tempProfile.highlightKeys.clear();
                     
                     // Use the consolidated function to apply colors consistently
@@ -270,32 +277,26 @@ INT_PTR CALLBACK KeysDialog(HWND hDlg, UINT message, WPARAM wParam, LPARAM lPara
             // Save the highlight keys and close dialog
             if (!currentAppNameForKeys.empty()) {
                 UpdateAppProfileHighlightKeys(currentAppNameForKeys, currentHighlightKeys);
-                UpdateAppProfileHighlightKeysInRegistry(currentAppNameForKeys, currentHighlightKeys);
+                UpdateAppProfileHighlightKeysInStore(currentAppNameForKeys, currentHighlightKeys);
             }
             
-            // Remove keyboard hook
-            if (keysDialogHook) {
-                UnhookWindowsHookEx(keysDialogHook);
-                keysDialogHook = nullptr;
-            }
+            // Stop capturing keys
+            SetKeyboardHookSubscriberEnabled(KeyboardHookClient::HighlightKeysDialog, false);
+            keysDialogWindow = nullptr;
             
             // Restore the original active profile colors
             RestoreActiveProfileColors();
-            savedActiveProfile = nullptr;
             
             EndDialog(hDlg, LOWORD(wParam));
             return (INT_PTR)TRUE;
             
         case IDCANCEL:
-            // Remove keyboard hook
-            if (keysDialogHook) {
-                UnhookWindowsHookEx(keysDialogHook);
-                keysDialogHook = nullptr;
-            }
+            // Stop capturing keys
+            SetKeyboardHookSubscriberEnabled(KeyboardHookClient::HighlightKeysDialog, false);
+            keysDialogWindow = nullptr;
             
             // Restore the original active profile colors
             RestoreActiveProfileColors();
-            savedActiveProfile = nullptr;
             
             EndDialog(hDlg, LOWORD(wParam));
             return (INT_PTR)TRUE;
@@ -303,15 +304,12 @@ INT_PTR CALLBACK KeysDialog(HWND hDlg, UINT message, WPARAM wParam, LPARAM lPara
         break;
         
     case WM_CLOSE:
-        // Remove keyboard hook
-        if (keysDialogHook) {
-            UnhookWindowsHookEx(keysDialogHook);
-            keysDialogHook = nullptr;
-        }
+        // Stop capturing keys
+        SetKeyboardHookSubscriberEnabled(KeyboardHookClient::HighlightKeysDialog, false);
+        keysDialogWindow = nullptr;
         
         // Restore the original active profile colors
         RestoreActiveProfileColors();
-        savedActiveProfile = nullptr;
         
         EndDialog(hDlg, IDCANCEL);
         return (INT_PTR)TRUE;
@@ -319,53 +317,12 @@ INT_PTR CALLBACK KeysDialog(HWND hDlg, UINT message, WPARAM wParam, LPARAM lPara
     return (INT_PTR)FALSE;
 }
 
-// Low-level keyboard hook for the Action Keys dialog
-LRESULT CALLBACK ActionKeysDialogKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam) {
-    if (nCode >= 0 && (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN)) {
-        KBDLLHOOKSTRUCT* pKeyStruct = (KBDLLHOOKSTRUCT*)lParam;
-        
-        // Convert virtual key to LogiLed key with flags for proper ENTER/NUM_ENTER distinction
-        LogiLed::KeyName logiKey = VirtualKeyToLogiLedKey(pKeyStruct->vkCode, pKeyStruct->flags);
-        
-        // Check if key is already in the list
-        auto it = std::find(currentActionKeys.begin(), currentActionKeys.end(), logiKey);
-        
-        if (it != currentActionKeys.end()) {
-            // Key is in list, remove it
-            currentActionKeys.erase(it);
-        } else {
-            // Key is not in list, add it
-            currentActionKeys.push_back(logiKey);
-        }
-        
-        // Update the text field
-        HWND hEditKeys = FindWindow(nullptr, L"Configure Action Keys");
-        if (hEditKeys) {
-            hEditKeys = GetDlgItem(hEditKeys, IDC_EDIT_KEYS);
-            if (hEditKeys) {
-                std::wstring keysText = FormatHighlightKeysForDisplay(currentActionKeys);
-                SetWindowTextW(hEditKeys, keysText.c_str());
-            }
-        }
-        
-        // Apply the current profile's colors temporarily to show the updated keys
-        if (!currentAppNameForActionKeys.empty()) {
-            AppColorProfile* profile = GetAppProfileByName(currentAppNameForActionKeys);
-            if (profile) {
-                // Create a temporary profile with current action keys for display
-                AppColorProfile tempProfile = *profile;
-                tempProfile.actionKeys = currentActionKeys;
-                
-                // Use the consolidated function to apply colors consistently
-                ApplyProfileColors(&tempProfile, false); // Don't update hook state during temporary preview
-            }
-        }
-        
-        // Prevent the key from being processed by other applications
-        return 1;
+// Hand a captured key to the Action Keys dialog (hook worker thread)
+static void OnActionKeysDialogHookEvent(const KeyboardHookEvent& event) {
+    HWND hDlg = actionKeysDialogWindow.load();
+    if (hDlg) {
+        PostMessage(hDlg, WM_KEY_CAPTURED, event.vkCode, event.flags);
     }
-    
-    return CallNextHookEx(actionKeysDialogHook, nCode, wParam, lParam);
 }
 
 // Callback function for the Action Keys dialog box
@@ -375,9 +332,6 @@ INT_PTR CALLBACK ActionKeysDialog(HWND hDlg, UINT message, WPARAM wParam, LPARAM
     {
     case WM_INITDIALOG:
     {
-        // Store the currently active profile to restore later
-        savedActiveProfileForActionKeys = GetDisplayedProfile();
-        
         // Set the dialog title
         SetWindowTextW(hDlg, L"Configure Action Keys");
         
@@ -393,12 +347,12 @@ INT_PTR CALLBACK ActionKeysDialog(HWND hDlg, UINT message, WPARAM wParam, LPARAM
                 currentAppNameForActionKeys = appName;
                 
                 // Get current action keys for this profile
-                AppColorProfile* profile = GetAppProfileByName(currentAppNameForActionKeys);
-                if (profile) {
-                    currentActionKeys = profile->actionKeys;
+                AppColorProfile profile;
+                if (GetResolvedAppProfileCopy(currentAppNameForActionKeys, profile)) {
+                    currentActionKeys = profile.actionKeys;
                     
                     // Apply the edited profile's colors temporarily
-                    ApplyProfileColors(profile, false); // Don't update hook state during editing
+                    ApplyProfileColors(&profile, false); // Don't update hook state during editing
                 } else {
                     currentActionKeys.clear();
                 }
@@ -407,13 +361,18 @@ INT_PTR CALLBACK ActionKeysDialog(HWND hDlg, UINT message, WPARAM wParam, LPARAM
                 std::wstring keysText = FormatHighlightKeysForDisplay(currentActionKeys);
                 SetDlgItemTextW(hDlg, IDC_EDIT_KEYS, keysText.c_str());
                 
-                // Set up keyboard hook to capture key presses
-                actionKeysDialogHook = SetWindowsHookEx(WH_KEYBOARD_LL, ActionKeysDialogKeyboardProc, GetModuleHandle(nullptr), 0);
+                // Capture key presses through the keyboard hook
+                actionKeysDialogWindow = hDlg;
+                StartKeyCapture(KeyboardHookClient::ActionKeysDialog, OnActionKeysDialogHookEvent);
             }
         }
         
         return (INT_PTR)TRUE;
     }
+    case WM_KEY_CAPTURED:
+        // Key recorded by the dialog's keyboard hook
+        ToggleCapturedKey(hDlg, currentActionKeys, currentAppNameForActionKeys, true, static_cast<DWORD>(wParam), static_cast<DWORD>(lParam));
+        return (INT_PTR)TRUE;
     case WM_COMMAND:
         switch (LOWORD(wParam))
         {
@@ -424,10 +383,9 @@ INT_PTR CALLBACK ActionKeysDialog(HWND hDlg, UINT message, WPARAM wParam, LPARAM
             
             // Apply the current profile's colors with no action keys
             if (!currentAppNameForActionKeys.empty()) {
-                AppColorProfile* profile = GetAppProfileByName(currentAppNameForActionKeys);
-                if (profile) {
-                    // Create a temporary profile with no action keys for display
-                    AppColorProfile tempProfile = *profile;
+                AppColorProfile tempProfile;
+                if (GetResolvedAppProfileCopy(currentAppNameForActionKeys, tempProfile)) {
+                    // Clear the action keys of the copy for display
                     tempProfile.actionKeys.clear();
                     
                     // Use the consolidated function to apply colors consistently
@@ -441,32 +399,26 @@ INT_PTR CALLBACK ActionKeysDialog(HWND hDlg, UINT message, WPARAM wParam, LPARAM
             // Save the action keys and close dialog
             if (!currentAppNameForActionKeys.empty()) {
                 UpdateAppProfileActionKeys(currentAppNameForActionKeys, currentActionKeys);
-                UpdateAppProfileActionKeysInRegistry(currentAppNameForActionKeys, currentActionKeys);
+                UpdateAppProfileActionKeysInStore(currentAppNameForActionKeys, currentActionKeys);
             }
             
-            // Remove keyboard hook
-            if (actionKeysDialogHook) {
-                UnhookWindowsHookEx(actionKeysDialogHook);
-                actionKeysDialogHook = nullptr;
-            }
+            // Stop capturing keys
+            SetKeyboardHookSubscriberEnabled(KeyboardHookClient::ActionKeysDialog, false);
+            actionKeysDialogWindow = nullptr;
             
             // Restore the original active profile colors
             RestoreActiveProfileColors();
-            savedActiveProfileForActionKeys = nullptr;
             
             EndDialog(hDlg, LOWORD(wParam));
             return (INT_PTR)TRUE;
             
         case IDCANCEL:
-            // Remove keyboard hook
-            if (actionKeysDialogHook) {
-                UnhookWindowsHookEx(actionKeysDialogHook);
-                actionKeysDialogHook = nullptr;
-            }
+            // Stop capturing keys
+            SetKeyboardHookSubscriberEnabled(KeyboardHookClient::ActionKeysDialog, false);
+            actionKeysDialogWindow = nullptr;
             
             // Restore the original active profile colors
             RestoreActiveProfileColors();
-            savedActiveProfileForActionKeys = nullptr;
             
             EndDialog(hDlg, LOWORD(wParam));
             return (INT_PTR)TRUE;
@@ -474,15 +426,12 @@ INT_PTR CALLBACK ActionKeysDialog(HWND hDlg, UINT message, WPARAM wParam, LPARAM
         break;
         
     case WM_CLOSE:
-        // Remove keyboard hook
-        if (actionKeysDialogHook) {
-            UnhookWindowsHookEx(actionKeysDialogHook);
-            actionKeysDialogHook = nullptr;
-        }
+        // Stop capturing keys
+        SetKeyboardHookSubscriberEnabled(KeyboardHookClient::ActionKeysDialog, false);
+        actionKeysDialogWindow = nullptr;
         
         // Restore the original active profile colors
         RestoreActiveProfileColors();
-        savedActiveProfileForActionKeys = nullptr;
         
         EndDialog(hDlg, IDCANCEL);
         return (INT_PTR)TRUE;
@@ -506,25 +455,10 @@ INT_PTR CALLBACK AddProfileDialog(HWND hDlg, UINT message, WPARAM wParam, LPARAM
                 // Get visible and minimized running processes
                 std::vector<std::wstring> processes = GetVisibleAndMinimizedRunningProcesses();
                 
-                // Get existing profiles to filter out apps that already have profiles
-                std::vector<AppColorProfile> existingProfiles = GetAppColorProfilesCopy();
-                
                 // Add processes to combo box, but filter out those that already have profiles
                 for (const auto& process : processes) {
-                    bool hasProfile = false;
-                    
-                    // Check if this process already has a profile (case-insensitive)
-                    for (const auto& profile : existingProfiles) {
-                        std::wstring lowerProcess = process;
-                        std::wstring lowerProfileApp = profile.appName;
-                        std::transform(lowerProcess.begin(), lowerProcess.end(), lowerProcess.begin(), ::towlower);
-                        std::transform(lowerProfileApp.begin(), lowerProfileApp.end(), lowerProfileApp.begin(), ::towlower);
-                        
-                        if (lowerProcess == lowerProfileApp) {
-                            hasProfile = true;
-                            break;
-                        }
-                    }
+                    // Check if this process already has a stored profile (case-insensitive)
+                    bool hasProfile = AppProfileExists(process);
                     
                     // Only add to combo box if it doesn't already have a profile
                     if (!hasProfile) {
@@ -556,19 +490,7 @@ INT_PTR CALLBACK AddProfileDialog(HWND hDlg, UINT message, WPARAM wParam, LPARAM
                     }
                     
                     // Check if profile already exists (double-check since user can type manually)
-                    std::vector<AppColorProfile> profiles = GetAppColorProfilesCopy();
-                    bool exists = false;
-                    for (const auto& profile : profiles) {
-                        std::wstring lowerExisting = profile.appName;
-                        std::wstring lowerNew = appName;
-                        std::transform(lowerExisting.begin(), lowerExisting.end(), lowerExisting.begin(), ::towlower);
-                        std::transform(lowerNew.begin(), lowerNew.end(), lowerNew.begin(), ::towlower);
-                        
-                        if (lowerExisting == lowerNew) {
-                            exists = true;
-                            break;
-                        }
-                    }
+                    bool exists = AppProfileExists(appName);
                     
                     if (exists) {
                         MessageBoxW(hDlg, L"Profile already exists for this application!", L"Add Profile", MB_OK | MB_ICONWARNING);
@@ -585,13 +507,13 @@ INT_PTR CALLBACK AddProfileDialog(HWND hDlg, UINT message, WPARAM wParam, LPARAM
                     // Add the profile
                     AddAppColorProfile(newAppName, appColor, lockKeysEnabled);
                     
-                    // Get the added profile, set highlight color, action color and save to registry
-                    AppColorProfile* newProfile = GetAppProfileByName(newAppName);
-                    if (newProfile) {
-                        newProfile->appHighlightColor = highlightColor;
-                        newProfile->appActionColor = actionColor;
+                    // Set highlight color and action color, then save to registry
+                    UpdateAppProfileColorProperty(newAppName, highlightColor, ColorUpdateType::HighlightColor);
+                    UpdateAppProfileColorProperty(newAppName, actionColor, ColorUpdateType::ActionColor);
+                    AppColorProfile newProfile;
+                    if (GetAppProfileCopy(newAppName, newProfile)) {
                         // highlightKeys and actionKeys are already empty by default
-                        AddAppProfileToRegistry(*newProfile);
+                        AddAppProfileToStore(newProfile);
                     }
                     
                     // Close the dialog and refresh the main window
@@ -680,9 +602,9 @@ void ShowAppColorPicker(HWND hWnd, int colorType) {
     WCHAR appName[256]{};
     SendMessageW(hCombo, CB_GETLBTEXT, selectedIndex, (LPARAM)appName);
     
-    // Get the current profile
-    AppColorProfile* profile = GetAppProfileByName(appName);
-    if (!profile) {
+    // Get the current profile (effective colors, including inherited ones)
+    AppColorProfile profile;
+    if (!GetResolvedAppProfileCopy(appName, profile)) {
         MessageBoxW(hWnd, L"Profile not found", L"Error", MB_OK | MB_ICONERROR);
         return;
     }
@@ -693,15 +615,15 @@ void ShowAppColorPicker(HWND hWnd, int colorType) {
     
     switch (colorType) {
         case 1: // Highlight color
-            currentColor = profile->appHighlightColor;
+            currentColor = profile.appHighlightColor;
             updateType = ColorUpdateType::HighlightColor;
             break;
         case 2: // Action color
-            currentColor = profile->appActionColor;
+            currentColor = profile.appActionColor;
             updateType = ColorUpdateType::ActionColor;
             break;
         default: // App color
-            currentColor = profile->appColor;
+            currentColor = profile.appColor;
             updateType = ColorUpdateType::AppColor;
             break;
     }
@@ -714,13 +636,13 @@ void ShowAppColorPicker(HWND hWnd, int colorType) {
         // Update registry based on type
         switch (colorType) {
             case 1: // Highlight color
-                UpdateAppProfileHighlightColorInRegistry(appName, currentColor);
+                UpdateAppProfileHighlightColorInStore(appName, currentColor);
                 break;
             case 2: // Action color
-                UpdateAppProfileActionColorInRegistry(appName, currentColor);
+                UpdateAppProfileActionColorInStore(appName, currentColor);
                 break;
             default: // App color
-                UpdateAppProfileColorInRegistry(appName, currentColor);
+                UpdateAppProfileColorInStore(appName, currentColor);
                 break;
         }
         
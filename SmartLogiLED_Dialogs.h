@@ -30,10 +30,6 @@ void ShowKeysDialog(HWND hWnd);
 void ShowActionKeysDialog(HWND hWnd);
 void ShowAddProfileDialog(HWND hWnd);
 
-// Dialog hook procedures for key capture
-LRESULT CALLBACK KeysDialogKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam);
-LRESULT CALLBACK ActionKeysDialogKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam);
-
 // Color picker dialogs
 void ShowAppColorPicker(HWND hWnd, int colorType);
 
@@ -0,0 +1,403 @@
+// SmartLogiLED_EvdevInputSource.cpp : Contains the Linux evdev input source.
+//
+// Every /dev/input/event* device with letter keys is read by one thread (poll over all devices
+// plus an eventfd for wake-ups). Linux key codes are translated to the virtual key codes and
+// extended flags the Windows hook reports, and lock key states come from the EV_LED events and
+// EVIOCGLED. Devices are enumerated when the source starts; keyboards plugged in later are not
+// seen until it is restarted. A source created with device descriptors reads those instead
+// (anything that delivers input_event records, e.g. a pipe in the tests).
+//
+// Key capture cannot drop single events from evdev, so while it is on the keyboards are grabbed
+// (EVIOCGRAB) and every key event the sink does not swallow is written to a uinput keyboard.
+
+#include "SmartLogiLED_InputSource.h"
+
+#ifdef __linux__
+
+#include "SmartLogiLED_Constants.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <linux/uinput.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+
+// Linux key code -> virtual key code and flags as the Windows hook reports the key
+struct EvdevKeyMapping {
+    uint16_t code;
+    uint8_t vkCode;
+    uint8_t flags;
+};
+
+static const EvdevKeyMapping evdevKeyMappings[] = {
+    { KEY_ESC, 0x1B, 0 },
+    { KEY_1, 0x31, 0 }, { KEY_2, 0x32, 0 }, { KEY_3, 0x33, 0 }, { KEY_4, 0x34, 0 }, { KEY_5, 0x35, 0 },
+    { KEY_6, 0x36, 0 }, { KEY_7, 0x37, 0 }, { KEY_8, 0x38, 0 }, { KEY_9, 0x39, 0 }, { KEY_0, 0x30, 0 },
+    { KEY_MINUS, 0xBD, 0 }, { KEY_EQUAL, 0xBB, 0 }, { KEY_BACKSPACE, 0x08, 0 }, { KEY_TAB, 0x09, 0 },
+    { KEY_Q, 0x51, 0 }, { KEY_W, 0x57, 0 }, { KEY_E, 0x45, 0 }, { KEY_R, 0x52, 0 }, { KEY_T, 0x54, 0 },
+    { KEY_Y, 0x59, 0 }, { KEY_U, 0x55, 0 }, { KEY_I, 0x49, 0 }, { KEY_O, 0x4F, 0 }, { KEY_P, 0x50, 0 },
+    { KEY_LEFTBRACE, 0xDB, 0 }, { KEY_RIGHTBRACE, 0xDD, 0 }, { KEY_ENTER, 0x0D, 0 },
+    { KEY_LEFTCTRL, 0xA2, 0 },
+    { KEY_A, 0x41, 0 }, { KEY_S, 0x53, 0 }, { KEY_D, 0x44, 0 }, { KEY_F, 0x46, 0 }, { KEY_G, 0x47, 0 },
+    { KEY_H, 0x48, 0 }, { KEY_J, 0x4A, 0 }, { KEY_K, 0x4B, 0 }, { KEY_L, 0x4C, 0 },
+    { KEY_SEMICOLON, 0xBA, 0 }, { KEY_APOSTROPHE, 0xDE, 0 }, { KEY_GRAVE, 0xC0, 0 },
+    { KEY_LEFTSHIFT, 0xA0, 0 }, { KEY_BACKSLASH, 0xDC, 0 },
+    { KEY_Z, 0x5A, 0 }, { KEY_X, 0x58, 0 }, { KEY_C, 0x43, 0 }, { KEY_V, 0x56, 0 }, { KEY_B, 0x42, 0 },
+    { KEY_N, 0x4E, 0 }, { KEY_M, 0x4D, 0 },
+    { KEY_COMMA, 0xBC, 0 }, { KEY_DOT, 0xBE, 0 }, { KEY_SLASH, 0xBF, 0 }, { KEY_RIGHTSHIFT, 0xA1, 0 },
+    { KEY_KPASTERISK, 0x6A, 0 }, { KEY_LEFTALT, 0xA4, 0 }, { KEY_SPACE, 0x20, 0 }, { KEY_CAPSLOCK, 0x14, 0 },
+    { KEY_F1, 0x70, 0 }, { KEY_F2, 0x71, 0 }, { KEY_F3, 0x72, 0 }, { KEY_F4, 0x73, 0 }, { KEY_F5, 0x74, 0 },
+    { KEY_F6, 0x75, 0 }, { KEY_F7, 0x76, 0 }, { KEY_F8, 0x77, 0 }, { KEY_F9, 0x78, 0 }, { KEY_F10, 0x79, 0 },
+    { KEY_NUMLOCK, 0x90, INPUT_KEY_FLAG_EXTENDED }, { KEY_SCROLLLOCK, 0x91, 0 },
+    { KEY_KP7, 0x67, 0 }, { KEY_KP8, 0x68, 0 }, { KEY_KP9, 0x69, 0 }, { KEY_KPMINUS, 0x6D, 0 },
+    { KEY_KP4, 0x64, 0 }, { KEY_KP5, 0x65, 0 }, { KEY_KP6, 0x66, 0 }, { KEY_KPPLUS, 0x6B, 0 },
+    { KEY_KP1, 0x61, 0 }, { KEY_KP2, 0x62, 0 }, { KEY_KP3, 0x63, 0 }, { KEY_KP0, 0x60, 0 }, { KEY_KPDOT, 0x6E, 0 },
+    { KEY_102ND, 0xE2, 0 }, { KEY_F11, 0x7A, 0 }, { KEY_F12, 0x7B, 0 },
+    { KEY_KPENTER, 0x0D, INPUT_KEY_FLAG_EXTENDED }, { KEY_RIGHTCTRL, 0xA3, INPUT_KEY_FLAG_EXTENDED },
+    { KEY_KPSLASH, 0x6F, INPUT_KEY_FLAG_EXTENDED }, { KEY_SYSRQ, 0x2C, INPUT_KEY_FLAG_EXTENDED },
+    { KEY_RIGHTALT, 0xA5, INPUT_KEY_FLAG_EXTENDED },
+    { KEY_HOME, 0x24, INPUT_KEY_FLAG_EXTENDED }, { KEY_UP, 0x26, INPUT_KEY_FLAG_EXTENDED },
+    { KEY_PAGEUP, 0x21, INPUT_KEY_FLAG_EXTENDED }, { KEY_LEFT, 0x25, INPUT_KEY_FLAG_EXTENDED },
+    { KEY_RIGHT, 0x27, INPUT_KEY_FLAG_EXTENDED }, { KEY_END, 0x23, INPUT_KEY_FLAG_EXTENDED },
+    { KEY_DOWN, 0x28, INPUT_KEY_FLAG_EXTENDED }, { KEY_PAGEDOWN, 0x22, INPUT_KEY_FLAG_EXTENDED },
+    { KEY_INSERT, 0x2D, INPUT_KEY_FLAG_EXTENDED }, { KEY_DELETE, 0x2E, INPUT_KEY_FLAG_EXTENDED },
+    { KEY_PAUSE, 0x13, 0 },
+    { KEY_LEFTMETA, 0x5B, INPUT_KEY_FLAG_EXTENDED }, { KEY_RIGHTMETA, 0x5C, INPUT_KEY_FLAG_EXTENDED },
+    { KEY_COMPOSE, 0x5D, INPUT_KEY_FLAG_EXTENDED },
+    { KEY_F13, 0x7C, 0 }, { KEY_F14, 0x7D, 0 }, { KEY_F15, 0x7E, 0 }, { KEY_F16, 0x7F, 0 },
+    { KEY_F17, 0x80, 0 }, { KEY_F18, 0x81, 0 }, { KEY_F19, 0x82, 0 }, { KEY_F20, 0x83, 0 },
+    { KEY_F21, 0x84, 0 }, { KEY_F22, 0x85, 0 }, { KEY_F23, 0x86, 0 }, { KEY_F24, 0x87, 0 }
+};
+
+static const size_t EVDEV_KEY_BITS_LONGS = KEY_MAX / (8 * sizeof(unsigned long)) + 1;
+static const size_t EVDEV_LED_BITS_LONGS = LED_MAX / (8 * sizeof(unsigned long)) + 1;
+
+static bool TestEvdevBit(const unsigned long* bits, unsigned int bit) {
+    const unsigned int bitsPerLong = 8 * sizeof(unsigned long);
+    return (bits[bit / bitsPerLong] >> (bit % bitsPerLong)) & 1UL;
+}
+
+// Translation table indexed by Linux key code (vkCode 0 = key not reported)
+struct EvdevKeyTable {
+    EvdevKeyMapping byCode[KEY_CNT] = {};
+    EvdevKeyTable() {
+        for (const EvdevKeyMapping& mapping : evdevKeyMappings) {
+            byCode[mapping.code] = mapping;
+        }
+    }
+};
+
+static const EvdevKeyTable& GetEvdevKeyTable() {
+    static const EvdevKeyTable table;
+    return table;
+}
+
+static uint32_t GetEvdevLockKeyBit(uint16_t ledCode) {
+    switch (ledCode) {
+        case LED_NUML:    return LOCK_KEY_STATE_NUM;
+        case LED_CAPSL:   return LOCK_KEY_STATE_CAPS;
+        case LED_SCROLLL: return LOCK_KEY_STATE_SCROLL;
+        default:          return 0;
+    }
+}
+
+// Open every readable input device that has letter keys (keyboards, not mice or power buttons)
+static std::vector<int> OpenEvdevKeyboards() {
+    std::vector<int> descriptors;
+    DIR* directory = opendir(INPUT_EVDEV_DIRECTORY);
+    if (!directory) {
+        return descriptors;
+    }
+    while (dirent* entry = readdir(directory)) {
+        if (std::strncmp(entry->d_name, "event", 5) != 0 || descriptors.size() >= INPUT_EVDEV_MAX_DEVICES) {
+            continue;
+        }
+        std::string path = std::string(INPUT_EVDEV_DIRECTORY) + "/" + entry->d_name;
+        int descriptor = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (descriptor < 0) {
+            continue; // Usually missing permissions (member of the "input" group needed)
+        }
+        unsigned long keyBits[EVDEV_KEY_BITS_LONGS] = {};
+        if (ioctl(descriptor, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits) < 0 ||
+            !TestEvdevBit(keyBits, KEY_A) || !TestEvdevBit(keyBits, KEY_SPACE)) {
+            close(descriptor);
+            continue;
+        }
+        descriptors.push_back(descriptor);
+    }
+    closedir(directory);
+    return descriptors;
+}
+
+static uint32_t ReadEvdevLockKeyStates(int descriptor) {
+    unsigned long ledBits[EVDEV_LED_BITS_LONGS] = {};
+    if (ioctl(descriptor, EVIOCGLED(sizeof(ledBits)), ledBits) < 0) {
+        return 0;
+    }
+    uint32_t states = 0;
+    for (uint16_t ledCode : { LED_NUML, LED_CAPSL, LED_SCROLLL }) {
+        if (TestEvdevBit(ledBits, ledCode)) {
+            states |= GetEvdevLockKeyBit(ledCode);
+        }
+    }
+    return states;
+}
+
+class EvdevInputSource : public IInputEventSource {
+public:
+    explicit EvdevInputSource(std::vector<int> devices) : givenKeyboards(std::move(devices)) {
+    }
+
+    ~EvdevInputSource() override {
+        Stop();
+        for (int descriptor : givenKeyboards) {
+            close(descriptor);
+        }
+    }
+
+    const wchar_t* GetName() const override {
+        return L"evdev";
+    }
+
+    bool Start(InputKeyEventSink sink) override {
+        if (readerThread.joinable()) {
+            return true;
+        }
+        keyboards = OpenKeyboards();
+        wakeDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (keyboards.empty() || wakeDescriptor < 0) {
+            CloseDescriptors();
+            return false;
+        }
+        uint32_t states = 0;
+        for (int descriptor : keyboards) {
+            states |= ReadEvdevLockKeyStates(descriptor);
+        }
+        lockKeyStates = states;
+        stopRequested = false;
+        readerThread = std::thread(&EvdevInputSource::ReaderThreadProc, this, sink);
+        return true;
+    }
+
+    void Stop() override {
+        if (!readerThread.joinable()) {
+            return;
+        }
+        stopRequested = true;
+        WakeReader();
+        readerThread.join();
+        CloseDescriptors();
+    }
+
+    bool IsRunning() const override {
+        return readerThread.joinable();
+    }
+
+    void SetKeyCapture(bool capture) override {
+        captureRequested = capture;
+        WakeReader(); // The reader grabs or releases the keyboards between events
+    }
+
+    uint32_t ReadLockKeyStates() override {
+        if (IsRunning()) {
+            return lockKeyStates.load();
+        }
+        std::vector<int> descriptors = OpenKeyboards();
+        uint32_t states = 0;
+        for (int descriptor : descriptors) {
+            states |= ReadEvdevLockKeyStates(descriptor);
+        }
+        ReleaseKeyboards(descriptors);
+        return states;
+    }
+
+    bool IsKeyDown(uint32_t vkCode) override {
+        std::vector<int> descriptors = IsRunning() ? keyboards : OpenKeyboards();
+        bool down = false;
+        for (int descriptor : descriptors) {
+            unsigned long keyBits[EVDEV_KEY_BITS_LONGS] = {};
+            if (ioctl(descriptor, EVIOCGKEY(sizeof(keyBits)), keyBits) < 0) {
+                continue;
+            }
+            for (const EvdevKeyMapping& mapping : evdevKeyMappings) {
+                down |= mapping.vkCode == vkCode && TestEvdevBit(keyBits, mapping.code);
+            }
+        }
+        if (!IsRunning()) {
+            ReleaseKeyboards(descriptors);
+        }
+        return down;
+    }
+
+    uint32_t GetSinkTimeoutMs() override {
+        return 0; // The kernel queues events while the reader is busy
+    }
+
+private:
+    std::vector<int> OpenKeyboards() {
+        return givenKeyboards.empty() ? OpenEvdevKeyboards() : givenKeyboards;
+    }
+
+    void ReleaseKeyboards(const std::vector<int>& descriptors) {
+        if (givenKeyboards.empty()) {
+            for (int descriptor : descriptors) {
+                close(descriptor);
+            }
+        }
+    }
+
+    void WakeReader() {
+        if (wakeDescriptor >= 0) {
+            uint64_t one = 1;
+            ssize_t written = write(wakeDescriptor, &one, sizeof(one));
+            (void)written; // A full counter still wakes the reader
+        }
+    }
+
+    void CloseDescriptors() {
+        ReleaseKeyboards(keyboards);
+        keyboards.clear();
+        if (wakeDescriptor >= 0) {
+            close(wakeDescriptor);
+            wakeDescriptor = -1;
+        }
+    }
+
+    // Virtual keyboard that receives the key events the sink lets through while grabbed
+    bool CreateForwardingKeyboard() {
+        uinputDescriptor = open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+        if (uinputDescriptor < 0) {
+            return false;
+        }
+        bool created = ioctl(uinputDescriptor, UI_SET_EVBIT, EV_KEY) >= 0;
+        for (const EvdevKeyMapping& mapping : evdevKeyMappings) {
+            created = created && ioctl(uinputDescriptor, UI_SET_KEYBIT, mapping.code) >= 0;
+        }
+        uinput_setup setup{};
+        setup.id.bustype = BUS_VIRTUAL;
+        std::strncpy(setup.name, "SmartLogiLED key capture", UINPUT_MAX_NAME_SIZE - 1);
+        created = created && ioctl(uinputDescriptor, UI_DEV_SETUP, &setup) >= 0 && ioctl(uinputDescriptor, UI_DEV_CREATE) >= 0;
+        if (!created) {
+            close(uinputDescriptor);
+            uinputDescriptor = -1;
+        }
+        return created;
+    }
+
+    void ForwardKeyEvent(const input_event& keyEvent) {
+        input_event events[2] = { keyEvent, {} };
+        events[1].type = EV_SYN;
+        events[1].code = SYN_REPORT;
+        ssize_t written = write(uinputDescriptor, events, sizeof(events));
+        (void)written; // A lost forward is a dropped key, as with a removed hook
+    }
+
+    // Grab or release the keyboards when the capture state changes (reader thread)
+    void ApplyKeyCapture(bool capture) {
+        if (capture == captureActive) {
+            return;
+        }
+        if (capture) {
+            if (!CreateForwardingKeyboard()) {
+                return; // Without uinput the keys cannot be forwarded, so nothing is grabbed
+            }
+            for (int descriptor : keyboards) {
+                ioctl(descriptor, EVIOCGRAB, 1);
+            }
+        } else {
+            for (int descriptor : keyboards) {
+                ioctl(descriptor, EVIOCGRAB, 0);
+            }
+            ioctl(uinputDescriptor, UI_DEV_DESTROY); // Releases keys still held on the virtual keyboard
+            close(uinputDescriptor);
+            uinputDescriptor = -1;
+        }
+        captureActive = capture;
+    }
+
+    void HandleEvdevEvent(const input_event& rawEvent, InputKeyEventSink sink) {
+        if (rawEvent.type == EV_LED) {
+            uint32_t bit = GetEvdevLockKeyBit(rawEvent.code);
+            if (rawEvent.value) {
+                lockKeyStates.fetch_or(bit);
+            } else {
+                lockKeyStates.fetch_and(~bit);
+            }
+            return;
+        }
+        if (rawEvent.type != EV_KEY || rawEvent.code >= KEY_CNT) {
+            return;
+        }
+        const EvdevKeyMapping& mapping = GetEvdevKeyTable().byCode[rawEvent.code];
+        bool swallow = false;
+        if (mapping.vkCode != 0) {
+            InputKeyEvent event;
+            event.vkCode = mapping.vkCode;
+            event.flags = mapping.flags;
+            event.keyDown = (rawEvent.value != 0); // 1 = press, 2 = auto-repeat
+            swallow = sink(event) && event.keyDown;
+        }
+        if (captureActive && !swallow) {
+            ForwardKeyEvent(rawEvent);
+        }
+    }
+
+    void ReaderThreadProc(InputKeyEventSink sink) {
+        std::vector<pollfd> pollDescriptors;
+        for (int descriptor : keyboards) {
+            pollDescriptors.push_back({ descriptor, POLLIN, 0 });
+        }
+        pollDescriptors.push_back({ wakeDescriptor, POLLIN, 0 });
+
+        input_event rawEvents[64];
+        while (!stopRequested) {
+            ApplyKeyCapture(captureRequested.load());
+            if (poll(pollDescriptors.data(), pollDescriptors.size(), -1) < 0 && errno != EINTR) {
+                break;
+            }
+            for (pollfd& entry : pollDescriptors) {
+                if (entry.fd == wakeDescriptor) {
+                    uint64_t count = 0;
+                    ssize_t drained = read(wakeDescriptor, &count, sizeof(count));
+                    (void)drained;
+                    continue;
+                }
+                if (entry.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                    entry.fd = -1; // Unplugged: poll ignores negative descriptors
+                    continue;
+                }
+                if (!(entry.revents & POLLIN)) {
+                    continue;
+                }
+                ssize_t bytes = read(entry.fd, rawEvents, sizeof(rawEvents));
+                for (ssize_t index = 0; bytes > 0 && index < bytes / static_cast<ssize_t>(sizeof(input_event)); ++index) {
+                    HandleEvdevEvent(rawEvents[index], sink);
+                }
+            }
+        }
+        ApplyKeyCapture(false); // Grabbed again on the next start if capture is still on
+    }
+
+    std::vector<int> givenKeyboards;
+    std::vector<int> keyboards;
+    int wakeDescriptor = -1;
+    int uinputDescriptor = -1;
+    std::thread readerThread;
+    std::atomic<bool> stopRequested{ false };
+    std::atomic<bool> captureRequested{ false };
+    bool captureActive = false;             // Reader thread
+    std::atomic<uint32_t> lockKeyStates{ 0 };
+};
+
+std::unique_ptr<IInputEventSource> CreateEvdevInputSource(std::vector<int> keyboards) {
+    return std::unique_ptr<IInputEventSource>(new EvdevInputSource(std::move(keyboards)));
+}
+
+#endif // __linux__
@@ -0,0 +1,173 @@
+// SmartLogiLED_Heatmap.cpp : Contains the typing heatmap mode (frame timer, rendering, persistence).
+//
+// The counters and heat values live in SmartLogiLED_HeatmapCounters.cpp. Every frame the
+// timer folds the counted presses into the heat values and only keys whose gradient color
+// changed are sent to the SDK.
+
+#include "framework.h"
+#include "SmartLogiLED_Heatmap.h"
+#include "SmartLogiLED_HeatmapCounters.h"
+#include "SmartLogiLED_LockKeys.h"
+#include "SmartLogiLED_AppProfiles.h"
+#include "SmartLogiLED_Config.h"
+#include "SmartLogiLED_KeyboardHook.h"
+#include "SmartLogiLED_Platform.h"
+#include "SmartLogiLED_Constants.h"
+#include <atomic>
+#include <ctime>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// Module-specific variables
+static std::atomic<bool> heatmapModeEnabled{ false };
+static HWND heatmapWindow = nullptr;
+
+// Frame timer state (UI thread)
+static COLORREF heatmapFrameColors[HEATMAP_MAX_KEYS];
+static COLORREF heatmapPaintedColors[HEATMAP_MAX_KEYS];
+static bool heatmapFullFramePending = true;
+static bool heatmapDirty = false;                               // Counted presses not saved yet
+static ULONGLONG heatmapLastFrameTick = 0;
+static ULONGLONG heatmapLastSaveTick = 0;
+static std::thread heatmapSaveThread;
+
+// ======================================================================
+// RENDERING
+// ======================================================================
+
+// Paint the keys whose color changed (every key after RequestHeatmapFullFrame)
+static void RenderHeatmapFrame() {
+    ComputeHeatmapColors(heatmapFrameColors);
+
+    bool fullFrame = heatmapFullFramePending;
+    heatmapFullFramePending = false;
+    if (fullFrame) {
+        SetDefaultColor(GetHeatmapColor(0.0)); // Keys without a counter (G keys, logo) stay cold
+    }
+
+    for (size_t i = 0; i < GetHeatmapKeyCount(); ++i) {
+        COLORREF color = heatmapFrameColors[i];
+        if (fullFrame || color != heatmapPaintedColors[i]) {
+            SetKeyColor(GetHeatmapKey(i), color);
+            heatmapPaintedColors[i] = color;
+        }
+    }
+}
+
+// ======================================================================
+// PERSISTENCE
+// ======================================================================
+
+std::wstring GetHeatmapFilePath() {
+    std::wstring storePath = GetProfileStorePath();
+    size_t separator = storePath.find_last_of(L"\\/");
+    return (separator == std::wstring::npos ? std::wstring() : storePath.substr(0, separator + 1)) + HEATMAP_FILE_NAME;
+}
+
+// Read the saved heat values, decayed by the time since they were saved (UI thread, mode off)
+static void LoadHeatmapFromFile() {
+    MappedFile file;
+    if (!MapFileReadOnly(GetHeatmapFilePath(), file)) {
+        return;
+    }
+    LoadHeatmapImage(file.data, file.size, static_cast<uint64_t>(std::time(nullptr)));
+    UnmapFile(file);
+}
+
+// Write the heat values in the background (UI thread; waits for the previous write)
+static void SaveHeatmapToFile() {
+    if (heatmapSaveThread.joinable()) {
+        heatmapSaveThread.join();
+    }
+
+    std::vector<uint8_t> image = BuildHeatmapImage(static_cast<uint64_t>(std::time(nullptr)));
+    heatmapDirty = false;
+    heatmapLastSaveTick = GetTickCount64();
+    heatmapSaveThread = std::thread([image = std::move(image)]() {
+        if (!WriteFileAtomically(GetHeatmapFilePath(), image.data(), image.size())) {
+#ifdef ENABLE_DEBUG_LOGGING
+            OutputDebugStringW(L"[DEBUG] Failed to save the typing heatmap\n");
+#endif
+        }
+    });
+}
+
+// ======================================================================
+// MODE
+// ======================================================================
+
+bool IsHeatmapModeEnabled() {
+    return heatmapModeEnabled.load(std::memory_order_relaxed);
+}
+
+void SetHeatmapModeEnabled(HWND hWnd, bool enabled) {
+    if (enabled == IsHeatmapModeEnabled()) {
+        return;
+    }
+
+    if (enabled) {
+        ResetHeatmapCounters();
+        LoadHeatmapFromFile();
+
+        heatmapWindow = hWnd;
+        heatmapFullFramePending = true;
+        heatmapDirty = false;
+        heatmapLastFrameTick = heatmapLastSaveTick = GetTickCount64();
+        heatmapModeEnabled = true;
+
+        // Counting runs inside the hook (it does not need the hook worker)
+        KeyboardHookSubscriber subscriber;
+        subscriber.inlineHandler = CountHeatmapKeyEvent;
+        SubscribeKeyboardHook(KeyboardHookClient::Heatmap, subscriber);
+        SetKeyboardHookSubscriberEnabled(KeyboardHookClient::Heatmap, true);
+        SetTimer(hWnd, HEATMAP_FRAME_TIMER_ID, HEATMAP_FRAME_INTERVAL_MS, nullptr);
+        RenderHeatmapFrame();
+    } else {
+        KillTimer(heatmapWindow, HEATMAP_FRAME_TIMER_ID);
+        SetKeyboardHookSubscriberEnabled(KeyboardHookClient::Heatmap, false);
+        heatmapModeEnabled = false;
+        AggregateHeatmapCounts((GetTickCount64() - heatmapLastFrameTick) / 1000.0);
+        SaveHeatmapToFile();
+        ApplyDisplayedProfileColors(); // Back to the profile colors
+    }
+    SaveHeatmapModeSetting(enabled);
+
+#ifdef ENABLE_DEBUG_LOGGING
+    std::wstringstream debugMsg;
+    debugMsg << L"[DEBUG] Typing heatmap " << (enabled ? L"enabled" : L"disabled") << L" (" << GetHeatmapKeyCount() << L" keys)\n";
+    OutputDebugStringW(debugMsg.str().c_str());
+#endif
+}
+
+void RequestHeatmapFullFrame() {
+    heatmapFullFramePending = true;
+}
+
+void OnHeatmapFrameTimer() {
+    if (!IsHeatmapModeEnabled()) {
+        return;
+    }
+
+    // Decay by the real time since the last frame (timer messages are not exact)
+    ULONGLONG now = GetTickCount64();
+    heatmapDirty |= AggregateHeatmapCounts((now - heatmapLastFrameTick) / 1000.0);
+    heatmapLastFrameTick = now;
+    RenderHeatmapFrame();
+
+    if (heatmapDirty && now - heatmapLastSaveTick >= HEATMAP_SAVE_INTERVAL_MS) {
+        SaveHeatmapToFile();
+    }
+}
+
+void ShutdownHeatmap() {
+    if (IsHeatmapModeEnabled()) {
+        KillTimer(heatmapWindow, HEATMAP_FRAME_TIMER_ID);
+        SetKeyboardHookSubscriberEnabled(KeyboardHookClient::Heatmap, false);
+        AggregateHeatmapCounts((GetTickCount64() - heatmapLastFrameTick) / 1000.0);
+        SaveHeatmapToFile();
+    }
+    if (heatmapSaveThread.joinable()) {
+        heatmapSaveThread.join();
+    }
+}
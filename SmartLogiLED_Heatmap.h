@@ -0,0 +1,20 @@
+// SmartLogiLED_Heatmap.h : Header file for the typing heatmap mode.
+//
+// While the mode is on, the keyboard hook counts key presses into one atomic counter per key
+// and a main window timer folds the counts into time-decayed heat values, painting the
+// keyboard as a blue-to-red gradient instead of the displayed profile's colors.
+
+#pragma once
+
+#include "framework.h"
+#include <string>
+
+// Mode (UI thread)
+void SetHeatmapModeEnabled(HWND hWnd, bool enabled);   // Starts/stops the frame timer, loads/saves the heat values
+bool IsHeatmapModeEnabled();                            // Any thread
+void RequestHeatmapFullFrame();                         // Repaint every key on the next frame (e.g. after a profile apply)
+void OnHeatmapFrameTimer();                             // HEATMAP_FRAME_TIMER_ID
+void ShutdownHeatmap();                                 // Save the heat values and wait for the write (application exit)
+
+// Heat values are kept next to the profile store
+std::wstring GetHeatmapFilePath();
@@ -0,0 +1,185 @@
+// SmartLogiLED_HeatmapCounters.cpp : Contains the typing heatmap counters, heat values and gradient.
+//
+// The hook runs on the UI thread and only does a table lookup and a relaxed atomic add per key
+// press: the pressed LED key (FilterKeyPress) maps to a dense key index built when the mode
+// is turned on. The frame timer, also on the UI thread, swaps the counters to zero and adds
+// them to heat values that halve every HEATMAP_HALF_LIFE_SECONDS.
+
+#include "SmartLogiLED_HeatmapCounters.h"
+#include "SmartLogiLED_KeyMapping.h"
+#include "SmartLogiLED_Constants.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+static const uint16_t HEATMAP_NO_KEY = 0xFFFF;
+
+// Heatmap file: header, then one entry per key with heat
+struct HeatmapFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t savedAt;               // Unix time in seconds
+};
+
+struct HeatmapFileEntry {
+    uint32_t keyName;               // LogiLed::KeyName (the dense index is rebuilt per session)
+    float heat;
+};
+
+static_assert(sizeof(HeatmapFileHeader) == 24, "Heatmap file header layout changed");
+static_assert(sizeof(HeatmapFileEntry) == 8, "Heatmap file entry layout changed");
+
+// Module-specific variables
+static uint16_t heatmapKeyIndexByKey[KEYBOARD_HOOK_PRESS_KEY_COUNT]; // Written before the mode is on, read by the hook
+static KeyPressFilter heatmapPressFilter;                       // Hook only
+static std::atomic<uint32_t> heatmapCounters[HEATMAP_MAX_KEYS]; // Key presses since the last frame
+
+// Frame timer state (UI thread)
+static std::vector<LogiLed::KeyName> heatmapKeys;               // Dense key index -> key
+static double heatmapHeat[HEATMAP_MAX_KEYS];
+
+// ======================================================================
+// KEY INDEX
+// ======================================================================
+
+void ResetHeatmapCounters() {
+    heatmapKeys.clear();
+    for (size_t keyName = 0; keyName < KEYBOARD_HOOK_PRESS_KEY_COUNT; ++keyName) {
+        heatmapKeyIndexByKey[keyName] = HEATMAP_NO_KEY;
+
+        LogiLed::KeyName key = static_cast<LogiLed::KeyName>(keyName);
+        if (!IsLogiLedKeyKnown(key) || heatmapKeys.size() >= HEATMAP_MAX_KEYS) {
+            continue;
+        }
+        heatmapKeyIndexByKey[keyName] = static_cast<uint16_t>(heatmapKeys.size());
+        heatmapKeys.push_back(key);
+    }
+
+    for (auto& counter : heatmapCounters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+    ResetKeyPressFilter(heatmapPressFilter);
+    std::fill(heatmapHeat, heatmapHeat + HEATMAP_MAX_KEYS, 0.0);
+}
+
+size_t GetHeatmapKeyCount() {
+    return heatmapKeys.size();
+}
+
+LogiLed::KeyName GetHeatmapKey(size_t keyIndex) {
+    return heatmapKeys[keyIndex];
+}
+
+static int FindHeatmapKeyIndex(LogiLed::KeyName key) {
+    auto it = std::find(heatmapKeys.begin(), heatmapKeys.end(), key);
+    return it != heatmapKeys.end() ? static_cast<int>(it - heatmapKeys.begin()) : -1;
+}
+
+// ======================================================================
+// HOOK SIDE
+// ======================================================================
+
+void CountHeatmapKeyEvent(const InputKeyEvent& keyEvent) {
+    LogiLed::KeyName key;
+    if (!FilterKeyPress(heatmapPressFilter, keyEvent, key)) {
+        return;
+    }
+    uint16_t keyIndex = heatmapKeyIndexByKey[key];
+    if (keyIndex != HEATMAP_NO_KEY) {
+        heatmapCounters[keyIndex].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// ======================================================================
+// AGGREGATION AND COLORS
+// ======================================================================
+
+bool AggregateHeatmapCounts(double elapsedSeconds) {
+    double decay = std::exp2(-elapsedSeconds / HEATMAP_HALF_LIFE_SECONDS);
+    bool pressed = false;
+    for (size_t i = 0; i < heatmapKeys.size(); ++i) {
+        uint32_t count = heatmapCounters[i].exchange(0, std::memory_order_relaxed);
+        heatmapHeat[i] = heatmapHeat[i] * decay + count;
+        pressed |= count != 0;
+    }
+    return pressed;
+}
+
+COLORREF GetHeatmapColor(double level) {
+    static const COLORREF stops[] = {
+        RGB(0, 0, 160),     // Cold
+        RGB(0, 160, 255),
+        RGB(0, 255, 0),
+        RGB(255, 255, 0),
+        RGB(255, 0, 0)      // Hottest
+    };
+    const int segments = static_cast<int>(sizeof(stops) / sizeof(stops[0])) - 1;
+
+    double position = (std::min)((std::max)(level, 0.0), 1.0) * segments;
+    int segment = (std::min)(static_cast<int>(position), segments - 1);
+    double t = position - segment;
+    COLORREF from = stops[segment];
+    COLORREF to = stops[segment + 1];
+    return RGB(static_cast<int>(GetRValue(from) + (GetRValue(to) - GetRValue(from)) * t + 0.5),
+               static_cast<int>(GetGValue(from) + (GetGValue(to) - GetGValue(from)) * t + 0.5),
+               static_cast<int>(GetBValue(from) + (GetBValue(to) - GetBValue(from)) * t + 0.5));
+}
+
+void ComputeHeatmapColors(COLORREF* colors) {
+    double maxHeat = 0.0;
+    for (size_t i = 0; i < heatmapKeys.size(); ++i) {
+        maxHeat = (std::max)(maxHeat, heatmapHeat[i]);
+    }
+    for (size_t i = 0; i < heatmapKeys.size(); ++i) {
+        // Square root spreads the typical typing distribution (a few very hot keys) over the gradient
+        double level = maxHeat > 0.0 ? std::sqrt(heatmapHeat[i] / maxHeat) : 0.0;
+        colors[i] = GetHeatmapColor(level);
+    }
+}
+
+// ======================================================================
+// FILE IMAGE
+// ======================================================================
+
+std::vector<uint8_t> BuildHeatmapImage(uint64_t savedAt) {
+    HeatmapFileHeader header{};
+    header.magic = HEATMAP_FILE_MAGIC;
+    header.version = HEATMAP_FILE_VERSION;
+    header.savedAt = savedAt;
+
+    std::vector<uint8_t> image(sizeof(header));
+    for (size_t i = 0; i < heatmapKeys.size(); ++i) {
+        if (heatmapHeat[i] <= 0.0) {
+            continue;
+        }
+        HeatmapFileEntry entry{ static_cast<uint32_t>(heatmapKeys[i]), static_cast<float>(heatmapHeat[i]) };
+        image.insert(image.end(), reinterpret_cast<const uint8_t*>(&entry), reinterpret_cast<const uint8_t*>(&entry) + sizeof(entry));
+        ++header.entryCount;
+    }
+    memcpy(image.data(), &header, sizeof(header));
+    return image;
+}
+
+void LoadHeatmapImage(const uint8_t* data, size_t size, uint64_t now) {
+    HeatmapFileHeader header{};
+    if (size >= sizeof(header)) {
+        memcpy(&header, data, sizeof(header));
+    }
+    if (header.magic != HEATMAP_FILE_MAGIC || header.version != HEATMAP_FILE_VERSION ||
+        size < sizeof(header) + static_cast<uint64_t>(header.entryCount) * sizeof(HeatmapFileEntry)) {
+        return;
+    }
+
+    double decay = std::exp2(-static_cast<double>(now > header.savedAt ? now - header.savedAt : 0) / HEATMAP_HALF_LIFE_SECONDS);
+    for (uint32_t i = 0; i < header.entryCount; ++i) {
+        HeatmapFileEntry entry;
+        memcpy(&entry, data + sizeof(header) + i * sizeof(HeatmapFileEntry), sizeof(entry));
+        int keyIndex = FindHeatmapKeyIndex(static_cast<LogiLed::KeyName>(entry.keyName));
+        if (keyIndex >= 0 && std::isfinite(entry.heat) && entry.heat > 0.0f) {
+            heatmapHeat[keyIndex] = entry.heat * decay;
+        }
+    }
+}
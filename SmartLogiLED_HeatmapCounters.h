@@ -0,0 +1,35 @@
+// SmartLogiLED_HeatmapCounters.h : Header file for the typing heatmap counters and heat values.
+//
+// The part of the typing heatmap that neither touches the SDK nor the settings: the per-key
+// press counters the hook adds to, the time-decayed heat values the frame timer folds them
+// into, the gradient colors and the heat value file image. The Bench tool links it without
+// the application (SmartLogiLED_Heatmap.cpp runs the mode, the timer and the file).
+
+#pragma once
+
+#include "SmartLogiLED_WinTypes.h"
+#include "LogitechLEDLib.h"
+#include "SmartLogiLED_InputSource.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Give every key the key mapping knows a dense key index and zero the counters, the press
+// filter and the heat values (UI thread, while the hook subscriber is disabled)
+void ResetHeatmapCounters();
+
+// Hook side (inline hook subscriber): count one key event (lock-free, no system calls; auto-repeat is not counted)
+void CountHeatmapKeyEvent(const InputKeyEvent& keyEvent);
+
+// Frame timer (UI thread): fold the counted presses into the heat values; true if any key was pressed
+bool AggregateHeatmapCounts(double elapsedSeconds);
+
+// Dense key index -> key, and the gradient color of every dense key against the hottest key
+size_t GetHeatmapKeyCount();
+LogiLed::KeyName GetHeatmapKey(size_t keyIndex);
+void ComputeHeatmapColors(COLORREF* colors);    // GetHeatmapKeyCount() colors
+COLORREF GetHeatmapColor(double level);         // 0 (cold) to 1 (hottest key)
+
+// Heat value file image (keys with heat only); loading decays the values by the time since the save
+std::vector<uint8_t> BuildHeatmapImage(uint64_t savedAt);
+void LoadHeatmapImage(const uint8_t* data, size_t size, uint64_t now);
@@ -0,0 +1,162 @@
+// SmartLogiLED_HookInputSource.cpp : Contains the WH_KEYBOARD_LL input source and the input source selection.
+//
+// The hook procedure runs on the UI thread (the thread that installed it) and hands every key
+// to the multiplexer's sink (SmartLogiLED_KeyboardHook.cpp). Windows removes the hook when a
+// call overruns LowLevelHooksTimeout, which the source reports as its sink timeout.
+
+#include "framework.h"
+#include "SmartLogiLED_KeyboardHook.h"
+#include "SmartLogiLED_InputSource.h"
+#include "SmartLogiLED_Platform.h"
+#include "SmartLogiLED_Constants.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cwchar>
+#include <shellapi.h>
+#include <sstream>
+
+static_assert(INPUT_KEY_FLAG_EXTENDED == LLKHF_EXTENDED && INPUT_KEY_FLAG_INJECTED == LLKHF_INJECTED, "Input key flags must match the hook flags");
+
+// Module-specific variables
+static HHOOK keyboardHook = nullptr;                        // The only WH_KEYBOARD_LL hook of the application
+static InputKeyEventSink keyboardHookSink = nullptr;        // Receives the hook's events
+
+// ======================================================================
+// HOOK INPUT SOURCE
+// ======================================================================
+
+// LowLevelHooksTimeout in milliseconds (HKCU\Control Panel\Desktop)
+static DWORD ReadLowLevelHooksTimeout() {
+    DWORD timeoutMs = 0;
+    DWORD size = sizeof(timeoutMs);
+    if (RegGetValueW(HKEY_CURRENT_USER, L"Control Panel\\Desktop", L"LowLevelHooksTimeout", RRF_RT_REG_DWORD, nullptr, &timeoutMs, &size) != ERROR_SUCCESS || timeoutMs == 0) {
+        timeoutMs = KEYBOARD_HOOK_DEFAULT_TIMEOUT_MS;
+    }
+    return timeoutMs;
+}
+
+// The application's only low-level keyboard hook: hand the key to the multiplexer
+static LRESULT CALLBACK KeyboardHookProc(int nCode, WPARAM wParam, LPARAM lParam) {
+    if (nCode >= 0 && keyboardHookSink) {
+        const KBDLLHOOKSTRUCT* keyInfo = reinterpret_cast<const KBDLLHOOKSTRUCT*>(lParam);
+        InputKeyEvent keyEvent;
+        keyEvent.vkCode = keyInfo->vkCode;
+        keyEvent.flags = keyInfo->flags;
+        keyEvent.time = keyInfo->time;
+        keyEvent.keyDown = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
+        if (keyboardHookSink(keyEvent)) {
+            return 1; // Prevent the key from being processed by other applications
+        }
+    }
+    return CallNextHookEx(keyboardHook, nCode, wParam, lParam);
+}
+
+// WH_KEYBOARD_LL hook on the thread that starts it (the UI thread)
+class KeyboardHookInputSource : public IInputEventSource {
+public:
+    ~KeyboardHookInputSource() override {
+        Stop();
+    }
+
+    const wchar_t* GetName() const override {
+        return L"Keyboard hook";
+    }
+
+    bool Start(InputKeyEventSink sink) override {
+        if (keyboardHook) {
+            return true;
+        }
+        keyboardHookSink = sink;
+        keyboardHook = SetWindowsHookEx(WH_KEYBOARD_LL, KeyboardHookProc, GetModuleHandle(nullptr), 0);
+        return keyboardHook != nullptr;
+    }
+
+    void Stop() override {
+        if (keyboardHook && UnhookWindowsHookEx(keyboardHook)) {
+            keyboardHook = nullptr;
+        }
+    }
+
+    bool IsRunning() const override {
+        return keyboardHook != nullptr;
+    }
+
+    void SetKeyCapture(bool) override {
+        // The hook procedure swallows each captured key itself
+    }
+
+    // GetKeyState follows the input of the calling thread (the UI thread)
+    uint32_t ReadLockKeyStates() override {
+        uint32_t states = 0;
+        if (GetKeyState(VK_NUMLOCK) & 0x0001) states |= LOCK_KEY_STATE_NUM;
+        if (GetKeyState(VK_CAPITAL) & 0x0001) states |= LOCK_KEY_STATE_CAPS;
+        if (GetKeyState(VK_SCROLL) & 0x0001)  states |= LOCK_KEY_STATE_SCROLL;
+        return states;
+    }
+
+    bool IsKeyDown(uint32_t vkCode) override {
+        return (GetAsyncKeyState(static_cast<int>(vkCode)) & 0x8000) != 0;
+    }
+
+    uint32_t GetSinkTimeoutMs() override {
+        return ReadLowLevelHooksTimeout();
+    }
+};
+
+std::unique_ptr<IInputEventSource> CreateKeyboardHookInputSource() {
+    return std::unique_ptr<IInputEventSource>(new KeyboardHookInputSource());
+}
+
+// ======================================================================
+// SOURCE SELECTION
+// ======================================================================
+
+// Replay a key recording instead of the keyboard: /replay <file> [/replayspeed <factor>] [/replayloops <count>]
+void SelectInputEventSource(LPCWSTR commandLine) {
+    int argumentCount = 0;
+    LPWSTR* arguments = (commandLine && *commandLine) ? CommandLineToArgvW(commandLine, &argumentCount) : nullptr;
+    if (!arguments) {
+        return;
+    }
+
+    std::wstring recordingPath;
+    double speedFactor = INPUT_REPLAY_DEFAULT_SPEED;
+    uint32_t loopCount = 1;
+    std::wstring loopText;
+    for (int index = 0; index + 1 < argumentCount; ++index) {
+        if (_wcsicmp(arguments[index], L"/replay") == 0) {
+            recordingPath = arguments[++index];
+        } else if (_wcsicmp(arguments[index], L"/replayspeed") == 0) {
+            speedFactor = (std::max)(0.0, _wtof(arguments[++index]));
+        } else if (_wcsicmp(arguments[index], L"/replayloops") == 0) {
+            loopText = arguments[++index];
+        }
+    }
+    LocalFree(arguments);
+    if (recordingPath.empty()) {
+        return;
+    }
+    if (!loopText.empty()) {
+        // Whole argument must be a count of at least one; a typo keeps the keyboard instead of looping 0 or 4 billion times
+        wchar_t* end = nullptr;
+        errno = 0;
+        unsigned long parsedLoops = wcstoul(loopText.c_str(), &end, 10);
+        if (loopText[0] == L'-' || end == loopText.c_str() || *end != L'\0' || errno == ERANGE || parsedLoops < 1 || parsedLoops > UINT32_MAX) {
+            // Logged on every occurrence (not only with ENABLE_DEBUG_LOGGING)
+            std::wstringstream message;
+            message << L"[HOOK] Invalid /replayloops value \"" << loopText << L"\" - using the keyboard instead of the replay\n";
+            WriteDebugLog(message.str());
+            return;
+        }
+        loopCount = static_cast<uint32_t>(parsedLoops);
+    }
+
+    std::vector<RecordedKeyEvent> events;
+    std::wstring errorMessage;
+    if (!LoadKeyRecording(recordingPath, events, errorMessage)) {
+        MessageBoxW(nullptr, (errorMessage + L"\n\nThe keyboard is used instead.").c_str(), L"Key Replay", MB_OK | MB_ICONWARNING);
+        return;
+    }
+    SetInputEventSource(CreateReplayInputSource(std::move(events), speedFactor, loopCount));
+}
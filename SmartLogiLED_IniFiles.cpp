@@ -5,16 +5,21 @@
 #include "SmartLogiLED_ProcessMonitor.h"
 #include "SmartLogiLED_Dialogs.h"
 #include "SmartLogiLED_Version.h"
+#include "SmartLogiLED_IniParser.h"
+#include "SmartLogiLED_Platform.h"
+#include "SmartLogiLED_Constants.h"
+#include "SmartLogiLED_PersistenceWorker.h"
 #include "Resource.h"
 #include <windows.h>
 #include <string>
 #include <vector>
 #include <algorithm>
 #include <sstream>
-#include <iomanip>
 #include <shlobj.h>
-#include <set>
+#include <atomic>
 #include <functional>
+#include <thread>
+#include <unordered_map>
 
 // Forward declaration for combo box refresh
 void RefreshAppProfileCombo(HWND hWnd);
@@ -36,214 +41,118 @@ INT CALLBACK BrowseCallbackProc(HWND hwnd, UINT uMsg, LPARAM lParam, LPARAM lpDa
     return 0;
 }
 
+// Run work(0..itemCount-1) on one thread per core (including the calling thread); each
+// thread takes the next unprocessed item, so slow files do not hold up a whole share
+static void RunOnWorkerThreads(size_t itemCount, const std::function<void(size_t)>& work) {
+    std::atomic<size_t> nextItem{ 0 };
+    auto processItems = [&]() {
+        for (size_t i = nextItem++; i < itemCount; i = nextItem++) {
+            work(i);
+        }
+    };
+    
+    size_t workerCount = (std::min)(itemCount, static_cast<size_t>((std::max)(1u, std::thread::hardware_concurrency())));
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < workerCount; ++i) {
+        workers.emplace_back(processItems);
+    }
+    processItems();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+// Build the file name of a profile: SmartLogiLED_<appname>.ini (without .exe, unsafe characters replaced)
+static std::wstring GetProfileIniFileName(const std::wstring& appName) {
+    std::wstring appBaseName = appName;
+    if (appBaseName.length() > 4 && appBaseName.substr(appBaseName.length() - 4) == L".exe") {
+        appBaseName = appBaseName.substr(0, appBaseName.length() - 4);
+    }
+    std::wstring validChars = L"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_-";
+    for (auto& ch : appBaseName) {
+        if (validChars.find(ch) == std::wstring::npos) {
+            ch = L'_';
+        }
+    }
+    return L"SmartLogiLED_" + appBaseName + L".ini";
+}
+
 // Update the existing INI file or create a new one while preserving comments
-void UpdateOrCreateProfileIniFile(const std::wstring& filename, const AppColorProfile& profile) {
-    std::wstringstream newContent;
-    bool fileExists = false;
+bool UpdateOrCreateProfileIniFile(const std::wstring& filename, const AppColorProfile& profile) {
+    std::string newContent;
     bool foundProfileSection = false;
     
-    // Track which keys we've seen during parsing
-    std::set<std::wstring> seenKeys;
-    
-    // Check if file exists and read existing content
-    HANDLE hFile = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, 
-                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    // Track which keys we've seen during parsing (bit per ProfileIniKey)
+    DWORD seenKeys = 0;
     
-    if (hFile != INVALID_HANDLE_VALUE) {
-        fileExists = true;
-        DWORD fileSize = GetFileSize(hFile, nullptr);
-        if (fileSize != INVALID_FILE_SIZE && fileSize > 0) {
-            std::vector<char> buffer(fileSize + 1);
-            DWORD bytesRead = 0;
-            
-            if (ReadFile(hFile, buffer.data(), fileSize, &bytesRead, nullptr)) {
-                buffer[bytesRead] = '\0';
-                
-                // Convert from UTF-8 to wide string
-                int wideSize = MultiByteToWideChar(CP_UTF8, 0, buffer.data(), -1, nullptr, 0);
-                if (wideSize > 0) {
-                    std::wstring existingContent(wideSize - 1, L'\0');
-                    MultiByteToWideChar(CP_UTF8, 0, buffer.data(), -1, &existingContent[0], wideSize);
-                    
-                    // Parse and update existing content
-                    std::wstringstream ss(existingContent);
-                    std::wstring line;
-                    bool inProfileSection = false;
-                    
-                    while (std::getline(ss, line)) {
-                        std::wstring trimmedLine = line;
-                        trimmedLine.erase(0, trimmedLine.find_first_not_of(L" \t\r\n"));
-                        trimmedLine.erase(trimmedLine.find_last_not_of(L" \t\r\n") + 1);
-                        
-                        if (trimmedLine == L"[SmartLogiLED Profile]") {
-                            foundProfileSection = true;
-                            inProfileSection = true;
-                            newContent << line << L"\n";
-                            continue;
-                        }
-                        
-                        if (trimmedLine.empty() || trimmedLine[0] == L';') {
-                            // Preserve empty lines and comments
-                            newContent << line << L"\n";
-                            continue;
-                        }
-                        
-                        if (trimmedLine[0] == L'[') {
-                            // Before leaving the profile section, add any missing keys
-                            if (inProfileSection) {
-                                AddMissingProfileKeys(newContent, profile, seenKeys);
-                            }
-                            inProfileSection = false;
-                            newContent << line << L"\n";
-                            continue;
-                        }
-                        
-                        if (inProfileSection) {
-                            size_t equalPos = trimmedLine.find(L'=');
-                            if (equalPos != std::wstring::npos) {
-                                std::wstring key = trimmedLine.substr(0, equalPos);
-                                key.erase(0, key.find_first_not_of(L" \t"));
-                                key.erase(key.find_last_not_of(L" \t") + 1);
-                                
-                                // Track that we've seen this key
-                                seenKeys.insert(key);
-                                
-                                // Update profile values, keep everything else
-                                if (key == L"AppName") {
-                                    newContent << L"AppName=" << profile.appName << L"\n";
-                                } else if (key == L"AppColor") {
-                                    newContent << L"AppColor=" << std::hex << std::setfill(L'0') << std::setw(6) << (profile.appColor & 0xFFFFFF) << L"\n";
-                                } else if (key == L"AppHighlightColor") {
-                                    newContent << L"AppHighlightColor=" << std::hex << std::setfill(L'0') << std::setw(6) << (profile.appHighlightColor & 0xFFFFFF) << L"\n";
-                                } else if (key == L"AppActionColor") {
-                                    newContent << L"AppActionColor=" << std::hex << std::setfill(L'0') << std::setw(6) << (profile.appActionColor & 0xFFFFFF) << L"\n";
-                                } else if (key == L"LockKeysEnabled") {
-                                    newContent << L"LockKeysEnabled=" << (profile.lockKeysEnabled ? L"1" : L"0") << L"\n";
-                                } else if (key == L"HighlightKeys") {
-                                    newContent << L"HighlightKeys=";
-                                    if (!profile.highlightKeys.empty()) {
-										// sort keys for consistent order
-										std::vector<LogiLed::KeyName> sortedKeys = profile.highlightKeys;
-										std::sort(sortedKeys.begin(), sortedKeys.end());
-
-                                        for (size_t i = 0; i < sortedKeys.size(); ++i) {
-                                            if (i > 0) newContent << L",";
-                                            newContent << LogiLedKeyToDisplayName(sortedKeys[i]);
-                                        }
-                                    }
-                                    newContent << L"\n";
-                                } else if (key == L"ActionKeys") {
-                                    newContent << L"ActionKeys=";
-                                    if (!profile.actionKeys.empty()) {
-										//sort keys for consistent order
-										std::vector<LogiLed::KeyName> sortedKeys = profile.actionKeys;
-										std::sort(sortedKeys.begin(), sortedKeys.end());
-
-                                        for (size_t i = 0; i < sortedKeys.size(); ++i) {
-                                            if (i > 0) newContent << L",";
-                                            newContent << LogiLedKeyToDisplayName(sortedKeys[i]);
-                                        }
-                                    }
-                                    newContent << L"\n";
-                                } else {
-                                    // Keep any other unknown keys unchanged
-                                    newContent << line << L"\n";
-                                }
-                            } else {
-                                // Keep non-key=value lines unchanged
-                                newContent << line << L"\n";
-                            }
-                        } else {
-                            // Keep lines outside profile section unchanged
-                            newContent << line << L"\n";
-                        }
-                    }
+    // Scan the existing file in place; lines outside the profile values are copied byte for byte
+    MappedFile existingFile;
+    if (MapFileReadOnly(filename, existingFile)) {
+        std::string_view text(reinterpret_cast<const char*>(existingFile.data), existingFile.size);
+        std::string_view body = SkipUtf8ByteOrderMark(text);
+        newContent.reserve(text.size() + 256);
+        newContent.append(text.data(), text.size() - body.size()); // Keep the BOM if there is one
+        
+        IniLine line;
+        bool inProfileSection = false;
+        while (ReadIniLine(body, line)) {
+            if (line.type == IniLineType::Section) {
+                // Before leaving the profile section, add any missing keys
+                if (inProfileSection) {
+                    AddMissingProfileKeys(newContent, profile, seenKeys);
+                }
+                inProfileSection = (line.trimmed == PROFILE_INI_SECTION);
+                foundProfileSection = foundProfileSection || inProfileSection;
+            } else if (inProfileSection && line.type == IniLineType::KeyValue) {
+                ProfileIniKey key = GetProfileIniKey(line.key);
+                if (key != ProfileIniKey::Unknown) {
+                    seenKeys |= 1u << static_cast<int>(key);
                     
-                    // If we ended while still in the profile section, add missing keys
-                    if (inProfileSection) {
-                        AddMissingProfileKeys(newContent, profile, seenKeys);
+                    // Update profile values; fields the profile inherits from its parent are dropped
+                    if (ShouldWriteProfileIniKey(profile, key)) {
+                        AppendProfileIniLine(newContent, profile, key);
                     }
+                    continue;
                 }
             }
+            
+            // Keep comments, empty lines, unknown keys and other sections unchanged
+            newContent.append(line.raw.data(), line.raw.size());
+            newContent.push_back('\n');
         }
-        CloseHandle(hFile);
-    }
-    
-    // If file doesn't exist or no profile section found, create new content
-    if (!fileExists || !foundProfileSection) {
-        if (foundProfileSection) {
-            // Profile section exists but needs update - content already built above
-        } else {
-            // Create completely new content
-            newContent.str(L"");
-            newContent.clear();
-            newContent << L"[SmartLogiLED Profile]\n";
-            newContent << L"AppName=" << profile.appName << L"\n";
-            newContent << L"AppColor=" << std::hex << std::setfill(L'0') << std::setw(6) << (profile.appColor & 0xFFFFFF) << L"\n";
-            newContent << L"AppHighlightColor=" << std::hex << std::setfill(L'0') << std::setw(6) << (profile.appHighlightColor & 0xFFFFFF) << L"\n";
-            newContent << L"AppActionColor=" << std::hex << std::setfill(L'0') << std::setw(6) << (profile.appActionColor & 0xFFFFFF) << L"\n";
-            newContent << L"LockKeysEnabled=" << (profile.lockKeysEnabled ? L"1" : L"0") << L"\n";
-            if (!profile.highlightKeys.empty()) {
-                newContent << L"HighlightKeys=";
-                for (size_t i = 0; i < profile.highlightKeys.size(); ++i) {
-                    if (i > 0) newContent << L",";
-                    newContent << LogiLedKeyToDisplayName(profile.highlightKeys[i]);
-                }
-                newContent << L"\n";
-            } else {
-                newContent << L"HighlightKeys=\n";
-            }
-            if (!profile.actionKeys.empty()) {
-                newContent << L"ActionKeys=";
-                for (size_t i = 0; i < profile.actionKeys.size(); ++i) {
-                    if (i > 0) newContent << L",";
-                    newContent << LogiLedKeyToDisplayName(profile.actionKeys[i]);
-                }
-                newContent << L"\n";
-            } else {
-                newContent << L"ActionKeys=\n";
-            }
-            newContent << L"\n";
-            newContent << L"; SmartLogiLED Profile Export\n";
-            newContent << L"; Generated by " << SMARTLOGILED_PRODUCT_NAME << L" v" << SMARTLOGILED_VERSION_STRING << L" (" << SMARTLOGILED_BUILD_TYPE << L")\n";
-            newContent << L"; " << SMARTLOGILED_COPYRIGHT << L"\n";
-            newContent << L"; \n";
-            newContent << L"; AppColor, AppHighlightColor, and AppActionColor are in hexadecimal RGB format (e.g., FF0000 = Red)\n";
-            newContent << L"; LockKeysEnabled: 1 = enabled, 0 = disabled\n";
-            newContent << L"; HighlightKeys: Comma-separated list of key names to highlight\n";
-            newContent << L"; ActionKeys: Comma-separated list of key names for actions\n";
+        
+        // If we ended while still in the profile section, add missing keys
+        if (inProfileSection) {
+            AddMissingProfileKeys(newContent, profile, seenKeys);
         }
+        UnmapFile(existingFile); // Must be closed before the file is replaced
     }
     
-    // Write the updated content back to file
-    hFile = CreateFileW(filename.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
-    if (hFile != INVALID_HANDLE_VALUE) {
-        std::string utf8Content;
-        int utf8Size = WideCharToMultiByte(CP_UTF8, 0, newContent.str().c_str(), -1, nullptr, 0, nullptr, nullptr);
-        if (utf8Size > 0) {
-            utf8Content.resize(utf8Size - 1);
-            WideCharToMultiByte(CP_UTF8, 0, newContent.str().c_str(), -1, &utf8Content[0], utf8Size, nullptr, nullptr);
-            DWORD bytesWritten = 0;
-            WriteFile(hFile, utf8Content.c_str(), static_cast<DWORD>(utf8Content.size()), &bytesWritten, nullptr);
-        }
-        CloseHandle(hFile);
-    }
-}
-
-// Helper function to get the application directory
-std::wstring GetApplicationDirectory() {
-    wchar_t exePath[MAX_PATH];
-    DWORD pathLen = GetModuleFileNameW(nullptr, exePath, MAX_PATH);
-    if (pathLen == 0 || pathLen == MAX_PATH) {
-        return L""; // Failed to get path
+    // If the file doesn't exist or has no profile section, create completely new content
+    if (!foundProfileSection) {
+        std::wstringstream header;
+        header << L"; Generated by " << SMARTLOGILED_PRODUCT_NAME << L" v" << SMARTLOGILED_VERSION_STRING << L" (" << SMARTLOGILED_BUILD_TYPE << L")\n";
+        header << L"; " << SMARTLOGILED_COPYRIGHT << L"\n";
+        
+        newContent.clear();
+        newContent += PROFILE_INI_SECTION "\n";
+        AddMissingProfileKeys(newContent, profile, seenKeys);
+        newContent += "\n";
+        newContent += "; SmartLogiLED Profile Export\n";
+        AppendWideAsUtf8(newContent, header.str());
+        newContent += "; \n";
+        newContent += "; AppColor, AppHighlightColor, and AppActionColor are in hexadecimal RGB format (e.g., FF0000 = Red)\n";
+        newContent += "; LockKeysEnabled: 1 = enabled, 0 = disabled\n";
+        newContent += "; HighlightKeys: Comma-separated list of key names to highlight\n";
+        newContent += "; ActionKeys: Comma-separated list of key names for actions\n";
+        newContent += "; KeyEffect: Reaction to key presses - None, Fade or Ripple (None if left out)\n";
+        newContent += "; ModifierLayer: Key groups lit while a modifier is held, e.g. Ctrl:Action,Shift:Highlight (Both = both groups)\n";
+        newContent += "; ModifierColor: Color of the modifier layer keys (hexadecimal RGB, FFFFFF if left out)\n";
+        newContent += "; ParentProfile: Optional template profile; keys left out of this file are inherited from it\n";
     }
     
-    std::wstring appDir = exePath;
-    size_t lastSlash = appDir.find_last_of(L'\\');
-    if (lastSlash != std::wstring::npos) {
-        appDir = appDir.substr(0, lastSlash);
-    }
-    return appDir;
+    // Write the updated content back to file
+    return WriteFileAtomically(filename, newContent.data(), newContent.size());
 }
 
 // Helper function to get the default AppProfiles export directory
@@ -261,15 +170,141 @@ std::wstring GetDefaultExportDirectory() {
     return exportDir;
 }
 
-// Export all profiles to individual INI files
-void ExportAllProfilesToIniFiles() {
+// ======================================================================
+// EXPORT ALL PROFILES (BACKGROUND)
+// ======================================================================
+
+static std::thread exportThread;
+static std::atomic<bool> exportRunning{ false };
+static std::atomic<bool> exportCancelRequested{ false };
+
+enum class ProfileExportResult { Unchanged, Created, Updated, Failed };
+
+// Export one profile; a file whose profile values already match the profile is not touched
+static ProfileExportResult ExportProfileToIniFile(const std::wstring& filename, const AppColorProfile& profile) {
+    bool fileExists = FileExists(filename);
+    if (fileExists) {
+        MappedFile existingFile;
+        if (MapFileReadOnly(filename, existingFile)) {
+            uint64_t fileHash = 0;
+            bool unchanged = HashProfileIniFile(std::string_view(reinterpret_cast<const char*>(existingFile.data), existingFile.size), fileHash) &&
+                             fileHash == HashProfileIniCanonical(profile);
+            UnmapFile(existingFile);
+            if (unchanged) {
+                return ProfileExportResult::Unchanged;
+            }
+        }
+    }
+    if (!UpdateOrCreateProfileIniFile(filename, profile)) {
+        return ProfileExportResult::Failed;
+    }
+    return fileExists ? ProfileExportResult::Updated : ProfileExportResult::Created;
+}
+
+// Export thread: files are compared and written in parallel; progress and the final report are posted to hWnd
+static void ExportAllProfilesThreadProc(HWND hWnd, std::wstring exportDir) {
+    ULONGLONG exportStart = GetTickCount64();
+    std::vector<std::wstring> profileNames = GetAppProfileNames();
+    size_t total = profileNames.size();
+    std::vector<ProfileExportResult> results(total, ProfileExportResult::Failed);
+    std::vector<std::wstring> errors(total);
+    
+    // Profiles whose names map to the same file are written once (by the first name)
+    std::vector<std::wstring> filenames(total);
+    std::unordered_map<std::wstring, size_t> profileByFile; // lower-case file name -> profile
+    for (size_t i = 0; i < total; ++i) {
+        filenames[i] = GetProfileIniFileName(profileNames[i]);
+        std::wstring fileKey = filenames[i];
+        std::transform(fileKey.begin(), fileKey.end(), fileKey.begin(), ::towlower);
+        auto inserted = profileByFile.emplace(fileKey, i);
+        if (!inserted.second) {
+            errors[i] = L"Skipped " + profileNames[i] + L": same file name as " + profileNames[inserted.first->second] + L"\n";
+            filenames[i].clear();
+        }
+    }
+    
+    // Report progress whenever the percentage changes
+    std::atomic<size_t> doneCount{ 0 };
+    std::atomic<size_t> postedPercent{ 0 };
+    RunOnWorkerThreads(total, [&](size_t i) {
+        if (exportCancelRequested || filenames[i].empty()) {
+            return;
+        }
+        AppColorProfile profile;
+        if (!GetAppProfileCopy(profileNames[i], profile)) {
+            errors[i] = L"Failed to read profile: " + profileNames[i] + L"\n";
+        } else {
+            std::wstring filename = exportDir + filenames[i];
+            results[i] = ExportProfileToIniFile(filename, profile);
+            if (results[i] == ProfileExportResult::Failed) {
+                errors[i] = L"Failed to update/create file: " + filename + L"\n";
+            }
+        }
+        
+        size_t done = ++doneCount;
+        size_t percent = done * 100 / total;
+        size_t previous = postedPercent.load();
+        if (percent > previous && postedPercent.compare_exchange_strong(previous, percent)) {
+            PostMessage(hWnd, WM_PROFILE_EXPORT_PROGRESS, static_cast<WPARAM>(done), static_cast<LPARAM>(total));
+        }
+    });
+    
+    if (exportCancelRequested) {
+        exportRunning = false;
+        return; // Closing - nobody is waiting for the report
+    }
+    
+    size_t createdCount = std::count(results.begin(), results.end(), ProfileExportResult::Created);
+    size_t updatedCount = std::count(results.begin(), results.end(), ProfileExportResult::Updated);
+    size_t unchangedCount = std::count(results.begin(), results.end(), ProfileExportResult::Unchanged);
+    std::wstring errorMessages;
+    for (const auto& error : errors) {
+        errorMessages += error;
+    }
+    
+    std::wstringstream resultMessage;
+    if (total == 0) {
+        resultMessage << L"No app profiles to export";
+    } else {
+        resultMessage << L"Export completed in " << (GetTickCount64() - exportStart) << L" ms.\n";
+        if (createdCount > 0) {
+            resultMessage << L"Created " << createdCount << L" new profile file(s).\n";
+        }
+        if (updatedCount > 0) {
+            resultMessage << L"Updated " << updatedCount << L" existing profile file(s).\n";
+        }
+        if (unchangedCount > 0) {
+            resultMessage << L"Skipped " << unchangedCount << L" unchanged profile file(s).\n";
+        }
+        resultMessage << L"Total profiles processed: " << total << L"\n";
+        resultMessage << L"Files location: " << exportDir << L"\n";
+        if (!errorMessages.empty()) {
+            resultMessage << L"\nErrors encountered:\n" << errorMessages;
+        }
+    }
+    
+    // The report is owned by the window once the message is posted
+    std::wstring* report = new std::wstring(resultMessage.str());
+    exportRunning = false;
+    if (!PostMessage(hWnd, WM_PROFILE_EXPORT_DONE, errorMessages.empty() ? 0 : 1, reinterpret_cast<LPARAM>(report))) {
+        delete report;
+    }
+}
+
+// Export all profiles to individual INI files (the folder is chosen here, the files are written in the background)
+void ExportAllProfilesToIniFiles(HWND hWnd) {
+    if (exportRunning) {
+        MessageBoxW(hWnd, L"An export is already running.", L"Export Profiles", MB_OK | MB_ICONINFORMATION);
+        return;
+    }
+    
     // Get default export directory
     std::wstring defaultDir = GetDefaultExportDirectory();
     
     // Show folder selection dialog with default directory via callback
     BROWSEINFOW bi = {0};
     wchar_t szFolder[MAX_PATH] = {0};
-    bi.hwndOwner = nullptr;
+    bi.hwndOwner = hWnd;
     bi.lpszTitle = L"Select folder to export profile INI files";
     bi.pszDisplayName = szFolder; // output buffer
     bi.ulFlags = BIF_RETURNONLYFSDIRS | BIF_NEWDIALOGSTYLE | BIF_EDITBOX;
@@ -278,70 +313,31 @@ void ExportAllProfilesToIniFiles() {
 
     PIDLIST_ABSOLUTE pidl = SHBrowseForFolderW(&bi);
     if (!pidl) {
-        MessageBoxW(nullptr, L"Export cancelled.", L"Export Profiles", MB_OK | MB_ICONINFORMATION);
+        MessageBoxW(hWnd, L"Export cancelled.", L"Export Profiles", MB_OK | MB_ICONINFORMATION);
         return;
     }
     if (!SHGetPathFromIDListW(pidl, szFolder)) {
         CoTaskMemFree(pidl);
-        MessageBoxW(nullptr, L"Failed to get selected folder path.", L"Export Error", MB_OK | MB_ICONERROR);
+        MessageBoxW(hWnd, L"Failed to get selected folder path.", L"Export Error", MB_OK | MB_ICONERROR);
         return;
     }
     CoTaskMemFree(pidl);
     std::wstring exportDir = szFolder;
     if (!exportDir.empty() && exportDir.back() != L'\\') exportDir += L'\\';
-
-    // Get all app profiles
-    std::vector<AppColorProfile> profiles = GetAppColorProfilesCopy();
-    if (profiles.empty()) {
-        MessageBoxW(nullptr, L"No app profiles to export", L"Export Profiles", MB_OK | MB_ICONINFORMATION);
-        return;
-    }
-    int exportedCount = 0;
-    int updatedCount = 0;
-    std::wstring errorMessages;
-    for (const auto& profile : profiles) {
-        // Create filename: SmartLogiLED_<appname>.ini
-        std::wstring appBaseName = profile.appName;
-        if (appBaseName.length() > 4 && appBaseName.substr(appBaseName.length() - 4) == L".exe") {
-            appBaseName = appBaseName.substr(0, appBaseName.length() - 4);
-        }
-        std::wstring validChars = L"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_-";
-        for (auto& ch : appBaseName) {
-            if (validChars.find(ch) == std::wstring::npos) {
-                ch = L'_';
-            }
-        }
-        std::wstring filename = exportDir + L"SmartLogiLED_" + appBaseName + L".ini";
-        
-        // Check if file already exists
-        bool fileExists = (GetFileAttributesW(filename.c_str()) != INVALID_FILE_ATTRIBUTES);
-        
-        try {
-            UpdateOrCreateProfileIniFile(filename, profile);
-            if (fileExists) {
-                updatedCount++;
-            } else {
-                exportedCount++;
-            }
-        } catch (...) {
-            errorMessages += L"Failed to update/create file: " + filename + L"\n";
-        }
+    
+    if (exportThread.joinable()) {
+        exportThread.join(); // Previous export has finished (exportRunning is false)
     }
-    std::wstringstream resultMessage;
-    resultMessage << L"Export completed.\n";
-    if (exportedCount > 0) {
-        resultMessage << L"Created " << exportedCount << L" new profile file(s).\n";
-    }
-    if (updatedCount > 0) {
-        resultMessage << L"Updated " << updatedCount << L" existing profile file(s).\n";
-    }
-    resultMessage << L"Total profiles processed: " << profiles.size() << L"\n";
-    resultMessage << L"Files location: " << exportDir << L"\n";
-    if (!errorMessages.empty()) {
-        resultMessage << L"\nErrors encountered:\n" << errorMessages;
-        MessageBoxW(nullptr, resultMessage.str().c_str(), L"Export Profiles", MB_OK | MB_ICONWARNING);
-    } else {
-        MessageBoxW(nullptr, resultMessage.str().c_str(), L"Export Profiles", MB_OK | MB_ICONINFORMATION);
+    exportCancelRequested = false;
+    exportRunning = true;
+    exportThread = std::thread(ExportAllProfilesThreadProc, hWnd, exportDir);
+}
+
+// Stop a running export and wait for its thread (called when the application closes)
+void WaitForProfileExport() {
+    exportCancelRequested = true;
+    if (exportThread.joinable()) {
+        exportThread.join();
     }
 }
 
@@ -364,9 +360,9 @@ void ExportSelectedProfileToIniFile(HWND hWnd) {
     WCHAR appName[256]{};
     SendMessageW(hCombo, CB_GETLBTEXT, selectedIndex, (LPARAM)appName);
     
-    // Get the profile data
-    AppColorProfile* profile = GetAppProfileByName(appName);
-    if (!profile) {
+    // Get the profile data (a copy - the engine may change the profile while the dialogs are open)
+    AppColorProfile profile;
+    if (!GetAppProfileCopy(appName, profile)) {
         MessageBoxW(hWnd, L"Selected profile not found.", L"Export Error", MB_OK | MB_ICONERROR);
         return;
     }
@@ -379,19 +375,7 @@ void ExportSelectedProfileToIniFile(HWND hWnd) {
     wchar_t szFile[MAX_PATH] = { 0 };
     
     // Create default filename: SmartLogiLED_<appname>.ini
-    std::wstring defaultName = L"SmartLogiLED_";
-    std::wstring appBaseName = profile->appName;
-    if (appBaseName.length() > 4 && appBaseName.substr(appBaseName.length() - 4) == L".exe") {
-        appBaseName = appBaseName.substr(0, appBaseName.length() - 4);
-    }
-    // Sanitize filename characters
-    std::wstring validChars = L"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_-";
-    for (auto& ch : appBaseName) {
-        if (validChars.find(ch) == std::wstring::npos) {
-            ch = L'_';
-        }
-    }
-    defaultName += appBaseName + L".ini";
+    std::wstring defaultName = GetProfileIniFileName(profile.appName);
     
     // If we have a default directory, include it in the full path
     if (!defaultExportDir.empty()) {
@@ -433,7 +417,10 @@ void ExportSelectedProfileToIniFile(HWND hWnd) {
     
     // Update or create the file
     try {
-        UpdateOrCreateProfileIniFile(szFile, *profile);
+        if (!UpdateOrCreateProfileIniFile(szFile, profile)) {
+            MessageBoxW(hWnd, L"Failed to update/create the profile file.", L"Export Error", MB_OK | MB_ICONERROR);
+            return;
+        }
         
         std::wstring successMessage = fileExists ? 
             L"Profile file updated successfully!\n\nAll comments have been preserved." :
@@ -470,195 +457,54 @@ void ImportProfileFromIniFile(HWND hWnd) {
         return; // User cancelled
     }
     
-    // Read and parse the INI file
+    // Map and parse the INI file (fields missing from the file keep the AppColorProfile defaults)
     AppColorProfile importedProfile;
-    bool profileValid = false;
-    std::wstring errorMessage;
-    
-    // Read file content
-    HANDLE hFile = CreateFileW(szFile, GENERIC_READ, FILE_SHARE_READ, nullptr, 
-                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
-    
-    if (hFile != INVALID_HANDLE_VALUE) {
-        DWORD fileSize = GetFileSize(hFile, nullptr);
-        if (fileSize != INVALID_FILE_SIZE && fileSize > 0) {
-            std::vector<char> buffer(fileSize + 1);
-            DWORD bytesRead = 0;
-            
-            if (ReadFile(hFile, buffer.data(), fileSize, &bytesRead, nullptr)) {
-                buffer[bytesRead] = '\0'; // Null terminate
-                
-                // Convert from UTF-8 to wide string
-                int wideSize = MultiByteToWideChar(CP_UTF8, 0, buffer.data(), -1, nullptr, 0);
-                if (wideSize > 0) {
-                    std::wstring fileContent(wideSize - 1, L'\0');
-                    MultiByteToWideChar(CP_UTF8, 0, buffer.data(), -1, &fileContent[0], wideSize);
-                    
-                    // Parse the INI content
-                    std::wstringstream ss(fileContent);
-                    std::wstring line;
-                    bool inProfileSection = false;
-                    
-                    // Initialize with defaults
-                    importedProfile.appColor = RGB(0, 255, 255);
-                    importedProfile.appHighlightColor = RGB(255, 255, 255);
-                    importedProfile.appActionColor = RGB(255, 255, 0);
-                    importedProfile.lockKeysEnabled = true;
-                    importedProfile.isAppRunning = false;
-                    importedProfile.isProfileCurrInUse = false;
-                    
-                    while (std::getline(ss, line)) {
-                        // Trim whitespace
-                        line.erase(0, line.find_first_not_of(L" \t\r\n"));
-                        line.erase(line.find_last_not_of(L" \t\r\n") + 1);
-                        
-                        if (line.empty() || line[0] == L';') {
-                            continue; // Skip empty lines and comments
-                        }
-                        
-                        if (line == L"[SmartLogiLED Profile]") {
-                            inProfileSection = true;
-                            continue;
-                        }
-                        
-                        if (line[0] == L'[') {
-                            inProfileSection = false;
-                            continue;
-                        }
-                        
-                        if (inProfileSection) {
-                            size_t equalPos = line.find(L'=');
-                            if (equalPos != std::wstring::npos) {
-                                std::wstring key = line.substr(0, equalPos);
-                                std::wstring value = line.substr(equalPos + 1);
-                                
-                                // Trim key and value
-                                key.erase(0, key.find_first_not_of(L" \t"));
-                                key.erase(key.find_last_not_of(L" \t") + 1);
-                                value.erase(0, value.find_first_not_of(L" \t"));
-                                value.erase(value.find_last_not_of(L" \t") + 1);
-                                
-                                if (key == L"AppName") {
-                                    importedProfile.appName = value;
-                                    profileValid = true;
-                                } else if (key == L"AppColor") {
-                                    try {
-                                        unsigned long colorValue = std::wcstoul(value.c_str(), nullptr, 16);
-                                        importedProfile.appColor = static_cast<COLORREF>(colorValue);
-                                    } catch (...) {
-                                        // Keep default color on parse error
-                                    }
-                                } else if (key == L"AppHighlightColor") {
-                                    try {
-                                        unsigned long colorValue = std::wcstoul(value.c_str(), nullptr, 16);
-                                        importedProfile.appHighlightColor = static_cast<COLORREF>(colorValue);
-                                    } catch (...) {
-                                        // Keep default color on parse error
-                                    }
-                                } else if (key == L"AppActionColor") {
-                                    try {
-                                        unsigned long colorValue = std::wcstoul(value.c_str(), nullptr, 16);
-                                        importedProfile.appActionColor = static_cast<COLORREF>(colorValue);
-                                    } catch (...) {
-                                        // Keep default color on parse error
-                                    }
-                                } else if (key == L"LockKeysEnabled") {
-                                    importedProfile.lockKeysEnabled = (value == L"1");
-                                } else if (key == L"HighlightKeys") {
-                                    if (!value.empty()) {
-                                        // Parse comma-separated key names
-                                        std::wstringstream keyStream(value);
-                                        std::wstring keyName;
-                                        
-                                        while (std::getline(keyStream, keyName, L',')) {
-                                            // Trim whitespace
-                                            keyName.erase(0, keyName.find_first_not_of(L" \t"));
-                                            keyName.erase(keyName.find_last_not_of(L" \t") + 1);
-                                            
-                                            if (!keyName.empty()) {
-                                                LogiLed::KeyName logiKey = DisplayNameToLogiLedKey(keyName);
-                                                if (logiKey != LogiLed::KeyName::ESC || keyName == L"ESC") {
-                                                    importedProfile.highlightKeys.push_back(logiKey);
-                                                }
-                                            }
-                                        }
-                                    }
-                                } else if (key == L"ActionKeys") {
-                                    if (!value.empty()) {
-                                        // Parse comma-separated key names
-                                        std::wstringstream keyStream(value);
-                                        std::wstring keyName;
-                                        
-                                        while (std::getline(keyStream, keyName, L',')) {
-                                            // Trim whitespace
-                                            keyName.erase(0, keyName.find_first_not_of(L" \t"));
-                                            keyName.erase(keyName.find_last_not_of(L" \t") + 1);
-                                            
-                                            if (!keyName.empty()) {
-                                                LogiLed::KeyName logiKey = DisplayNameToLogiLedKey(keyName);
-                                                if (logiKey != LogiLed::KeyName::ESC || keyName == L"ESC") {
-                                                    importedProfile.actionKeys.push_back(logiKey);
-                                                }
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-					//sort keys for consistent order
-					std::sort(importedProfile.highlightKeys.begin(), importedProfile.highlightKeys.end());
-					std::sort(importedProfile.actionKeys.begin(), importedProfile.actionKeys.end());
-                }
-            }
-        }
-        CloseHandle(hFile);
+    ProfileIniParseResult parseResult;
+    MappedFile iniFile;
+    if (MapFileReadOnly(szFile, iniFile)) {
+        parseResult = ParseProfileIni(std::string_view(reinterpret_cast<const char*>(iniFile.data), iniFile.size), importedProfile);
+        UnmapFile(iniFile);
+    } else {
+        parseResult.problems = L"The file could not be read or is empty.\n";
     }
+    DWORD importedFields = parseResult.presentFields; // PROFILE_FIELD_* present in the file
+    bool profileValid = parseResult.valid;
     
-    // If the profile is valid, add or update it in the registry
+    if (!parseResult.problems.empty()) {
+        std::wstring message = profileValid ?
+            L"The profile was imported, but some values were ignored:\n\n" + parseResult.problems :
+            L"The file is not a valid profile:\n\n" + parseResult.problems;
+        MessageBoxW(hWnd, message.c_str(), L"Import Profile", MB_OK | (profileValid ? MB_ICONWARNING : MB_ICONERROR));
+    }
+    
+    // If the profile is valid, add or replace it with one engine event
     if (profileValid) {
-        // Check if profile already exists
-        AppColorProfile* existingProfile = GetAppProfileByName(importedProfile.appName);
-        if (existingProfile) {
+        if (AppProfileExists(importedProfile.appName)) {
             std::wstring message = L"A profile for '" + importedProfile.appName + L"' already exists.\n\nDo you want to overwrite it?";
             int result = MessageBoxW(hWnd, message.c_str(), L"Profile Exists", MB_YESNO | MB_ICONQUESTION);
             
             if (result == IDNO) {
                 return; // User cancelled or chose not to overwrite
             }
-            
-            // Update existing profile
-            existingProfile->appColor = importedProfile.appColor;
-            existingProfile->appHighlightColor = importedProfile.appHighlightColor;
-            existingProfile->appActionColor = importedProfile.appActionColor;
-            existingProfile->lockKeysEnabled = importedProfile.lockKeysEnabled;
-            existingProfile->highlightKeys = importedProfile.highlightKeys;
-            existingProfile->actionKeys = importedProfile.actionKeys;
-            
-            // Update in registry
-            UpdateAppProfileColorInRegistry(importedProfile.appName, importedProfile.appColor);
-            UpdateAppProfileHighlightColorInRegistry(importedProfile.appName, importedProfile.appHighlightColor);
-            UpdateAppProfileActionColorInRegistry(importedProfile.appName, importedProfile.appActionColor);
-            UpdateAppProfileLockKeysEnabledInRegistry(importedProfile.appName, importedProfile.lockKeysEnabled);
-            UpdateAppProfileHighlightKeysInRegistry(importedProfile.appName, importedProfile.highlightKeys);
-            UpdateAppProfileActionKeysInRegistry(importedProfile.appName, importedProfile.actionKeys);
-            
-        } else {
-            // Add new profile
-            importedProfile.isAppRunning = IsAppRunning(importedProfile.appName);
-            AddAppColorProfile(importedProfile.appName, importedProfile.appColor, importedProfile.lockKeysEnabled);
-            
-            // Update the highlight color, action color and keys (AddAppColorProfile doesn't handle these)
-            UpdateAppProfileColorProperty(importedProfile.appName, importedProfile.appHighlightColor, ColorUpdateType::HighlightColor);
-            UpdateAppProfileColorProperty(importedProfile.appName, importedProfile.appActionColor, ColorUpdateType::ActionColor);
-            UpdateAppProfileHighlightKeys(importedProfile.appName, importedProfile.highlightKeys);
-            UpdateAppProfileActionKeys(importedProfile.appName, importedProfile.actionKeys);
-            
-            // Save to registry
-            AppColorProfile* newProfile = GetAppProfileByName(importedProfile.appName);
-            if (newProfile) {
-                AddAppProfileToRegistry(*newProfile);
+        }
+        
+        // Files with a ParentProfile only override the fields they list
+        if (!importedProfile.parentName.empty()) {
+            importedProfile.overrideMask = importedFields;
+        }
+        
+        // The whole profile in one event with one process snapshot, as a folder import of one file
+        RunningProcessScan runningProcesses = ScanRunningProcesses();
+        ImportAppColorProfiles({ importedProfile }, runningProcesses.visibleProcesses);
+        
+        // Store the profile as the engine left it (a parent that would create a loop was dropped)
+        AppColorProfile storedProfile;
+        if (GetAppProfileCopy(importedProfile.appName, storedProfile)) {
+            if (storedProfile.parentName != importedProfile.parentName) {
+                std::wstring message = L"The parent profile '" + importedProfile.parentName + L"' would create an inheritance loop.\n\nThe profile was imported as a standalone profile.";
+                MessageBoxW(hWnd, message.c_str(), L"Import Profile", MB_OK | MB_ICONWARNING);
             }
+            AddAppProfileToStore(storedProfile);
         }
     }
     
@@ -670,40 +516,211 @@ void ImportProfileFromIniFile(HWND hWnd) {
 }
 
 // Helper function to add missing profile keys when updating existing files
-void AddMissingProfileKeys(std::wstringstream& content, const AppColorProfile& profile, const std::set<std::wstring>& seenKeys) {
-    // List of all required keys in the order they should appear
-    std::vector<std::pair<std::wstring, std::function<void()>>> requiredKeys = {
-        {L"AppName", [&]() { content << L"AppName=" << profile.appName << L"\n"; }},
-        {L"AppColor", [&]() { content << L"AppColor=" << std::hex << std::setfill(L'0') << std::setw(6) << (profile.appColor & 0xFFFFFF) << L"\n"; }},
-        {L"AppHighlightColor", [&]() { content << L"AppHighlightColor=" << std::hex << std::setfill(L'0') << std::setw(6) << (profile.appHighlightColor & 0xFFFFFF) << L"\n"; }},
-        {L"AppActionColor", [&]() { content << L"AppActionColor=" << std::hex << std::setfill(L'0') << std::setw(6) << (profile.appActionColor & 0xFFFFFF) << L"\n"; }},
-        {L"LockKeysEnabled", [&]() { content << L"LockKeysEnabled=" << (profile.lockKeysEnabled ? L"1" : L"0") << L"\n"; }},
-        {L"HighlightKeys", [&]() { 
-            content << L"HighlightKeys=";
-            if (!profile.highlightKeys.empty()) {
-                for (size_t i = 0; i < profile.highlightKeys.size(); ++i) {
-                    if (i > 0) content << L",";
-                    content << LogiLedKeyToDisplayName(profile.highlightKeys[i]);
-                }
+void AddMissingProfileKeys(std::string& content, const AppColorProfile& profile, DWORD seenKeys) {
+    // Add any missing keys in the order they should appear (inherited fields are left to the parent profile)
+    for (int i = 0; i < static_cast<int>(ProfileIniKey::Count); ++i) {
+        ProfileIniKey key = static_cast<ProfileIniKey>(i);
+        if ((seenKeys & (1u << i)) == 0 && ShouldWriteProfileIniKey(profile, key)) {
+            AppendProfileIniLine(content, profile, key);
+        }
+    }
+}
+
+// ======================================================================
+// BULK IMPORT
+// ======================================================================
+
+// One file of a bulk import
+struct ProfileImportFile {
+    std::wstring fileName;
+    AppColorProfile profile;
+    ProfileIniParseResult parseResult;
+    bool accepted = false;      // Passed validation and merging
+    std::wstring remark;        // Line of the per-file report (empty = imported cleanly)
+};
+
+// List the *.ini files of a directory, sorted by name so the merge does not depend on enumeration order
+static std::vector<ProfileImportFile> EnumerateProfileIniFiles(const std::wstring& directory) {
+    std::vector<ProfileImportFile> files;
+    WIN32_FIND_DATAW findData;
+    HANDLE hFind = FindFirstFileW((directory + L"*.ini").c_str(), &findData);
+    if (hFind != INVALID_HANDLE_VALUE) {
+        do {
+            if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+                files.emplace_back();
+                files.back().fileName = findData.cFileName;
             }
-            content << L"\n";
-        }},
-        {L"ActionKeys", [&]() { 
-            content << L"ActionKeys=";
-            if (!profile.actionKeys.empty()) {
-                for (size_t i = 0; i < profile.actionKeys.size(); ++i) {
-                    if (i > 0) content << L",";
-                    content << LogiLedKeyToDisplayName(profile.actionKeys[i]);
+        } while (FindNextFileW(hFind, &findData));
+        FindClose(hFind);
+    }
+    std::sort(files.begin(), files.end(), [](const ProfileImportFile& a, const ProfileImportFile& b) {
+        return _wcsicmp(a.fileName.c_str(), b.fileName.c_str()) < 0;
+    });
+    return files;
+}
+
+// Map and parse every file on the worker threads
+static void ParseProfileIniFiles(const std::wstring& directory, std::vector<ProfileImportFile>& files) {
+    RunOnWorkerThreads(files.size(), [&](size_t i) {
+        ProfileImportFile& file = files[i];
+        MappedFile iniFile;
+        if (MapFileReadOnly(directory + file.fileName, iniFile)) {
+            file.parseResult = ParseProfileIni(std::string_view(reinterpret_cast<const char*>(iniFile.data), iniFile.size), file.profile);
+            UnmapFile(iniFile);
+        } else {
+            file.parseResult.problems = L"The file could not be read or is empty.\n";
+        }
+        if (!file.profile.parentName.empty()) {
+            file.profile.overrideMask = file.parseResult.presentFields; // Only listed fields override the parent
+        }
+    });
+}
+
+// Report line of one file ("file: problem; problem")
+static std::wstring MakeImportRemark(const ProfileImportFile& file, const std::wstring& what) {
+    std::wstring remark = file.fileName + L": " + what;
+    while (!remark.empty() && remark.back() == L'\n') {
+        remark.pop_back();
+    }
+    std::replace(remark.begin(), remark.end(), L'\n', L';');
+    return remark;
+}
+
+// Import every profile INI file of a folder in one batch: files are parsed in parallel, the
+// first file (by name) wins when several define the same app, and the accepted profiles go to
+// the profile engine as one event with one process snapshot and to the store with one write
+void ImportProfilesFromFolder(HWND hWnd) {
+    std::wstring defaultImportDir = GetDefaultExportDirectory();
+    
+    BROWSEINFOW bi = {0};
+    wchar_t szFolder[MAX_PATH] = {0};
+    bi.hwndOwner = hWnd;
+    bi.lpszTitle = L"Select folder to import profile INI files from";
+    bi.pszDisplayName = szFolder; // output buffer
+    bi.ulFlags = BIF_RETURNONLYFSDIRS | BIF_NEWDIALOGSTYLE | BIF_EDITBOX;
+    bi.lpfn = BrowseCallbackProc;
+    bi.lParam = defaultImportDir.empty() ? 0 : reinterpret_cast<LPARAM>(defaultImportDir.c_str());
+    
+    PIDLIST_ABSOLUTE pidl = SHBrowseForFolderW(&bi);
+    if (!pidl) {
+        return; // User cancelled
+    }
+    if (!SHGetPathFromIDListW(pidl, szFolder)) {
+        CoTaskMemFree(pidl);
+        MessageBoxW(hWnd, L"Failed to get selected folder path.", L"Import Error", MB_OK | MB_ICONERROR);
+        return;
+    }
+    CoTaskMemFree(pidl);
+    std::wstring importDir = szFolder;
+    if (!importDir.empty() && importDir.back() != L'\\') importDir += L'\\';
+    
+    ULONGLONG importStart = GetTickCount64();
+    std::vector<ProfileImportFile> files = EnumerateProfileIniFiles(importDir);
+    if (files.empty()) {
+        MessageBoxW(hWnd, L"No profile INI files found in the selected folder.", L"Import Profiles", MB_OK | MB_ICONINFORMATION);
+        return;
+    }
+    ParseProfileIniFiles(importDir, files);
+    
+    // Merge in file order: invalid files and later duplicates of an app are skipped
+    std::unordered_map<std::wstring, size_t> fileByAppName; // lower-case app name -> accepted file
+    size_t existingCount = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        ProfileImportFile& file = files[i];
+        if (!file.parseResult.valid) {
+            file.remark = MakeImportRemark(file, L"Not imported - " + file.parseResult.problems);
+            continue;
+        }
+        std::wstring appKey = file.profile.appName;
+        std::transform(appKey.begin(), appKey.end(), appKey.begin(), ::towlower);
+        auto inserted = fileByAppName.emplace(appKey, i);
+        if (!inserted.second) {
+            file.remark = MakeImportRemark(file, L"Not imported - " + file.profile.appName + L" is already imported from " + files[inserted.first->second].fileName);
+            continue;
+        }
+        file.accepted = true;
+        if (!file.parseResult.problems.empty()) {
+            file.remark = MakeImportRemark(file, file.parseResult.problems);
+        }
+        if (AppProfileExists(file.profile.appName)) {
+            ++existingCount;
+        }
+    }
+    
+    // Ask once for all profiles that already exist
+    if (existingCount > 0) {
+        std::wstringstream question;
+        question << existingCount << L" of the imported profiles already exist.\n\n"
+                 << L"Yes: overwrite them\nNo: keep the existing profiles and import only new ones";
+        int answer = MessageBoxW(hWnd, question.str().c_str(), L"Import Profiles", MB_YESNOCANCEL | MB_ICONQUESTION);
+        if (answer == IDCANCEL) {
+            return;
+        }
+        if (answer == IDNO) {
+            for (auto& file : files) {
+                if (file.accepted && AppProfileExists(file.profile.appName)) {
+                    file.accepted = false;
+                    file.remark = MakeImportRemark(file, L"Not imported - the existing profile was kept");
                 }
             }
-            content << L"\n";
-        }}
-    };
+        }
+    }
+    
+    std::vector<AppColorProfile> importedProfiles;
+    for (const auto& file : files) {
+        if (file.accepted) {
+            importedProfiles.push_back(file.profile);
+        }
+    }
+    
+    // One process snapshot and one engine event for the whole batch
+    if (!importedProfiles.empty()) {
+        RunningProcessScan runningProcesses = ScanRunningProcesses();
+        ImportAppColorProfiles(importedProfiles, runningProcesses.visibleProcesses);
+        
+        // Store the profiles as the engine left them (a parent may have been dropped to break a loop)
+        std::vector<AppColorProfile> storedProfiles;
+        storedProfiles.reserve(importedProfiles.size());
+        for (auto& file : files) {
+            AppColorProfile storedProfile;
+            if (!file.accepted || !GetAppProfileCopy(file.profile.appName, storedProfile)) {
+                continue;
+            }
+            if (storedProfile.parentName != file.profile.parentName) {
+                file.remark = MakeImportRemark(file, L"Imported as a standalone profile - the parent profile " + file.profile.parentName + L" would create an inheritance loop");
+            }
+            storedProfiles.push_back(std::move(storedProfile));
+        }
+        AddAppProfilesToStore(storedProfiles);
+    }
+    bool saved = FlushPendingProfileWrites();
     
-    // Add any missing keys
-    for (const auto& keyPair : requiredKeys) {
-        if (seenKeys.find(keyPair.first) == seenKeys.end()) {
-            keyPair.second(); // Call the lambda to add the key
+    // Per-file report (the first lines of it - a folder may hold thousands of files)
+    std::wstringstream report;
+    report << L"Imported " << importedProfiles.size() << L" of " << files.size() << L" profile file(s) in "
+           << (GetTickCount64() - importStart) << L" ms.\n";
+    if (!saved) {
+        report << L"\nThe profiles could not be saved to the profile store.\n";
+    }
+    size_t remarkCount = 0;
+    for (const auto& file : files) {
+        if (file.remark.empty()) {
+            continue;
         }
+        if (remarkCount == 0) {
+            report << L"\n";
+        }
+        if (remarkCount < PROFILE_IMPORT_REPORT_MAX_LINES) {
+            report << file.remark << L"\n";
+        }
+        ++remarkCount;
+    }
+    if (remarkCount > PROFILE_IMPORT_REPORT_MAX_LINES) {
+        report << L"... and " << (remarkCount - PROFILE_IMPORT_REPORT_MAX_LINES) << L" more\n";
+    }
+    MessageBoxW(hWnd, report.str().c_str(), L"Import Profiles", MB_OK | (remarkCount > 0 || !saved ? MB_ICONWARNING : MB_ICONINFORMATION));
+    
+    if (hWnd) {
+        RefreshAppProfileCombo(hWnd);
     }
 }
\ No newline at end of file
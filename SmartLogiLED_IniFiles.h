@@ -2,8 +2,6 @@
 #include <windows.h>
 #include <string>
 #include <vector>
-#include <set>
-#include <functional>
 #include <sstream>
 #include "LogitechLEDLib.h"
 #include "SmartLogiLED_Types.h"
@@ -12,15 +10,16 @@
 
 // Export functionality
 void ExportSelectedProfileToIniFile(HWND hWnd);
-void ExportAllProfilesToIniFiles();
+void ExportAllProfilesToIniFiles(HWND hWnd); // Writes in the background; progress and the report are posted to hWnd
+void WaitForProfileExport();                  // Cancel a running export and wait for it (on exit)
 
 // Import functionality  
 void ImportProfileFromIniFile(HWND hWnd);
+void ImportProfilesFromFolder(HWND hWnd); // Every *.ini file of a folder in one batch
 
 // Helper functions for INI file operations
-void UpdateOrCreateProfileIniFile(const std::wstring& filename, const AppColorProfile& profile);
-void AddMissingProfileKeys(std::wstringstream& content, const AppColorProfile& profile, const std::set<std::wstring>& seenKeys);
-std::wstring GetApplicationDirectory();
+bool UpdateOrCreateProfileIniFile(const std::wstring& filename, const AppColorProfile& profile);
+void AddMissingProfileKeys(std::string& content, const AppColorProfile& profile, DWORD seenKeys); // seenKeys: bit per ProfileIniKey
 std::wstring GetDefaultExportDirectory();
 
 // Callback for folder browser dialog
@@ -0,0 +1,520 @@
+// SmartLogiLED_IniParser.cpp : Contains the single-pass profile INI parser.
+//
+
+#include "SmartLogiLED_IniParser.h"
+#include "SmartLogiLED_KeyMapping.h"
+#include "SmartLogiLED_Constants.h"
+#include <algorithm>
+#include <vector>
+
+static const char* const profileIniKeyNames[] = {
+    "AppName", "ParentProfile", "AppColor", "AppHighlightColor", "AppActionColor",
+    "LockKeysEnabled", "HighlightKeys", "ActionKeys", "KeyEffect", "ModifierLayer", "ModifierColor"
+};
+
+// KeyEffect values (index = KEY_EFFECT_*)
+static const char* const keyEffectNames[] = { "None", "Fade", "Ripple" };
+
+static_assert(sizeof(keyEffectNames) / sizeof(keyEffectNames[0]) == KEY_EFFECT_COUNT, "Every key effect needs a name");
+
+// ModifierLayer entries ("Modifier:Groups", groups index = MODIFIER_LAYER_*_KEYS bits)
+static const char* const modifierLayerModifierNames[] = { "Shift", "Ctrl", "Alt" };
+static const DWORD modifierLayerModifiers[] = { MODIFIER_LAYER_SHIFT, MODIFIER_LAYER_CTRL, MODIFIER_LAYER_ALT };
+static const char* const modifierLayerGroupNames[] = { "None", "Highlight", "Action", "Both" };
+static const DWORD MODIFIER_LAYER_MODIFIER_COUNT = sizeof(modifierLayerModifiers) / sizeof(modifierLayerModifiers[0]);
+static const DWORD MODIFIER_LAYER_GROUP_COUNT = sizeof(modifierLayerGroupNames) / sizeof(modifierLayerGroupNames[0]);
+
+static_assert(sizeof(profileIniKeyNames) / sizeof(profileIniKeyNames[0]) == static_cast<size_t>(ProfileIniKey::Count),
+              "Every profile INI key needs a name");
+
+// ======================================================================
+// SCANNING
+// ======================================================================
+
+static bool IsIniSpace(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+static std::string_view TrimIniText(std::string_view text) {
+    size_t begin = 0;
+    size_t end = text.size();
+    while (begin < end && IsIniSpace(text[begin])) {
+        ++begin;
+    }
+    while (end > begin && IsIniSpace(text[end - 1])) {
+        --end;
+    }
+    return text.substr(begin, end - begin);
+}
+
+std::string_view SkipUtf8ByteOrderMark(std::string_view text) {
+    if (text.size() >= 3 && text.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+        text.remove_prefix(3);
+    }
+    return text;
+}
+
+bool ReadIniLine(std::string_view& text, IniLine& line) {
+    if (text.empty()) {
+        return false;
+    }
+
+    size_t lineEnd = text.find('\n');
+    line = IniLine();
+    line.raw = text.substr(0, lineEnd);
+    text.remove_prefix(lineEnd == std::string_view::npos ? text.size() : lineEnd + 1);
+
+    line.trimmed = TrimIniText(line.raw);
+    if (line.trimmed.empty()) {
+        line.type = IniLineType::Blank;
+    } else if (line.trimmed[0] == ';') {
+        line.type = IniLineType::Comment;
+    } else if (line.trimmed[0] == '[') {
+        line.type = IniLineType::Section;
+    } else {
+        size_t equalPos = line.trimmed.find('=');
+        if (equalPos == std::string_view::npos) {
+            line.type = IniLineType::Text;
+        } else {
+            line.type = IniLineType::KeyValue;
+            line.key = TrimIniText(line.trimmed.substr(0, equalPos));
+            line.value = TrimIniText(line.trimmed.substr(equalPos + 1));
+        }
+    }
+    return true;
+}
+
+bool ReadIniListItem(std::string_view& list, std::string_view& item) {
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        item = TrimIniText(list.substr(0, comma));
+        list.remove_prefix(comma == std::string_view::npos ? list.size() : comma + 1);
+        if (!item.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Parse a hex RGB value (optional 0x prefix); false if it is not a hex number
+static bool ParseIniColor(std::string_view text, COLORREF& color) {
+    if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        text.remove_prefix(2);
+    }
+    if (text.empty() || text.size() > 8) {
+        return false;
+    }
+    DWORD value = 0;
+    for (char ch : text) {
+        int digit = (ch >= '0' && ch <= '9') ? ch - '0' :
+                    (ch >= 'a' && ch <= 'f') ? ch - 'a' + 10 :
+                    (ch >= 'A' && ch <= 'F') ? ch - 'A' + 10 : -1;
+        if (digit < 0) {
+            return false;
+        }
+        value = (value << 4) | static_cast<DWORD>(digit);
+    }
+    color = static_cast<COLORREF>(value);
+    return true;
+}
+
+// ======================================================================
+// TEXT CONVERSION
+// ======================================================================
+
+#ifdef _WIN32
+
+std::wstring Utf8ToWide(std::string_view text) {
+    std::wstring wide;
+    if (text.empty()) {
+        return wide;
+    }
+    int wideSize = MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0);
+    if (wideSize > 0) {
+        wide.resize(wideSize);
+        MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), &wide[0], wideSize);
+    }
+    return wide;
+}
+
+void AppendWideAsUtf8(std::string& output, const std::wstring& text) {
+    if (text.empty()) {
+        return;
+    }
+    int utf8Size = WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), nullptr, 0, nullptr, nullptr);
+    if (utf8Size > 0) {
+        size_t offset = output.size();
+        output.resize(offset + utf8Size);
+        WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), &output[offset], utf8Size, nullptr, nullptr);
+    }
+}
+
+#else
+
+// wchar_t holds whole code points here; invalid bytes become U+FFFD like MultiByteToWideChar makes them
+std::wstring Utf8ToWide(std::string_view text) {
+    std::wstring wide;
+    wide.reserve(text.size());
+    for (size_t i = 0; i < text.size();) {
+        uint8_t lead = static_cast<uint8_t>(text[i]);
+        size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+        uint32_t cp = length == 1 ? lead : length == 2 ? (lead & 0x1F) : length == 3 ? (lead & 0x0F) : (lead & 0x07);
+        for (size_t k = 1; k < length; ++k) {
+            uint8_t next = i + k < text.size() ? static_cast<uint8_t>(text[i + k]) : 0;
+            if ((next & 0xC0) != 0x80) {
+                length = 0;
+                break;
+            }
+            cp = (cp << 6) | (next & 0x3F);
+        }
+        if (length == 0) {
+            wide.push_back(static_cast<wchar_t>(0xFFFD));
+            ++i;
+        } else {
+            wide.push_back(static_cast<wchar_t>(cp));
+            i += length;
+        }
+    }
+    return wide;
+}
+
+void AppendWideAsUtf8(std::string& output, const std::wstring& text) {
+    for (wchar_t wch : text) {
+        uint32_t cp = static_cast<uint32_t>(wch);
+        if (cp < 0x80) {
+            output.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            output.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            output.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            output.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            output.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            output.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            output.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+}
+
+#endif
+
+// ======================================================================
+// PROFILE KEYS
+// ======================================================================
+
+ProfileIniKey GetProfileIniKey(std::string_view key) {
+    for (size_t i = 0; i < static_cast<size_t>(ProfileIniKey::Count); ++i) {
+        if (key == profileIniKeyNames[i]) {
+            return static_cast<ProfileIniKey>(i);
+        }
+    }
+    return ProfileIniKey::Unknown;
+}
+
+const char* GetProfileIniKeyName(ProfileIniKey key) {
+    return key < ProfileIniKey::Count ? profileIniKeyNames[static_cast<size_t>(key)] : "";
+}
+
+// PROFILE_FIELD_* stored under a key (0 = not an inheritable field)
+static DWORD GetProfileIniKeyField(ProfileIniKey key) {
+    switch (key) {
+        case ProfileIniKey::AppColor:           return PROFILE_FIELD_APP_COLOR;
+        case ProfileIniKey::AppHighlightColor:  return PROFILE_FIELD_HIGHLIGHT_COLOR;
+        case ProfileIniKey::AppActionColor:     return PROFILE_FIELD_ACTION_COLOR;
+        case ProfileIniKey::LockKeysEnabled:    return PROFILE_FIELD_LOCK_KEYS_ENABLED;
+        case ProfileIniKey::HighlightKeys:      return PROFILE_FIELD_HIGHLIGHT_KEYS;
+        case ProfileIniKey::ActionKeys:         return PROFILE_FIELD_ACTION_KEYS;
+        case ProfileIniKey::KeyEffect:          return PROFILE_FIELD_KEY_EFFECT;
+        case ProfileIniKey::ModifierLayer:      return PROFILE_FIELD_MODIFIER_LAYER;
+        case ProfileIniKey::ModifierColor:      return PROFILE_FIELD_MODIFIER_LAYER;
+        default:                                return 0;
+    }
+}
+
+// Inheriting profiles only store the fields they override; everything else comes from ParentProfile
+bool ShouldWriteProfileIniKey(const AppColorProfile& profile, ProfileIniKey key) {
+    if (key == ProfileIniKey::ParentProfile) {
+        return !profile.parentName.empty();
+    }
+    if (key == ProfileIniKey::KeyEffect && profile.parentName.empty()) {
+        return profile.keyEffect != KEY_EFFECT_NONE; // Files without effects stay as older versions wrote them
+    }
+    if ((key == ProfileIniKey::ModifierLayer || key == ProfileIniKey::ModifierColor) && profile.parentName.empty()) {
+        return profile.modifierLayer != 0;
+    }
+    DWORD field = GetProfileIniKeyField(key);
+    return profile.parentName.empty() || field == 0 || (profile.overrideMask & field) != 0;
+}
+
+static void AppendIniColor(std::string& content, COLORREF color) {
+    static const char hexDigits[] = "0123456789abcdef";
+    for (int shift = 20; shift >= 0; shift -= 4) {
+        content.push_back(hexDigits[(color >> shift) & 0xF]);
+    }
+}
+
+// "Shift:Highlight,Ctrl:Action" - modifiers without groups are left out ("None" if there are none)
+static void AppendIniModifierLayer(std::string& content, DWORD modifierLayer) {
+    size_t start = content.size();
+    for (DWORD i = 0; i < MODIFIER_LAYER_MODIFIER_COUNT; ++i) {
+        DWORD groups = MODIFIER_LAYER_GROUPS(modifierLayer, modifierLayerModifiers[i]);
+        if (groups == 0) {
+            continue;
+        }
+        if (content.size() > start) {
+            content.push_back(',');
+        }
+        content += modifierLayerModifierNames[i];
+        content.push_back(':');
+        content += modifierLayerGroupNames[groups];
+    }
+    if (content.size() == start) {
+        content += modifierLayerGroupNames[0];
+    }
+}
+
+// Key lists are written sorted, so the same profile always gives the same file
+static void AppendIniKeyList(std::string& content, const std::vector<LogiLed::KeyName>& keys) {
+    std::vector<LogiLed::KeyName> sortedKeys = keys;
+    std::sort(sortedKeys.begin(), sortedKeys.end());
+    for (size_t i = 0; i < sortedKeys.size(); ++i) {
+        if (i > 0) {
+            content.push_back(',');
+        }
+        content += LogiLedKeyToConfigName(sortedKeys[i]);
+    }
+}
+
+void AppendProfileIniLine(std::string& content, const AppColorProfile& profile, ProfileIniKey key) {
+    content += GetProfileIniKeyName(key);
+    content.push_back('=');
+    switch (key) {
+        case ProfileIniKey::AppName:            AppendWideAsUtf8(content, profile.appName); break;
+        case ProfileIniKey::ParentProfile:      AppendWideAsUtf8(content, profile.parentName); break;
+        case ProfileIniKey::AppColor:           AppendIniColor(content, profile.appColor & 0xFFFFFF); break;
+        case ProfileIniKey::AppHighlightColor:  AppendIniColor(content, profile.appHighlightColor & 0xFFFFFF); break;
+        case ProfileIniKey::AppActionColor:     AppendIniColor(content, profile.appActionColor & 0xFFFFFF); break;
+        case ProfileIniKey::LockKeysEnabled:    content.push_back(profile.lockKeysEnabled ? '1' : '0'); break;
+        case ProfileIniKey::HighlightKeys:      AppendIniKeyList(content, profile.highlightKeys); break;
+        case ProfileIniKey::ActionKeys:         AppendIniKeyList(content, profile.actionKeys); break;
+        case ProfileIniKey::KeyEffect:          content += keyEffectNames[profile.keyEffect < KEY_EFFECT_COUNT ? profile.keyEffect : KEY_EFFECT_NONE]; break;
+        case ProfileIniKey::ModifierLayer:      AppendIniModifierLayer(content, profile.modifierLayer); break;
+        case ProfileIniKey::ModifierColor:      AppendIniColor(content, profile.appModifierColor & 0xFFFFFF); break;
+        default:                                break;
+    }
+    content.push_back('\n');
+}
+
+// ======================================================================
+// PROFILE PARSING
+// ======================================================================
+
+static void AddIniProblem(ProfileIniParseResult& result, const wchar_t* what, std::string_view value) {
+    result.problems += what;
+    result.problems += Utf8ToWide(value);
+    result.problems += L"\n";
+}
+
+static void ParseIniKeyList(std::string_view list, std::vector<LogiLed::KeyName>& keys, ProfileIniParseResult& result) {
+    keys.clear();
+    std::string_view item;
+    while (ReadIniListItem(list, item)) {
+        LogiLed::KeyName key;
+        if (DisplayNameToLogiLedKey(item, key)) {
+            keys.push_back(key);
+        } else {
+            AddIniProblem(result, L"Unknown key name ignored: ", item);
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+}
+
+// Index of a name in a table (case-insensitive); false if it is not in the table
+static bool FindIniName(std::string_view text, const char* const* names, DWORD count, DWORD& index) {
+    for (DWORD i = 0; i < count; ++i) {
+        std::string_view name = names[i];
+        if (text.size() == name.size() && std::equal(text.begin(), text.end(), name.begin(), [](char a, char b) {
+                return (a | 0x20) == (b | 0x20);
+            })) {
+            index = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// KeyEffect value (case-insensitive); false if it is not a known effect
+static bool ParseIniKeyEffect(std::string_view text, DWORD& keyEffect) {
+    return FindIniName(text, keyEffectNames, KEY_EFFECT_COUNT, keyEffect);
+}
+
+// ModifierLayer list ("Ctrl:Action,Shift:Highlight"); unknown entries are reported and skipped
+static void ParseIniModifierLayer(std::string_view list, DWORD& modifierLayer, ProfileIniParseResult& result) {
+    modifierLayer = 0;
+    std::string_view item;
+    while (ReadIniListItem(list, item)) {
+        size_t colon = item.find(':');
+        DWORD modifier = 0;
+        DWORD groups = 0;
+        if (colon == std::string_view::npos) {
+            if (!FindIniName(item, modifierLayerGroupNames, 1, groups)) { // A lone "None"
+                AddIniProblem(result, L"Unknown modifier layer entry ignored: ", item);
+            }
+            continue;
+        }
+        std::string_view modifierName = TrimIniText(item.substr(0, colon));
+        std::string_view groupName = TrimIniText(item.substr(colon + 1));
+        if (!FindIniName(modifierName, modifierLayerModifierNames, MODIFIER_LAYER_MODIFIER_COUNT, modifier) ||
+            !FindIniName(groupName, modifierLayerGroupNames, MODIFIER_LAYER_GROUP_COUNT, groups)) {
+            AddIniProblem(result, L"Unknown modifier layer entry ignored: ", item);
+            continue;
+        }
+        modifierLayer |= groups << modifierLayerModifiers[modifier];
+    }
+}
+
+ProfileIniParseResult ParseProfileIni(std::string_view text, AppColorProfile& profile) {
+    ProfileIniParseResult result;
+    bool inProfileSection = false;
+    bool foundProfileSection = false;
+
+    text = SkipUtf8ByteOrderMark(text);
+    IniLine line;
+    while (ReadIniLine(text, line)) {
+        if (line.type == IniLineType::Section) {
+            inProfileSection = (line.trimmed == PROFILE_INI_SECTION);
+            foundProfileSection = foundProfileSection || inProfileSection;
+            continue;
+        }
+        if (!inProfileSection || line.type != IniLineType::KeyValue) {
+            continue;
+        }
+
+        ProfileIniKey key = GetProfileIniKey(line.key);
+        result.presentFields |= GetProfileIniKeyField(key);
+        switch (key) {
+            case ProfileIniKey::AppName:
+                profile.appName = Utf8ToWide(line.value);
+                result.valid = !profile.appName.empty();
+                break;
+            case ProfileIniKey::ParentProfile:
+                profile.parentName = Utf8ToWide(line.value);
+                break;
+            case ProfileIniKey::AppColor:
+            case ProfileIniKey::AppHighlightColor:
+            case ProfileIniKey::AppActionColor: {
+                COLORREF& color = (key == ProfileIniKey::AppColor) ? profile.appColor :
+                                  (key == ProfileIniKey::AppHighlightColor) ? profile.appHighlightColor : profile.appActionColor;
+                if (!ParseIniColor(line.value, color)) {
+                    AddIniProblem(result, L"Invalid color kept at its default: ", line.trimmed);
+                }
+                break;
+            }
+            case ProfileIniKey::LockKeysEnabled:
+                profile.lockKeysEnabled = (line.value == "1");
+                break;
+            case ProfileIniKey::HighlightKeys:
+                ParseIniKeyList(line.value, profile.highlightKeys, result);
+                break;
+            case ProfileIniKey::ActionKeys:
+                ParseIniKeyList(line.value, profile.actionKeys, result);
+                break;
+            case ProfileIniKey::KeyEffect:
+                if (!ParseIniKeyEffect(line.value, profile.keyEffect)) {
+                    AddIniProblem(result, L"Unknown key effect kept at None: ", line.trimmed);
+                }
+                break;
+            case ProfileIniKey::ModifierLayer:
+                ParseIniModifierLayer(line.value, profile.modifierLayer, result);
+                break;
+            case ProfileIniKey::ModifierColor:
+                if (!ParseIniColor(line.value, profile.appModifierColor)) {
+                    AddIniProblem(result, L"Invalid color kept at its default: ", line.trimmed);
+                }
+                break;
+            default:
+                break; // Unknown keys are kept by export and ignored by import
+        }
+    }
+
+    if (!foundProfileSection) {
+        result.valid = false;
+        result.problems = L"No [SmartLogiLED Profile] section found\n";
+    } else if (!result.valid) {
+        result.problems = L"The profile section has no AppName\n";
+    }
+    return result;
+}
+
+// ======================================================================
+// CANONICAL HASH
+// ======================================================================
+
+static const uint64_t CANONICAL_HASH_SEED = 14695981039346656037ull;
+
+// FNV-1a
+static uint64_t HashIniText(uint64_t hash, std::string_view text) {
+    for (char ch : text) {
+        hash = (hash ^ static_cast<uint8_t>(ch)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t HashProfileIniCanonical(const AppColorProfile& profile) {
+    std::string canonical;
+    for (int i = 0; i < static_cast<int>(ProfileIniKey::Count); ++i) {
+        ProfileIniKey key = static_cast<ProfileIniKey>(i);
+        if (ShouldWriteProfileIniKey(profile, key)) {
+            AppendProfileIniLine(canonical, profile, key);
+        }
+    }
+    return HashIniText(CANONICAL_HASH_SEED, canonical);
+}
+
+bool HashProfileIniFile(std::string_view text, uint64_t& hash) {
+    std::string_view values[static_cast<size_t>(ProfileIniKey::Count)];
+    bool present[static_cast<size_t>(ProfileIniKey::Count)] = {};
+    bool inProfileSection = false;
+    bool foundProfileSection = false;
+
+    text = SkipUtf8ByteOrderMark(text);
+    IniLine line;
+    while (ReadIniLine(text, line)) {
+        if (line.type == IniLineType::Section) {
+            inProfileSection = (line.trimmed == PROFILE_INI_SECTION);
+            if (inProfileSection && foundProfileSection) {
+                return false; // A second profile section is merged on export - always rewrite
+            }
+            foundProfileSection = foundProfileSection || inProfileSection;
+        } else if (inProfileSection && line.type == IniLineType::KeyValue) {
+            ProfileIniKey key = GetProfileIniKey(line.key);
+            if (key == ProfileIniKey::Unknown) {
+                continue; // Kept as they are by export
+            }
+            size_t index = static_cast<size_t>(key);
+            if (present[index]) {
+                return false;
+            }
+            present[index] = true;
+            values[index] = line.value;
+        }
+    }
+    if (!foundProfileSection) {
+        return false;
+    }
+
+    // Same bytes as AppendProfileIniLine produces for the profile
+    hash = CANONICAL_HASH_SEED;
+    for (size_t i = 0; i < static_cast<size_t>(ProfileIniKey::Count); ++i) {
+        if (present[i]) {
+            hash = HashIniText(hash, GetProfileIniKeyName(static_cast<ProfileIniKey>(i)));
+            hash = HashIniText(hash, "=");
+            hash = HashIniText(hash, values[i]);
+            hash = HashIniText(hash, "\n");
+        }
+    }
+    return true;
+}
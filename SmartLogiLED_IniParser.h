@@ -0,0 +1,71 @@
+// SmartLogiLED_IniParser.h : Header file for the single-pass profile INI parser.
+//
+// The parser works on the UTF-8 bytes of a file (usually memory-mapped): lines, keys and
+// values are string views into the buffer, so reading a file allocates nothing per line.
+// Import and export (UpdateOrCreateProfileIniFile) share it.
+
+#pragma once
+
+#include "SmartLogiLED_WinTypes.h"
+#include "SmartLogiLED_Types.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Keys of the [SmartLogiLED Profile] section, in the order they are written
+enum class ProfileIniKey {
+    AppName,
+    ParentProfile,
+    AppColor,
+    AppHighlightColor,
+    AppActionColor,
+    LockKeysEnabled,
+    HighlightKeys,
+    ActionKeys,
+    KeyEffect,
+    ModifierLayer,
+    ModifierColor,
+    Count,
+    Unknown = Count
+};
+
+// One line of an INI file (views into the file buffer)
+enum class IniLineType { Blank, Comment, Section, KeyValue, Text };
+
+struct IniLine {
+    IniLineType type = IniLineType::Blank;
+    std::string_view raw;           // The line as stored, without the '\n'
+    std::string_view trimmed;
+    std::string_view key;           // KeyValue lines only (trimmed)
+    std::string_view value;
+};
+
+// Line and list scanning (text is advanced past what was read)
+std::string_view SkipUtf8ByteOrderMark(std::string_view text);
+bool ReadIniLine(std::string_view& text, IniLine& line);
+bool ReadIniListItem(std::string_view& list, std::string_view& item); // Comma-separated, items trimmed
+
+// Profile keys
+ProfileIniKey GetProfileIniKey(std::string_view key);
+const char* GetProfileIniKeyName(ProfileIniKey key);
+bool ShouldWriteProfileIniKey(const AppColorProfile& profile, ProfileIniKey key); // Inheriting profiles only store overridden fields
+void AppendProfileIniLine(std::string& content, const AppColorProfile& profile, ProfileIniKey key); // "Key=value\n" (UTF-8)
+
+// Result of parsing one profile file
+struct ProfileIniParseResult {
+    bool valid = false;             // A profile section with an AppName was found
+    DWORD presentFields = 0;        // PROFILE_FIELD_* listed in the file
+    std::wstring problems;          // Why the file is invalid, or values that were ignored (one per line)
+};
+
+// Parse a profile file in one pass; fields not in the file keep the defaults of AppColorProfile
+ProfileIniParseResult ParseProfileIni(std::string_view text, AppColorProfile& profile);
+
+// Canonical form of a profile file: its known "Key=value" lines in key order, with inherited keys
+// left out. Equal hashes mean exporting the profile would not change the values in the file.
+uint64_t HashProfileIniCanonical(const AppColorProfile& profile);
+bool HashProfileIniFile(std::string_view text, uint64_t& hash); // false if there is no single profile section
+
+// UTF-8 <-> UTF-16 for single values
+std::wstring Utf8ToWide(std::string_view text);
+void AppendWideAsUtf8(std::string& output, const std::wstring& text);
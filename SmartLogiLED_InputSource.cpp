@@ -0,0 +1,286 @@
+// SmartLogiLED_InputSource.cpp : Contains the key recording reader, the replay input source and the active source.
+//
+// The replay source runs its own thread and hands the recorded events to the sink at their
+// recorded times divided by the speed factor. Lock key states and held keys are tracked from
+// the replayed events, so lock key painting and modifier checks see the replayed keyboard.
+
+#include "SmartLogiLED_InputSource.h"
+#include "SmartLogiLED_Platform.h"
+#include "SmartLogiLED_Constants.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+// ======================================================================
+// KEY RECORDINGS
+// ======================================================================
+
+// Next whitespace-separated word of a line
+static std::string TakeRecordingWord(const char*& cursor, const char* end) {
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t')) {
+        ++cursor;
+    }
+    const char* start = cursor;
+    while (cursor < end && *cursor != ' ' && *cursor != '\t') {
+        ++cursor;
+    }
+    return std::string(start, cursor);
+}
+
+static bool ParseRecordingNumber(const std::string& word, int base, uint32_t& value) {
+    if (word.empty()) {
+        return false;
+    }
+    char* parsedEnd = nullptr;
+    unsigned long parsed = std::strtoul(word.c_str(), &parsedEnd, base);
+    if (*parsedEnd != '\0' || parsed > 0xFFFFFFFFUL) {
+        return false;
+    }
+    value = static_cast<uint32_t>(parsed);
+    return true;
+}
+
+bool LoadKeyRecording(const std::wstring& filePath, std::vector<RecordedKeyEvent>& events, std::wstring& errorMessage) {
+    events.clear();
+    MappedFile file;
+    if (!MapFileReadOnly(filePath, file)) {
+        errorMessage = L"The key recording could not be opened: " + filePath;
+        return false;
+    }
+
+    const char* text = reinterpret_cast<const char*>(file.data);
+    const char* textEnd = text + file.size;
+    size_t lineNumber = 0;
+    uint32_t lastOffsetMs = 0;
+    bool valid = true;
+    while (text < textEnd && valid) {
+        const char* lineEnd = text;
+        while (lineEnd < textEnd && *lineEnd != '\n') {
+            ++lineEnd;
+        }
+        const char* contentEnd = lineEnd;
+        for (const char* comment = text; comment < contentEnd; ++comment) {
+            if (*comment == ';') {
+                contentEnd = comment;
+            }
+        }
+        while (contentEnd > text && (contentEnd[-1] == '\r' || contentEnd[-1] == ' ' || contentEnd[-1] == '\t')) {
+            --contentEnd;
+        }
+        ++lineNumber;
+
+        const char* cursor = text;
+        std::string offsetWord = TakeRecordingWord(cursor, contentEnd);
+        if (!offsetWord.empty()) {
+            std::string directionWord = TakeRecordingWord(cursor, contentEnd);
+            std::string keyWord = TakeRecordingWord(cursor, contentEnd);
+            std::string flagsWord = TakeRecordingWord(cursor, contentEnd);
+
+            RecordedKeyEvent recorded;
+            valid = ParseRecordingNumber(offsetWord, 10, recorded.offsetMs) && recorded.offsetMs >= lastOffsetMs &&
+                    (directionWord == "down" || directionWord == "up") &&
+                    ParseRecordingNumber(keyWord, 16, recorded.event.vkCode) && recorded.event.vkCode > 0 && recorded.event.vkCode < 0xFF &&
+                    (flagsWord.empty() || ParseRecordingNumber(flagsWord, 16, recorded.event.flags)) &&
+                    TakeRecordingWord(cursor, contentEnd).empty();
+            if (valid) {
+                recorded.event.keyDown = (directionWord == "down");
+                lastOffsetMs = recorded.offsetMs;
+                events.push_back(recorded);
+            }
+        }
+        text = lineEnd + 1;
+    }
+    UnmapFile(file);
+
+    if (!valid) {
+        std::wstringstream message;
+        message << L"Line " << lineNumber << L" of the key recording is not \"<milliseconds> down|up <virtual key> [flags]\" "
+                << L"(times must not go backwards): " << filePath;
+        errorMessage = message.str();
+        events.clear();
+        return false;
+    }
+    if (events.empty()) {
+        errorMessage = L"The key recording contains no key events: " + filePath;
+        return false;
+    }
+    return true;
+}
+
+// ======================================================================
+// REPLAY SOURCE
+// ======================================================================
+
+// Replay statistics (replay thread, read by the report)
+static std::atomic<uint64_t> replayedEvents{ 0 };
+static std::atomic<uint64_t> replayedLoops{ 0 };
+static std::atomic<uint64_t> replayMicros{ 0 };            // Time spent replaying
+static std::atomic<uint64_t> replayLateMaxMicros{ 0 };     // Worst delay behind the scaled recording time
+static std::atomic<bool> replaySourceActive{ false };
+
+// Lock key bit of a virtual key (VK_NUMLOCK, VK_CAPITAL, VK_SCROLL)
+static uint32_t GetReplayLockKeyBit(uint32_t vkCode) {
+    switch (vkCode) {
+        case 0x90: return LOCK_KEY_STATE_NUM;
+        case 0x14: return LOCK_KEY_STATE_CAPS;
+        case 0x91: return LOCK_KEY_STATE_SCROLL;
+        default:   return 0;
+    }
+}
+
+class ReplayInputSource : public IInputEventSource {
+public:
+    ReplayInputSource(std::vector<RecordedKeyEvent> recordedEvents, double speed, uint32_t loops)
+        : events(std::move(recordedEvents)), speedFactor(speed), loopCount(loops) {
+        replaySourceActive = true;
+    }
+
+    ~ReplayInputSource() override {
+        Stop();
+        replaySourceActive = false;
+    }
+
+    const wchar_t* GetName() const override {
+        return L"Replay";
+    }
+
+    bool Start(InputKeyEventSink sink) override {
+        if (replayThread.joinable()) {
+            return true;
+        }
+        stopRequested = false;
+        replayThread = std::thread(&ReplayInputSource::ReplayThreadProc, this, sink);
+        return true;
+    }
+
+    void Stop() override {
+        if (!replayThread.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(stopMutex);
+            stopRequested = true;
+        }
+        stopCondition.notify_all();
+        replayThread.join();
+    }
+
+    bool IsRunning() const override {
+        return replayThread.joinable();
+    }
+
+    void SetKeyCapture(bool) override {
+        // Nothing reaches other applications anyway
+    }
+
+    uint32_t ReadLockKeyStates() override {
+        return lockKeyStates.load();
+    }
+
+    bool IsKeyDown(uint32_t vkCode) override {
+        return vkCode < 256 && (keysDown[vkCode >> 6].load() & (1ULL << (vkCode & 63))) != 0;
+    }
+
+    uint32_t GetSinkTimeoutMs() override {
+        return 0;
+    }
+
+private:
+    // Wait until the given time; false if the source is stopped first
+    bool WaitUntil(std::chrono::steady_clock::time_point due) {
+        std::unique_lock<std::mutex> lock(stopMutex);
+        return !stopCondition.wait_until(lock, due, [this] { return stopRequested.load(); });
+    }
+
+    void TrackReplayedKey(const InputKeyEvent& event) {
+        uint64_t bit = 1ULL << (event.vkCode & 63);
+        std::atomic<uint64_t>& word = keysDown[(event.vkCode & 0xFF) >> 6];
+        uint64_t before = event.keyDown ? word.fetch_or(bit) : word.fetch_and(~bit);
+        if (event.keyDown && !(before & bit)) {
+            lockKeyStates.fetch_xor(GetReplayLockKeyBit(event.vkCode)); // Toggles on the first key down, not on auto-repeat
+        }
+    }
+
+    void ReplayThreadProc(InputKeyEventSink sink) {
+        for (uint32_t loop = 0; loopCount == 0 || loop < loopCount; ++loop) {
+            auto loopStart = std::chrono::steady_clock::now();
+            for (const RecordedKeyEvent& recorded : events) {
+                if (speedFactor > 0) {
+                    auto due = loopStart + std::chrono::microseconds(static_cast<int64_t>(recorded.offsetMs * 1000.0 / speedFactor));
+                    if (!WaitUntil(due)) {
+                        return;
+                    }
+                    uint64_t lateMicros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - due).count());
+                    if (lateMicros > replayLateMaxMicros.load(std::memory_order_relaxed)) {
+                        replayLateMaxMicros.store(lateMicros, std::memory_order_relaxed);
+                    }
+                } else if (stopRequested) {
+                    return;
+                }
+
+                TrackReplayedKey(recorded.event);
+                sink(recorded.event);
+                replayedEvents.fetch_add(1, std::memory_order_relaxed);
+            }
+            replayMicros.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - loopStart).count()), std::memory_order_relaxed);
+            replayedLoops.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    std::vector<RecordedKeyEvent> events;
+    double speedFactor;
+    uint32_t loopCount;
+    std::thread replayThread;
+    std::mutex stopMutex;
+    std::condition_variable stopCondition;
+    std::atomic<bool> stopRequested{ false };   // Set under stopMutex so a waiting replay wakes up
+    std::atomic<uint32_t> lockKeyStates{ 0 };
+    std::atomic<uint64_t> keysDown[4] = {};
+};
+
+std::unique_ptr<IInputEventSource> CreateReplayInputSource(std::vector<RecordedKeyEvent> events, double speedFactor, uint32_t loopCount) {
+    return std::unique_ptr<IInputEventSource>(new ReplayInputSource(std::move(events), speedFactor, loopCount));
+}
+
+std::wstring FormatInputSourceStatistics() {
+    if (!replaySourceActive) {
+        return std::wstring();
+    }
+    uint64_t events = replayedEvents.load(std::memory_order_relaxed);
+    uint64_t micros = replayMicros.load(std::memory_order_relaxed);
+    std::wstringstream report;
+    report << L"Replay: " << events << L" key events, " << replayedLoops.load(std::memory_order_relaxed) << L" passes completed";
+    if (micros > 0) {
+        report << L", " << (events * 1000000ULL / micros) << L" events/s";
+    }
+    report << L"; at most " << replayLateMaxMicros.load(std::memory_order_relaxed) << L" us behind the recording";
+    return report.str();
+}
+
+// ======================================================================
+// ACTIVE SOURCE
+// ======================================================================
+
+// Module-specific variables
+static std::unique_ptr<IInputEventSource> activeInputSource;
+
+void SetInputEventSource(std::unique_ptr<IInputEventSource> source) {
+    activeInputSource = std::move(source);
+}
+
+IInputEventSource& GetInputEventSource() {
+    if (!activeInputSource) {
+#if defined(_WIN32)
+        activeInputSource = CreateKeyboardHookInputSource();
+#elif defined(__linux__)
+        activeInputSource = CreateEvdevInputSource();
+#else
+        activeInputSource = CreateReplayInputSource(std::vector<RecordedKeyEvent>(), 0, 1);
+#endif
+    }
+    return *activeInputSource;
+}
@@ -0,0 +1,82 @@
+// SmartLogiLED_InputSource.h : Header file for the keyboard input sources.
+//
+// The keyboard hook multiplexer gets its key events and lock key states from the active input
+// source. On Windows this is the WH_KEYBOARD_LL hook; the evdev source reads Linux input devices
+// and the replay source plays a recorded key stream (optionally faster than recorded) for
+// benchmarks. Events carry Windows virtual key codes whatever the source, so everything behind
+// the multiplexer works unchanged. Only the Win32 hook source depends on Win32.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Key event flags (same values as the KBDLLHOOKSTRUCT LLKHF_* flags)
+#define INPUT_KEY_FLAG_EXTENDED 0x01
+#define INPUT_KEY_FLAG_INJECTED 0x10
+
+// One key event in the form the hook sees it
+struct InputKeyEvent {
+    uint32_t vkCode = 0;            // Windows virtual key code (left/right specific for modifiers)
+    uint32_t flags = 0;             // INPUT_KEY_FLAG_*
+    uint32_t time = 0;              // Milliseconds on the GetTickCount clock; 0 = stamped on arrival
+    bool keyDown = false;           // Auto-repeat arrives as further key downs
+};
+
+// Receives every event of a running source on the source's thread (the UI thread for the hook).
+// Returns true if the key down must not reach other applications (key capture).
+typedef bool (*InputKeyEventSink)(const InputKeyEvent& event);
+
+// Source of key events and lock key states
+class IInputEventSource {
+public:
+    virtual ~IInputEventSource() = default;
+
+    virtual const wchar_t* GetName() const = 0;
+
+    // Deliver events to the sink until Stop (the thread that calls Start owns the source)
+    virtual bool Start(InputKeyEventSink sink) = 0;
+    virtual void Stop() = 0;
+    virtual bool IsRunning() const = 0;
+
+    // Key downs the sink swallows are only withheld while key capture is on
+    virtual void SetKeyCapture(bool capture) = 0;
+
+    // Current state as the source's OS sees it (LOCK_KEY_STATE_* bits; virtual key held down)
+    virtual uint32_t ReadLockKeyStates() = 0;
+    virtual bool IsKeyDown(uint32_t vkCode) = 0;
+
+    // Time the OS gives one sink call before it drops the source (0 = no limit); the multiplexer
+    // reports calls that come close to it
+    virtual uint32_t GetSinkTimeoutMs() = 0;
+};
+
+// Recorded key stream: one event per line, "<milliseconds> down|up <virtual key> [flags]"
+// with hexadecimal key and flags (e.g. "125 down 41", "130 up A3 1"); ';' starts a comment
+struct RecordedKeyEvent {
+    uint32_t offsetMs = 0;          // Since the start of the recording
+    InputKeyEvent event;
+};
+
+bool LoadKeyRecording(const std::wstring& filePath, std::vector<RecordedKeyEvent>& events, std::wstring& errorMessage);
+
+// Sources
+// Replays the events speedFactor times faster than recorded (0 = as fast as possible), loopCount
+// times (0 = until stopped); lock key states follow the replayed lock key presses
+std::unique_ptr<IInputEventSource> CreateReplayInputSource(std::vector<RecordedKeyEvent> events, double speedFactor, uint32_t loopCount);
+#ifdef _WIN32
+std::unique_ptr<IInputEventSource> CreateKeyboardHookInputSource(); // WH_KEYBOARD_LL hook (SmartLogiLED_HookInputSource.cpp)
+#endif
+#ifdef __linux__
+// /dev/input keyboards, uinput for key capture; given device descriptors (owned by the source) are read instead
+std::unique_ptr<IInputEventSource> CreateEvdevInputSource(std::vector<int> keyboards = std::vector<int>());
+#endif
+
+// Active source (the platform's native source until another one is set; set it while stopped)
+void SetInputEventSource(std::unique_ptr<IInputEventSource> source);
+IInputEventSource& GetInputEventSource();
+
+// Replayed events and the achieved rate (replay source only; empty for the others)
+std::wstring FormatInputSourceStatistics();
@@ -0,0 +1,263 @@
+// SmartLogiLED_KeyEffectBuffer.cpp : Contains the key effect press queue, effect buffer and intensities.
+//
+// The hook runs on the UI thread and only writes the pressed key's layout index and the event
+// time into a small ring. The frame timer, also on the UI thread, moves queued presses into a
+// structure-of-arrays buffer of at most KEY_EFFECT_MAX_ACTIVE effects (a press beyond the cap
+// replaces the oldest effect) and computes one intensity per layout key.
+
+#include "SmartLogiLED_KeyEffectBuffer.h"
+#include "SmartLogiLED_KeyMapping.h"
+#include "SmartLogiLED_Constants.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+static_assert((KEY_EFFECT_QUEUE_CAPACITY & (KEY_EFFECT_QUEUE_CAPACITY - 1)) == 0, "Key effect queue capacity must be a power of two");
+
+static const uint8_t KEY_EFFECT_NO_KEY = 0xFF;
+
+// Key centers on a full-size keyboard in quarter key widths (rows are one key width apart)
+struct KeyEffectLayoutKey {
+    LogiLed::KeyName key;
+    uint8_t x;
+    uint8_t y;
+};
+
+static const KeyEffectLayoutKey keyEffectLayout[] = {
+    { LogiLed::KeyName::ESC, 2, 0 }, { LogiLed::KeyName::F1, 10, 0 }, { LogiLed::KeyName::F2, 14, 0 },
+    { LogiLed::KeyName::F3, 18, 0 }, { LogiLed::KeyName::F4, 22, 0 }, { LogiLed::KeyName::F5, 28, 0 },
+    { LogiLed::KeyName::F6, 32, 0 }, { LogiLed::KeyName::F7, 36, 0 }, { LogiLed::KeyName::F8, 40, 0 },
+    { LogiLed::KeyName::F9, 46, 0 }, { LogiLed::KeyName::F10, 50, 0 }, { LogiLed::KeyName::F11, 54, 0 },
+    { LogiLed::KeyName::F12, 58, 0 }, { LogiLed::KeyName::PRINT_SCREEN, 63, 0 }, { LogiLed::KeyName::SCROLL_LOCK, 67, 0 },
+    { LogiLed::KeyName::PAUSE_BREAK, 71, 0 },
+
+    { LogiLed::KeyName::TILDE, 2, 4 }, { LogiLed::KeyName::ONE, 6, 4 }, { LogiLed::KeyName::TWO, 10, 4 },
+    { LogiLed::KeyName::THREE, 14, 4 }, { LogiLed::KeyName::FOUR, 18, 4 }, { LogiLed::KeyName::FIVE, 22, 4 },
+    { LogiLed::KeyName::SIX, 26, 4 }, { LogiLed::KeyName::SEVEN, 30, 4 }, { LogiLed::KeyName::EIGHT, 34, 4 },
+    { LogiLed::KeyName::NINE, 38, 4 }, { LogiLed::KeyName::ZERO, 42, 4 }, { LogiLed::KeyName::MINUS, 46, 4 },
+    { LogiLed::KeyName::EQUALS, 50, 4 }, { LogiLed::KeyName::BACKSPACE, 56, 4 }, { LogiLed::KeyName::INSERT, 63, 4 },
+    { LogiLed::KeyName::HOME, 67, 4 }, { LogiLed::KeyName::PAGE_UP, 71, 4 }, { LogiLed::KeyName::NUM_LOCK, 76, 4 },
+    { LogiLed::KeyName::NUM_SLASH, 80, 4 }, { LogiLed::KeyName::NUM_ASTERISK, 84, 4 }, { LogiLed::KeyName::NUM_MINUS, 88, 4 },
+
+    { LogiLed::KeyName::TAB, 3, 8 }, { LogiLed::KeyName::Q, 8, 8 }, { LogiLed::KeyName::W, 12, 8 },
+    { LogiLed::KeyName::E, 16, 8 }, { LogiLed::KeyName::R, 20, 8 }, { LogiLed::KeyName::T, 24, 8 },
+    { LogiLed::KeyName::Y, 28, 8 }, { LogiLed::KeyName::U, 32, 8 }, { LogiLed::KeyName::I, 36, 8 },
+    { LogiLed::KeyName::O, 40, 8 }, { LogiLed::KeyName::P, 44, 8 }, { LogiLed::KeyName::OPEN_BRACKET, 48, 8 },
+    { LogiLed::KeyName::CLOSE_BRACKET, 52, 8 }, { LogiLed::KeyName::BACKSLASH, 57, 8 }, { LogiLed::KeyName::KEYBOARD_DELETE, 63, 8 },
+    { LogiLed::KeyName::END, 67, 8 }, { LogiLed::KeyName::PAGE_DOWN, 71, 8 }, { LogiLed::KeyName::NUM_SEVEN, 76, 8 },
+    { LogiLed::KeyName::NUM_EIGHT, 80, 8 }, { LogiLed::KeyName::NUM_NINE, 84, 8 }, { LogiLed::KeyName::NUM_PLUS, 88, 10 },
+
+    { LogiLed::KeyName::CAPS_LOCK, 3, 12 }, { LogiLed::KeyName::A, 9, 12 }, { LogiLed::KeyName::S, 13, 12 },
+    { LogiLed::KeyName::D, 17, 12 }, { LogiLed::KeyName::F, 21, 12 }, { LogiLed::KeyName::G, 25, 12 },
+    { LogiLed::KeyName::H, 29, 12 }, { LogiLed::KeyName::J, 33, 12 }, { LogiLed::KeyName::K, 37, 12 },
+    { LogiLed::KeyName::L, 41, 12 }, { LogiLed::KeyName::SEMICOLON, 45, 12 }, { LogiLed::KeyName::APOSTROPHE, 49, 12 },
+    { LogiLed::KeyName::ENTER, 56, 12 }, { LogiLed::KeyName::NUM_FOUR, 76, 12 }, { LogiLed::KeyName::NUM_FIVE, 80, 12 },
+    { LogiLed::KeyName::NUM_SIX, 84, 12 },
+
+    { LogiLed::KeyName::LEFT_SHIFT, 4, 16 }, { LogiLed::KeyName::Z, 11, 16 }, { LogiLed::KeyName::X, 15, 16 },
+    { LogiLed::KeyName::C, 19, 16 }, { LogiLed::KeyName::V, 23, 16 }, { LogiLed::KeyName::B, 27, 16 },
+    { LogiLed::KeyName::N, 31, 16 }, { LogiLed::KeyName::M, 35, 16 }, { LogiLed::KeyName::COMMA, 39, 16 },
+    { LogiLed::KeyName::PERIOD, 43, 16 }, { LogiLed::KeyName::FORWARD_SLASH, 47, 16 }, { LogiLed::KeyName::RIGHT_SHIFT, 55, 16 },
+    { LogiLed::KeyName::ARROW_UP, 67, 16 }, { LogiLed::KeyName::NUM_ONE, 76, 16 }, { LogiLed::KeyName::NUM_TWO, 80, 16 },
+    { LogiLed::KeyName::NUM_THREE, 84, 16 }, { LogiLed::KeyName::NUM_ENTER, 88, 18 },
+
+    { LogiLed::KeyName::LEFT_CONTROL, 3, 20 }, { LogiLed::KeyName::LEFT_WINDOWS, 8, 20 }, { LogiLed::KeyName::LEFT_ALT, 12, 20 },
+    { LogiLed::KeyName::SPACE, 28, 20 }, { LogiLed::KeyName::RIGHT_ALT, 42, 20 }, { LogiLed::KeyName::RIGHT_WINDOWS, 47, 20 },
+    { LogiLed::KeyName::APPLICATION_SELECT, 52, 20 }, { LogiLed::KeyName::RIGHT_CONTROL, 57, 20 }, { LogiLed::KeyName::ARROW_LEFT, 63, 20 },
+    { LogiLed::KeyName::ARROW_DOWN, 67, 20 }, { LogiLed::KeyName::ARROW_RIGHT, 71, 20 }, { LogiLed::KeyName::NUM_ZERO, 78, 20 },
+    { LogiLed::KeyName::NUM_PERIOD, 84, 20 }
+};
+
+static_assert(sizeof(keyEffectLayout) / sizeof(keyEffectLayout[0]) == KEY_EFFECT_LAYOUT_KEYS, "KEY_EFFECT_LAYOUT_KEYS must match the effect layout");
+static_assert(KEY_EFFECT_LAYOUT_KEYS < KEY_EFFECT_NO_KEY, "Layout indexes must fit the key index table");
+
+// Queued key press (hook -> frame timer)
+struct KeyEffectPress {
+    uint8_t keyIndex;
+    DWORD time;                     // InputKeyEvent::time (GetTickCount clock)
+};
+
+// Module-specific variables
+static uint8_t keyEffectIndexByKey[KEYBOARD_HOOK_PRESS_KEY_COUNT]; // Written before the subscriber is enabled, read by the hook
+static KeyPressFilter keyEffectPressFilter;                     // Hook only
+static KeyEffectPress keyEffectQueue[KEY_EFFECT_QUEUE_CAPACITY];
+static std::atomic<uint32_t> keyEffectQueueHead{ 0 };          // Next press to read (frame timer)
+static std::atomic<uint32_t> keyEffectQueueTail{ 0 };          // Next slot to write (hook)
+
+// Active effects, structure of arrays (UI thread)
+static uint8_t activeEffectKeys[KEY_EFFECT_MAX_ACTIVE];
+static DWORD activeEffectStarts[KEY_EFFECT_MAX_ACTIVE];
+static size_t activeEffectCount = 0;
+
+// Statistics
+static std::atomic<ULONGLONG> keyEffectPressesQueued{ 0 };
+static std::atomic<ULONGLONG> keyEffectPressesDropped{ 0 };    // Queue was full
+static ULONGLONG keyEffectsReplaced = 0;                        // Cap reached - the oldest effect was replaced
+
+// ======================================================================
+// KEY INDEX
+// ======================================================================
+
+void ResetKeyEffectIndex() {
+    memset(keyEffectIndexByKey, KEY_EFFECT_NO_KEY, sizeof(keyEffectIndexByKey));
+    for (size_t i = 0; i < KEY_EFFECT_LAYOUT_KEYS; ++i) {
+        if (static_cast<size_t>(keyEffectLayout[i].key) < KEYBOARD_HOOK_PRESS_KEY_COUNT) {
+            keyEffectIndexByKey[keyEffectLayout[i].key] = static_cast<uint8_t>(i);
+        }
+    }
+    ResetKeyPressFilter(keyEffectPressFilter);
+}
+
+LogiLed::KeyName GetKeyEffectLayoutKey(size_t layoutIndex) {
+    return keyEffectLayout[layoutIndex].key;
+}
+
+// ======================================================================
+// HOOK SIDE
+// ======================================================================
+
+void QueueKeyEffectPress(const InputKeyEvent& keyEvent) {
+    LogiLed::KeyName key;
+    if (!FilterKeyPress(keyEffectPressFilter, keyEvent, key)) {
+        return;
+    }
+    uint8_t keyIndex = keyEffectIndexByKey[key];
+    if (keyIndex == KEY_EFFECT_NO_KEY) {
+        return;
+    }
+    uint32_t tail = keyEffectQueueTail.load(std::memory_order_relaxed);
+    if (tail - keyEffectQueueHead.load(std::memory_order_acquire) >= KEY_EFFECT_QUEUE_CAPACITY) {
+        keyEffectPressesDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    keyEffectQueue[tail & (KEY_EFFECT_QUEUE_CAPACITY - 1)] = { keyIndex, keyEvent.time };
+    keyEffectQueueTail.store(tail + 1, std::memory_order_release);
+    keyEffectPressesQueued.fetch_add(1, std::memory_order_relaxed);
+}
+
+// ======================================================================
+// EFFECT BUFFER
+// ======================================================================
+
+static DWORD GetKeyEffectDurationMs(DWORD effect) {
+    return effect == KEY_EFFECT_RIPPLE ? KEY_EFFECT_RIPPLE_MS : KEY_EFFECT_FADE_MS;
+}
+
+// Start an effect for a press (a fade on a key that is still fading restarts it)
+static void StartKeyEffect(DWORD effect, uint8_t keyIndex, DWORD time) {
+    if (effect == KEY_EFFECT_FADE) {
+        for (size_t i = 0; i < activeEffectCount; ++i) {
+            if (activeEffectKeys[i] == keyIndex) {
+                activeEffectStarts[i] = time;
+                return;
+            }
+        }
+    }
+
+    size_t slot = activeEffectCount;
+    if (activeEffectCount == KEY_EFFECT_MAX_ACTIVE) {
+        slot = 0;
+        for (size_t i = 1; i < activeEffectCount; ++i) {
+            if (static_cast<int32_t>(activeEffectStarts[i] - activeEffectStarts[slot]) < 0) {
+                slot = i;
+            }
+        }
+        ++keyEffectsReplaced;
+    } else {
+        ++activeEffectCount;
+    }
+    activeEffectKeys[slot] = keyIndex;
+    activeEffectStarts[slot] = time;
+}
+
+void DrainKeyEffectQueue(DWORD effect) {
+    uint32_t head = keyEffectQueueHead.load(std::memory_order_relaxed);
+    uint32_t tail = keyEffectQueueTail.load(std::memory_order_acquire);
+    for (; head != tail; ++head) {
+        const KeyEffectPress& press = keyEffectQueue[head & (KEY_EFFECT_QUEUE_CAPACITY - 1)];
+        if (effect != KEY_EFFECT_NONE) {
+            StartKeyEffect(effect, press.keyIndex, press.time);
+        }
+    }
+    keyEffectQueueHead.store(head, std::memory_order_release);
+}
+
+// Finished effects are swapped with the last one, so the buffer stays dense
+void ExpireKeyEffects(DWORD effect, DWORD now) {
+    DWORD duration = GetKeyEffectDurationMs(effect);
+    for (size_t i = 0; i < activeEffectCount;) {
+        if (static_cast<int32_t>(now - activeEffectStarts[i]) >= static_cast<int32_t>(duration)) {
+            --activeEffectCount;
+            activeEffectKeys[i] = activeEffectKeys[activeEffectCount];
+            activeEffectStarts[i] = activeEffectStarts[activeEffectCount];
+        } else {
+            ++i;
+        }
+    }
+}
+
+size_t GetActiveKeyEffectCount() {
+    return activeEffectCount;
+}
+
+void ClearKeyEffectBuffer() {
+    keyEffectQueueHead.store(keyEffectQueueTail.load(std::memory_order_acquire), std::memory_order_release);
+    activeEffectCount = 0;
+}
+
+// ======================================================================
+// INTENSITIES
+// ======================================================================
+
+// Each layout key gets the intensity of the strongest effect covering it
+void ComputeKeyEffectIntensities(DWORD effect, DWORD now, float* intensities) {
+    std::fill(intensities, intensities + KEY_EFFECT_LAYOUT_KEYS, 0.0f);
+    float duration = static_cast<float>(GetKeyEffectDurationMs(effect));
+
+    for (size_t e = 0; e < activeEffectCount; ++e) {
+        int32_t age = static_cast<int32_t>(now - activeEffectStarts[e]);
+        float life = 1.0f - static_cast<float>((std::max)(age, 0)) / duration;
+        uint8_t origin = activeEffectKeys[e];
+        if (effect == KEY_EFFECT_FADE) {
+            intensities[origin] = (std::max)(intensities[origin], life * life);
+            continue;
+        }
+
+        // Ripple: a ring of KEY_EFFECT_RIPPLE_WIDTH around the current radius, fading with age
+        float radius = static_cast<float>(KEY_EFFECT_RIPPLE_SPEED) * (std::max)(age, 0) / 1000.0f;
+        float inner = (std::max)(radius - static_cast<float>(KEY_EFFECT_RIPPLE_WIDTH), 0.0f);
+        float outer = radius + static_cast<float>(KEY_EFFECT_RIPPLE_WIDTH);
+        float originX = keyEffectLayout[origin].x / 4.0f;
+        float originY = keyEffectLayout[origin].y / 4.0f;
+        for (size_t k = 0; k < KEY_EFFECT_LAYOUT_KEYS; ++k) {
+            float dx = keyEffectLayout[k].x / 4.0f - originX;
+            float dy = keyEffectLayout[k].y / 4.0f - originY;
+            float distanceSquared = dx * dx + dy * dy;
+            if (distanceSquared > outer * outer || distanceSquared < inner * inner) {
+                continue;
+            }
+            float band = 1.0f - std::fabs(std::sqrt(distanceSquared) - radius) / static_cast<float>(KEY_EFFECT_RIPPLE_WIDTH);
+            intensities[k] = (std::max)(intensities[k], band * life);
+        }
+    }
+}
+
+COLORREF BlendKeyEffectColor(COLORREF base, COLORREF effect, float intensity) {
+    auto channel = [intensity](int from, int to) {
+        return static_cast<int>(from + (to - from) * intensity + 0.5f);
+    };
+    return RGB(channel(GetRValue(base), GetRValue(effect)),
+               channel(GetGValue(base), GetGValue(effect)),
+               channel(GetBValue(base), GetBValue(effect)));
+}
+
+// ======================================================================
+// STATISTICS
+// ======================================================================
+
+void GetKeyEffectBufferStatistics(ULONGLONG& queued, ULONGLONG& dropped, ULONGLONG& replaced) {
+    queued = keyEffectPressesQueued.load(std::memory_order_relaxed);
+    dropped = keyEffectPressesDropped.load(std::memory_order_relaxed);
+    replaced = keyEffectsReplaced;
+}
@@ -0,0 +1,34 @@
+// SmartLogiLED_KeyEffectBuffer.h : Header file for the key effect press queue and effect buffer.
+//
+// The part of the reactive key effects that neither touches the SDK nor the displayed
+// profile: the lock-free press queue the hook writes, the bounded buffer of active effects
+// and the per-key intensities of a frame. The Bench tool links it without the application
+// (SmartLogiLED_KeyEffects.cpp runs the timer and blends the intensities over the profile).
+
+#pragma once
+
+#include "SmartLogiLED_WinTypes.h"
+#include "SmartLogiLED_Types.h"
+#include "SmartLogiLED_InputSource.h"
+#include <cstddef>
+
+// Layout keys (KEY_EFFECT_LAYOUT_KEYS, the index of the intensities)
+LogiLed::KeyName GetKeyEffectLayoutKey(size_t layoutIndex);
+
+// Map every key of the effect layout to its layout index and reset the press filter (UI thread, subscriber disabled)
+void ResetKeyEffectIndex();
+
+// Hook side (inline hook subscriber): queue one key press (lock-free, no system calls; auto-repeat is not queued)
+void QueueKeyEffectPress(const InputKeyEvent& keyEvent);
+
+// Frame timer (UI thread; effect = KEY_EFFECT_*)
+void DrainKeyEffectQueue(DWORD effect);         // Queued presses start effects (at most one queue's worth per frame)
+void ExpireKeyEffects(DWORD effect, DWORD now); // Drop finished effects
+size_t GetActiveKeyEffectCount();
+void ComputeKeyEffectIntensities(DWORD effect, DWORD now, float* intensities); // KEY_EFFECT_LAYOUT_KEYS values, 0-1
+void ClearKeyEffectBuffer();                    // Forget queued presses and active effects
+
+COLORREF BlendKeyEffectColor(COLORREF base, COLORREF effect, float intensity);
+
+// Queued and dropped (queue full) presses, effects replaced at the cap
+void GetKeyEffectBufferStatistics(ULONGLONG& queued, ULONGLONG& dropped, ULONGLONG& replaced);
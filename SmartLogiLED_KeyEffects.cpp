@@ -0,0 +1,164 @@
+// SmartLogiLED_KeyEffects.cpp : Contains the reactive key effects (frame timer, rendering).
+//
+// The press queue and the effect buffer live in SmartLogiLED_KeyEffectBuffer.cpp. Every frame
+// the timer moves queued presses into the buffer, computes one intensity per layout key and
+// blends the displayed profile's highlight color over the key's profile color. Only keys whose
+// color changed are sent to the SDK, so an idle keyboard costs nothing but the timer message.
+
+#include "framework.h"
+#include "SmartLogiLED_KeyEffects.h"
+#include "SmartLogiLED_KeyEffectBuffer.h"
+#include "SmartLogiLED_LockKeys.h"
+#include "SmartLogiLED_ModifierLayer.h"
+#include "SmartLogiLED_AppProfiles.h"
+#include "SmartLogiLED_KeyboardHook.h"
+#include "SmartLogiLED_Heatmap.h"
+#include "SmartLogiLED_LatencyTrace.h"
+#include "SmartLogiLED_Constants.h"
+#include <algorithm>
+#include <sstream>
+
+// Module-specific variables
+static HWND keyEffectWindow = nullptr;
+static DWORD keyEffectType = KEY_EFFECT_NONE;                   // Effect of the displayed profile (UI thread)
+
+// Per layout key: intensity of the current frame and the color last sent (UI thread)
+static float keyEffectIntensity[KEY_EFFECT_LAYOUT_KEYS];
+static COLORREF keyEffectPainted[KEY_EFFECT_LAYOUT_KEYS];
+static bool keyEffectLit[KEY_EFFECT_LAYOUT_KEYS];              // Painted with an effect color, not the profile color
+static size_t keyEffectLitCount = 0;
+
+// Statistics
+static ULONGLONG keyEffectFrames = 0;                           // Frames with something to render
+static ULONGLONG keyEffectFrameMicros = 0;
+static ULONGLONG keyEffectFrameMaxMicros = 0;
+static ULONGLONG keyEffectKeysPushed = 0;
+
+// ======================================================================
+// RENDERING
+// ======================================================================
+
+// Paint the keys whose color changed; keys an effect just left go back to their profile (or modifier layer) color
+static void RenderKeyEffectFrame(DWORD now) {
+    ComputeKeyEffectIntensities(keyEffectType, now, keyEffectIntensity);
+
+    std::shared_ptr<const AppColorProfile> displayedProfile = GetDisplayedProfile();
+    COLORREF effectColor = displayedProfile ? displayedProfile->appHighlightColor : RGB(255, 255, 255);
+    for (size_t k = 0; k < KEY_EFFECT_LAYOUT_KEYS; ++k) {
+        float intensity = keyEffectIntensity[k];
+        if (intensity <= 0.0f && !keyEffectLit[k]) {
+            continue;
+        }
+
+        LogiLed::KeyName key = GetKeyEffectLayoutKey(k);
+        COLORREF base = GetLayeredKeyColor(displayedProfile.get(), key);
+        COLORREF color = intensity > 0.0f ? BlendKeyEffectColor(base, effectColor, intensity) : base;
+        if (!keyEffectLit[k] || color != keyEffectPainted[k]) {
+            SetKeyColor(key, color);
+            keyEffectPainted[k] = color;
+            ++keyEffectKeysPushed;
+        }
+
+        bool lit = intensity > 0.0f;
+        if (lit && !keyEffectLit[k]) {
+            ++keyEffectLitCount;
+        } else if (!lit && keyEffectLit[k]) {
+            --keyEffectLitCount;
+        }
+        keyEffectLit[k] = lit;
+    }
+}
+
+// Forget every effect (the caller repaints the profile colors)
+static void ClearKeyEffects() {
+    ClearKeyEffectBuffer();
+    std::fill(keyEffectLit, keyEffectLit + KEY_EFFECT_LAYOUT_KEYS, false);
+    keyEffectLitCount = 0;
+}
+
+// ======================================================================
+// EFFECTS
+// ======================================================================
+
+void InitializeKeyEffects(HWND hWnd) {
+    keyEffectWindow = hWnd;
+}
+
+void UpdateKeyEffectsForProfile(const AppColorProfile* displayedProfile) {
+    DWORD effect = displayedProfile ? displayedProfile->keyEffect : KEY_EFFECT_NONE;
+    if (IsHeatmapModeEnabled() || !keyEffectWindow) {
+        effect = KEY_EFFECT_NONE; // The heatmap owns the keyboard colors
+    }
+
+    // The full apply that called us painted every key with its profile color
+    ClearKeyEffects();
+    if (effect == keyEffectType) {
+        return;
+    }
+
+    if (keyEffectType == KEY_EFFECT_NONE) {
+        ResetKeyEffectIndex();
+
+        KeyboardHookSubscriber subscriber;
+        subscriber.inlineHandler = QueueKeyEffectPress;
+        SubscribeKeyboardHook(KeyboardHookClient::KeyEffects, subscriber);
+        SetKeyboardHookSubscriberEnabled(KeyboardHookClient::KeyEffects, true);
+        SetTimer(keyEffectWindow, KEY_EFFECT_FRAME_TIMER_ID, KEY_EFFECT_FRAME_INTERVAL_MS, nullptr);
+    } else if (effect == KEY_EFFECT_NONE) {
+        KillTimer(keyEffectWindow, KEY_EFFECT_FRAME_TIMER_ID);
+        SetKeyboardHookSubscriberEnabled(KeyboardHookClient::KeyEffects, false);
+    }
+    keyEffectType = effect;
+
+#ifdef ENABLE_DEBUG_LOGGING
+    std::wstringstream debugMsg;
+    debugMsg << L"[DEBUG] Key effect changed to " << effect << L"\n";
+    OutputDebugStringW(debugMsg.str().c_str());
+#endif
+}
+
+void OnKeyEffectFrameTimer() {
+    if (keyEffectType == KEY_EFFECT_NONE) {
+        return;
+    }
+    if (IsHeatmapModeEnabled()) {
+        ClearKeyEffects(); // Turning the heatmap off re-applies the profile, which restarts the effects
+        return;
+    }
+    DrainKeyEffectQueue(keyEffectType);
+    DWORD now = GetTickCount(); // Same clock as InputKeyEvent::time
+    ExpireKeyEffects(keyEffectType, now);
+    if (GetActiveKeyEffectCount() == 0 && keyEffectLitCount == 0) {
+        return;
+    }
+
+    ULONGLONG start = ReadTraceClock();
+    RenderKeyEffectFrame(now);
+    ULONGLONG micros = ReadTraceClock() - start;
+    ++keyEffectFrames;
+    keyEffectFrameMicros += micros;
+    keyEffectFrameMaxMicros = (std::max)(keyEffectFrameMaxMicros, micros);
+}
+
+void ShutdownKeyEffects() {
+    if (keyEffectType != KEY_EFFECT_NONE) {
+        KillTimer(keyEffectWindow, KEY_EFFECT_FRAME_TIMER_ID);
+        SetKeyboardHookSubscriberEnabled(KeyboardHookClient::KeyEffects, false);
+        keyEffectType = KEY_EFFECT_NONE;
+    }
+    ClearKeyEffects();
+}
+
+std::wstring FormatKeyEffectStatistics() {
+    ULONGLONG queued, dropped, replaced;
+    GetKeyEffectBufferStatistics(queued, dropped, replaced);
+
+    std::wstringstream report;
+    report << L"Key effects: " << queued << L" presses queued, " << dropped << L" dropped, "
+           << replaced << L" effects replaced at the cap of " << KEY_EFFECT_MAX_ACTIVE;
+    if (keyEffectFrames > 0) {
+        report << L"\n" << keyEffectFrames << L" effect frames, avg " << keyEffectFrameMicros / keyEffectFrames
+               << L" us, max " << keyEffectFrameMaxMicros << L" us, " << keyEffectKeysPushed << L" key colors sent";
+    }
+    return report.str();
+}
@@ -0,0 +1,20 @@
+// SmartLogiLED_KeyEffects.h : Header file for the reactive key effects (fade and ripple).
+//
+// While the displayed profile has a key effect, the keyboard hook queues key presses and a
+// main window timer renders the active effects over the profile colors. The work per frame
+// is bounded by KEY_EFFECT_QUEUE_CAPACITY and KEY_EFFECT_MAX_ACTIVE, not by the typing speed.
+
+#pragma once
+
+#include "framework.h"
+#include "SmartLogiLED_Types.h"
+#include <string>
+
+// Effects (UI thread)
+void InitializeKeyEffects(HWND hWnd);                       // Window that owns the frame timer
+void UpdateKeyEffectsForProfile(const AppColorProfile* displayedProfile); // After every full apply of the displayed frame
+void OnKeyEffectFrameTimer();                               // KEY_EFFECT_FRAME_TIMER_ID
+void ShutdownKeyEffects();
+
+// Queued, dropped and replaced presses and frame render times
+std::wstring FormatKeyEffectStatistics();
@@ -3,132 +3,394 @@
 // This file contains functions for converting between different key representations.
 
 #include "SmartLogiLED_KeyMapping.h"
+#include "SmartLogiLED_Constants.h"
 #include <algorithm> 
-#include <windows.h>
-
-// Add this helper function
-bool IsQWERTZLayout() {
-    HKL layout = GetKeyboardLayout(0);
-    LANGID langId = LOWORD(layout);
-    // Check for German, Austrian, Czech, Slovak layouts
-    return (PRIMARYLANGID(langId) == LANG_GERMAN || 
-            PRIMARYLANGID(langId) == LANG_CZECH ||
-            PRIMARYLANGID(langId) == LANG_SLOVAK);
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <sstream>
+
+// ======================================================================
+// KEY DESCRIPTOR TABLE
+// ======================================================================
+
+// Which hook events of a virtual key mean the key (VK_RETURN is Enter or numpad Enter by the extended flag)
+enum KeyVirtualKeyMatch : uint8_t {
+    KEY_VK_ANY,
+    KEY_VK_NOT_EXTENDED,
+    KEY_VK_EXTENDED
+};
+
+// One key: LED SDK name, INI/display name and the virtual key the hook reports for it
+struct KeyDescriptor {
+    LogiLed::KeyName key;
+    std::string_view name;          // ASCII
+    uint8_t vkCode;                 // 0 = no virtual key (G keys, logo)
+    KeyVirtualKeyMatch vkMatch;
+};
+
+// Every lookup table below is generated from this table at compile time
+static constexpr KeyDescriptor keyDescriptors[] = {
+    { LogiLed::KeyName::ESC, "ESC", VK_ESCAPE, KEY_VK_ANY },
+    { LogiLed::KeyName::F1, "F1", VK_F1, KEY_VK_ANY },
+    { LogiLed::KeyName::F2, "F2", VK_F2, KEY_VK_ANY },
+    { LogiLed::KeyName::F3, "F3", VK_F3, KEY_VK_ANY },
+    { LogiLed::KeyName::F4, "F4", VK_F4, KEY_VK_ANY },
+    { LogiLed::KeyName::F5, "F5", VK_F5, KEY_VK_ANY },
+    { LogiLed::KeyName::F6, "F6", VK_F6, KEY_VK_ANY },
+    { LogiLed::KeyName::F7, "F7", VK_F7, KEY_VK_ANY },
+    { LogiLed::KeyName::F8, "F8", VK_F8, KEY_VK_ANY },
+    { LogiLed::KeyName::F9, "F9", VK_F9, KEY_VK_ANY },
+    { LogiLed::KeyName::F10, "F10", VK_F10, KEY_VK_ANY },
+    { LogiLed::KeyName::F11, "F11", VK_F11, KEY_VK_ANY },
+    { LogiLed::KeyName::F12, "F12", VK_F12, KEY_VK_ANY },
+    { LogiLed::KeyName::PRINT_SCREEN, "PRINT", VK_SNAPSHOT, KEY_VK_ANY },
+    { LogiLed::KeyName::SCROLL_LOCK, "SCROLL", VK_SCROLL, KEY_VK_ANY },
+    { LogiLed::KeyName::PAUSE_BREAK, "PAUSE", VK_PAUSE, KEY_VK_ANY },
+    { LogiLed::KeyName::TILDE, "~", VK_OEM_3, KEY_VK_ANY },
+    { LogiLed::KeyName::ONE, "1", '1', KEY_VK_ANY },
+    { LogiLed::KeyName::TWO, "2", '2', KEY_VK_ANY },
+    { LogiLed::KeyName::THREE, "3", '3', KEY_VK_ANY },
+    { LogiLed::KeyName::FOUR, "4", '4', KEY_VK_ANY },
+    { LogiLed::KeyName::FIVE, "5", '5', KEY_VK_ANY },
+    { LogiLed::KeyName::SIX, "6", '6', KEY_VK_ANY },
+    { LogiLed::KeyName::SEVEN, "7", '7', KEY_VK_ANY },
+    { LogiLed::KeyName::EIGHT, "8", '8', KEY_VK_ANY },
+    { LogiLed::KeyName::NINE, "9", '9', KEY_VK_ANY },
+    { LogiLed::KeyName::ZERO, "0", '0', KEY_VK_ANY },
+    { LogiLed::KeyName::MINUS, "-", VK_OEM_MINUS, KEY_VK_ANY },
+    { LogiLed::KeyName::EQUALS, "=", VK_OEM_PLUS, KEY_VK_ANY },
+    { LogiLed::KeyName::BACKSPACE, "BACKSPACE", VK_BACK, KEY_VK_ANY },
+    { LogiLed::KeyName::INSERT, "INSERT", VK_INSERT, KEY_VK_ANY },
+    { LogiLed::KeyName::HOME, "HOME", VK_HOME, KEY_VK_ANY },
+    { LogiLed::KeyName::PAGE_UP, "PGUP", VK_PRIOR, KEY_VK_ANY },
+    { LogiLed::KeyName::NUM_LOCK, "NUMLOCK", VK_NUMLOCK, KEY_VK_ANY },
+    { LogiLed::KeyName::NUM_SLASH, "NUM/", VK_DIVIDE, KEY_VK_ANY },
+    { LogiLed::KeyName::NUM_ASTERISK, "NUM*", VK_MULTIPLY, KEY_VK_ANY },
+    { LogiLed::KeyName::NUM_MINUS, "NUM-", VK_SUBTRACT, KEY_VK_ANY },
+    { LogiLed::KeyName::TAB, "TAB", VK_TAB, KEY_VK_ANY },
+    { LogiLed::KeyName::Q, "Q", 'Q', KEY_VK_ANY },
+    { LogiLed::KeyName::W, "W", 'W', KEY_VK_ANY },
+    { LogiLed::KeyName::E, "E", 'E', KEY_VK_ANY },
+    { LogiLed::KeyName::R, "R", 'R', KEY_VK_ANY },
+    { LogiLed::KeyName::T, "T", 'T', KEY_VK_ANY },
+    { LogiLed::KeyName::Y, "Y", 'Y', KEY_VK_ANY },
+    { LogiLed::KeyName::U, "U", 'U', KEY_VK_ANY },
+    { LogiLed::KeyName::I, "I", 'I', KEY_VK_ANY },
+    { LogiLed::KeyName::O, "O", 'O', KEY_VK_ANY },
+    { LogiLed::KeyName::P, "P", 'P', KEY_VK_ANY },
+    { LogiLed::KeyName::OPEN_BRACKET, "[", VK_OEM_4, KEY_VK_ANY },
+    { LogiLed::KeyName::CLOSE_BRACKET, "]", VK_OEM_6, KEY_VK_ANY },
+    { LogiLed::KeyName::BACKSLASH, "\\", VK_OEM_5, KEY_VK_ANY },
+    { LogiLed::KeyName::KEYBOARD_DELETE, "DELETE", VK_DELETE, KEY_VK_ANY },
+    { LogiLed::KeyName::END, "END", VK_END, KEY_VK_ANY },
+    { LogiLed::KeyName::PAGE_DOWN, "PGDN", VK_NEXT, KEY_VK_ANY },
+    { LogiLed::KeyName::NUM_SEVEN, "NUM7", VK_NUMPAD7, KEY_VK_ANY },
+    { LogiLed::KeyName::NUM_EIGHT, "NUM8", VK_NUMPAD8, KEY_VK_ANY },
+    { LogiLed::KeyName::NUM_NINE, "NUM9", VK_NUMPAD9, KEY_VK_ANY },
+    { LogiLed::KeyName::NUM_PLUS, "NUM+", VK_ADD, KEY_VK_ANY },
+    { LogiLed::KeyName::CAPS_LOCK, "CAPS", VK_CAPITAL, KEY_VK_ANY },
+    { LogiLed::KeyName::A, "A", 'A', KEY_VK_ANY },
+    { LogiLed::KeyName::S, "S", 'S', KEY_VK_ANY },
+    { LogiLed::KeyName::D, "D", 'D', KEY_VK_ANY },
+    { LogiLed::KeyName::F, "F", 'F', KEY_VK_ANY },
+    { LogiLed::KeyName::G, "G", 'G', KEY_VK_ANY },
+    { LogiLed::KeyName::H, "H", 'H', KEY_VK_ANY },
+    { LogiLed::KeyName::J, "J", 'J', KEY_VK_ANY },
+    { LogiLed::KeyName::K, "K", 'K', KEY_VK_ANY },
+    { LogiLed::KeyName::L, "L", 'L', KEY_VK_ANY },
+    { LogiLed::KeyName::SEMICOLON, ";", VK_OEM_1, KEY_VK_ANY },
+    { LogiLed::KeyName::APOSTROPHE, "'", VK_OEM_7, KEY_VK_ANY },
+    { LogiLed::KeyName::ENTER, "ENTER", VK_RETURN, KEY_VK_NOT_EXTENDED },
+    { LogiLed::KeyName::NUM_FOUR, "NUM4", VK_NUMPAD4, KEY_VK_ANY },
+    { LogiLed::KeyName::NUM_FIVE, "NUM5", VK_NUMPAD5, KEY_VK_ANY },
+    { LogiLed::KeyName::NUM_SIX, "NUM6", VK_NUMPAD6, KEY_VK_ANY },
+    { LogiLed::KeyName::LEFT_SHIFT, "LSHIFT", VK_LSHIFT, KEY_VK_ANY },
+    { LogiLed::KeyName::Z, "Z", 'Z', KEY_VK_ANY },
+    { LogiLed::KeyName::X, "X", 'X', KEY_VK_ANY },
+    { LogiLed::KeyName::C, "C", 'C', KEY_VK_ANY },
+    { LogiLed::KeyName::V, "V", 'V', KEY_VK_ANY },
+    { LogiLed::KeyName::B, "B", 'B', KEY_VK_ANY },
+    { LogiLed::KeyName::N, "N", 'N', KEY_VK_ANY },
+    { LogiLed::KeyName::M, "M", 'M', KEY_VK_ANY },
+    { LogiLed::KeyName::COMMA, ",", VK_OEM_COMMA, KEY_VK_ANY },
+    { LogiLed::KeyName::PERIOD, ".", VK_OEM_PERIOD, KEY_VK_ANY },
+    { LogiLed::KeyName::FORWARD_SLASH, "/", VK_OEM_2, KEY_VK_ANY },
+    { LogiLed::KeyName::RIGHT_SHIFT, "RSHIFT", VK_RSHIFT, KEY_VK_ANY },
+    { LogiLed::KeyName::ARROW_UP, "UP", VK_UP, KEY_VK_ANY },
+    { LogiLed::KeyName::NUM_ONE, "NUM1", VK_NUMPAD1, KEY_VK_ANY },
+    { LogiLed::KeyName::NUM_TWO, "NUM2", VK_NUMPAD2, KEY_VK_ANY },
+    { LogiLed::KeyName::NUM_THREE, "NUM3", VK_NUMPAD3, KEY_VK_ANY },
+    { LogiLed::KeyName::NUM_ENTER, "NUMENTER", VK_RETURN, KEY_VK_EXTENDED },
+    { LogiLed::KeyName::LEFT_CONTROL, "LCTRL", VK_LCONTROL, KEY_VK_ANY },
+    { LogiLed::KeyName::LEFT_WINDOWS, "LWIN", VK_LWIN, KEY_VK_ANY },
+    { LogiLed::KeyName::LEFT_ALT, "LALT", VK_LMENU, KEY_VK_ANY },
+    { LogiLed::KeyName::SPACE, "SPACE", VK_SPACE, KEY_VK_ANY },
+    { LogiLed::KeyName::RIGHT_ALT, "RALT", VK_RMENU, KEY_VK_ANY },
+    { LogiLed::KeyName::RIGHT_WINDOWS, "RWIN", VK_RWIN, KEY_VK_ANY },
+    { LogiLed::KeyName::APPLICATION_SELECT, "MENU", VK_APPS, KEY_VK_ANY },
+    { LogiLed::KeyName::RIGHT_CONTROL, "RCTRL", VK_RCONTROL, KEY_VK_ANY },
+    { LogiLed::KeyName::ARROW_LEFT, "LEFT", VK_LEFT, KEY_VK_ANY },
+    { LogiLed::KeyName::ARROW_DOWN, "DOWN", VK_DOWN, KEY_VK_ANY },
+    { LogiLed::KeyName::ARROW_RIGHT, "RIGHT", VK_RIGHT, KEY_VK_ANY },
+    { LogiLed::KeyName::NUM_ZERO, "NUM0", VK_NUMPAD0, KEY_VK_ANY },
+    { LogiLed::KeyName::NUM_PERIOD, "NUM.", VK_DECIMAL, KEY_VK_ANY },
+    { LogiLed::KeyName::G_1, "G1", 0, KEY_VK_ANY },
+    { LogiLed::KeyName::G_2, "G2", 0, KEY_VK_ANY },
+    { LogiLed::KeyName::G_3, "G3", 0, KEY_VK_ANY },
+    { LogiLed::KeyName::G_4, "G4", 0, KEY_VK_ANY },
+    { LogiLed::KeyName::G_5, "G5", 0, KEY_VK_ANY },
+    { LogiLed::KeyName::G_6, "G6", 0, KEY_VK_ANY },
+    { LogiLed::KeyName::G_7, "G7", 0, KEY_VK_ANY },
+    { LogiLed::KeyName::G_8, "G8", 0, KEY_VK_ANY },
+    { LogiLed::KeyName::G_9, "G9", 0, KEY_VK_ANY },
+    { LogiLed::KeyName::G_LOGO, "G_LOGO", 0, KEY_VK_ANY },
+    { LogiLed::KeyName::G_BADGE, "G_BADGE", 0, KEY_VK_ANY },
+};
+
+static constexpr size_t KEY_DESCRIPTOR_COUNT = sizeof(keyDescriptors) / sizeof(keyDescriptors[0]);
+static_assert(KEY_DESCRIPTOR_COUNT < 0xFF, "Key descriptor indexes are stored in bytes");
+
+// Dense index of a LED SDK key: scan codes 0-0x1FF, then G1-G9, G logo and G badge (-1 = not a key)
+static constexpr int GetKeyNameIndex(LogiLed::KeyName key) {
+    if (key >= 0 && key <= 0x1FF) {
+        return key;
+    }
+    if (key >= LogiLed::KeyName::G_1 && key <= LogiLed::KeyName::G_9) {
+        return 0x200 + (key - LogiLed::KeyName::G_1);
+    }
+    if (key == LogiLed::KeyName::G_LOGO || key == LogiLed::KeyName::G_BADGE) {
+        return 0x209 + (key - LogiLed::KeyName::G_LOGO);
+    }
+    return -1;
+}
+
+static constexpr size_t KEY_NAME_INDEX_COUNT = 0x20B;
+
+// Key -> descriptor index + 1 (0 = key without a name)
+struct KeyDescriptorsByKey {
+    uint8_t entries[KEY_NAME_INDEX_COUNT] = {};
+};
+
+static constexpr KeyDescriptorsByKey BuildKeyDescriptorsByKey() {
+    KeyDescriptorsByKey table;
+    for (size_t i = 0; i < KEY_DESCRIPTOR_COUNT; ++i) {
+        table.entries[GetKeyNameIndex(keyDescriptors[i].key)] = static_cast<uint8_t>(i + 1);
+    }
+    return table;
+}
+
+static constexpr KeyDescriptorsByKey keyDescriptorsByKey = BuildKeyDescriptorsByKey();
+
+// (virtual key, extended flag) -> key for one keyboard layout; ESC for virtual keys the table does not know
+struct KeyLayoutTable {
+    LogiLed::KeyName entries[2][256] = {};
+};
+
+// Virtual keys as the descriptor table lists them (US layout)
+static constexpr KeyLayoutTable BuildDefaultKeyLayoutTable() {
+    KeyLayoutTable table;
+    for (size_t extended = 0; extended < 2; ++extended) {
+        for (size_t vkCode = 0; vkCode < 256; ++vkCode) {
+            table.entries[extended][vkCode] = LogiLed::KeyName::ESC;
+        }
+    }
+    for (const KeyDescriptor& descriptor : keyDescriptors) {
+        if (descriptor.vkCode == 0) {
+            continue;
+        }
+        if (descriptor.vkMatch != KEY_VK_EXTENDED) {
+            table.entries[0][descriptor.vkCode] = descriptor.key;
+        }
+        if (descriptor.vkMatch != KEY_VK_NOT_EXTENDED) {
+            table.entries[1][descriptor.vkCode] = descriptor.key;
+        }
+    }
+    return table;
+}
+
+static constexpr KeyLayoutTable defaultKeyLayoutTable = BuildDefaultKeyLayoutTable();
+
+// Name -> key: perfect hash over the key names. The seed is searched at compile time so that
+// no two names share a slot; a lookup is one hash, one slot read and one name comparison.
+static constexpr uint32_t KEY_NAME_HASH_BITS = 11;
+static constexpr size_t KEY_NAME_HASH_SLOTS = size_t(1) << KEY_NAME_HASH_BITS;
+static constexpr uint32_t KEY_NAME_SEED_LIMIT = 1024;
+
+static constexpr size_t GetKeyNameSlot(std::string_view name, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed; // FNV-1a
+    for (char ch : name) {
+        hash = (hash ^ static_cast<uint8_t>(ch)) * 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x45D9F3Bu;
+    return hash >> (32 - KEY_NAME_HASH_BITS);
+}
+
+static constexpr uint32_t FindKeyNameSeed() {
+    for (uint32_t seed = 0; seed < KEY_NAME_SEED_LIMIT; ++seed) {
+        bool used[KEY_NAME_HASH_SLOTS] = {};
+        bool collision = false;
+        for (size_t i = 0; i < KEY_DESCRIPTOR_COUNT && !collision; ++i) {
+            size_t slot = GetKeyNameSlot(keyDescriptors[i].name, seed);
+            collision = used[slot];
+            used[slot] = true;
+        }
+        if (!collision) {
+            return seed;
+        }
+    }
+    return KEY_NAME_SEED_LIMIT;
+}
+
+static constexpr uint32_t keyNameSeed = FindKeyNameSeed();
+static_assert(keyNameSeed < KEY_NAME_SEED_LIMIT, "No collision-free key name seed - raise KEY_NAME_HASH_BITS");
+
+// Slot -> descriptor index + 1 (0 = empty slot)
+struct KeyDescriptorsByName {
+    uint8_t slots[KEY_NAME_HASH_SLOTS] = {};
+};
+
+static constexpr KeyDescriptorsByName BuildKeyDescriptorsByName() {
+    KeyDescriptorsByName table;
+    for (size_t i = 0; i < KEY_DESCRIPTOR_COUNT; ++i) {
+        table.slots[GetKeyNameSlot(keyDescriptors[i].name, keyNameSeed)] = static_cast<uint8_t>(i + 1);
+    }
+    return table;
+}
+
+static constexpr KeyDescriptorsByName keyDescriptorsByName = BuildKeyDescriptorsByName();
+
+// ======================================================================
+// KEYBOARD LAYOUTS
+// ======================================================================
+
+// Module-specific variables (UI thread, except the active table which the hook reads)
+static std::atomic<const KeyLayoutTable*> activeKeyLayoutTable{ &defaultKeyLayoutTable };
+
+#ifdef _WIN32
+
+struct KeyLayoutCacheEntry {
+    HKL layout;
+    std::unique_ptr<KeyLayoutTable> table;
+};
+
+static std::vector<KeyLayoutCacheEntry> keyLayoutCache;        // Tables are kept until exit (the hook may still read a replaced one)
+static HKL activeKeyLayout = nullptr;
+static HWND keyLayoutWindow = nullptr;
+static HWINEVENTHOOK keyLayoutForegroundHook = nullptr;
+static ULONGLONG keyLayoutSwitches = 0;
+
+// Letters, digits and punctuation: the only virtual keys whose key position depends on the layout
+static bool IsLayoutDependentVirtualKey(UINT vkCode) {
+    return (vkCode >= '0' && vkCode <= '9') || (vkCode >= 'A' && vkCode <= 'Z') ||
+           (vkCode >= VK_OEM_1 && vkCode <= VK_OEM_3) || (vkCode >= VK_OEM_4 && vkCode <= VK_OEM_8) ||
+           vkCode == VK_OEM_102;
+}
+
+// Place the layout-dependent virtual keys by the scan code the layout gives them (the LED keys
+// of the main block are their scan codes); everything else keeps the default table's key
+static std::unique_ptr<KeyLayoutTable> BuildKeyLayoutTable(HKL layout) {
+    std::unique_ptr<KeyLayoutTable> table(new KeyLayoutTable(defaultKeyLayoutTable));
+    for (UINT vkCode = 0; vkCode < 256; ++vkCode) {
+        if (!IsLayoutDependentVirtualKey(vkCode)) {
+            continue;
+        }
+        UINT scanCode = MapVirtualKeyExW(vkCode, MAPVK_VK_TO_VSC, layout);
+        if (scanCode == 0 || scanCode >= 0x80 || keyDescriptorsByKey.entries[scanCode] == 0) {
+            continue; // Not on this layout, or no LED key
+        }
+        table->entries[0][vkCode] = table->entries[1][vkCode] = static_cast<LogiLed::KeyName>(scanCode);
+    }
+    return table;
+}
+
+static const KeyLayoutTable* GetKeyLayoutTable(HKL layout) {
+    for (const KeyLayoutCacheEntry& entry : keyLayoutCache) {
+        if (entry.layout == layout) {
+            return entry.table.get();
+        }
+    }
+    keyLayoutCache.push_back({ layout, BuildKeyLayoutTable(layout) });
+    return keyLayoutCache.back().table.get();
+}
+
+// Layout of the window the user types into (each thread has its own layout)
+static HKL GetForegroundKeyboardLayout() {
+    HWND foreground = GetForegroundWindow();
+    return GetKeyboardLayout(foreground ? GetWindowThreadProcessId(foreground, nullptr) : 0);
+}
+
+static void CALLBACK OnKeyLayoutForegroundChanged(HWINEVENTHOOK, DWORD, HWND, LONG, LONG, DWORD, DWORD) {
+    UpdateKeyboardLayout();
+}
+
+void UpdateKeyboardLayout() {
+    HKL layout = GetForegroundKeyboardLayout();
+    if (layout == activeKeyLayout) {
+        return;
+    }
+    activeKeyLayout = layout;
+    activeKeyLayoutTable.store(GetKeyLayoutTable(layout), std::memory_order_release);
+    ++keyLayoutSwitches;
+
+#ifdef ENABLE_DEBUG_LOGGING
+    std::wstringstream debugMsg;
+    debugMsg << L"Keyboard layout " << std::hex << reinterpret_cast<uintptr_t>(layout) << std::dec
+             << L" active (" << keyLayoutCache.size() << L" layout tables cached)\n";
+    OutputDebugStringW(debugMsg.str().c_str());
+#endif
+}
+
+void InitializeKeyboardLayouts(HWND hWnd) {
+    // Build the table of every installed layout up front, so switching is only a pointer swap
+    int layoutCount = GetKeyboardLayoutList(0, nullptr);
+    if (layoutCount > 0) {
+        std::vector<HKL> layouts(static_cast<size_t>(layoutCount));
+        layoutCount = GetKeyboardLayoutList(layoutCount, layouts.data());
+        for (int i = 0; i < layoutCount; ++i) {
+            GetKeyLayoutTable(layouts[i]);
+        }
+    }
+    UpdateKeyboardLayout();
+
+    // Switching windows may switch the layout; a switch inside the foreground window is only seen by the check timer
+    keyLayoutWindow = hWnd;
+    keyLayoutForegroundHook = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr,
+                                              OnKeyLayoutForegroundChanged, 0, 0, WINEVENT_OUTOFCONTEXT);
+    SetTimer(hWnd, KEY_LAYOUT_CHECK_TIMER_ID, KEY_LAYOUT_CHECK_INTERVAL_MS, nullptr);
+}
+
+void ShutdownKeyboardLayouts() {
+    if (keyLayoutWindow) {
+        KillTimer(keyLayoutWindow, KEY_LAYOUT_CHECK_TIMER_ID);
+        keyLayoutWindow = nullptr;
+    }
+    if (keyLayoutForegroundHook) {
+        UnhookWinEvent(keyLayoutForegroundHook);
+        keyLayoutForegroundHook = nullptr;
+    }
 }
 
-// Convert Virtual Key code to LogiLed::KeyName with extended key information
-LogiLed::KeyName VirtualKeyToLogiLedKey(DWORD vkCode, DWORD flags = 0) {
-    switch (vkCode) {
-        case VK_ESCAPE: return LogiLed::KeyName::ESC;
-        case VK_F1: return LogiLed::KeyName::F1;
-        case VK_F2: return LogiLed::KeyName::F2;
-        case VK_F3: return LogiLed::KeyName::F3;
-        case VK_F4: return LogiLed::KeyName::F4;
-        case VK_F5: return LogiLed::KeyName::F5;
-        case VK_F6: return LogiLed::KeyName::F6;
-        case VK_F7: return LogiLed::KeyName::F7;
-        case VK_F8: return LogiLed::KeyName::F8;
-        case VK_F9: return LogiLed::KeyName::F9;
-        case VK_F10: return LogiLed::KeyName::F10;
-        case VK_F11: return LogiLed::KeyName::F11;
-        case VK_F12: return LogiLed::KeyName::F12;
-        case VK_SNAPSHOT: return LogiLed::KeyName::PRINT_SCREEN;
-        case VK_SCROLL: return LogiLed::KeyName::SCROLL_LOCK;
-        case VK_PAUSE: return LogiLed::KeyName::PAUSE_BREAK;
-        case VK_OEM_3: return LogiLed::KeyName::TILDE; // ~ key
-        case '1': return LogiLed::KeyName::ONE;
-        case '2': return LogiLed::KeyName::TWO;
-        case '3': return LogiLed::KeyName::THREE;
-        case '4': return LogiLed::KeyName::FOUR;
-        case '5': return LogiLed::KeyName::FIVE;
-        case '6': return LogiLed::KeyName::SIX;
-        case '7': return LogiLed::KeyName::SEVEN;
-        case '8': return LogiLed::KeyName::EIGHT;
-        case '9': return LogiLed::KeyName::NINE;
-        case '0': return LogiLed::KeyName::ZERO;
-        case VK_OEM_MINUS: return LogiLed::KeyName::MINUS;
-        case VK_OEM_PLUS: return LogiLed::KeyName::EQUALS;
-        case VK_BACK: return LogiLed::KeyName::BACKSPACE;
-        case VK_INSERT: return LogiLed::KeyName::INSERT;
-        case VK_HOME: return LogiLed::KeyName::HOME;
-        case VK_PRIOR: return LogiLed::KeyName::PAGE_UP;
-        case VK_NUMLOCK: return LogiLed::KeyName::NUM_LOCK;
-        case VK_DIVIDE: return LogiLed::KeyName::NUM_SLASH;
-        case VK_MULTIPLY: return LogiLed::KeyName::NUM_ASTERISK;
-        case VK_SUBTRACT: return LogiLed::KeyName::NUM_MINUS;
-        case VK_TAB: return LogiLed::KeyName::TAB;
-        case 'Q': return LogiLed::KeyName::Q;
-        case 'W': return LogiLed::KeyName::W;
-        case 'E': return LogiLed::KeyName::E;
-        case 'R': return LogiLed::KeyName::R;
-        case 'T': return LogiLed::KeyName::T;
-        case 'Y': 
-            return IsQWERTZLayout() ? LogiLed::KeyName::Z : LogiLed::KeyName::Y;
-        case 'U': return LogiLed::KeyName::U;
-        case 'I': return LogiLed::KeyName::I;
-        case 'O': return LogiLed::KeyName::O;
-        case 'P': return LogiLed::KeyName::P;
-        case VK_OEM_4: return LogiLed::KeyName::OPEN_BRACKET; // [
-        case VK_OEM_6: return LogiLed::KeyName::CLOSE_BRACKET; // ]
-        case VK_OEM_5: return LogiLed::KeyName::BACKSLASH; // backslash
-        case VK_DELETE: return LogiLed::KeyName::KEYBOARD_DELETE;
-        case VK_END: return LogiLed::KeyName::END;
-        case VK_NEXT: return LogiLed::KeyName::PAGE_DOWN;
-        case VK_NUMPAD7: return LogiLed::KeyName::NUM_SEVEN;
-        case VK_NUMPAD8: return LogiLed::KeyName::NUM_EIGHT;
-        case VK_NUMPAD9: return LogiLed::KeyName::NUM_NINE;
-        case VK_ADD: return LogiLed::KeyName::NUM_PLUS;
-        case VK_CAPITAL: return LogiLed::KeyName::CAPS_LOCK;
-        case 'A': return LogiLed::KeyName::A;
-        case 'S': return LogiLed::KeyName::S;
-        case 'D': return LogiLed::KeyName::D;
-        case 'F': return LogiLed::KeyName::F;
-        case 'G': return LogiLed::KeyName::G;
-        case 'H': return LogiLed::KeyName::H;
-        case 'J': return LogiLed::KeyName::J;
-        case 'K': return LogiLed::KeyName::K;
-        case 'L': return LogiLed::KeyName::L;
-        case VK_OEM_1: return LogiLed::KeyName::SEMICOLON; // ;
-        case VK_OEM_7: return LogiLed::KeyName::APOSTROPHE; // '
-        case VK_RETURN: 
-            // Check if this is numpad enter - numpad enter has extended key flag NOT set
-            // Regular enter has extended key flag set
-            return (flags & LLKHF_EXTENDED) ? LogiLed::KeyName::ENTER : LogiLed::KeyName::NUM_ENTER;
-        case VK_NUMPAD4: return LogiLed::KeyName::NUM_FOUR;
-        case VK_NUMPAD5: return LogiLed::KeyName::NUM_FIVE;
-        case VK_NUMPAD6: return LogiLed::KeyName::NUM_SIX;
-        case VK_LSHIFT: return LogiLed::KeyName::LEFT_SHIFT;
-        case 'Z': 
-            return IsQWERTZLayout() ? LogiLed::KeyName::Y : LogiLed::KeyName::Z;
-        case 'X': return LogiLed::KeyName::X;
-        case 'C': return LogiLed::KeyName::C;
-        case 'V': return LogiLed::KeyName::V;
-        case 'B': return LogiLed::KeyName::B;
-        case 'N': return LogiLed::KeyName::N;
-        case 'M': return LogiLed::KeyName::M;
-        case VK_OEM_COMMA: return LogiLed::KeyName::COMMA;
-        case VK_OEM_PERIOD: return LogiLed::KeyName::PERIOD;
-        case VK_OEM_2: return LogiLed::KeyName::FORWARD_SLASH; // /
-        case VK_RSHIFT: return LogiLed::KeyName::RIGHT_SHIFT;
-        case VK_UP: return LogiLed::KeyName::ARROW_UP;
-        case VK_NUMPAD1: return LogiLed::KeyName::NUM_ONE;
-        case VK_NUMPAD2: return LogiLed::KeyName::NUM_TWO;
-        case VK_NUMPAD3: return LogiLed::KeyName::NUM_THREE;
-        case VK_LCONTROL: return LogiLed::KeyName::LEFT_CONTROL;
-        case VK_LWIN: return LogiLed::KeyName::LEFT_WINDOWS;
-        case VK_LMENU: return LogiLed::KeyName::LEFT_ALT;
-        case VK_SPACE: return LogiLed::KeyName::SPACE;
-        case VK_RMENU: return LogiLed::KeyName::RIGHT_ALT;
-        case VK_RWIN: return LogiLed::KeyName::RIGHT_WINDOWS;
-        case VK_APPS: return LogiLed::KeyName::APPLICATION_SELECT;
-        case VK_RCONTROL: return LogiLed::KeyName::RIGHT_CONTROL;
-        case VK_LEFT: return LogiLed::KeyName::ARROW_LEFT;
-        case VK_DOWN: return LogiLed::KeyName::ARROW_DOWN;
-        case VK_RIGHT: return LogiLed::KeyName::ARROW_RIGHT;
-        case VK_NUMPAD0: return LogiLed::KeyName::NUM_ZERO;
-        case VK_DECIMAL: return LogiLed::KeyName::NUM_PERIOD;
-        default: return LogiLed::KeyName::ESC; // Return ESC for unknown keys
+#endif
+
+// ======================================================================
+// LOOKUPS
+// ======================================================================
+
+// Convert Virtual Key code to LogiLed::KeyName with extended key information (keyboard layout in use)
+LogiLed::KeyName VirtualKeyToLogiLedKey(DWORD vkCode, DWORD flags) {
+    if (vkCode > 0xFF) {
+        return LogiLed::KeyName::ESC; // Return ESC for unknown keys
     }
+    return activeKeyLayoutTable.load(std::memory_order_acquire)->entries[(flags & INPUT_KEY_FLAG_EXTENDED) ? 1 : 0][vkCode];
+}
+
+// Same lookup, but unknown virtual keys are reported instead of mapped to ESC
+bool TranslateVirtualKey(DWORD vkCode, DWORD flags, LogiLed::KeyName& key) {
+    key = VirtualKeyToLogiLedKey(vkCode, flags);
+    return key != LogiLed::KeyName::ESC || vkCode == VK_ESCAPE;
 }
 
 // Overload for backward compatibility
@@ -136,247 +398,74 @@ LogiLed::KeyName VirtualKeyToLogiLedKey(DWORD vkCode) {
     return VirtualKeyToLogiLedKey(vkCode, 0);
 }
 
+void ResetKeyPressFilter(KeyPressFilter& filter) {
+    memset(filter.slotsDown, 0, sizeof(filter.slotsDown));
+}
+
+bool FilterKeyPress(KeyPressFilter& filter, const InputKeyEvent& keyEvent, LogiLed::KeyName& key) {
+    size_t slot = (keyEvent.vkCode & 0xFF) | ((keyEvent.flags & INPUT_KEY_FLAG_EXTENDED) ? 0x100 : 0);
+    uint64_t bit = 1ULL << (slot & 63);
+    uint64_t& downWord = filter.slotsDown[slot >> 6];
+
+    if (!keyEvent.keyDown) {
+        downWord &= ~bit;
+        return false;
+    }
+    if (downWord & bit) {
+        return false; // Auto-repeat
+    }
+    downWord |= bit;
+
+    return TranslateVirtualKey(keyEvent.vkCode, keyEvent.flags, key) &&
+           static_cast<size_t>(key) < KEYBOARD_HOOK_PRESS_KEY_COUNT;
+}
+
+bool IsLogiLedKeyKnown(LogiLed::KeyName key) {
+    int index = GetKeyNameIndex(key);
+    return index >= 0 && keyDescriptorsByKey.entries[index] != 0;
+}
+
+// Convert LogiLed::KeyName to its config name (ASCII, "UNKNOWN" for keys without a name)
+std::string_view LogiLedKeyToConfigName(LogiLed::KeyName key) {
+    int index = GetKeyNameIndex(key);
+    uint8_t entry = index >= 0 ? keyDescriptorsByKey.entries[index] : 0;
+    return entry != 0 ? keyDescriptors[entry - 1].name : std::string_view("UNKNOWN");
+}
+
 // Convert LogiLed::KeyName to display name (used for both UI display and config storage)
 std::wstring LogiLedKeyToDisplayName(LogiLed::KeyName key) {
-    switch (key) {
-        case LogiLed::KeyName::ESC: return L"ESC";
-        case LogiLed::KeyName::F1: return L"F1";
-        case LogiLed::KeyName::F2: return L"F2";
-        case LogiLed::KeyName::F3: return L"F3";
-        case LogiLed::KeyName::F4: return L"F4";
-        case LogiLed::KeyName::F5: return L"F5";
-        case LogiLed::KeyName::F6: return L"F6";
-        case LogiLed::KeyName::F7: return L"F7";
-        case LogiLed::KeyName::F8: return L"F8";
-        case LogiLed::KeyName::F9: return L"F9";
-        case LogiLed::KeyName::F10: return L"F10";
-        case LogiLed::KeyName::F11: return L"F11";
-        case LogiLed::KeyName::F12: return L"F12";
-        case LogiLed::KeyName::PRINT_SCREEN: return L"PRINT";
-        case LogiLed::KeyName::SCROLL_LOCK: return L"SCROLL";
-        case LogiLed::KeyName::PAUSE_BREAK: return L"PAUSE";
-        case LogiLed::KeyName::TILDE: return L"~";
-        case LogiLed::KeyName::ONE: return L"1";
-        case LogiLed::KeyName::TWO: return L"2";
-        case LogiLed::KeyName::THREE: return L"3";
-        case LogiLed::KeyName::FOUR: return L"4";
-        case LogiLed::KeyName::FIVE: return L"5";
-        case LogiLed::KeyName::SIX: return L"6";
-        case LogiLed::KeyName::SEVEN: return L"7";
-        case LogiLed::KeyName::EIGHT: return L"8";
-        case LogiLed::KeyName::NINE: return L"9";
-        case LogiLed::KeyName::ZERO: return L"0";
-        case LogiLed::KeyName::MINUS: return L"-";
-        case LogiLed::KeyName::EQUALS: return L"=";
-        case LogiLed::KeyName::BACKSPACE: return L"BACKSPACE";
-        case LogiLed::KeyName::INSERT: return L"INSERT";
-        case LogiLed::KeyName::HOME: return L"HOME";
-        case LogiLed::KeyName::PAGE_UP: return L"PGUP";
-        case LogiLed::KeyName::NUM_LOCK: return L"NUMLOCK";
-        case LogiLed::KeyName::NUM_SLASH: return L"NUM/";
-        case LogiLed::KeyName::NUM_ASTERISK: return L"NUM*";
-        case LogiLed::KeyName::NUM_MINUS: return L"NUM-";
-        case LogiLed::KeyName::TAB: return L"TAB";
-        case LogiLed::KeyName::Q: return L"Q";
-        case LogiLed::KeyName::W: return L"W";
-        case LogiLed::KeyName::E: return L"E";
-        case LogiLed::KeyName::R: return L"R";
-        case LogiLed::KeyName::T: return L"T";
-        case LogiLed::KeyName::Y: return L"Y";
-        case LogiLed::KeyName::U: return L"U";
-        case LogiLed::KeyName::I: return L"I";
-        case LogiLed::KeyName::O: return L"O";
-        case LogiLed::KeyName::P: return L"P";
-        case LogiLed::KeyName::OPEN_BRACKET: return L"[";
-        case LogiLed::KeyName::CLOSE_BRACKET: return L"]";
-        case LogiLed::KeyName::BACKSLASH: return L"\\";
-        case LogiLed::KeyName::KEYBOARD_DELETE: return L"DELETE";
-        case LogiLed::KeyName::END: return L"END";
-        case LogiLed::KeyName::PAGE_DOWN: return L"PGDN";
-        case LogiLed::KeyName::NUM_SEVEN: return L"NUM7";
-        case LogiLed::KeyName::NUM_EIGHT: return L"NUM8";
-        case LogiLed::KeyName::NUM_NINE: return L"NUM9";
-        case LogiLed::KeyName::NUM_PLUS: return L"NUM+";
-        case LogiLed::KeyName::CAPS_LOCK: return L"CAPS";
-        case LogiLed::KeyName::A: return L"A";
-        case LogiLed::KeyName::S: return L"S";
-        case LogiLed::KeyName::D: return L"D";
-        case LogiLed::KeyName::F: return L"F";
-        case LogiLed::KeyName::G: return L"G";
-        case LogiLed::KeyName::H: return L"H";
-        case LogiLed::KeyName::J: return L"J";
-        case LogiLed::KeyName::K: return L"K";
-        case LogiLed::KeyName::L: return L"L";
-        case LogiLed::KeyName::SEMICOLON: return L";";
-        case LogiLed::KeyName::APOSTROPHE: return L"'";
-        case LogiLed::KeyName::ENTER: return L"ENTER";
-        case LogiLed::KeyName::NUM_FOUR: return L"NUM4";
-        case LogiLed::KeyName::NUM_FIVE: return L"NUM5";
-        case LogiLed::KeyName::NUM_SIX: return L"NUM6";
-        case LogiLed::KeyName::LEFT_SHIFT: return L"LSHIFT";
-        case LogiLed::KeyName::Z: return L"Z";
-        case LogiLed::KeyName::X: return L"X";
-        case LogiLed::KeyName::C: return L"C";
-        case LogiLed::KeyName::V: return L"V";
-        case LogiLed::KeyName::B: return L"B";
-        case LogiLed::KeyName::N: return L"N";
-        case LogiLed::KeyName::M: return L"M";
-        case LogiLed::KeyName::COMMA: return L",";
-        case LogiLed::KeyName::PERIOD: return L".";
-        case LogiLed::KeyName::FORWARD_SLASH: return L"/";
-        case LogiLed::KeyName::RIGHT_SHIFT: return L"RSHIFT";
-        case LogiLed::KeyName::ARROW_UP: return L"UP";
-        case LogiLed::KeyName::NUM_ONE: return L"NUM1";
-        case LogiLed::KeyName::NUM_TWO: return L"NUM2";
-        case LogiLed::KeyName::NUM_THREE: return L"NUM3";
-        case LogiLed::KeyName::NUM_ENTER: return L"NUMENTER";
-        case LogiLed::KeyName::LEFT_CONTROL: return L"LCTRL";
-        case LogiLed::KeyName::LEFT_WINDOWS: return L"LWIN";
-        case LogiLed::KeyName::LEFT_ALT: return L"LALT";
-        case LogiLed::KeyName::SPACE: return L"SPACE";
-        case LogiLed::KeyName::RIGHT_ALT: return L"RALT";
-        case LogiLed::KeyName::RIGHT_WINDOWS: return L"RWIN";
-        case LogiLed::KeyName::APPLICATION_SELECT: return L"MENU";
-        case LogiLed::KeyName::RIGHT_CONTROL: return L"RCTRL";
-        case LogiLed::KeyName::ARROW_LEFT: return L"LEFT";
-        case LogiLed::KeyName::ARROW_DOWN: return L"DOWN";
-        case LogiLed::KeyName::ARROW_RIGHT: return L"RIGHT";
-        case LogiLed::KeyName::NUM_ZERO: return L"NUM0";
-        case LogiLed::KeyName::NUM_PERIOD: return L"NUM.";
-        case LogiLed::KeyName::G_1: return L"G1";
-        case LogiLed::KeyName::G_2: return L"G2";
-        case LogiLed::KeyName::G_3: return L"G3";
-        case LogiLed::KeyName::G_4: return L"G4";
-        case LogiLed::KeyName::G_5: return L"G5";
-        case LogiLed::KeyName::G_6: return L"G6";
-        case LogiLed::KeyName::G_7: return L"G7";
-        case LogiLed::KeyName::G_8: return L"G8";
-        case LogiLed::KeyName::G_9: return L"G9";
-        case LogiLed::KeyName::G_LOGO: return L"G_LOGO";
-        case LogiLed::KeyName::G_BADGE: return L"G_BADGE";
-        default: return L"UNKNOWN";
+    std::string_view name = LogiLedKeyToConfigName(key);
+    return std::wstring(name.begin(), name.end()); // Key names are ASCII
+}
+
+// Convert display name to LogiLed::KeyName; false for unknown names (used by the INI parser)
+bool DisplayNameToLogiLedKey(std::string_view displayName, LogiLed::KeyName& key) {
+    uint8_t entry = keyDescriptorsByName.slots[GetKeyNameSlot(displayName, keyNameSeed)];
+    if (entry == 0 || keyDescriptors[entry - 1].name != displayName) {
+        return false;
     }
+    key = keyDescriptors[entry - 1].key;
+    return true;
 }
 
 // Convert display name to LogiLed::KeyName (for config import/export)
 LogiLed::KeyName DisplayNameToLogiLedKey(const std::wstring& displayName) {
-    if (displayName == L"ESC") return LogiLed::KeyName::ESC;
-    if (displayName == L"F1") return LogiLed::KeyName::F1;
-    if (displayName == L"F2") return LogiLed::KeyName::F2;
-    if (displayName == L"F3") return LogiLed::KeyName::F3;
-    if (displayName == L"F4") return LogiLed::KeyName::F4;
-    if (displayName == L"F5") return LogiLed::KeyName::F5;
-    if (displayName == L"F6") return LogiLed::KeyName::F6;
-    if (displayName == L"F7") return LogiLed::KeyName::F7;
-    if (displayName == L"F8") return LogiLed::KeyName::F8;
-    if (displayName == L"F9") return LogiLed::KeyName::F9;
-    if (displayName == L"F10") return LogiLed::KeyName::F10;
-    if (displayName == L"F11") return LogiLed::KeyName::F11;
-    if (displayName == L"F12") return LogiLed::KeyName::F12;
-    if (displayName == L"PRINT") return LogiLed::KeyName::PRINT_SCREEN;
-    if (displayName == L"SCROLL") return LogiLed::KeyName::SCROLL_LOCK;
-    if (displayName == L"PAUSE") return LogiLed::KeyName::PAUSE_BREAK;
-    if (displayName == L"~") return LogiLed::KeyName::TILDE;
-    if (displayName == L"1") return LogiLed::KeyName::ONE;
-    if (displayName == L"2") return LogiLed::KeyName::TWO;
-    if (displayName == L"3") return LogiLed::KeyName::THREE;
-    if (displayName == L"4") return LogiLed::KeyName::FOUR;
-    if (displayName == L"5") return LogiLed::KeyName::FIVE;
-    if (displayName == L"6") return LogiLed::KeyName::SIX;
-    if (displayName == L"7") return LogiLed::KeyName::SEVEN;
-    if (displayName == L"8") return LogiLed::KeyName::EIGHT;
-    if (displayName == L"9") return LogiLed::KeyName::NINE;
-    if (displayName == L"0") return LogiLed::KeyName::ZERO;
-    if (displayName == L"-") return LogiLed::KeyName::MINUS;
-    if (displayName == L"=") return LogiLed::KeyName::EQUALS;
-    if (displayName == L"BACKSPACE") return LogiLed::KeyName::BACKSPACE;
-    if (displayName == L"INSERT") return LogiLed::KeyName::INSERT;
-    if (displayName == L"HOME") return LogiLed::KeyName::HOME;
-    if (displayName == L"PGUP") return LogiLed::KeyName::PAGE_UP;
-    if (displayName == L"NUMLOCK") return LogiLed::KeyName::NUM_LOCK;
-    if (displayName == L"NUM/") return LogiLed::KeyName::NUM_SLASH;
-    if (displayName == L"NUM*") return LogiLed::KeyName::NUM_ASTERISK;
-    if (displayName == L"NUM-") return LogiLed::KeyName::NUM_MINUS;
-    if (displayName == L"TAB") return LogiLed::KeyName::TAB;
-    if (displayName == L"Q") return LogiLed::KeyName::Q;
-    if (displayName == L"W") return LogiLed::KeyName::W;
-    if (displayName == L"E") return LogiLed::KeyName::E;
-    if (displayName == L"R") return LogiLed::KeyName::R;
-    if (displayName == L"T") return LogiLed::KeyName::T;
-    if (displayName == L"Y") return LogiLed::KeyName::Y;
-    if (displayName == L"U") return LogiLed::KeyName::U;
-    if (displayName == L"I") return LogiLed::KeyName::I;
-    if (displayName == L"O") return LogiLed::KeyName::O;
-    if (displayName == L"P") return LogiLed::KeyName::P;
-    if (displayName == L"[") return LogiLed::KeyName::OPEN_BRACKET;
-    if (displayName == L"]") return LogiLed::KeyName::CLOSE_BRACKET;
-    if (displayName == L"\\") return LogiLed::KeyName::BACKSLASH;
-    if (displayName == L"DELETE") return LogiLed::KeyName::KEYBOARD_DELETE;
-    if (displayName == L"END") return LogiLed::KeyName::END;
-    if (displayName == L"PGDN") return LogiLed::KeyName::PAGE_DOWN;
-    if (displayName == L"NUM7") return LogiLed::KeyName::NUM_SEVEN;
-    if (displayName == L"NUM8") return LogiLed::KeyName::NUM_EIGHT;
-    if (displayName == L"NUM9") return LogiLed::KeyName::NUM_NINE;
-    if (displayName == L"NUM+") return LogiLed::KeyName::NUM_PLUS;
-    if (displayName == L"CAPS") return LogiLed::KeyName::CAPS_LOCK;
-    if (displayName == L"A") return LogiLed::KeyName::A;
-    if (displayName == L"S") return LogiLed::KeyName::S;
-    if (displayName == L"D") return LogiLed::KeyName::D;
-    if (displayName == L"F") return LogiLed::KeyName::F;
-    if (displayName == L"G") return LogiLed::KeyName::G;
-    if (displayName == L"H") return LogiLed::KeyName::H;
-    if (displayName == L"J") return LogiLed::KeyName::J;
-    if (displayName == L"K") return LogiLed::KeyName::K;
-    if (displayName == L"L") return LogiLed::KeyName::L;
-    if (displayName == L";") return LogiLed::KeyName::SEMICOLON;
-    if (displayName == L"'") return LogiLed::KeyName::APOSTROPHE;
-    if (displayName == L"ENTER") return LogiLed::KeyName::ENTER;
-    if (displayName == L"NUM4") return LogiLed::KeyName::NUM_FOUR;
-    if (displayName == L"NUM5") return LogiLed::KeyName::NUM_FIVE;
-    if (displayName == L"NUM6") return LogiLed::KeyName::NUM_SIX;
-    if (displayName == L"LSHIFT") return LogiLed::KeyName::LEFT_SHIFT;
-    if (displayName == L"Z") return LogiLed::KeyName::Z;
-    if (displayName == L"X") return LogiLed::KeyName::X;
-    if (displayName == L"C") return LogiLed::KeyName::C;
-    if (displayName == L"V") return LogiLed::KeyName::V;
-    if (displayName == L"B") return LogiLed::KeyName::B;
-    if (displayName == L"N") return LogiLed::KeyName::N;
-    if (displayName == L"M") return LogiLed::KeyName::M;
-    if (displayName == L",") return LogiLed::KeyName::COMMA;
-    if (displayName == L".") return LogiLed::KeyName::PERIOD;
-    if (displayName == L"/") return LogiLed::KeyName::FORWARD_SLASH;
-    if (displayName == L"RSHIFT") return LogiLed::KeyName::RIGHT_SHIFT;
-    if (displayName == L"UP") return LogiLed::KeyName::ARROW_UP;
-    if (displayName == L"NUM1") return LogiLed::KeyName::NUM_ONE;
-    if (displayName == L"NUM2") return LogiLed::KeyName::NUM_TWO;
-    if (displayName == L"NUM3") return LogiLed::KeyName::NUM_THREE;
-    if (displayName == L"NUMENTER") return LogiLed::KeyName::NUM_ENTER;
-    if (displayName == L"LCTRL") return LogiLed::KeyName::LEFT_CONTROL;
-    if (displayName == L"LWIN") return LogiLed::KeyName::LEFT_WINDOWS;
-    if (displayName == L"LALT") return LogiLed::KeyName::LEFT_ALT;
-    if (displayName == L"SPACE") return LogiLed::KeyName::SPACE;
-    if (displayName == L"RALT") return LogiLed::KeyName::RIGHT_ALT;
-    if (displayName == L"RWIN") return LogiLed::KeyName::RIGHT_WINDOWS;
-    if (displayName == L"MENU") return LogiLed::KeyName::APPLICATION_SELECT;
-    if (displayName == L"RCTRL") return LogiLed::KeyName::RIGHT_CONTROL;
-    if (displayName == L"LEFT") return LogiLed::KeyName::ARROW_LEFT;
-    if (displayName == L"DOWN") return LogiLed::KeyName::ARROW_DOWN;
-    if (displayName == L"RIGHT") return LogiLed::KeyName::ARROW_RIGHT;
-    if (displayName == L"NUM0") return LogiLed::KeyName::NUM_ZERO;
-    if (displayName == L"NUM.") return LogiLed::KeyName::NUM_PERIOD;
-    if (displayName == L"G1") return LogiLed::KeyName::G_1;
-    if (displayName == L"G2") return LogiLed::KeyName::G_2;
-    if (displayName == L"G3") return LogiLed::KeyName::G_3;
-    if (displayName == L"G4") return LogiLed::KeyName::G_4;
-    if (displayName == L"G5") return LogiLed::KeyName::G_5;
-    if (displayName == L"G6") return LogiLed::KeyName::G_6;
-    if (displayName == L"G7") return LogiLed::KeyName::G_7;
-    if (displayName == L"G8") return LogiLed::KeyName::G_8;
-    if (displayName == L"G9") return LogiLed::KeyName::G_9;
-    
-    // Use a special invalid key value instead of ESC to indicate unknown keys
-    // TODO: Define INVALID_KEY in LogiLed enum or use std::optional
-    return LogiLed::KeyName::ESC; // Temporary fallback - consider using std::optional<LogiLed::KeyName> instead
+    char name[16];
+    size_t length = 0;
+    for (wchar_t ch : displayName) {
+        if (length == sizeof(name) || ch > 0x7F) {
+            return LogiLed::KeyName::ESC; // Longer than any key name, or not ASCII
+        }
+        name[length++] = static_cast<char>(ch);
+    }
+
+    LogiLed::KeyName key;
+    if (!DisplayNameToLogiLedKey(std::string_view(name, length), key)) {
+        // Use a special invalid key value instead of ESC to indicate unknown keys
+        // TODO: Define INVALID_KEY in LogiLed enum or use std::optional
+        return LogiLed::KeyName::ESC; // Temporary fallback - consider using std::optional<LogiLed::KeyName> instead
+    }
+    return key;
 }
 
 // Format highlight keys for display in text field
@@ -396,7 +485,8 @@ std::wstring FormatHighlightKeysForDisplay(const std::vector<LogiLed::KeyName>&
         if (i > 0) {
             result += L" - ";
         }
-        result += LogiLedKeyToDisplayName(sortedKeys[i]);
+        std::string_view name = LogiLedKeyToConfigName(sortedKeys[i]);
+        result.append(name.begin(), name.end());
     }
     return result;
 }
\ No newline at end of file
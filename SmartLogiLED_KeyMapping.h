@@ -5,28 +5,69 @@
 // - LogiLed::KeyName to display names
 // - Config names to LogiLed::KeyName (for INI import/export)
 // - LogiLed::KeyName to config names
+//
+// Virtual keys are translated through a table per keyboard layout, built once per layout from the
+// layout's scan codes and swapped atomically when the layout of the foreground window changes.
+// Without Win32 (tests, benchmark, other input sources) the US layout table of the descriptor
+// table is used.
 
 #pragma once
 
-#include "framework.h"
+#include "SmartLogiLED_WinTypes.h"
 #include "LogitechLEDLib.h"
+#include "SmartLogiLED_InputSource.h"
+#include "SmartLogiLED_Constants.h"
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
+// Keyboard layout tracking (UI thread): InitializeKeyboardLayouts builds the tables of all installed
+// layouts; UpdateKeyboardLayout switches to the foreground window's layout (WM_INPUTLANGCHANGE, check timer)
+#ifdef _WIN32
+void InitializeKeyboardLayouts(HWND hWnd);
+void UpdateKeyboardLayout();
+void ShutdownKeyboardLayouts();
+#endif
+
 // Convert Virtual Key code to LogiLed::KeyName
 LogiLed::KeyName VirtualKeyToLogiLedKey(DWORD vkCode);
 
 // Convert Virtual Key code to LogiLed::KeyName with extended key information
 LogiLed::KeyName VirtualKeyToLogiLedKey(DWORD vkCode, DWORD flags);
 
+// Convert Virtual Key code to LogiLed::KeyName in the keyboard layout in use; false for virtual keys
+// the key tables do not know (VirtualKeyToLogiLedKey returns ESC for those)
+bool TranslateVirtualKey(DWORD vkCode, DWORD flags, LogiLed::KeyName& key);
+
+// Key presses for inline hook handlers that react to presses (heatmap counters, key effects). The
+// input source reports auto-repeat as further key downs, so each such subscriber keeps a filter that
+// passes only the first key down of a key. The pressed key comes from TranslateVirtualKey;
+// subscribers index their own tables by LED key, not by virtual key, so a keyboard layout switch
+// only changes which virtual key reaches which entry.
+struct KeyPressFilter {
+    uint64_t slotsDown[KEYBOARD_HOOK_PRESS_SLOT_COUNT / 64] = {}; // Virtual key (+256 if extended) is down
+};
+
+void ResetKeyPressFilter(KeyPressFilter& filter);  // UI thread, while the subscriber is disabled
+
+// Inside the hook: true for the first key down of a key the key tables know (key is below KEYBOARD_HOOK_PRESS_KEY_COUNT)
+bool FilterKeyPress(KeyPressFilter& filter, const InputKeyEvent& keyEvent, LogiLed::KeyName& key);
+
+// True for keys the key tables know (VirtualKeyToLogiLedKey returns ESC for unknown virtual keys)
+bool IsLogiLedKeyKnown(LogiLed::KeyName key);
+
 // Convert LogiLed::KeyName to display name for UI
 std::wstring LogiLedKeyToDisplayName(LogiLed::KeyName key);
 
 // Convert config name to LogiLed::KeyName (for INI import)
 LogiLed::KeyName DisplayNameToLogiLedKey(const std::wstring& configName);
 
-// Convert LogiLed::KeyName to config name (for INI export)
-std::wstring LogiLedKeyToDisplayName(LogiLed::KeyName key);
+// Convert UTF-8 config name to LogiLed::KeyName; false if the name is unknown
+bool DisplayNameToLogiLedKey(std::string_view configName, LogiLed::KeyName& key);
+
+// Convert LogiLed::KeyName to config name (for INI export; ASCII, no allocation)
+std::string_view LogiLedKeyToConfigName(LogiLed::KeyName key);
 
 // Format highlight keys for display in text field
 std::wstring FormatHighlightKeysForDisplay(const std::vector<LogiLed::KeyName>& keys);
\ No newline at end of file
@@ -0,0 +1,400 @@
+// SmartLogiLED_KeyboardHook.cpp : Contains the keyboard hook multiplexer (subscribers, event ring, worker, call timing).
+//
+// Key events come from the active input source: the hook procedure, which runs on the UI thread
+// (the thread that installed it), or the thread of an evdev or replay source. Only one source
+// runs at a time, so the ring has a single producer and a single consumer (the hook worker).
+// Each event walks the enabled subscribers, runs their inline handlers and is copied into the
+// ring once for all subscribers with a worker handler; the worker is only woken when it may be
+// waiting. Timing, the wake event and logging come from SmartLogiLED_Platform, so the
+// multiplexer builds without Win32; worker handlers that talk to windows belong to the app.
+
+#include "SmartLogiLED_KeyboardHook.h"
+#include "SmartLogiLED_InputSource.h"
+#include "SmartLogiLED_Platform.h"
+#include "SmartLogiLED_Constants.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+static_assert((KEYBOARD_HOOK_RING_CAPACITY & (KEYBOARD_HOOK_RING_CAPACITY - 1)) == 0, "Hook ring capacity must be a power of two");
+
+// Histogram buckets: bucket n counts calls below 2^n nanoseconds (last bucket: everything above)
+static const int HOOK_HISTOGRAM_BUCKETS = 40;
+
+static const size_t HOOK_CLIENT_COUNT = static_cast<size_t>(KeyboardHookClient::Count);
+
+// Times one hook procedure call into the hook histogram
+class KeyboardHookTimer {
+public:
+    KeyboardHookTimer();
+    ~KeyboardHookTimer();
+private:
+    uint64_t start;
+};
+
+// Dispatch cost of one subscriber
+struct KeyboardHookDispatchStats {
+    std::atomic<ULONGLONG> events{ 0 };
+    std::atomic<ULONGLONG> hookNanos{ 0 };                  // Filter and inline handler, inside the hook
+    std::atomic<ULONGLONG> hookMaxNanos{ 0 };
+    std::atomic<ULONGLONG> workerNanos{ 0 };                // Worker handler
+    std::atomic<ULONGLONG> workerMaxNanos{ 0 };
+};
+
+// Module-specific variables
+static bool inputSourceRunning = false;                     // The active input source was started (UI thread)
+static bool inputSourceCapturing = false;                   // Key capture was switched on in the source (UI thread)
+static KeyboardHookSubscriber hookSubscribers[HOOK_CLIENT_COUNT];   // UI thread (read by the source)
+static std::atomic<DWORD> hookSubscriberMask{ 0 };          // Enabled subscribers
+static std::atomic<DWORD> hookKeyCaptureMask{ 0 };          // Subscribers that swallow key downs (written by the UI thread)
+static KeyboardHookDispatchStats hookDispatchStats[HOOK_CLIENT_COUNT];
+static KeyboardHookEvent hookEventRing[KEYBOARD_HOOK_RING_CAPACITY];
+static std::atomic<uint32_t> hookRingHead{ 0 };            // Next event to read (worker)
+static std::atomic<uint32_t> hookRingTail{ 0 };            // Next slot to write (hook)
+static std::atomic<KeyboardHookEventHandler> hookEventHandlers[HOOK_CLIENT_COUNT];
+static std::thread hookWorkerThread;
+static std::atomic<bool> hookWorkerStopRequested{ false };
+static WakeEvent hookWorkerWakeEvent;
+
+// Hook call timing (written by the hook, read by the worker and the statistics report)
+static ULONGLONG hookWarningNanos = 0;                      // Calls this long are reported (0 = source without a timeout)
+static DWORD hookTimeoutMs = 0;                             // Sink timeout of the running source
+static std::atomic<ULONGLONG> hookCallBuckets[HOOK_HISTOGRAM_BUCKETS];
+static std::atomic<ULONGLONG> hookCallCount{ 0 };
+static std::atomic<ULONGLONG> hookCallMaxNanos{ 0 };
+static std::atomic<ULONGLONG> hookSlowCallNanos{ 0 };       // Slowest call not yet reported by the worker
+static std::atomic<ULONGLONG> hookRecordedEvents{ 0 };
+static std::atomic<ULONGLONG> hookDroppedEvents{ 0 };       // Ring was full
+
+// ======================================================================
+// EVENT RING
+// ======================================================================
+
+static void RecordKeyboardHookEvent(DWORD clients, const InputKeyEvent& keyEvent) {
+    uint32_t tail = hookRingTail.load(std::memory_order_relaxed);
+    if (tail - hookRingHead.load(std::memory_order_acquire) >= KEYBOARD_HOOK_RING_CAPACITY) {
+        hookDroppedEvents.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    KeyboardHookEvent& event = hookEventRing[tail & (KEYBOARD_HOOK_RING_CAPACITY - 1)];
+    event.vkCode = keyEvent.vkCode;
+    event.flags = keyEvent.flags;
+    event.timeMicros = ReadMonotonicNanos() / 1000;         // Trace clock (ReadTraceClock)
+    event.keyDown = keyEvent.keyDown;
+    event.clients = clients;
+    hookRingTail.store(tail + 1);
+    hookRecordedEvents.fetch_add(1, std::memory_order_relaxed);
+
+    // The worker only waits once it has read everything before this event
+    if (hookRingHead.load() == tail && hookWorkerWakeEvent.handle) {
+        SignalWakeEvent(hookWorkerWakeEvent);
+    }
+}
+
+static bool TakeKeyboardHookEvent(KeyboardHookEvent& event) {
+    uint32_t head = hookRingHead.load(std::memory_order_relaxed);
+    if (head == hookRingTail.load()) {
+        return false;
+    }
+    event = hookEventRing[head & (KEYBOARD_HOOK_RING_CAPACITY - 1)];
+    hookRingHead.store(head + 1);
+    return true;
+}
+
+// ======================================================================
+// HOOK CALL TIMING
+// ======================================================================
+
+static int GetHookCallBucket(ULONGLONG nanos) {
+    int bucket = 0;
+    while (nanos > 0 && bucket < HOOK_HISTOGRAM_BUCKETS - 1) {
+        nanos >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+KeyboardHookTimer::KeyboardHookTimer() : start(ReadMonotonicNanos()) {
+}
+
+KeyboardHookTimer::~KeyboardHookTimer() {
+    ULONGLONG nanos = ReadMonotonicNanos() - start;
+
+    hookCallBuckets[GetHookCallBucket(nanos)].fetch_add(1, std::memory_order_relaxed);
+    hookCallCount.fetch_add(1, std::memory_order_relaxed);
+    if (nanos > hookCallMaxNanos.load(std::memory_order_relaxed)) {
+        hookCallMaxNanos.store(nanos, std::memory_order_relaxed); // Single writer (the UI thread)
+    }
+
+    // Close to the point where the OS drops the source (Windows removes the hook) - let the worker report it
+    if (hookWarningNanos != 0 && nanos >= hookWarningNanos && nanos > hookSlowCallNanos.load(std::memory_order_relaxed)) {
+        hookSlowCallNanos.store(nanos);
+        if (hookWorkerWakeEvent.handle) {
+            SignalWakeEvent(hookWorkerWakeEvent);
+        }
+    }
+}
+
+// Log a hook call that came close to the timeout (worker thread - never from the hook itself)
+static void ReportSlowKeyboardHookCall() {
+    ULONGLONG nanos = hookSlowCallNanos.exchange(0);
+    if (nanos == 0) {
+        return;
+    }
+
+    // Logged on every occurrence (not only with ENABLE_DEBUG_LOGGING)
+    std::wstringstream message;
+    message << std::fixed << std::setprecision(1) << L"[HOOK] Keyboard hook call took " << nanos / 1000000.0
+            << L" ms - the input source is dropped after " << hookTimeoutMs << L" ms\n";
+    WriteDebugLog(message.str());
+}
+
+// ======================================================================
+// HOOK PROCEDURE AND SUBSCRIBERS
+// ======================================================================
+
+static void AddDispatchNanos(std::atomic<ULONGLONG>& total, std::atomic<ULONGLONG>& maximum, ULONGLONG nanos) {
+    total.fetch_add(nanos, std::memory_order_relaxed);
+    if (nanos > maximum.load(std::memory_order_relaxed)) {
+        maximum.store(nanos, std::memory_order_relaxed); // Single writer per counter
+    }
+}
+
+// Dispatch one event of the active input source to the enabled subscribers; true = swallow the key
+static bool DispatchInputKeyEvent(const InputKeyEvent& sourceEvent) {
+    KeyboardHookTimer timer;
+    DWORD enabled = hookSubscriberMask.load(std::memory_order_relaxed);
+    if (enabled == 0) {
+        return false;
+    }
+
+    InputKeyEvent keyEvent = sourceEvent;
+    if (keyEvent.time == 0) {
+        keyEvent.time = ReadTickCountMs(); // Sources without the tick clock (evdev, replay)
+    }
+    bool swallow = false;
+    DWORD recordFor = 0;
+    DWORD captureMask = hookKeyCaptureMask.load(std::memory_order_relaxed);
+    if (keyEvent.keyDown && (enabled & captureMask)) {
+        enabled &= captureMask; // A captured key never reaches the system, so nobody else sees it either
+    }
+
+    ULONGLONG mark = ReadMonotonicNanos();
+    for (size_t client = 0; client < HOOK_CLIENT_COUNT; ++client) {
+        const KeyboardHookSubscriber& subscriber = hookSubscribers[client];
+        if (!(enabled & (1u << client)) || (subscriber.keyDownOnly && !keyEvent.keyDown) ||
+            (subscriber.wantsKey && !subscriber.wantsKey(keyEvent.vkCode))) {
+            continue;
+        }
+
+        if (subscriber.inlineHandler) {
+            subscriber.inlineHandler(keyEvent);
+        }
+        if (subscriber.handler) {
+            recordFor |= 1u << client;
+        }
+        swallow |= subscriber.swallowKeyDown && keyEvent.keyDown;
+
+        ULONGLONG now = ReadMonotonicNanos();
+        hookDispatchStats[client].events.fetch_add(1, std::memory_order_relaxed);
+        AddDispatchNanos(hookDispatchStats[client].hookNanos, hookDispatchStats[client].hookMaxNanos, now - mark);
+        mark = now;
+    }
+
+    if (recordFor != 0) {
+        RecordKeyboardHookEvent(recordFor, keyEvent);
+    }
+    return swallow;
+}
+
+// Start the active input source with the first enabled subscriber and stop it with the last
+static void UpdateInputSourceState() {
+    DWORD enabled = hookSubscriberMask.load();
+    IInputEventSource& source = GetInputEventSource();
+    if (enabled != 0 && !inputSourceRunning) {
+        hookTimeoutMs = source.GetSinkTimeoutMs(); // Set before the source's thread calls the sink
+        hookWarningNanos = static_cast<ULONGLONG>(hookTimeoutMs) * 1000000ULL * KEYBOARD_HOOK_WARNING_PERCENT / 100;
+        inputSourceRunning = source.Start(DispatchInputKeyEvent);
+#ifdef ENABLE_DEBUG_LOGGING
+        std::wstringstream debugMsg;
+        debugMsg << L"[DEBUG] Input source " << source.GetName() << (inputSourceRunning ? L" started\n" : L" failed to start\n");
+        WriteDebugLog(debugMsg.str());
+#endif
+    } else if (enabled == 0 && inputSourceRunning) {
+        source.Stop();
+        inputSourceRunning = false;
+#ifdef ENABLE_DEBUG_LOGGING
+        std::wstringstream debugMsg;
+        debugMsg << L"[DEBUG] Input source " << source.GetName() << L" stopped\n";
+        WriteDebugLog(debugMsg.str());
+#endif
+    }
+
+    bool capture = (enabled & hookKeyCaptureMask.load()) != 0;
+    if (capture != inputSourceCapturing) {
+        source.SetKeyCapture(capture);
+        inputSourceCapturing = capture;
+    }
+}
+
+void SubscribeKeyboardHook(KeyboardHookClient client, const KeyboardHookSubscriber& subscriber) {
+    DWORD bit = 1u << static_cast<size_t>(client);
+    hookSubscribers[static_cast<size_t>(client)] = subscriber;
+    if (subscriber.swallowKeyDown) {
+        hookKeyCaptureMask.fetch_or(bit);
+    } else {
+        hookKeyCaptureMask.fetch_and(~bit);
+    }
+    hookEventHandlers[static_cast<size_t>(client)] = subscriber.handler;
+}
+
+bool IsKeyboardHookSubscriberEnabled(KeyboardHookClient client) {
+    return (hookSubscriberMask.load() & (1u << static_cast<size_t>(client))) != 0;
+}
+
+bool IsKeyboardHookInstalled() {
+    return inputSourceRunning;
+}
+
+void SetKeyboardHookSubscriberEnabled(KeyboardHookClient client, bool enabled) {
+    DWORD bit = 1u << static_cast<size_t>(client);
+    if (enabled) {
+        hookSubscriberMask.fetch_or(bit);
+    } else {
+        hookSubscriberMask.fetch_and(~bit);
+    }
+    UpdateInputSourceState(); // One source (one hook) for all subscribers
+}
+
+// ======================================================================
+// WORKER THREAD
+// ======================================================================
+
+static void KeyboardHookWorkerThreadProc() {
+    while (!hookWorkerStopRequested) {
+        WaitWakeEvent(hookWorkerWakeEvent);
+
+        KeyboardHookEvent event;
+        while (TakeKeyboardHookEvent(event)) {
+            for (size_t client = 0; client < HOOK_CLIENT_COUNT; ++client) {
+                KeyboardHookEventHandler handler = hookEventHandlers[client].load();
+                if (!(event.clients & (1u << client)) || !handler) {
+                    continue;
+                }
+                ULONGLONG start = ReadMonotonicNanos();
+                handler(event);
+                AddDispatchNanos(hookDispatchStats[client].workerNanos, hookDispatchStats[client].workerMaxNanos, ReadMonotonicNanos() - start);
+            }
+        }
+        ReportSlowKeyboardHookCall();
+    }
+}
+
+void StartKeyboardHookWorker() {
+    if (hookWorkerThread.joinable()) {
+        return;
+    }
+    CreateWakeEvent(hookWorkerWakeEvent);
+    hookWorkerStopRequested = false;
+    hookWorkerThread = std::thread(KeyboardHookWorkerThreadProc);
+}
+
+// Stop the worker and the input source (events still in the ring are dropped)
+void StopKeyboardHookWorker() {
+    hookSubscriberMask = 0;
+    UpdateInputSourceState();
+    if (!hookWorkerThread.joinable()) {
+        return;
+    }
+    hookWorkerStopRequested = true;
+    SignalWakeEvent(hookWorkerWakeEvent);
+    hookWorkerThread.join();
+    CloseWakeEvent(hookWorkerWakeEvent);
+}
+
+// ======================================================================
+// REPORTING
+// ======================================================================
+
+// Upper bound of the bucket holding the given percentile (capped at the observed maximum)
+static ULONGLONG GetHookCallPercentile(ULONGLONG count, int percentile) {
+    ULONGLONG rank = (count * percentile + 99) / 100;
+    ULONGLONG seen = 0;
+    ULONGLONG maxNanos = hookCallMaxNanos.load(std::memory_order_relaxed);
+    for (int bucket = 0; bucket < HOOK_HISTOGRAM_BUCKETS; ++bucket) {
+        seen += hookCallBuckets[bucket].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            ULONGLONG upperBound = (bucket == 0) ? 1 : (1ULL << bucket);
+            return (std::min)(upperBound, maxNanos);
+        }
+    }
+    return maxNanos;
+}
+
+static const wchar_t* GetKeyboardHookClientName(KeyboardHookClient client) {
+    switch (client) {
+        case KeyboardHookClient::LockKeys:            return L"Lock keys";
+        case KeyboardHookClient::HighlightKeysDialog: return L"Highlight keys dialog";
+        case KeyboardHookClient::ActionKeysDialog:    return L"Action keys dialog";
+        case KeyboardHookClient::Heatmap:             return L"Typing heatmap";
+        case KeyboardHookClient::KeyEffects:          return L"Key effects";
+        case KeyboardHookClient::ModifierLayer:       return L"Modifier layer";
+        default:                                      return L"Unknown";
+    }
+}
+
+static std::wstring FormatNanos(ULONGLONG nanos) {
+    std::wstringstream text;
+    if (nanos >= 10000000) {
+        text << (nanos / 1000000) << L" ms";
+    } else if (nanos >= 10000) {
+        text << (nanos / 1000) << L" us";
+    } else {
+        text << nanos << L" ns";
+    }
+    return text.str();
+}
+
+std::wstring FormatKeyboardHookStatistics() {
+    std::wstringstream report;
+    ULONGLONG count = hookCallCount.load(std::memory_order_relaxed);
+    report << L"Keyboard hook\t" << count;
+    if (count > 0) {
+        report << L"\t" << FormatNanos(GetHookCallPercentile(count, 50))
+               << L"\t" << FormatNanos(GetHookCallPercentile(count, 99))
+               << L"\t" << FormatNanos(hookCallMaxNanos.load(std::memory_order_relaxed));
+    } else {
+        report << L"\t-\t-\t-";
+    }
+    report << L"\n" << hookRecordedEvents.load(std::memory_order_relaxed) << L" key events recorded, "
+           << hookDroppedEvents.load(std::memory_order_relaxed) << L" dropped";
+    if (hookTimeoutMs != 0) {
+        report << L"; hook timeout " << hookTimeoutMs << L" ms";
+    }
+    report << L"\nInput source: " << GetInputEventSource().GetName();
+    std::wstring sourceStatistics = FormatInputSourceStatistics();
+    if (!sourceStatistics.empty()) {
+        report << L"\n" << sourceStatistics;
+    }
+
+    // Average and maximum per dispatched event, inside the hook and on the worker
+    report << L"\n\nSubscriber\tEvents\tHook avg\tHook max\tWorker avg\tWorker max";
+    for (size_t client = 0; client < HOOK_CLIENT_COUNT; ++client) {
+        const KeyboardHookDispatchStats& stats = hookDispatchStats[client];
+        ULONGLONG events = stats.events.load(std::memory_order_relaxed);
+        report << L"\n" << GetKeyboardHookClientName(static_cast<KeyboardHookClient>(client)) << L"\t" << events;
+        if (events == 0) {
+            report << L"\t-\t-\t-\t-";
+            continue;
+        }
+        report << L"\t" << FormatNanos(stats.hookNanos.load(std::memory_order_relaxed) / events)
+               << L"\t" << FormatNanos(stats.hookMaxNanos.load(std::memory_order_relaxed))
+               << L"\t" << FormatNanos(stats.workerNanos.load(std::memory_order_relaxed) / events)
+               << L"\t" << FormatNanos(stats.workerMaxNanos.load(std::memory_order_relaxed));
+    }
+    return report.str();
+}
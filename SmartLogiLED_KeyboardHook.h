@@ -0,0 +1,70 @@
+// SmartLogiLED_KeyboardHook.h : Header file for the keyboard hook multiplexer.
+//
+// Low-level keyboard hooks run inside every keystroke of the system, and Windows silently
+// removes a hook that overruns LowLevelHooksTimeout. The application therefore installs one
+// WH_KEYBOARD_LL hook (while at least one subscriber is enabled) and dispatches every key
+// event to the enabled subscribers from a table. Subscribers that need more than a counter
+// update get the event through a preallocated lock-free ring on the hook worker thread.
+// The hook is the default input source on Windows (SmartLogiLED_InputSource.h); an evdev or
+// replay source can take its place. The multiplexer itself builds without Win32.
+
+#pragma once
+
+#include "SmartLogiLED_WinTypes.h"
+#include "SmartLogiLED_InputSource.h"
+#include <string>
+
+// Hook subscribers (one bit each in the enable mask)
+enum class KeyboardHookClient {
+    LockKeys,               // Lock key state tracker (SmartLogiLED_LockKeys.cpp)
+    HighlightKeysDialog,    // Key capture of the Highlight Keys dialog
+    ActionKeysDialog,       // Key capture of the Action Keys dialog
+    Heatmap,                // Typing heatmap counters
+    KeyEffects,             // Reactive key effects (press queue)
+    ModifierLayer,          // Modifier layer (Shift/Ctrl/Alt state)
+    Count
+};
+
+// Key event as seen by the hook
+struct KeyboardHookEvent {
+    DWORD vkCode = 0;
+    DWORD flags = 0;                // INPUT_KEY_FLAG_* (the KBDLLHOOKSTRUCT LLKHF_* flags)
+    ULONGLONG timeMicros = 0;       // Trace clock when the hook saw the key
+    bool keyDown = false;
+    DWORD clients = 0;              // Subscribers that receive the event (bit per KeyboardHookClient)
+};
+
+// Called on the hook worker thread (handlers post to the UI thread instead of touching windows)
+typedef void (*KeyboardHookEventHandler)(const KeyboardHookEvent& event);
+
+// Called inside the hook (on the input source's thread): lock-free and without system calls (e.g. a counter update)
+typedef void (*KeyboardHookInlineHandler)(const InputKeyEvent& keyEvent);
+
+// Which keys a subscriber wants (called inside the hook; nullptr = every key)
+typedef bool (*KeyboardHookKeyFilter)(DWORD vkCode);
+
+struct KeyboardHookSubscriber {
+    KeyboardHookKeyFilter wantsKey = nullptr;
+    KeyboardHookInlineHandler inlineHandler = nullptr;
+    KeyboardHookEventHandler handler = nullptr;
+    bool keyDownOnly = false;       // Key up events are not dispatched
+    bool swallowKeyDown = false;    // Other applications do not see the key down (key capture)
+};
+
+// Subscribers (UI thread - the thread that owns the hook)
+void SubscribeKeyboardHook(KeyboardHookClient client, const KeyboardHookSubscriber& subscriber); // Call while disabled
+void SetKeyboardHookSubscriberEnabled(KeyboardHookClient client, bool enabled); // Installs/removes the hook as needed
+bool IsKeyboardHookSubscriberEnabled(KeyboardHookClient client);                // Any thread
+bool IsKeyboardHookInstalled();                                                 // The input source is running
+
+#ifdef _WIN32
+// Input source (before the first subscriber is enabled): replay a key recording given on the command line
+void SelectInputEventSource(LPCWSTR commandLine);   // SmartLogiLED_HookInputSource.cpp
+#endif
+
+// Worker thread (start before the first subscriber is enabled; stopping removes the hook)
+void StartKeyboardHookWorker();
+void StopKeyboardHookWorker();
+
+// Hook call durations (count, percentiles, max, dropped events) and per-subscriber dispatch cost
+std::wstring FormatKeyboardHookStatistics();
@@ -0,0 +1,308 @@
+// SmartLogiLED_LatencyTrace.cpp : Contains profile switch latency tracing.
+//
+// A traced profile switch gets an ID when the app monitor detects the app. Every stage
+// (detection, event queue, engine decision, UI queue, LED push) records a timestamped span
+// under that ID into a bounded span log and a per-stage log2 histogram.
+
+#include "framework.h"
+#include "SmartLogiLED_LatencyTrace.h"
+#include "SmartLogiLED_IniFiles.h"
+#include "SmartLogiLED_KeyboardHook.h"
+#include "SmartLogiLED_Platform.h"
+#include "SmartLogiLED_KeyEffects.h"
+#include "SmartLogiLED_ModifierLayer.h"
+#include "SmartLogiLED_LockKeys.h"
+#include "SmartLogiLED_Version.h"
+#include <commdlg.h>
+#include <algorithm>
+#include <mutex>
+#include <vector>
+#include <iomanip>
+#include <sstream>
+
+// Histogram buckets: bucket n counts durations below 2^n microseconds (last bucket: everything above)
+static const int LATENCY_HISTOGRAM_BUCKETS = 32;
+static const int LATENCY_STAGE_COUNT = static_cast<int>(LatencyStage::Count);
+
+// Per-stage latency histogram (lock-free)
+struct LatencyHistogram {
+    std::atomic<ULONGLONG> buckets[LATENCY_HISTOGRAM_BUCKETS];
+    std::atomic<ULONGLONG> count{ 0 };
+    std::atomic<ULONGLONG> totalMicros{ 0 };
+    std::atomic<ULONGLONG> maxMicros{ 0 };
+};
+
+// One recorded span
+struct LatencySpan {
+    ULONGLONG traceId = 0;
+    LatencyStage stage = LatencyStage::Detection;
+    ULONGLONG startMicros = 0;
+    ULONGLONG durationMicros = 0;
+};
+
+// Module-specific variables
+#ifdef ENABLE_LATENCY_TRACING
+std::atomic<bool> latencyTracingEnabled{ false };
+#endif
+static std::atomic<ULONGLONG> nextTraceId{ 1 };
+static LatencyHistogram stageHistograms[LATENCY_STAGE_COUNT];
+static std::mutex spanLogMutex;
+static std::vector<LatencySpan> spanLog;      // Ring buffer of the most recent spans
+static size_t spanLogNext = 0;
+
+void SetLatencyTracingEnabled(bool enabled) {
+#ifdef ENABLE_LATENCY_TRACING
+    latencyTracingEnabled = enabled;
+#else
+    UNREFERENCED_PARAMETER(enabled);
+#endif
+}
+
+void ResetLatencyStatistics() {
+    for (auto& histogram : stageHistograms) {
+        for (auto& bucket : histogram.buckets) {
+            bucket = 0;
+        }
+        histogram.count = 0;
+        histogram.totalMicros = 0;
+        histogram.maxMicros = 0;
+    }
+    std::lock_guard<std::mutex> lock(spanLogMutex);
+    spanLog.clear();
+    spanLogNext = 0;
+}
+
+// ======================================================================
+// TRACE CLOCK
+// ======================================================================
+
+// The hook multiplexer stamps its events from the same clock
+ULONGLONG ReadTraceClock() {
+    return ReadMonotonicNanos() / 1000;
+}
+
+ULONGLONG TraceClockFromFileTime(ULONGLONG fileTime) {
+    FILETIME nowFileTime;
+    GetSystemTimeAsFileTime(&nowFileTime);
+    ULONGLONG nowMicros = ReadTraceClock();
+    ULONGLONG now = (static_cast<ULONGLONG>(nowFileTime.dwHighDateTime) << 32) | nowFileTime.dwLowDateTime;
+
+    if (fileTime == 0 || fileTime > now) {
+        return 0;
+    }
+    ULONGLONG ageMicros = (now - fileTime) / 10;
+    return (ageMicros < nowMicros) ? nowMicros - ageMicros : 0;
+}
+
+// ======================================================================
+// RECORDING
+// ======================================================================
+
+LatencyTrace BeginLatencyTrace(ULONGLONG startMicros) {
+    LatencyTrace trace;
+    trace.id = nextTraceId.fetch_add(1, std::memory_order_relaxed);
+    trace.startMicros = startMicros;
+    return trace;
+}
+
+// Map a duration to its histogram bucket
+static int GetLatencyBucket(ULONGLONG micros) {
+    int bucket = 0;
+    while (micros > 0 && bucket < LATENCY_HISTOGRAM_BUCKETS - 1) {
+        micros >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+void RecordLatencySpan(LatencyStage stage, ULONGLONG traceId, ULONGLONG startMicros, ULONGLONG endMicros) {
+    if (!IsLatencyTracingEnabled() || traceId == 0 || startMicros == 0 || endMicros < startMicros) {
+        return;
+    }
+
+    ULONGLONG duration = endMicros - startMicros;
+    LatencyHistogram& histogram = stageHistograms[static_cast<int>(stage)];
+    histogram.buckets[GetLatencyBucket(duration)].fetch_add(1, std::memory_order_relaxed);
+    histogram.count.fetch_add(1, std::memory_order_relaxed);
+    histogram.totalMicros.fetch_add(duration, std::memory_order_relaxed);
+    ULONGLONG previousMax = histogram.maxMicros.load(std::memory_order_relaxed);
+    while (duration > previousMax && !histogram.maxMicros.compare_exchange_weak(previousMax, duration, std::memory_order_relaxed)) {
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(spanLogMutex);
+        LatencySpan span;
+        span.traceId = traceId;
+        span.stage = stage;
+        span.startMicros = startMicros;
+        span.durationMicros = duration;
+        if (spanLog.size() < LATENCY_TRACE_SPAN_CAPACITY) {
+            spanLog.push_back(span);
+        } else {
+            spanLog[spanLogNext] = span;
+        }
+        spanLogNext = (spanLogNext + 1) % LATENCY_TRACE_SPAN_CAPACITY;
+    }
+
+#ifdef ENABLE_DEBUG_LOGGING
+    std::wstringstream debugMsg;
+    debugMsg << L"[DEBUG] Latency trace #" << traceId << L" " << GetLatencyStageName(stage)
+             << L": " << duration << L" us\n";
+    OutputDebugStringW(debugMsg.str().c_str());
+#endif
+}
+
+// ======================================================================
+// REPORTING
+// ======================================================================
+
+const wchar_t* GetLatencyStageName(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::Detection:  return L"Detection";
+        case LatencyStage::EventQueue: return L"Event queue";
+        case LatencyStage::Decision:   return L"Decision";
+        case LatencyStage::ApplyQueue: return L"UI queue";
+        case LatencyStage::LedPush:    return L"LED push";
+        case LatencyStage::EndToEnd:   return L"End to end";
+        default:                       return L"Unknown";
+    }
+}
+
+// Upper bound of the bucket holding the given percentile (capped at the observed maximum)
+static ULONGLONG GetLatencyPercentile(const LatencyHistogram& histogram, ULONGLONG count, int percentile) {
+    ULONGLONG rank = (count * percentile + 99) / 100;
+    ULONGLONG seen = 0;
+    for (int bucket = 0; bucket < LATENCY_HISTOGRAM_BUCKETS; ++bucket) {
+        seen += histogram.buckets[bucket].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            ULONGLONG upperBound = (bucket == 0) ? 1 : (1ULL << bucket);
+            return (std::min)(upperBound, histogram.maxMicros.load(std::memory_order_relaxed));
+        }
+    }
+    return histogram.maxMicros.load(std::memory_order_relaxed);
+}
+
+// Format a duration in microseconds for display
+static std::wstring FormatMicros(ULONGLONG micros) {
+    std::wstringstream text;
+    if (micros >= 10000) {
+        text << (micros / 1000) << L" ms";
+    } else {
+        text << micros << L" us";
+    }
+    return text.str();
+}
+
+std::wstring FormatLatencyStatistics() {
+    std::wstringstream report;
+    if (!IsLatencyTracingEnabled()) {
+        report << L"Latency tracing is switched off.\n\n";
+    }
+    report << L"Stage\tCount\tp50\tp99\tMax\n";
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; ++stage) {
+        const LatencyHistogram& histogram = stageHistograms[stage];
+        ULONGLONG count = histogram.count.load(std::memory_order_relaxed);
+        report << GetLatencyStageName(static_cast<LatencyStage>(stage)) << L"\t" << count;
+        if (count > 0) {
+            report << L"\t" << FormatMicros(GetLatencyPercentile(histogram, count, 50))
+                   << L"\t" << FormatMicros(GetLatencyPercentile(histogram, count, 99))
+                   << L"\t" << FormatMicros(histogram.maxMicros.load(std::memory_order_relaxed));
+        } else {
+            report << L"\t-\t-\t-";
+        }
+        report << L"\n";
+    }
+    report << L"\nPercentiles are rounded up to the next power of two.";
+    return report.str();
+}
+
+void ShowLatencyStatistics(HWND hWnd) {
+    std::wstring report = FormatLatencyStatistics() + L"\n\n" + FormatKeyboardHookStatistics();
+    report += L"\n" + std::to_wstring(GetLockKeyStateCorrections()) + L" lock key state corrections from the OS";
+    report += L"\n\n" + FormatKeyEffectStatistics();
+    report += L"\n\n" + FormatModifierLayerStatistics();
+    MessageBoxW(hWnd, report.c_str(), L"Profile Switch Latency", MB_OK | MB_ICONINFORMATION);
+}
+
+// Write the statistics and the recorded spans as CSV (UTF-8)
+bool DumpLatencyTraceToFile(const std::wstring& filePath) {
+    std::wstringstream content;
+    content << L"# Generated by " << SMARTLOGILED_PRODUCT_NAME << L" v" << SMARTLOGILED_VERSION_STRING << L"\n";
+    content << L"stage,count,p50_us,p99_us,max_us,mean_us\n";
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; ++stage) {
+        const LatencyHistogram& histogram = stageHistograms[stage];
+        ULONGLONG count = histogram.count.load(std::memory_order_relaxed);
+        content << GetLatencyStageName(static_cast<LatencyStage>(stage)) << L"," << count << L",";
+        if (count > 0) {
+            content << GetLatencyPercentile(histogram, count, 50) << L","
+                    << GetLatencyPercentile(histogram, count, 99) << L","
+                    << histogram.maxMicros.load(std::memory_order_relaxed) << L","
+                    << (histogram.totalMicros.load(std::memory_order_relaxed) / count);
+        } else {
+            content << L",,,";
+        }
+        content << L"\n";
+    }
+
+    content << L"\ntrace_id,stage,start_us,duration_us\n";
+    {
+        std::lock_guard<std::mutex> lock(spanLogMutex);
+        // Oldest span first
+        size_t start = (spanLog.size() < LATENCY_TRACE_SPAN_CAPACITY) ? 0 : spanLogNext;
+        for (size_t i = 0; i < spanLog.size(); ++i) {
+            const LatencySpan& span = spanLog[(start + i) % spanLog.size()];
+            content << span.traceId << L"," << GetLatencyStageName(span.stage) << L","
+                    << span.startMicros << L"," << span.durationMicros << L"\n";
+        }
+    }
+
+    HANDLE hFile = CreateFileW(filePath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    bool success = true;
+    std::string utf8Content;
+    int utf8Size = WideCharToMultiByte(CP_UTF8, 0, content.str().c_str(), -1, nullptr, 0, nullptr, nullptr);
+    if (utf8Size > 0) {
+        utf8Content.resize(utf8Size - 1);
+        WideCharToMultiByte(CP_UTF8, 0, content.str().c_str(), -1, &utf8Content[0], utf8Size, nullptr, nullptr);
+        DWORD bytesWritten = 0;
+        success = WriteFile(hFile, utf8Content.c_str(), static_cast<DWORD>(utf8Content.size()), &bytesWritten, nullptr) != FALSE;
+    }
+    CloseHandle(hFile);
+    return success;
+}
+
+void DumpLatencyTraceWithDialog(HWND hWnd) {
+    std::wstring defaultDir = GetDefaultExportDirectory();
+
+    OPENFILENAMEW ofn;
+    wchar_t szFile[MAX_PATH] = { 0 };
+    std::wstring defaultName = L"SmartLogiLED_Latency.csv";
+    if (!defaultDir.empty()) {
+        std::wstring fullPath = defaultDir + L"\\" + defaultName;
+        wcscpy_s(szFile, fullPath.c_str());
+    } else {
+        wcscpy_s(szFile, defaultName.c_str());
+    }
+
+    ZeroMemory(&ofn, sizeof(ofn));
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = hWnd;
+    ofn.lpstrFile = szFile;
+    ofn.nMaxFile = sizeof(szFile) / sizeof(wchar_t);
+    ofn.lpstrFilter = L"CSV Files (*.csv)\0*.csv\0All Files (*.*)\0*.*\0";
+    ofn.nFilterIndex = 1;
+    ofn.lpstrInitialDir = defaultDir.empty() ? nullptr : defaultDir.c_str();
+    ofn.lpstrTitle = L"Dump Latency Trace";
+    ofn.Flags = OFN_PATHMUSTEXIST | OFN_HIDEREADONLY | OFN_OVERWRITEPROMPT;
+    ofn.lpstrDefExt = L"csv";
+
+    if (!GetSaveFileNameW(&ofn)) {
+        return; // User cancelled
+    }
+
+    if (!DumpLatencyTraceToFile(szFile)) {
+        MessageBoxW(hWnd, L"Failed to write the latency trace.", L"Dump Error", MB_OK | MB_ICONERROR);
+    }
+}
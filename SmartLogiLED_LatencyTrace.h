@@ -0,0 +1,57 @@
+// SmartLogiLED_LatencyTrace.h : Header file for profile switch latency tracing.
+//
+
+#pragma once
+
+#include "framework.h"
+#include "SmartLogiLED_Constants.h"
+#include <atomic>
+#include <string>
+
+// Stages of a profile switch, in the order they happen
+enum class LatencyStage {
+    Detection,      // Process created -> seen by the app monitor
+    EventQueue,     // Event queued -> picked up by the profile engine
+    Decision,       // Profile engine handler
+    ApplyQueue,     // Snapshot published -> UI thread starts pushing colors
+    LedPush,        // Logitech SDK calls in ApplyProfileColorsInternal
+    EndToEnd,       // Trace start -> colors pushed
+    Count
+};
+
+// Trace context carried with an event from detection to the LED push (id 0 = not traced)
+struct LatencyTrace {
+    ULONGLONG id = 0;
+    ULONGLONG startMicros = 0;
+};
+
+#ifdef ENABLE_LATENCY_TRACING
+extern std::atomic<bool> latencyTracingEnabled;
+
+// One relaxed load - the only cost of the instrumentation while tracing is switched off
+inline bool IsLatencyTracingEnabled() {
+    return latencyTracingEnabled.load(std::memory_order_relaxed);
+}
+#else
+inline bool IsLatencyTracingEnabled() {
+    return false;
+}
+#endif
+
+void SetLatencyTracingEnabled(bool enabled);
+void ResetLatencyStatistics();
+
+// Trace clock (microseconds of ReadMonotonicNanos, QueryPerformanceCounter based)
+ULONGLONG ReadTraceClock();
+ULONGLONG TraceClockFromFileTime(ULONGLONG fileTime); // FILETIME (100 ns units) -> trace clock, 0 if unknown
+
+// Recording
+LatencyTrace BeginLatencyTrace(ULONGLONG startMicros);
+void RecordLatencySpan(LatencyStage stage, ULONGLONG traceId, ULONGLONG startMicros, ULONGLONG endMicros);
+
+// Reporting
+const wchar_t* GetLatencyStageName(LatencyStage stage);
+std::wstring FormatLatencyStatistics();
+void ShowLatencyStatistics(HWND hWnd);
+bool DumpLatencyTraceToFile(const std::wstring& filePath);
+void DumpLatencyTraceWithDialog(HWND hWnd);
@@ -8,9 +8,14 @@
 #include "SmartLogiLED_Config.h"
 #include "SmartLogiLED_Dialogs.h"
 #include "SmartLogiLED_Constants.h"
+#include "SmartLogiLED_KeyboardHook.h"
+#include "SmartLogiLED_Heatmap.h"
+#include "SmartLogiLED_ModifierLayer.h"
 #include "LogitechLEDLib.h"
 #include "Resource.h"
 #include <commdlg.h>
+#include <algorithm>
+#include <atomic>
 #include <sstream>
 
 // External variables from main file
@@ -18,13 +23,18 @@ extern COLORREF capsLockColor;
 extern COLORREF scrollLockColor; 
 extern COLORREF numLockColor;  
 extern COLORREF defaultColor;
-extern HHOOK keyboardHook;
 
 
 // Hook management variables
 static bool isKeyboardHookEnabled = false;
 static HWND mainWindowHandle = nullptr;
 
+// Lock key states tracked from hook events (LOCK_KEY_STATE_* bits, see GetLockKeyBit)
+static std::atomic<DWORD> lockKeysToggled{ 0 };
+static std::atomic<DWORD> lockKeysDown{ 0 };
+static DWORD lockKeysMismatched = 0;                    // Keys that disagreed with the OS on the last check (UI thread)
+static std::atomic<ULONGLONG> lockKeyStateCorrections{ 0 };
+
 // Set color for a key using Logitech LED SDK
 void SetKeyColor(LogiLed::KeyName key, COLORREF color) {
     int r = GetRValue(color) * 100 / 255;
@@ -41,14 +51,33 @@ void SetDefaultColor(COLORREF color) {
     LogiLedSetLighting(r, g, b);
 }
 
+// Bit of a lock key in the lock state masks (0 = not a lock key)
+static DWORD GetLockKeyBit(DWORD vkCode) {
+    switch (vkCode) {
+        case VK_NUMLOCK: return LOCK_KEY_STATE_NUM;
+        case VK_CAPITAL: return LOCK_KEY_STATE_CAPS;
+        case VK_SCROLL:  return LOCK_KEY_STATE_SCROLL;
+        default:         return 0;
+    }
+}
+
+// Lock key states as the input source sees them (UI thread - the hook source reads this thread's input state)
+static DWORD ReadOsLockKeyStates() {
+    return GetInputEventSource().ReadLockKeyStates();
+}
+
+DWORD GetLockKeyStates() {
+    return lockKeysToggled.load(std::memory_order_acquire);
+}
+
 // Set color for lock keys depending on their state (only if lock keys feature is enabled)
 void SetLockKeysColor(void) {
-    AppColorProfile* displayedProfile = GetDisplayedProfile();
-    SetLockKeysColorWithProfile(displayedProfile);
+    std::shared_ptr<const AppColorProfile> displayedProfile = GetDisplayedProfile();
+    SetLockKeysColorWithProfile(displayedProfile.get());
 }
 
 // Set color for lock keys with a specific profile (unsafe version - doesn't acquire mutex)
-void SetLockKeysColorWithProfile(AppColorProfile* displayedProfile) {
+void SetLockKeysColorWithProfile(const AppColorProfile* displayedProfile) {
     // Determine the color to use for "off" state - app color if profile is active, otherwise default color
     COLORREF offStateColor = defaultColor;
     if (displayedProfile) {
@@ -65,27 +94,21 @@ void SetLockKeysColorWithProfile(AppColorProfile* displayedProfile) {
         return;
     }
 
-    // NumLock
-    SHORT keyStateNum = GetKeyState(VK_NUMLOCK) & 0x0001;
-    SetKeyColor(LogiLed::KeyName::NUM_LOCK, (keyStateNum == 0x0001) ? numLockColor : offStateColor);
-
-    // CapsLock
-    SHORT keyStateCaps = GetKeyState(VK_CAPITAL) & 0x0001;
-    SetKeyColor(LogiLed::KeyName::CAPS_LOCK, (keyStateCaps == 0x0001) ? capsLockColor : offStateColor);
-
-    // ScrollLock
-    SHORT keyStateScroll = GetKeyState(VK_SCROLL) & 0x0001;
-    SetKeyColor(LogiLed::KeyName::SCROLL_LOCK, (keyStateScroll == 0x0001) ? scrollLockColor : offStateColor);
+    // Lock states come from the tracked bitmask, not from the OS
+    DWORD lockStates = GetLockKeyStates();
+    SetKeyColor(LogiLed::KeyName::NUM_LOCK, (lockStates & LOCK_KEY_STATE_NUM) ? numLockColor : offStateColor);
+    SetKeyColor(LogiLed::KeyName::CAPS_LOCK, (lockStates & LOCK_KEY_STATE_CAPS) ? capsLockColor : offStateColor);
+    SetKeyColor(LogiLed::KeyName::SCROLL_LOCK, (lockStates & LOCK_KEY_STATE_SCROLL) ? scrollLockColor : offStateColor);
 }
 
 // Set highlight color for keys from the currently active profile
 void SetHighlightKeysColor() {
-    AppColorProfile* displayedProfile = GetDisplayedProfile();
-    SetHighlightKeysColorWithProfile(displayedProfile);
+    std::shared_ptr<const AppColorProfile> displayedProfile = GetDisplayedProfile();
+    SetHighlightKeysColorWithProfile(displayedProfile.get());
 }
 
 // Set highlight color for keys with a specific profile (unsafe version - doesn't acquire mutex)
-void SetHighlightKeysColorWithProfile(AppColorProfile* displayedProfile) {
+void SetHighlightKeysColorWithProfile(const AppColorProfile* displayedProfile) {
     if (!displayedProfile) return;
     
     // Apply highlight color to all keys in the highlight list
@@ -96,12 +119,12 @@ void SetHighlightKeysColorWithProfile(AppColorProfile* displayedProfile) {
 
 // Set action color for keys from the currently active profile
 void SetActionKeysColor() {
-    AppColorProfile* displayedProfile = GetDisplayedProfile();
-    SetActionKeysColorWithProfile(displayedProfile);
+    std::shared_ptr<const AppColorProfile> displayedProfile = GetDisplayedProfile();
+    SetActionKeysColorWithProfile(displayedProfile.get());
 }
 
 // Set action color for keys with a specific profile (unsafe version - doesn't acquire mutex)
-void SetActionKeysColorWithProfile(AppColorProfile* displayedProfile) {
+void SetActionKeysColorWithProfile(const AppColorProfile* displayedProfile) {
     if (!displayedProfile) return;
     
     // Apply action color to all keys in the action list
@@ -110,41 +133,54 @@ void SetActionKeysColorWithProfile(AppColorProfile* displayedProfile) {
     }
 }
 
-// Keyboard hook procedure to handle lock key presses
-LRESULT CALLBACK KeyboardProc(int nCode, WPARAM wParam, LPARAM lParam) {
-    if (nCode >= 0 && (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN)) {
-        KBDLLHOOKSTRUCT* pKeyStruct = (KBDLLHOOKSTRUCT*)lParam;
-
-        // Check if lock key was pressed
-        if ((pKeyStruct->vkCode == VK_NUMLOCK) || (pKeyStruct->vkCode == VK_SCROLL) || (pKeyStruct->vkCode == VK_CAPITAL)) {
-            // Send message to main window to handle lock key press
-            if (mainWindowHandle) {
-                // Get the key state *before* this press toggles it. The low-order bit is the toggle state.
-                SHORT keyState = GetKeyState(pKeyStruct->vkCode);
-                // send inverted state as Lock Key state toogles only after windows handling  
-                LPARAM state = !(keyState & 0x0001); // 1 if toggled on, 0 if off
-                PostMessage(mainWindowHandle, WM_LOCK_KEY_PRESSED, pKeyStruct->vkCode, state);
-            }
-        }
+// Hook subscriber filter: the lock key tracker only receives lock keys
+static bool IsLockKey(DWORD vkCode) {
+    return GetLockKeyBit(vkCode) != 0;
+}
+
+// Track the toggle state of a lock key and tell the main window (hook worker thread)
+static void OnLockKeyHookEvent(const KeyboardHookEvent& event) {
+    DWORD bit = GetLockKeyBit(event.vkCode);
+    if (!event.keyDown) {
+        lockKeysDown.fetch_and(~bit);
+        return;
+    }
+    if (lockKeysDown.fetch_or(bit) & bit) {
+        return; // Auto-repeat - the state only toggles on the first press
     }
 
-    return CallNextHookEx(keyboardHook, nCode, wParam, lParam);
+    DWORD toggled = lockKeysToggled.fetch_xor(bit) ^ bit;
+    if (mainWindowHandle) {
+        PostMessage(mainWindowHandle, WM_LOCK_KEY_PRESSED, event.vkCode, (toggled & bit) ? 1 : 0);
+    }
 }
 
-// Handle lock key press in main thread
-void HandleLockKeyPressed(DWORD vkCode, DWORD vkState) {
-    
-    // Check if lock keys feature is enabled
-    if (!IsLockKeysFeatureEnabled()) {
-        // Lock keys feature is disabled - keep lock keys at the app color
-        AppColorProfile* displayedProfile = GetDisplayedProfile();
-        COLORREF offStateColor = defaultColor;
-        if (displayedProfile) {
-            offStateColor = displayedProfile->appColor;
+// Final color of one lock key, with the precedence of a full profile apply
+// (action keys over highlight keys over the lock state over the app color)
+static COLORREF GetLockKeyFinalColor(const AppColorProfile* displayedProfile, LogiLed::KeyName lockKey, COLORREF onColor, bool isOn) {
+    if (displayedProfile) {
+        const auto& actionKeys = displayedProfile->actionKeys;
+        if (std::find(actionKeys.begin(), actionKeys.end(), lockKey) != actionKeys.end()) {
+            return displayedProfile->appActionColor;
+        }
+        const auto& highlightKeys = displayedProfile->highlightKeys;
+        if (std::find(highlightKeys.begin(), highlightKeys.end(), lockKey) != highlightKeys.end()) {
+            return displayedProfile->appHighlightColor;
         }
-        
-        LogiLed::KeyName lockKey;
-        switch (vkCode) {
+    }
+
+    // Determine the color to use for "off" state - app color if profile is active, otherwise default color
+    COLORREF offStateColor = displayedProfile ? displayedProfile->appColor : defaultColor;
+
+    // Lock colors only apply if the feature is enabled for the current context
+    bool lockKeysActive = !displayedProfile || displayedProfile->lockKeysEnabled;
+    return (lockKeysActive && isOn) ? onColor : offStateColor;
+}
+
+// Handle lock key press in main thread (updates only the toggled key; the tracked state already has the toggle)
+void HandleLockKeyPressed(DWORD vkCode) {
+    LogiLed::KeyName lockKey;
+    switch (vkCode) {
         case VK_NUMLOCK:
             lockKey = LogiLed::KeyName::NUM_LOCK;
             break;
@@ -155,58 +191,81 @@ void HandleLockKeyPressed(DWORD vkCode, DWORD vkState) {
             lockKey = LogiLed::KeyName::SCROLL_LOCK;
             break;
         default:
-            return; // Unknown key
-        }
-        SetKeyColor(lockKey, offStateColor);
+            return; // Not a lock key, ignore
+    }
+    if (IsHeatmapModeEnabled()) {
+        return; // The heatmap owns the keyboard colors
+    }
+
+    // One snapshot read and one SDK call, whatever the size of the profile's key lists; a lock key
+    // held under the modifier layer keeps the layer color until the modifier is released
+    std::shared_ptr<const AppColorProfile> displayedProfile = GetDisplayedProfile();
+    SetKeyColor(lockKey, GetLayeredKeyColor(displayedProfile.get(), lockKey));
+}
+
+// Color a full apply gives one key (effects blend over it instead of re-applying the profile)
+COLORREF GetProfileKeyColor(const AppColorProfile* displayedProfile, LogiLed::KeyName key) {
+    DWORD lockStates = GetLockKeyStates();
+    switch (key) {
+        case LogiLed::KeyName::NUM_LOCK:
+            return GetLockKeyFinalColor(displayedProfile, key, numLockColor, (lockStates & LOCK_KEY_STATE_NUM) != 0);
+        case LogiLed::KeyName::CAPS_LOCK:
+            return GetLockKeyFinalColor(displayedProfile, key, capsLockColor, (lockStates & LOCK_KEY_STATE_CAPS) != 0);
+        case LogiLed::KeyName::SCROLL_LOCK:
+            return GetLockKeyFinalColor(displayedProfile, key, scrollLockColor, (lockStates & LOCK_KEY_STATE_SCROLL) != 0);
+        default:
+            break;
+    }
+    if (!displayedProfile) {
+        return defaultColor;
+    }
+    const auto& actionKeys = displayedProfile->actionKeys;
+    if (std::find(actionKeys.begin(), actionKeys.end(), key) != actionKeys.end()) {
+        return displayedProfile->appActionColor;
+    }
+    const auto& highlightKeys = displayedProfile->highlightKeys;
+    if (std::find(highlightKeys.begin(), highlightKeys.end(), key) != highlightKeys.end()) {
+        return displayedProfile->appHighlightColor;
+    }
+    return displayedProfile->appColor;
+}
+
+// Correct lock key states that no longer match the OS (UI thread, LOCK_KEY_RECONCILE_TIMER_ID)
+//
+// Hook events can be missed (hook removed by a timeout, input injected by remote desktop
+// sessions, key state changed by SetKeyboardState). A key that disagrees on two checks in a row
+// is flipped and repainted; a single disagreement is usually a hook event still in flight.
+void ReconcileLockKeyStates() {
+    if (!isKeyboardHookEnabled) {
+        lockKeysMismatched = 0; // Lock colors are off - EnableKeyboardHook re-reads the states
         return;
     }
 
-    // Lock keys feature is enabled - apply lock key colors based on state
-    AppColorProfile* displayedProfile = GetDisplayedProfile();
-    COLORREF offStateColor = defaultColor;
-    if (displayedProfile) {
-        offStateColor = displayedProfile->appColor;
+    DWORD tracked = GetLockKeyStates();
+    DWORD mismatched = tracked ^ ReadOsLockKeyStates();
+    DWORD confirmed = mismatched & lockKeysMismatched;
+    lockKeysMismatched = mismatched & ~confirmed;
+    if (confirmed == 0 || !lockKeysToggled.compare_exchange_strong(tracked, tracked ^ confirmed)) {
+        return; // In sync, or the hook worker just changed a state - check again next time
     }
 
-    switch (vkCode) {
-        case VK_NUMLOCK:
-            if (vkState == 0x0001) {
-                // Key is now ON
-                SetKeyColor(LogiLed::KeyName::NUM_LOCK, numLockColor);
-            } else {
-                // Key is now OFF
-                SetKeyColor(LogiLed::KeyName::NUM_LOCK, offStateColor);
-            }
-            break;
-        case VK_CAPITAL:
-            if (vkState == 0x0001) {
-                // Key is now ON
-                SetKeyColor(LogiLed::KeyName::CAPS_LOCK, capsLockColor);
-            } else {
-                // Key is now OFF
-                SetKeyColor(LogiLed::KeyName::CAPS_LOCK, offStateColor);
-            }
-            break;
-        case VK_SCROLL:
-            if (vkState == 0x0001) {
-                // Key is now ON
-                SetKeyColor(LogiLed::KeyName::SCROLL_LOCK, scrollLockColor);
-            } else {
-                // Key is now OFF
-                SetKeyColor(LogiLed::KeyName::SCROLL_LOCK, offStateColor);
-            }
-            break;
-        default:
-            return; // Not a lock key, ignore
-	}
+    for (DWORD vkCode : { VK_NUMLOCK, VK_CAPITAL, VK_SCROLL }) {
+        DWORD bit = GetLockKeyBit(vkCode);
+        if (confirmed & bit) {
+            lockKeyStateCorrections.fetch_add(1, std::memory_order_relaxed);
+            HandleLockKeyPressed(vkCode);
+#ifdef ENABLE_DEBUG_LOGGING
+            std::wstringstream debugMsg;
+            debugMsg << L"[DEBUG] Lock key state corrected from the OS: VK " << vkCode << L" is "
+                     << (((tracked ^ confirmed) & bit) ? L"ON" : L"OFF") << L"\n";
+            OutputDebugStringW(debugMsg.str().c_str());
+#endif
+        }
+    }
+}
 
-    // Re-apply highlight colors in case a lock key was also a highlight key.
-    // The lock color will correctly take precedence.
-    SetHighlightKeysColor();
-    
-    // Re-apply action colors in case a lock key was also an action key.
-    // The lock color will correctly take precedence.
-    SetActionKeysColor();
+ULONGLONG GetLockKeyStateCorrections() {
+    return lockKeyStateCorrections.load(std::memory_order_relaxed);
 }
 
 // Hook management functions
@@ -216,40 +275,41 @@ bool IsKeyboardHookEnabled() {
     return isKeyboardHookEnabled;
 }
 
-// Enable the keyboard hook
+// Enable the lock key tracker on the keyboard hook
 void EnableKeyboardHook() {
-    if (!isKeyboardHookEnabled && !keyboardHook) {
-        keyboardHook = SetWindowsHookEx(WH_KEYBOARD_LL, KeyboardProc, GetModuleHandle(nullptr), 0);
-        if (keyboardHook) {
+    if (!isKeyboardHookEnabled) {
+        // Start from the current lock states; the hook events keep them up to date
+        lockKeysToggled = ReadOsLockKeyStates();
+        lockKeysDown = 0;
+        lockKeysMismatched = 0;
+
+        KeyboardHookSubscriber subscriber;
+        subscriber.wantsKey = IsLockKey;
+        subscriber.handler = OnLockKeyHookEvent; // Key up events too (auto-repeat filter)
+        SubscribeKeyboardHook(KeyboardHookClient::LockKeys, subscriber);
+        SetKeyboardHookSubscriberEnabled(KeyboardHookClient::LockKeys, true);
+        if (IsKeyboardHookInstalled()) {
             isKeyboardHookEnabled = true;
 #ifdef ENABLE_DEBUG_LOGGING
             OutputDebugStringW(L"[DEBUG] Keyboard hook enabled\n");
 #endif
-        }
+        } else {
+            SetKeyboardHookSubscriberEnabled(KeyboardHookClient::LockKeys, false);
 #ifdef ENABLE_DEBUG_LOGGING
-        else {
             OutputDebugStringW(L"[DEBUG] Failed to enable keyboard hook\n");
-        }
 #endif
+        }
     }
 }
 
-// Disable the keyboard hook
+// Disable the lock key tracker (the hook itself stays while other subscribers need it)
 void DisableKeyboardHook() {
-    if (isKeyboardHookEnabled && keyboardHook) {
-        if (UnhookWindowsHookEx(keyboardHook)) {
-            keyboardHook = nullptr;
-            isKeyboardHookEnabled = false;
-#ifdef ENABLE_DEBUG_LOGGING
-            OutputDebugStringW(L"[DEBUG] Keyboard hook disabled\n");
-#endif
-        }
+    if (isKeyboardHookEnabled) {
+        SetKeyboardHookSubscriberEnabled(KeyboardHookClient::LockKeys, false);
+        isKeyboardHookEnabled = false;
 #ifdef ENABLE_DEBUG_LOGGING
-        else {
-            OutputDebugStringW(L"[DEBUG] Failed to disable keyboard hook\n");
-        }
+        OutputDebugStringW(L"[DEBUG] Keyboard hook disabled\n");
 #endif
-
     }
 }
 
@@ -293,7 +353,7 @@ void UpdateKeyboardHookStateUnsafe() {
 
 // Check if lock keys feature should be enabled based on current displayed profile
 bool IsLockKeysFeatureEnabled() {
-    AppColorProfile* displayedProfile = GetDisplayedProfile();
+    std::shared_ptr<const AppColorProfile> displayedProfile = GetDisplayedProfile();
     if (displayedProfile) {
         return displayedProfile->lockKeysEnabled;
     }
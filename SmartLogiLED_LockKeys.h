@@ -9,11 +9,15 @@
 
 // Lock key color management functions
 void SetLockKeysColor(void);
-void SetLockKeysColorWithProfile(AppColorProfile* displayedProfile); // Unsafe version for mutex-locked contexts
-void HandleLockKeyPressed(DWORD vkCode, DWORD vkState);
+void SetLockKeysColorWithProfile(const AppColorProfile* displayedProfile); // Unsafe version for mutex-locked contexts
+void HandleLockKeyPressed(DWORD vkCode);
+
+// Lock key states (LOCK_KEY_STATE_* bits, readable from any thread without system calls)
+DWORD GetLockKeyStates();
+void ReconcileLockKeyStates(); // Main window timer: correct states the hook events missed
+ULONGLONG GetLockKeyStateCorrections();
 
 // Keyboard hook management functions
-LRESULT CALLBACK KeyboardProc(int nCode, WPARAM wParam, LPARAM lParam);
 void UpdateKeyboardHookState();
 void UpdateKeyboardHookStateUnsafe();
 void EnableKeyboardHook();
@@ -28,9 +32,10 @@ bool IsLockKeysFeatureEnabledUnsafe();
 void SetKeyColor(LogiLed::KeyName key, COLORREF color);
 void SetDefaultColor(COLORREF color);
 void SetHighlightKeysColor();
-void SetHighlightKeysColorWithProfile(AppColorProfile* displayedProfile); // Unsafe version for mutex-locked contexts
+void SetHighlightKeysColorWithProfile(const AppColorProfile* displayedProfile); // Unsafe version for mutex-locked contexts
 void SetActionKeysColor();
-void SetActionKeysColorWithProfile(AppColorProfile* displayedProfile);
+void SetActionKeysColorWithProfile(const AppColorProfile* displayedProfile);
+COLORREF GetProfileKeyColor(const AppColorProfile* displayedProfile, LogiLed::KeyName key); // Color of one key after a full apply
 
 // Main window handle management
 void SetMainWindowHandle(HWND hWnd);void SetMainWindowHandle(HWND hWnd);
\ No newline at end of file
@@ -0,0 +1,351 @@
+// SmartLogiLED_ModifierLayer.cpp : Contains the modifier layer (modifier key tracking, layer painting, latency).
+//
+// Modifier key events reach the hook worker through the keyboard hook ring. The worker keeps one
+// bit per modifier key (left and right Shift, Ctrl, Alt) and, when a modifier the displayed
+// profile's layer uses goes down or up, posts one WM_MODIFIER_LAYER_CHANGED; changes made before
+// the window handles it are picked up by the same message. The handler reads the current bits and
+// sends only the keys that enter or leave the layer to the SDK - the profile is not re-applied -
+// and records the time from the hook call of the first change to the last SDK call.
+
+#include "framework.h"
+#include "SmartLogiLED_ModifierLayer.h"
+#include "SmartLogiLED_LockKeys.h"
+#include "SmartLogiLED_AppProfiles.h"
+#include "SmartLogiLED_KeyboardHook.h"
+#include "SmartLogiLED_Heatmap.h"
+#include "SmartLogiLED_LatencyTrace.h"
+#include "SmartLogiLED_Constants.h"
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <vector>
+
+// Latency histogram: bucket n counts updates below 2^n microseconds (last bucket: everything above)
+static const int MODIFIER_LATENCY_BUCKETS = 24;
+
+static const DWORD modifierLayerModifiers[] = { MODIFIER_LAYER_SHIFT, MODIFIER_LAYER_CTRL, MODIFIER_LAYER_ALT };
+
+// Module-specific variables
+static HWND modifierLayerWindow = nullptr;
+static bool modifierLayerSubscribed = false;                    // Hook subscriber enabled (UI thread)
+static std::atomic<DWORD> modifierKeysDown{ 0 };                // Modifier key bits (hook worker, corrected by the UI thread)
+static std::atomic<DWORD> modifierLayerKeyMask{ 0 };            // Modifier key bits the displayed layer uses
+static std::atomic<bool> modifierLayerUpdatePending{ false };   // A WM_MODIFIER_LAYER_CHANGED is on its way
+static std::atomic<ULONGLONG> modifierChangeMicros{ 0 };        // Hook time of the first change the pending message covers
+static DWORD modifierKeysMismatched = 0;                        // Keys that disagreed with the OS on the last check (UI thread)
+static bool modifierReconcileTimerRunning = false;
+static std::vector<LogiLed::KeyName> modifierLayerPainted;      // Keys showing the layer color, sorted (UI thread)
+static std::vector<LogiLed::KeyName> modifierLayerNextKeys;     // Reused for the next layer
+
+// Statistics (UI thread)
+static ULONGLONG modifierLatencyBuckets[MODIFIER_LATENCY_BUCKETS];
+static ULONGLONG modifierLayerUpdates = 0;
+static ULONGLONG modifierUpdatesWithinBudget = 0;
+static ULONGLONG modifierLatencyMaxMicros = 0;
+static ULONGLONG modifierQueueMicros = 0;                       // Hook call -> window handler
+static ULONGLONG modifierQueueMaxMicros = 0;
+static ULONGLONG modifierPushMicros = 0;                        // SDK calls of the update
+static ULONGLONG modifierPushMaxMicros = 0;
+static ULONGLONG modifierKeysPushed = 0;
+static ULONGLONG modifierKeyCorrections = 0;
+
+// ======================================================================
+// MODIFIER KEYS
+// ======================================================================
+
+// Modifier key bits: the left and right key of a modifier sit at the modifier's MODIFIER_LAYER_* position
+static DWORD GetModifierKeyBit(DWORD vkCode) {
+    switch (vkCode) {
+        case VK_SHIFT:
+        case VK_LSHIFT:   return 0x1 << MODIFIER_LAYER_SHIFT;
+        case VK_RSHIFT:   return 0x2 << MODIFIER_LAYER_SHIFT;
+        case VK_CONTROL:
+        case VK_LCONTROL: return 0x1 << MODIFIER_LAYER_CTRL;
+        case VK_RCONTROL: return 0x2 << MODIFIER_LAYER_CTRL;
+        case VK_MENU:
+        case VK_LMENU:    return 0x1 << MODIFIER_LAYER_ALT;
+        case VK_RMENU:    return 0x2 << MODIFIER_LAYER_ALT;
+        default:          return 0;
+    }
+}
+
+// Both key bits of every modifier that has at least one of its keys down
+static DWORD GetHeldModifierKeys(DWORD keysDown) {
+    DWORD held = 0;
+    for (DWORD modifier : modifierLayerModifiers) {
+        if ((keysDown >> modifier) & 0x3) {
+            held |= 0x3 << modifier;
+        }
+    }
+    return held;
+}
+
+// Modifier keys the input source sees down (UI thread)
+static DWORD ReadOsModifierKeys() {
+    DWORD keysDown = 0;
+    for (DWORD vkCode : { VK_LSHIFT, VK_RSHIFT, VK_LCONTROL, VK_RCONTROL, VK_LMENU, VK_RMENU }) {
+        if (GetInputEventSource().IsKeyDown(vkCode)) {
+            keysDown |= GetModifierKeyBit(vkCode);
+        }
+    }
+    return keysDown;
+}
+
+// Hook subscriber filter: the modifier layer only receives modifier keys
+static bool IsModifierKey(DWORD vkCode) {
+    return GetModifierKeyBit(vkCode) != 0;
+}
+
+// Tell the main window once; a message already on its way reads the newest key bits
+static void RequestModifierLayerUpdate(ULONGLONG changeMicros) {
+    if (modifierLayerUpdatePending.load()) {
+        return;
+    }
+    modifierChangeMicros.store(changeMicros);
+    modifierLayerUpdatePending.store(true);
+    if (!modifierLayerWindow || !PostMessage(modifierLayerWindow, WM_MODIFIER_LAYER_CHANGED, 0, 0)) {
+        modifierLayerUpdatePending.store(false);
+    }
+}
+
+// Track a modifier key and post a layer update when a layer modifier changed (hook worker thread)
+static void OnModifierKeyHookEvent(const KeyboardHookEvent& event) {
+    DWORD bit = GetModifierKeyBit(event.vkCode);
+    DWORD before = event.keyDown ? modifierKeysDown.fetch_or(bit) : modifierKeysDown.fetch_and(~bit);
+    DWORD after = event.keyDown ? (before | bit) : (before & ~bit);
+    if (((GetHeldModifierKeys(before) ^ GetHeldModifierKeys(after)) & modifierLayerKeyMask.load()) == 0) {
+        return; // Auto-repeat, the other key of a held modifier, or a modifier the layer does not use
+    }
+    RequestModifierLayerUpdate(event.timeMicros);
+}
+
+// ======================================================================
+// LAYER PAINTING
+// ======================================================================
+
+// Send the keys that enter or leave the layer to the SDK; returns the number of keys sent (UI thread)
+static size_t PaintModifierLayer(const AppColorProfile* displayedProfile) {
+    if (IsHeatmapModeEnabled()) {
+        modifierLayerPainted.clear(); // The heatmap owns the keyboard colors
+        return 0;
+    }
+
+    DWORD held = GetHeldModifierKeys(modifierKeysDown.load());
+    DWORD layer = displayedProfile ? displayedProfile->modifierLayer : 0;
+    DWORD groups = 0;
+    for (DWORD modifier : modifierLayerModifiers) {
+        if (held & (0x3 << modifier)) {
+            groups |= MODIFIER_LAYER_GROUPS(layer, modifier);
+        }
+    }
+
+    std::vector<LogiLed::KeyName>& layerKeys = modifierLayerNextKeys;
+    layerKeys.clear();
+    if (groups & MODIFIER_LAYER_HIGHLIGHT_KEYS) {
+        layerKeys.insert(layerKeys.end(), displayedProfile->highlightKeys.begin(), displayedProfile->highlightKeys.end());
+    }
+    if (groups & MODIFIER_LAYER_ACTION_KEYS) {
+        layerKeys.insert(layerKeys.end(), displayedProfile->actionKeys.begin(), displayedProfile->actionKeys.end());
+    }
+    std::sort(layerKeys.begin(), layerKeys.end());
+    layerKeys.erase(std::unique(layerKeys.begin(), layerKeys.end()), layerKeys.end());
+
+    // Keys leaving the layer get the color a full apply gives them
+    size_t pushed = 0;
+    for (LogiLed::KeyName key : modifierLayerPainted) {
+        if (!std::binary_search(layerKeys.begin(), layerKeys.end(), key)) {
+            SetKeyColor(key, GetProfileKeyColor(displayedProfile, key));
+            ++pushed;
+        }
+    }
+    for (LogiLed::KeyName key : layerKeys) {
+        if (!std::binary_search(modifierLayerPainted.begin(), modifierLayerPainted.end(), key)) {
+            SetKeyColor(key, displayedProfile->appModifierColor);
+            ++pushed;
+        }
+    }
+    modifierLayerPainted.swap(layerKeys);
+    return pushed;
+}
+
+// Check held modifiers against the OS only while one is held (UI thread)
+static void UpdateModifierReconcileTimer() {
+    bool needed = modifierLayerSubscribed && modifierKeysDown.load() != 0;
+    if (needed == modifierReconcileTimerRunning) {
+        return;
+    }
+    if (needed) {
+        SetTimer(modifierLayerWindow, MODIFIER_LAYER_RECONCILE_TIMER_ID, MODIFIER_LAYER_RECONCILE_INTERVAL_MS, nullptr);
+    } else {
+        KillTimer(modifierLayerWindow, MODIFIER_LAYER_RECONCILE_TIMER_ID);
+        modifierKeysMismatched = 0;
+    }
+    modifierReconcileTimerRunning = needed;
+}
+
+static void RecordModifierLayerLatency(ULONGLONG changeMicros, ULONGLONG startMicros, ULONGLONG endMicros, size_t keysPushed) {
+    ULONGLONG queueMicros = startMicros > changeMicros ? startMicros - changeMicros : 0;
+    ULONGLONG pushMicros = endMicros - startMicros;
+    ULONGLONG totalMicros = queueMicros + pushMicros;
+
+    int bucket = 0;
+    for (ULONGLONG value = totalMicros; value > 0 && bucket < MODIFIER_LATENCY_BUCKETS - 1; value >>= 1) {
+        ++bucket;
+    }
+    ++modifierLatencyBuckets[bucket];
+    ++modifierLayerUpdates;
+    if (totalMicros < MODIFIER_LAYER_LATENCY_BUDGET_MS * 1000ULL) {
+        ++modifierUpdatesWithinBudget;
+    }
+    modifierLatencyMaxMicros = (std::max)(modifierLatencyMaxMicros, totalMicros);
+    modifierQueueMicros += queueMicros;
+    modifierQueueMaxMicros = (std::max)(modifierQueueMaxMicros, queueMicros);
+    modifierPushMicros += pushMicros;
+    modifierPushMaxMicros = (std::max)(modifierPushMaxMicros, pushMicros);
+    modifierKeysPushed += keysPushed;
+}
+
+// ======================================================================
+// LAYER
+// ======================================================================
+
+void InitializeModifierLayer(HWND hWnd) {
+    modifierLayerWindow = hWnd;
+}
+
+void UpdateModifierLayerForProfile(const AppColorProfile* displayedProfile) {
+    DWORD layer = displayedProfile ? displayedProfile->modifierLayer : 0;
+    if (IsHeatmapModeEnabled() || !modifierLayerWindow) {
+        layer = 0; // The heatmap owns the keyboard colors
+    }
+
+    // The full apply that called us painted every key with its profile color
+    modifierLayerPainted.clear();
+    DWORD keyMask = 0;
+    for (DWORD modifier : modifierLayerModifiers) {
+        if (MODIFIER_LAYER_GROUPS(layer, modifier) != 0) {
+            keyMask |= 0x3 << modifier;
+        }
+    }
+    modifierLayerKeyMask.store(keyMask);
+
+    if (layer != 0 && !modifierLayerSubscribed) {
+        // Start from the keys held right now; the hook events keep the bits up to date
+        modifierKeysDown = ReadOsModifierKeys();
+        modifierKeysMismatched = 0;
+
+        KeyboardHookSubscriber subscriber;
+        subscriber.wantsKey = IsModifierKey;
+        subscriber.handler = OnModifierKeyHookEvent; // Key up events too (the layer goes on release)
+        SubscribeKeyboardHook(KeyboardHookClient::ModifierLayer, subscriber);
+        SetKeyboardHookSubscriberEnabled(KeyboardHookClient::ModifierLayer, true);
+        modifierLayerSubscribed = true;
+    } else if (layer == 0 && modifierLayerSubscribed) {
+        SetKeyboardHookSubscriberEnabled(KeyboardHookClient::ModifierLayer, false);
+        modifierLayerSubscribed = false;
+    }
+
+    if (layer != 0) {
+        PaintModifierLayer(displayedProfile); // A modifier may be held through the profile switch
+    }
+    UpdateModifierReconcileTimer();
+
+#ifdef ENABLE_DEBUG_LOGGING
+    std::wstringstream debugMsg;
+    debugMsg << L"[DEBUG] Modifier layer changed to 0x" << std::hex << layer << L"\n";
+    OutputDebugStringW(debugMsg.str().c_str());
+#endif
+}
+
+void OnModifierLayerChanged() {
+    ULONGLONG changeMicros = modifierChangeMicros.load();
+    modifierLayerUpdatePending.store(false); // Changes from here on post a new message
+    if (!modifierLayerSubscribed) {
+        return;
+    }
+
+    ULONGLONG startMicros = ReadTraceClock();
+    size_t keysPushed = PaintModifierLayer(GetDisplayedProfile().get());
+    if (keysPushed > 0) {
+        RecordModifierLayerLatency(changeMicros, startMicros, ReadTraceClock(), keysPushed);
+    }
+    UpdateModifierReconcileTimer();
+}
+
+// Correct modifier keys the hook events got wrong (UI thread, MODIFIER_LAYER_RECONCILE_TIMER_ID)
+//
+// Key ups can be missed when the secure desktop takes the input (Ctrl+Alt+Del, UAC prompts) or the
+// hook is removed by a timeout. A key that disagrees with the OS on two checks in a row is
+// corrected and the layer repainted; a single disagreement is usually a hook event still in flight.
+void ReconcileModifierKeys() {
+    if (!modifierLayerSubscribed) {
+        UpdateModifierReconcileTimer();
+        return;
+    }
+
+    DWORD tracked = modifierKeysDown.load();
+    DWORD mismatched = tracked ^ ReadOsModifierKeys();
+    DWORD confirmed = mismatched & modifierKeysMismatched;
+    modifierKeysMismatched = mismatched & ~confirmed;
+    if (confirmed != 0 && modifierKeysDown.compare_exchange_strong(tracked, tracked ^ confirmed)) {
+        for (DWORD bits = confirmed; bits != 0; bits &= bits - 1) {
+            ++modifierKeyCorrections;
+        }
+        PaintModifierLayer(GetDisplayedProfile().get());
+#ifdef ENABLE_DEBUG_LOGGING
+        std::wstringstream debugMsg;
+        debugMsg << L"[DEBUG] Modifier keys corrected from the OS: 0x" << std::hex << confirmed << L"\n";
+        OutputDebugStringW(debugMsg.str().c_str());
+#endif
+    }
+    UpdateModifierReconcileTimer();
+}
+
+void ShutdownModifierLayer() {
+    if (modifierLayerSubscribed) {
+        SetKeyboardHookSubscriberEnabled(KeyboardHookClient::ModifierLayer, false);
+        modifierLayerSubscribed = false;
+    }
+    UpdateModifierReconcileTimer();
+    modifierLayerPainted.clear();
+}
+
+COLORREF GetLayeredKeyColor(const AppColorProfile* displayedProfile, LogiLed::KeyName key) {
+    if (displayedProfile && std::binary_search(modifierLayerPainted.begin(), modifierLayerPainted.end(), key)) {
+        return displayedProfile->appModifierColor;
+    }
+    return GetProfileKeyColor(displayedProfile, key);
+}
+
+// ======================================================================
+// REPORTING
+// ======================================================================
+
+// Upper bound of the bucket holding the given percentile (capped at the observed maximum)
+static ULONGLONG GetModifierLatencyPercentile(int percentile) {
+    ULONGLONG rank = (modifierLayerUpdates * percentile + 99) / 100;
+    ULONGLONG seen = 0;
+    for (int bucket = 0; bucket < MODIFIER_LATENCY_BUCKETS; ++bucket) {
+        seen += modifierLatencyBuckets[bucket];
+        if (seen >= rank) {
+            ULONGLONG upperBound = (bucket == 0) ? 1 : (1ULL << bucket);
+            return (std::min)(upperBound, modifierLatencyMaxMicros);
+        }
+    }
+    return modifierLatencyMaxMicros;
+}
+
+std::wstring FormatModifierLayerStatistics() {
+    std::wstringstream report;
+    report << L"Modifier layer: " << modifierLayerUpdates << L" updates";
+    if (modifierLayerUpdates > 0) {
+        report << L", hook to LED p50 " << GetModifierLatencyPercentile(50) << L" us, p99 " << GetModifierLatencyPercentile(99)
+               << L" us, max " << modifierLatencyMaxMicros << L" us; "
+               << modifierUpdatesWithinBudget << L" of " << modifierLayerUpdates << L" within " << MODIFIER_LAYER_LATENCY_BUDGET_MS << L" ms"
+               << L"\nQueue avg " << modifierQueueMicros / modifierLayerUpdates << L" us, max " << modifierQueueMaxMicros
+               << L" us; LED push avg " << modifierPushMicros / modifierLayerUpdates << L" us, max " << modifierPushMaxMicros
+               << L" us; " << modifierKeysPushed << L" key colors sent";
+    }
+    report << L"\n" << modifierKeyCorrections << L" modifier key states corrected from the OS";
+    return report.str();
+}
@@ -0,0 +1,26 @@
+// SmartLogiLED_ModifierLayer.h : Header file for the modifier layer.
+//
+// While Shift, Ctrl or Alt is held, the key groups the displayed profile assigns to that modifier
+// light up in the profile's modifier color and go back to their profile colors on release. The
+// hook worker posts the change straight to the main window, which only repaints the keys that
+// enter or leave the layer; the time from the hook to the last LED call is measured.
+
+#pragma once
+
+#include "framework.h"
+#include "SmartLogiLED_Types.h"
+#include "LogitechLEDLib.h"
+#include <string>
+
+// Layer (UI thread)
+void InitializeModifierLayer(HWND hWnd);                        // Window that receives WM_MODIFIER_LAYER_CHANGED
+void UpdateModifierLayerForProfile(const AppColorProfile* displayedProfile); // After every full apply of the displayed frame
+void OnModifierLayerChanged();                                  // WM_MODIFIER_LAYER_CHANGED
+void ReconcileModifierKeys();                                   // MODIFIER_LAYER_RECONCILE_TIMER_ID
+void ShutdownModifierLayer();
+
+// Color of one key with the modifier layer (effects blend over it instead of the profile color)
+COLORREF GetLayeredKeyColor(const AppColorProfile* displayedProfile, LogiLed::KeyName key);
+
+// Layer updates and hook-to-LED latency (p50, p99, max, share within MODIFIER_LAYER_LATENCY_BUDGET_MS)
+std::wstring FormatModifierLayerStatistics();
@@ -0,0 +1,165 @@
+// SmartLogiLED_PersistenceWorker.cpp : Contains the write-behind profile persistence worker.
+//
+// Profile edits change the in-memory profile store and are appended to its edit journal.
+// Once no edit arrived for PROFILE_WRITE_DEBOUNCE_MS (at the latest PROFILE_WRITE_MAX_DELAY_MS
+// after the first pending edit) the worker flushes the journal to disk and, when the journal
+// is due, compacts it into the store file, so the UI thread never waits on the disk.
+// Activation history changes ride along: the profile engine marks the history dirty once
+// per event batch and the snapshot is written with the next flush instead of every batch.
+
+#include "framework.h"
+#include "SmartLogiLED_PersistenceWorker.h"
+#include "SmartLogiLED_ProfileStore.h"
+#include "SmartLogiLED_Config.h"
+#include "SmartLogiLED_Constants.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <sstream>
+
+using PersistenceClock = std::chrono::steady_clock;
+
+// Module-specific variables
+static std::mutex persistenceMutex;
+static std::condition_variable persistenceWake;
+static std::thread persistenceThread;
+static bool persistenceRunning = false;
+static bool persistenceStopRequested = false;
+static bool writePending = false;
+static bool historyWritePending = false;
+static PersistenceClock::time_point firstPendingEdit;
+static PersistenceClock::time_point lastPendingEdit;
+
+// Mark a write as pending and wake the worker (INTERNAL - ASSUMES MUTEX LOCKED)
+static void MarkWritePendingInternal(bool& pendingFlag) {
+    auto now = PersistenceClock::now();
+    if (!writePending && !historyWritePending) {
+        firstPendingEdit = now;
+    }
+    pendingFlag = true;
+    lastPendingEdit = now;
+    persistenceWake.notify_all();
+}
+
+// Point in time at which the pending edits are written (INTERNAL - ASSUMES MUTEX LOCKED)
+static PersistenceClock::time_point GetWriteDeadlineInternal() {
+    auto quietDeadline = lastPendingEdit + std::chrono::milliseconds(PROFILE_WRITE_DEBOUNCE_MS);
+    auto maxDeadline = firstPendingEdit + std::chrono::milliseconds(PROFILE_WRITE_MAX_DELAY_MS);
+    return (quietDeadline < maxDeadline) ? quietDeadline : maxDeadline;
+}
+
+// Make pending edits durable: sync the journal, or compact it into the store file (called without the persistence lock)
+static bool WriteProfileStore(bool compact) {
+#ifdef ENABLE_DEBUG_LOGGING
+    ULONGLONG writeStart = GetTickCount64();
+#endif
+    bool written = compact ? CommitProfileStore() : SyncProfileStore();
+#ifdef ENABLE_DEBUG_LOGGING
+    std::wstringstream debugMsg;
+    debugMsg << L"[DEBUG] Profile store " << (compact ? L"commit" : L"sync") << (written ? L" done" : L" FAILED") << L" in "
+             << (GetTickCount64() - writeStart) << L" ms\n";
+    OutputDebugStringW(debugMsg.str().c_str());
+#endif
+    return written;
+}
+
+// Persistence worker thread function
+static void PersistenceWorkerThreadProc() {
+    std::unique_lock<std::mutex> lock(persistenceMutex);
+    while (!persistenceStopRequested) {
+        if (!writePending && !historyWritePending) {
+            persistenceWake.wait(lock);
+            continue;
+        }
+        if (persistenceWake.wait_until(lock, GetWriteDeadlineInternal()) == std::cv_status::no_timeout) {
+            continue; // New edit or stop request - recompute the deadline
+        }
+        if ((!writePending && !historyWritePending) || PersistenceClock::now() < GetWriteDeadlineInternal()) {
+            continue;
+        }
+
+        bool storeDue = writePending;
+        bool historyDue = historyWritePending;
+        writePending = false;
+        historyWritePending = false;
+        lock.unlock();
+        bool written = !storeDue || WriteProfileStore(false);
+        if (historyDue) {
+            SaveActivationHistoryToConfig(); // No-op if the history did not change
+        }
+        lock.lock();
+
+        if (!written && !writePending) {
+            // Retry after another quiet period
+            writePending = true;
+            firstPendingEdit = lastPendingEdit = PersistenceClock::now();
+        }
+    }
+}
+
+// ======================================================================
+// PUBLIC API
+// ======================================================================
+
+void StartPersistenceWorker() {
+    std::lock_guard<std::mutex> lock(persistenceMutex);
+    if (persistenceRunning) {
+        return;
+    }
+    persistenceStopRequested = false;
+    persistenceThread = std::thread(PersistenceWorkerThreadProc);
+    persistenceRunning = true;
+}
+
+void StopPersistenceWorker() {
+    {
+        std::lock_guard<std::mutex> lock(persistenceMutex);
+        if (!persistenceRunning) {
+            return;
+        }
+        persistenceRunning = false; // Writes are synchronous from now on
+        persistenceStopRequested = true;
+    }
+    persistenceWake.notify_all();
+    if (persistenceThread.joinable()) {
+        persistenceThread.join();
+    }
+    FlushPendingProfileWrites();
+
+    {
+        std::lock_guard<std::mutex> lock(persistenceMutex);
+        historyWritePending = false;
+    }
+    SaveActivationHistoryToConfig();
+}
+
+void SchedulePendingProfileWrite() {
+    {
+        std::lock_guard<std::mutex> lock(persistenceMutex);
+        if (persistenceRunning) {
+            MarkWritePendingInternal(writePending);
+            return;
+        }
+    }
+    WriteProfileStore(false);
+}
+
+void ScheduleActivationHistoryWrite() {
+    {
+        std::lock_guard<std::mutex> lock(persistenceMutex);
+        if (persistenceRunning) {
+            MarkWritePendingInternal(historyWritePending);
+            return;
+        }
+    }
+    SaveActivationHistoryToConfig();
+}
+
+bool FlushPendingProfileWrites() {
+    {
+        std::lock_guard<std::mutex> lock(persistenceMutex);
+        writePending = false;
+    }
+    return WriteProfileStore(true); // Folds the journal into the store file; no-op if nothing changed
+}
@@ -0,0 +1,17 @@
+// SmartLogiLED_PersistenceWorker.h : Header file for the write-behind profile persistence worker.
+//
+
+#pragma once
+
+// Worker lifetime (stopping flushes pending writes, including the activation history; without a running worker writes happen immediately)
+void StartPersistenceWorker();
+void StopPersistenceWorker();
+
+// Called after the profile store changed in memory - the journal is synced once edits go quiet
+void SchedulePendingProfileWrite();
+
+// Called after the activation history changed - the snapshot is saved on the same schedule as profile edits
+void ScheduleActivationHistoryWrite();
+
+// Fold the journal into the store file now and wait for the write; false if the write failed
+bool FlushPendingProfileWrites();
@@ -0,0 +1,458 @@
+// SmartLogiLED_Platform.cpp : Contains the portable primitives of the storage layer and the hook multiplexer.
+//
+
+#include "SmartLogiLED_Platform.h"
+
+#ifdef _WIN32
+
+#include "framework.h"
+
+// ======================================================================
+// WIN32 IMPLEMENTATION
+// ======================================================================
+
+bool MapFileReadOnly(const std::wstring& filePath, MappedFile& file) {
+    file = MappedFile();
+
+    HANDLE hFile = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    HANDLE hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!hMapping) {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    const void* view = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(hMapping);
+        CloseHandle(hFile);
+        return false;
+    }
+
+    file.data = static_cast<const uint8_t*>(view);
+    file.size = static_cast<size_t>(fileSize.QuadPart);
+    file.fileHandle = hFile;
+    file.mappingHandle = hMapping;
+    return true;
+}
+
+void UnmapFile(MappedFile& file) {
+    if (file.data) {
+        UnmapViewOfFile(file.data);
+    }
+    if (file.mappingHandle) {
+        CloseHandle(static_cast<HANDLE>(file.mappingHandle));
+    }
+    if (file.fileHandle) {
+        CloseHandle(static_cast<HANDLE>(file.fileHandle));
+    }
+    file = MappedFile();
+}
+
+bool WriteFileAtomically(const std::wstring& filePath, const void* data, size_t size) {
+    std::wstring tempPath = filePath + L".tmp";
+    HANDLE hFile = CreateFileW(tempPath.c_str(), GENERIC_WRITE, 0, nullptr,
+                               CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    bool written = true;
+    while (written && size > 0) {
+        DWORD chunk = static_cast<DWORD>(size > 0x40000000 ? 0x40000000 : size);
+        DWORD bytesWritten = 0;
+        written = WriteFile(hFile, bytes, chunk, &bytesWritten, nullptr) && bytesWritten == chunk;
+        bytes += chunk;
+        size -= chunk;
+    }
+    written = written && FlushFileBuffers(hFile);
+    CloseHandle(hFile);
+
+    if (!written || !MoveFileExW(tempPath.c_str(), filePath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        DeleteFileW(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool OpenAppendOnlyFile(const std::wstring& filePath, AppendOnlyFile& file) {
+    file = AppendOnlyFile();
+
+    HANDLE hFile = CreateFileW(filePath.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                               OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(hFile, &fileSize) || !SetFilePointerEx(hFile, fileSize, nullptr, FILE_BEGIN)) {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    file.handle = hFile;
+    file.size = static_cast<uint64_t>(fileSize.QuadPart);
+    return true;
+}
+
+bool AppendToFile(AppendOnlyFile& file, const void* data, size_t size) {
+    if (!file.handle) {
+        return false;
+    }
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        DWORD chunk = static_cast<DWORD>(size > 0x40000000 ? 0x40000000 : size);
+        DWORD bytesWritten = 0;
+        if (!WriteFile(static_cast<HANDLE>(file.handle), bytes, chunk, &bytesWritten, nullptr) || bytesWritten == 0) {
+            return false;
+        }
+        bytes += bytesWritten;
+        size -= bytesWritten;
+        file.size += bytesWritten;
+    }
+    return true;
+}
+
+bool FlushAppendOnlyFile(AppendOnlyFile& file) {
+    return file.handle && FlushFileBuffers(static_cast<HANDLE>(file.handle));
+}
+
+void CloseAppendOnlyFile(AppendOnlyFile& file) {
+    if (file.handle) {
+        CloseHandle(static_cast<HANDLE>(file.handle));
+    }
+    file = AppendOnlyFile();
+}
+
+bool FileExists(const std::wstring& filePath) {
+    DWORD attributes = GetFileAttributesW(filePath.c_str());
+    return attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+bool CreateDirectoryIfMissing(const std::wstring& directoryPath) {
+    return CreateDirectoryW(directoryPath.c_str(), nullptr) || GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
+std::wstring GetApplicationDirectory() {
+    wchar_t exePath[MAX_PATH];
+    DWORD pathLen = GetModuleFileNameW(nullptr, exePath, MAX_PATH);
+    if (pathLen == 0 || pathLen == MAX_PATH) {
+        return L""; // Failed to get path
+    }
+
+    std::wstring appDir(exePath, pathLen);
+    size_t lastSlash = appDir.find_last_of(L'\\');
+    if (lastSlash != std::wstring::npos) {
+        appDir = appDir.substr(0, lastSlash);
+    }
+    return appDir;
+}
+
+uint64_t ReadMonotonicNanos() {
+    static const LONGLONG frequency = [] {
+        LARGE_INTEGER f;
+        QueryPerformanceFrequency(&f);
+        return f.QuadPart;
+    }();
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return static_cast<uint64_t>((now.QuadPart / frequency) * 1000000000 + (now.QuadPart % frequency) * 1000000000 / frequency);
+}
+
+uint32_t ReadTickCountMs() {
+    return GetTickCount();
+}
+
+bool CreateWakeEvent(WakeEvent& event) {
+    event.handle = CreateEventW(NULL, FALSE, FALSE, NULL);
+    return event.handle != nullptr;
+}
+
+void SignalWakeEvent(WakeEvent& event) {
+    SetEvent(event.handle);
+}
+
+void WaitWakeEvent(WakeEvent& event) {
+    WaitForSingleObject(event.handle, INFINITE);
+}
+
+void CloseWakeEvent(WakeEvent& event) {
+    if (event.handle) {
+        CloseHandle(event.handle);
+    }
+    event = WakeEvent();
+}
+
+void WriteDebugLog(const std::wstring& message) {
+    OutputDebugStringW(message.c_str());
+}
+
+#else
+
+#include <cerrno>
+#include <condition_variable>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cwchar>
+
+// ======================================================================
+// POSIX IMPLEMENTATION
+// ======================================================================
+
+// Paths are passed around as wide strings (like on Windows) and converted to UTF-8 here
+static std::string ToNativePath(const std::wstring& path) {
+    std::string native;
+    native.reserve(path.size());
+    for (wchar_t wch : path) {
+        uint32_t cp = static_cast<uint32_t>(wch);
+        if (cp < 0x80) {
+            native.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            native.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            native.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            native.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            native.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            native.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            native.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            native.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            native.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            native.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+    return native;
+}
+
+bool MapFileReadOnly(const std::wstring& filePath, MappedFile& file) {
+    file = MappedFile();
+
+    int fd = open(ToNativePath(filePath).c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0 || fileInfo.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(fileInfo.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping stays valid without the descriptor
+    if (view == MAP_FAILED) {
+        return false;
+    }
+
+    file.data = static_cast<const uint8_t*>(view);
+    file.size = static_cast<size_t>(fileInfo.st_size);
+    return true;
+}
+
+void UnmapFile(MappedFile& file) {
+    if (file.data) {
+        munmap(const_cast<uint8_t*>(file.data), file.size);
+    }
+    file = MappedFile();
+}
+
+bool WriteFileAtomically(const std::wstring& filePath, const void* data, size_t size) {
+    std::string nativePath = ToNativePath(filePath);
+    std::string tempPath = nativePath + ".tmp";
+    int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    bool written = true;
+    while (written && size > 0) {
+        ssize_t bytesWritten = write(fd, bytes, size);
+        if (bytesWritten < 0 && errno == EINTR) {
+            continue;
+        }
+        written = bytesWritten > 0;
+        if (written) {
+            bytes += bytesWritten;
+            size -= static_cast<size_t>(bytesWritten);
+        }
+    }
+    written = written && fsync(fd) == 0;
+    close(fd);
+
+    if (!written || rename(tempPath.c_str(), nativePath.c_str()) != 0) {
+        unlink(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool OpenAppendOnlyFile(const std::wstring& filePath, AppendOnlyFile& file) {
+    file = AppendOnlyFile();
+
+    int fd = open(ToNativePath(filePath).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0) {
+        close(fd);
+        return false;
+    }
+
+    file.descriptor = fd;
+    file.size = static_cast<uint64_t>(fileInfo.st_size);
+    return true;
+}
+
+bool AppendToFile(AppendOnlyFile& file, const void* data, size_t size) {
+    if (file.descriptor < 0) {
+        return false;
+    }
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        ssize_t bytesWritten = write(file.descriptor, bytes, size);
+        if (bytesWritten < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytesWritten <= 0) {
+            return false;
+        }
+        bytes += bytesWritten;
+        size -= static_cast<size_t>(bytesWritten);
+        file.size += static_cast<uint64_t>(bytesWritten);
+    }
+    return true;
+}
+
+bool FlushAppendOnlyFile(AppendOnlyFile& file) {
+    return file.descriptor >= 0 && fsync(file.descriptor) == 0;
+}
+
+void CloseAppendOnlyFile(AppendOnlyFile& file) {
+    if (file.descriptor >= 0) {
+        close(file.descriptor);
+    }
+    file = AppendOnlyFile();
+}
+
+bool FileExists(const std::wstring& filePath) {
+    struct stat fileInfo;
+    return stat(ToNativePath(filePath).c_str(), &fileInfo) == 0 && S_ISREG(fileInfo.st_mode);
+}
+
+bool CreateDirectoryIfMissing(const std::wstring& directoryPath) {
+    return mkdir(ToNativePath(directoryPath).c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+// UTF-8 path from the system -> wide string (invalid bytes are kept as they are)
+static std::wstring FromNativePath(const std::string& native) {
+    std::wstring path;
+    path.reserve(native.size());
+    for (size_t i = 0; i < native.size();) {
+        uint8_t lead = static_cast<uint8_t>(native[i]);
+        size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+        uint32_t cp = length == 1 ? lead : length == 2 ? (lead & 0x1F) : length == 3 ? (lead & 0x0F) : (lead & 0x07);
+        for (size_t k = 1; k < length; ++k) {
+            uint8_t next = i + k < native.size() ? static_cast<uint8_t>(native[i + k]) : 0;
+            if ((next & 0xC0) != 0x80) {
+                length = 0;
+                break;
+            }
+            cp = (cp << 6) | (next & 0x3F);
+        }
+        if (length == 0) {
+            path.push_back(static_cast<wchar_t>(lead));
+            ++i;
+        } else {
+            path.push_back(static_cast<wchar_t>(cp));
+            i += length;
+        }
+    }
+    return path;
+}
+
+// Executable path from /proc (Linux)
+std::wstring GetApplicationDirectory() {
+    char exePath[4096];
+    ssize_t pathLen = readlink("/proc/self/exe", exePath, sizeof(exePath));
+    if (pathLen <= 0 || static_cast<size_t>(pathLen) == sizeof(exePath)) {
+        return L""; // Failed to get path
+    }
+
+    std::string appDir(exePath, static_cast<size_t>(pathLen));
+    size_t lastSlash = appDir.find_last_of('/');
+    if (lastSlash != std::string::npos) {
+        appDir = appDir.substr(0, lastSlash);
+    }
+    return FromNativePath(appDir);
+}
+
+uint64_t ReadMonotonicNanos() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+}
+
+// Wraps around like GetTickCount (about every 49.7 days)
+uint32_t ReadTickCountMs() {
+    return static_cast<uint32_t>(ReadMonotonicNanos() / 1000000);
+}
+
+struct PosixWakeEvent {
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool signaled = false;
+};
+
+bool CreateWakeEvent(WakeEvent& event) {
+    event.handle = new PosixWakeEvent();
+    return true;
+}
+
+void SignalWakeEvent(WakeEvent& event) {
+    PosixWakeEvent* posixEvent = static_cast<PosixWakeEvent*>(event.handle);
+    {
+        std::lock_guard<std::mutex> lock(posixEvent->mutex);
+        posixEvent->signaled = true;
+    }
+    posixEvent->condition.notify_one();
+}
+
+void WaitWakeEvent(WakeEvent& event) {
+    PosixWakeEvent* posixEvent = static_cast<PosixWakeEvent*>(event.handle);
+    std::unique_lock<std::mutex> lock(posixEvent->mutex);
+    posixEvent->condition.wait(lock, [posixEvent] { return posixEvent->signaled; });
+    posixEvent->signaled = false; // Auto-reset
+}
+
+void CloseWakeEvent(WakeEvent& event) {
+    delete static_cast<PosixWakeEvent*>(event.handle);
+    event = WakeEvent();
+}
+
+void WriteDebugLog(const std::wstring& message) {
+    fputws(message.c_str(), stderr);
+}
+
+#endif
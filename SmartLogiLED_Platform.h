@@ -0,0 +1,61 @@
+// SmartLogiLED_Platform.h : Header file for the portable primitives of the storage layer and the hook multiplexer.
+//
+// Everything declared here builds on Windows and POSIX systems, so the storage code and the
+// keyboard hook multiplexer built on top of it can be compiled, tested and benchmarked outside
+// the Win32 application.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only view of a whole file (memory-mapped)
+struct MappedFile {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    void* fileHandle = nullptr;     // Platform handles, owned by the view
+    void* mappingHandle = nullptr;
+};
+
+// Map a whole file read-only; false if it does not exist, is empty or cannot be mapped
+bool MapFileReadOnly(const std::wstring& filePath, MappedFile& file);
+void UnmapFile(MappedFile& file);
+
+// Replace a file in one step: the data goes to "<filePath>.tmp", is flushed to disk
+// and then renamed over the old file, so readers see either the old or the new file
+bool WriteFileAtomically(const std::wstring& filePath, const void* data, size_t size);
+
+// File opened for sequential appends (created if missing)
+struct AppendOnlyFile {
+    void* handle = nullptr;         // Platform handle (Win32)
+    int descriptor = -1;            // File descriptor (POSIX)
+    uint64_t size = 0;              // Current end of the file
+};
+
+bool OpenAppendOnlyFile(const std::wstring& filePath, AppendOnlyFile& file);
+bool AppendToFile(AppendOnlyFile& file, const void* data, size_t size);
+bool FlushAppendOnlyFile(AppendOnlyFile& file); // Wait until the appended data is on disk
+void CloseAppendOnlyFile(AppendOnlyFile& file);
+
+bool FileExists(const std::wstring& filePath);
+bool CreateDirectoryIfMissing(const std::wstring& directoryPath);
+std::wstring GetApplicationDirectory(); // Folder of the running executable, without a trailing separator; empty if unknown
+
+// Monotonic clocks: nanoseconds for call timing (QueryPerformanceCounter on Windows, the latency
+// trace clock is derived from it) and milliseconds on the GetTickCount clock for key event times
+uint64_t ReadMonotonicNanos();
+uint32_t ReadTickCountMs();
+
+// Auto-reset event: a signal wakes one waiting thread, or the next wait if nobody is waiting
+struct WakeEvent {
+    void* handle = nullptr;         // Platform object, owned by the event
+};
+
+bool CreateWakeEvent(WakeEvent& event);
+void SignalWakeEvent(WakeEvent& event);
+void WaitWakeEvent(WakeEvent& event);
+void CloseWakeEvent(WakeEvent& event);
+
+// Diagnostic message (debugger output on Windows, stderr elsewhere)
+void WriteDebugLog(const std::wstring& message);
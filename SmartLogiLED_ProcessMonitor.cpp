@@ -5,9 +5,11 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <unordered_set>
 #include <tlhelp32.h>
 #include <psapi.h>
 #include "SmartLogiLED_ProcessMonitor.h"
+#include "SmartLogiLED_AppProfiles.h"
 #include "SmartLogiLED_Constants.h"
 
 // Module-specific variables
@@ -16,78 +18,42 @@ static bool appMonitoringRunning = false;
 static HWND mainWindowHandle = nullptr;
 
 // Forward declarations for internal functions
-void AppMonitorThreadProc();
+void AppMonitorThreadProc(std::vector<std::wstring> lastRunningApps);
 std::vector<std::wstring> GetVisibleRunningProcesses();
-bool IsProcessVisible(DWORD processId);
 
-// Check if a process has visible windows (including minimized)
-bool IsProcessVisibleOrMinimized(DWORD processId) {
+// Collect the ids of all processes that own a top-level window with a title
+// (one EnumWindows pass for all processes instead of one pass per process)
+static std::unordered_set<DWORD> GetWindowOwnerProcessIds(bool includeMinimized) {
     struct EnumData {
-        DWORD processId;
-        bool hasVisibleWindow;
+        bool includeMinimized;
+        std::unordered_set<DWORD> processIds;
     };
     
-    EnumData enumData = { processId, false };
+    EnumData enumData = { includeMinimized, {} };
     
     EnumWindows([](HWND hwnd, LPARAM lParam) -> BOOL {
         EnumData* data = reinterpret_cast<EnumData*>(lParam);
         
-        DWORD windowProcessId;
-        GetWindowThreadProcessId(hwnd, &windowProcessId);
-        
-        if (windowProcessId == data->processId) {
-            // Include both visible and minimized windows
-            if (IsWindowVisible(hwnd)) {
-                if (GetWindow(hwnd, GW_OWNER) == NULL) {
-                    WCHAR windowTitle[256];
-                    if (GetWindowTextW(hwnd, windowTitle, sizeof(windowTitle) / sizeof(WCHAR)) > 0) {
-                        data->hasVisibleWindow = true;
-                        return FALSE; // Stop enumeration
-                    }
+        if (IsWindowVisible(hwnd) && (data->includeMinimized || !IsIconic(hwnd))) {
+            if (GetWindow(hwnd, GW_OWNER) == NULL) {
+                WCHAR windowTitle[256];
+                if (GetWindowTextW(hwnd, windowTitle, sizeof(windowTitle) / sizeof(WCHAR)) > 0) {
+                    DWORD windowProcessId;
+                    GetWindowThreadProcessId(hwnd, &windowProcessId);
+                    data->processIds.insert(windowProcessId);
                 }
             }
         }
         return TRUE; // Continue enumeration
     }, reinterpret_cast<LPARAM>(&enumData));
     
-    return enumData.hasVisibleWindow;
+    return enumData.processIds;
 }
 
-// Check if a process has visible windows
-bool IsProcessVisible(DWORD processId) {
-    struct EnumData {
-        DWORD processId;
-        bool hasVisibleWindow;
-    };
-    
-    EnumData enumData = { processId, false };
-    
-    EnumWindows([](HWND hwnd, LPARAM lParam) -> BOOL {
-        EnumData* data = reinterpret_cast<EnumData*>(lParam);
-        
-        DWORD windowProcessId;
-        GetWindowThreadProcessId(hwnd, &windowProcessId);
-        
-        if (windowProcessId == data->processId) {
-            if (IsWindowVisible(hwnd) && !IsIconic(hwnd)) {
-                if (GetWindow(hwnd, GW_OWNER) == NULL) {
-                    WCHAR windowTitle[256];
-                    if (GetWindowTextW(hwnd, windowTitle, sizeof(windowTitle) / sizeof(WCHAR)) > 0) {
-                        data->hasVisibleWindow = true;
-                        return FALSE; // Stop enumeration
-                    }
-                }
-            }
-        }
-        return TRUE; // Continue enumeration
-    }, reinterpret_cast<LPARAM>(&enumData));
-    
-    return enumData.hasVisibleWindow;
-}
-
-// Get list of currently running processes including minimized ones
-std::vector<std::wstring> GetVisibleAndMinimizedRunningProcesses() {
-    std::vector<std::wstring> processes;
+// Take one process snapshot; visible processes are the ones owning a window id in windowOwners
+static void ScanProcessSnapshot(const std::unordered_set<DWORD>* windowOwners,
+                                std::vector<std::wstring>* allProcesses,
+                                std::vector<std::wstring>* visibleProcesses) {
     HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
     
     if (hSnapshot != INVALID_HANDLE_VALUE) {
@@ -96,56 +62,46 @@ std::vector<std::wstring> GetVisibleAndMinimizedRunningProcesses() {
         
         if (Process32FirstW(hSnapshot, &pe32)) {
             do {
-                if (IsProcessVisibleOrMinimized(pe32.th32ProcessID)) {
-                    processes.push_back(std::wstring(pe32.szExeFile));
+                if (allProcesses) {
+                    allProcesses->push_back(std::wstring(pe32.szExeFile));
+                }
+                if (visibleProcesses && windowOwners->count(pe32.th32ProcessID) > 0) {
+                    visibleProcesses->push_back(std::wstring(pe32.szExeFile));
                 }
             } while (Process32NextW(hSnapshot, &pe32));
         }
         CloseHandle(hSnapshot);
     }
-    
+}
+
+// Get list of currently running processes including minimized ones
+std::vector<std::wstring> GetVisibleAndMinimizedRunningProcesses() {
+    std::unordered_set<DWORD> windowOwners = GetWindowOwnerProcessIds(true);
+    std::vector<std::wstring> processes;
+    ScanProcessSnapshot(&windowOwners, nullptr, &processes);
     return processes;
 }
 
 // Get list of currently running visible processes
 std::vector<std::wstring> GetVisibleRunningProcesses() {
+    std::unordered_set<DWORD> windowOwners = GetWindowOwnerProcessIds(false);
     std::vector<std::wstring> processes;
-    HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-    
-    if (hSnapshot != INVALID_HANDLE_VALUE) {
-        PROCESSENTRY32W pe32;
-        pe32.dwSize = sizeof(PROCESSENTRY32W);
-        
-        if (Process32FirstW(hSnapshot, &pe32)) {
-            do {
-                if (IsProcessVisible(pe32.th32ProcessID)) {
-                    processes.push_back(std::wstring(pe32.szExeFile));
-                }
-            } while (Process32NextW(hSnapshot, &pe32));
-        }
-        CloseHandle(hSnapshot);
-    }
-    
+    ScanProcessSnapshot(&windowOwners, nullptr, &processes);
     return processes;
 }
 
+// Scan all and visible running processes from the same snapshot
+RunningProcessScan ScanRunningProcesses() {
+    RunningProcessScan scan;
+    std::unordered_set<DWORD> windowOwners = GetWindowOwnerProcessIds(false);
+    ScanProcessSnapshot(&windowOwners, &scan.allProcesses, &scan.visibleProcesses);
+    return scan;
+}
+
 // Get list of all running processes (regardless of visibility)
 std::vector<std::wstring> GetAllRunningProcesses() {
     std::vector<std::wstring> processes;
-    HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-    
-    if (hSnapshot != INVALID_HANDLE_VALUE) {
-        PROCESSENTRY32W pe32;
-        pe32.dwSize = sizeof(PROCESSENTRY32W);
-        
-        if (Process32FirstW(hSnapshot, &pe32)) {
-            do {
-                processes.push_back(std::wstring(pe32.szExeFile));
-            } while (Process32NextW(hSnapshot, &pe32));
-        }
-        CloseHandle(hSnapshot);
-    }
-    
+    ScanProcessSnapshot(nullptr, &processes, nullptr);
     return processes;
 }
 
@@ -187,30 +143,69 @@ bool IsProcessRunning(const std::wstring& processName) {
     return false;
 }
 
+// Get the creation time (FILETIME) of the newest process with the given name, 0 if unknown
+static ULONGLONG GetNewestProcessCreationTime(const std::wstring& processName) {
+    ULONGLONG newest = 0;
+    HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    
+    if (hSnapshot != INVALID_HANDLE_VALUE) {
+        PROCESSENTRY32W pe32;
+        pe32.dwSize = sizeof(PROCESSENTRY32W);
+        
+        if (Process32FirstW(hSnapshot, &pe32)) {
+            do {
+                if (_wcsicmp(pe32.szExeFile, processName.c_str()) != 0) {
+                    continue;
+                }
+                HANDLE hProcess = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pe32.th32ProcessID);
+                if (hProcess) {
+                    FILETIME creationTime, exitTime, kernelTime, userTime;
+                    if (GetProcessTimes(hProcess, &creationTime, &exitTime, &kernelTime, &userTime)) {
+                        ULONGLONG created = (static_cast<ULONGLONG>(creationTime.dwHighDateTime) << 32) | creationTime.dwLowDateTime;
+                        newest = (std::max)(newest, created);
+                    }
+                    CloseHandle(hProcess);
+                }
+            } while (Process32NextW(hSnapshot, &pe32));
+        }
+        CloseHandle(hSnapshot);
+    }
+    
+    return newest;
+}
+
+// Start a latency trace for a newly detected app (the process creation time is the trace start,
+// so the monitor poll interval is part of the detection span)
+static LatencyTrace TraceAppDetection(const std::wstring& appName, ULONGLONG scanStartMicros) {
+    ULONGLONG startMicros = TraceClockFromFileTime(GetNewestProcessCreationTime(appName));
+    if (startMicros == 0 || startMicros > scanStartMicros) {
+        startMicros = scanStartMicros;
+    }
+    LatencyTrace trace = BeginLatencyTrace(startMicros);
+    RecordLatencySpan(LatencyStage::Detection, trace.id, startMicros, ReadTraceClock());
+    return trace;
+}
+
 // App monitoring thread function
-void AppMonitorThreadProc() {
-    std::vector<std::wstring> lastRunningApps;
+void AppMonitorThreadProc(std::vector<std::wstring> lastRunningApps) {
     
     while (appMonitoringRunning) {
+        bool tracing = IsLatencyTracingEnabled();
+        ULONGLONG scanStartMicros = tracing ? ReadTraceClock() : 0;
         std::vector<std::wstring> currentRunningApps = GetVisibleRunningProcesses();
         
         // Check for newly started apps
         for (const auto& app : currentRunningApps) {
             if (std::find(lastRunningApps.begin(), lastRunningApps.end(), app) == lastRunningApps.end()) {
-                if (mainWindowHandle) {
-                    std::wstring* appName = new std::wstring(app);
-                    PostMessage(mainWindowHandle, WM_APP_STARTED, 0, reinterpret_cast<LPARAM>(appName));
-                }
+                // Queued for the profile engine (traced apps carry their trace along)
+                HandleAppStarted(app, tracing ? TraceAppDetection(app, scanStartMicros) : LatencyTrace());
             }
         }
         
         // Check for stopped apps
         for (const auto& app : lastRunningApps) {
             if (std::find(currentRunningApps.begin(), currentRunningApps.end(), app) == currentRunningApps.end()) {
-                if (mainWindowHandle) {
-                    std::wstring* appName = new std::wstring(app);
-                    PostMessage(mainWindowHandle, WM_APP_STOPPED, 0, reinterpret_cast<LPARAM>(appName));
-                }
+                HandleAppStopped(app); // Queued for the profile engine
             }
         }
         
@@ -220,12 +215,12 @@ void AppMonitorThreadProc() {
     }
 }
 
-// Initialize app monitoring
-void InitializeAppMonitoring(HWND hMainWindow) {
+// Initialize app monitoring (apps in knownRunningApps are already accounted for and are not reported as started)
+void InitializeAppMonitoring(HWND hMainWindow, const std::vector<std::wstring>& knownRunningApps) {
     if (!appMonitoringRunning) {
         mainWindowHandle = hMainWindow;
         appMonitoringRunning = true;
-        appMonitorThread = std::thread(AppMonitorThreadProc);
+        appMonitorThread = std::thread(AppMonitorThreadProc, knownRunningApps);
     }
 }
 
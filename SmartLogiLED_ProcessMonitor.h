@@ -6,10 +6,17 @@
 #include "SmartLogiLED_Types.h"
 
 
+// Running processes from one snapshot
+struct RunningProcessScan {
+    std::vector<std::wstring> allProcesses;
+    std::vector<std::wstring> visibleProcesses;   // Processes with a visible, non-minimized top-level window
+};
+
 // Public interface for the Process Monitor
-void InitializeAppMonitoring(HWND hMainWindow);
+void InitializeAppMonitoring(HWND hMainWindow, const std::vector<std::wstring>& knownRunningApps = {});
 void CleanupAppMonitoring();
 bool IsAppRunning(const std::wstring& appName);
 bool IsProcessRunning(const std::wstring& processName); // New function for any process detection
 std::vector<std::wstring> GetVisibleRunningProcesses();
-std::vector<std::wstring> GetVisibleAndMinimizedRunningProcesses(); // New function including minimized apps
\ No newline at end of file
+std::vector<std::wstring> GetVisibleAndMinimizedRunningProcesses(); // New function including minimized apps
+RunningProcessScan ScanRunningProcesses();
\ No newline at end of file
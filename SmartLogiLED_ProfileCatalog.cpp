@@ -0,0 +1,169 @@
+// SmartLogiLED_ProfileCatalog.cpp : Contains the compact catalog of stored profile names.
+//
+// Only profiles that are in use (running apps, the profile being edited, parent templates)
+// are materialized as AppColorProfile objects. Every other stored profile is known by name
+// only, through this catalog.
+
+#include "framework.h"
+#include "SmartLogiLED_ProfileCatalog.h"
+#include <algorithm>
+#include <atomic>
+#include <cwctype>
+#include <sstream>
+
+// Module-specific variables
+static std::vector<wchar_t> catalogText;     // Null-terminated names, back to back
+static std::vector<DWORD> catalogOffsets;    // Offsets into catalogText, sorted case-insensitively
+static size_t catalogUnusedChars = 0;        // Characters of removed names still in catalogText
+static std::atomic<ULONGLONG> catalogVersion{ 0 }; // Bumped on every change of the name list
+
+// Case-insensitive comparison of two null-terminated names
+static int CompareProfileNames(const wchar_t* left, const wchar_t* right) {
+    while (*left && std::towlower(*left) == std::towlower(*right)) {
+        ++left;
+        ++right;
+    }
+    return static_cast<int>(std::towlower(*left)) - static_cast<int>(std::towlower(*right));
+}
+
+// Find the first catalog entry not less than the given name (INTERNAL - NO LOCK)
+static std::vector<DWORD>::iterator LowerBoundInternal(const std::wstring& appName) {
+    return std::lower_bound(catalogOffsets.begin(), catalogOffsets.end(), appName,
+        [](DWORD offset, const std::wstring& name) {
+            return CompareProfileNames(&catalogText[offset], name.c_str()) < 0;
+        });
+}
+
+// Append a name to the text buffer and return its offset (INTERNAL - NO LOCK)
+static DWORD AppendNameInternal(const std::wstring& appName) {
+    DWORD offset = static_cast<DWORD>(catalogText.size());
+    catalogText.insert(catalogText.end(), appName.begin(), appName.end());
+    catalogText.push_back(L'\0');
+    return offset;
+}
+
+// Drop the text of removed names once it makes up most of the buffer (INTERNAL - NO LOCK)
+static void CompactCatalogInternal() {
+    if (catalogUnusedChars < 4096 || catalogUnusedChars * 2 < catalogText.size()) {
+        return;
+    }
+
+    std::vector<wchar_t> compactText;
+    compactText.reserve(catalogText.size() - catalogUnusedChars);
+    for (auto& offset : catalogOffsets) {
+        DWORD newOffset = static_cast<DWORD>(compactText.size());
+        for (const wchar_t* ch = &catalogText[offset]; *ch; ++ch) {
+            compactText.push_back(*ch);
+        }
+        compactText.push_back(L'\0');
+        offset = newOffset;
+    }
+    catalogText.swap(compactText);
+    catalogUnusedChars = 0;
+}
+
+// Build the catalog from the names found in storage (INTERNAL - NO LOCK)
+void ResetProfileCatalogInternal(const std::vector<std::wstring>& storedNames) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    size_t totalChars = 0;
+    for (const auto& name : storedNames) {
+        totalChars += name.size() + 1;
+    }
+
+    catalogText.clear();
+    catalogOffsets.clear();
+    catalogUnusedChars = 0;
+    catalogText.reserve(totalChars);
+    catalogOffsets.reserve(storedNames.size());
+
+    for (const auto& name : storedNames) {
+        catalogOffsets.push_back(AppendNameInternal(name));
+    }
+    ++catalogVersion;
+    std::sort(catalogOffsets.begin(), catalogOffsets.end(), [](DWORD left, DWORD right) {
+        return CompareProfileNames(&catalogText[left], &catalogText[right]) < 0;
+    });
+
+    // Storage keys are unique per name, but drop case-only duplicates just in case
+    catalogOffsets.erase(std::unique(catalogOffsets.begin(), catalogOffsets.end(), [](DWORD left, DWORD right) {
+        return CompareProfileNames(&catalogText[left], &catalogText[right]) == 0;
+    }), catalogOffsets.end());
+
+#ifdef ENABLE_DEBUG_LOGGING
+    std::wstringstream debugMsg;
+    debugMsg << L"[DEBUG] Profile catalog built: " << catalogOffsets.size() << L" profiles, "
+             << (catalogText.size() * sizeof(wchar_t) + catalogOffsets.size() * sizeof(DWORD)) << L" bytes\n";
+    OutputDebugStringW(debugMsg.str().c_str());
+#endif
+}
+
+// Check whether a profile with this name is stored (INTERNAL - NO LOCK)
+bool CatalogContainsProfileInternal(const std::wstring& appName) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    auto it = LowerBoundInternal(appName);
+    return it != catalogOffsets.end() && CompareProfileNames(&catalogText[*it], appName.c_str()) == 0;
+}
+
+// Get the stored spelling of a profile name (INTERNAL - NO LOCK)
+std::wstring GetStoredProfileNameInternal(const std::wstring& appName) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    auto it = LowerBoundInternal(appName);
+    if (it != catalogOffsets.end() && CompareProfileNames(&catalogText[*it], appName.c_str()) == 0) {
+        return std::wstring(&catalogText[*it]);
+    }
+    return std::wstring();
+}
+
+// Add a newly stored profile name (INTERNAL - NO LOCK)
+void AddProfileToCatalogInternal(const std::wstring& appName) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    auto it = LowerBoundInternal(appName);
+    if (it != catalogOffsets.end() && CompareProfileNames(&catalogText[*it], appName.c_str()) == 0) {
+        return; // Already cataloged
+    }
+
+    size_t position = it - catalogOffsets.begin();
+    DWORD offset = AppendNameInternal(appName);
+    catalogOffsets.insert(catalogOffsets.begin() + position, offset);
+    ++catalogVersion;
+}
+
+// Remove a deleted profile name (INTERNAL - NO LOCK)
+void RemoveProfileFromCatalogInternal(const std::wstring& appName) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    auto it = LowerBoundInternal(appName);
+    if (it != catalogOffsets.end() && CompareProfileNames(&catalogText[*it], appName.c_str()) == 0) {
+        catalogUnusedChars += wcslen(&catalogText[*it]) + 1;
+        catalogOffsets.erase(it);
+        CompactCatalogInternal();
+        ++catalogVersion;
+    }
+}
+
+// Get the version of the name list (readable without the lock; changes whenever a name is added or removed)
+ULONGLONG GetProfileCatalogVersion() {
+    return catalogVersion.load();
+}
+
+// Get the number of stored profiles (INTERNAL - NO LOCK)
+size_t GetProfileCatalogSizeInternal() {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+    return catalogOffsets.size();
+}
+
+// Get all stored profile names in display order (INTERNAL - NO LOCK)
+std::vector<std::wstring> GetProfileCatalogNamesInternal() {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    std::vector<std::wstring> names;
+    names.reserve(catalogOffsets.size());
+    for (DWORD offset : catalogOffsets) {
+        names.emplace_back(&catalogText[offset]);
+    }
+    return names;
+}
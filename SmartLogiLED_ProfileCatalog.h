@@ -0,0 +1,23 @@
+// SmartLogiLED_ProfileCatalog.h : Header file for the compact catalog of stored profile names.
+//
+
+#pragma once
+
+#include "framework.h"
+#include <string>
+#include <vector>
+
+// Catalog of every stored profile name (materialized in memory or not)
+// Names are kept in one contiguous buffer and a sorted offset table, so a library of
+// tens of thousands of profiles costs a few bytes per name instead of a full profile.
+// All functions here assume the appProfilesMutex is already locked by the caller.
+void ResetProfileCatalogInternal(const std::vector<std::wstring>& storedNames);
+bool CatalogContainsProfileInternal(const std::wstring& appName);
+std::wstring GetStoredProfileNameInternal(const std::wstring& appName); // Stored spelling, empty if not cataloged
+void AddProfileToCatalogInternal(const std::wstring& appName);
+void RemoveProfileFromCatalogInternal(const std::wstring& appName);
+size_t GetProfileCatalogSizeInternal();
+std::vector<std::wstring> GetProfileCatalogNamesInternal(); // Sorted case-insensitively
+
+// Version of the name list, bumped on every change (the one function that needs no lock)
+ULONGLONG GetProfileCatalogVersion();
@@ -0,0 +1,338 @@
+// SmartLogiLED_ProfileEngine.cpp : Contains the profile engine (event queue and state snapshots).
+//
+// Every profile mutation and activation decision is an event processed in order on one
+// engine thread. Producers (app monitor, UI, import) push events onto an intrusive stack
+// with a compare-and-swap and take no lock; readers hold on to the snapshot the engine
+// publishes after each batch. The profile storage lock is taken once per batch, for the
+// handlers and the snapshot together. Keyboard colors are still pushed by the UI thread,
+// which owns the keyboard hook.
+
+#include "framework.h"
+#include "SmartLogiLED_ProfileEngine.h"
+#include "SmartLogiLED_Config.h"
+#include "SmartLogiLED_PersistenceWorker.h"
+#include "SmartLogiLED_Constants.h"
+#include <atomic>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <sstream>
+
+// Profile storage lock from the AppProfiles module
+extern std::mutex appProfilesMutex;
+
+// Queued event (intrusive node of the producer stack)
+struct ProfileEventNode {
+    ProfileEvent event;
+    std::shared_ptr<std::promise<bool>> completion; // Set for SendProfileEvent
+    bool result = false;                            // Handler result, set by the engine
+    ProfileEventNode* next = nullptr;
+};
+
+// Module-specific variables
+static std::atomic<ProfileEventNode*> pendingEvents{ nullptr };  // Newest first
+static std::atomic<bool> engineAcceptingEvents{ false };       // Producers may queue (cleared first by StopProfileEngine)
+static std::atomic<LONG> engineProducersInFlight{ 0 };          // Producers between the accepting check and the push
+static std::mutex engineLifetimeMutex;                          // StartProfileEngine / StopProfileEngine only
+static std::recursive_mutex engineProcessMutex;                 // Handlers run on one thread at a time
+static bool engineRunning = false;                              // Guarded by engineLifetimeMutex
+static std::atomic<bool> engineStopRequested{ false };
+static std::atomic<DWORD> pendingApplyFields{ 0 };
+static std::atomic<ULONGLONG> pendingApplyTraceId{ 0 };         // Traced switch waiting for the UI thread
+static std::atomic<ULONGLONG> pendingApplyTraceStart{ 0 };
+static std::atomic<ULONGLONG> pendingApplyPublishedMicros{ 0 };
+static std::shared_ptr<ProfileStateSnapshot> publishedSnapshot = std::make_shared<ProfileStateSnapshot>();
+static std::thread engineThread;
+static std::atomic<DWORD> engineThreadId{ 0 };
+static HANDLE engineWakeEvent = nullptr;
+static HWND mainWindowHandle = nullptr;
+static ULONGLONG eventSequence = 0;
+
+// Event log (consumer side only - producers never touch it)
+static std::mutex eventLogMutex;
+static std::deque<ProfileEvent> eventLog;
+
+// Work requested by the handlers of the batch being processed on this thread
+static thread_local DWORD batchApplyFields = 0;
+static thread_local bool batchRefreshUi = false;
+
+const wchar_t* GetProfileEventTypeName(ProfileEventType type) {
+    switch (type) {
+        case ProfileEventType::AppStarted:           return L"AppStarted";
+        case ProfileEventType::AppStopped:           return L"AppStopped";
+        case ProfileEventType::RunningAppsScanned:   return L"RunningAppsScanned";
+        case ProfileEventType::ProfileAdded:         return L"ProfileAdded";
+        case ProfileEventType::ProfileRemoved:       return L"ProfileRemoved";
+        case ProfileEventType::ProfileFieldChanged:  return L"ProfileFieldChanged";
+        case ProfileEventType::ProfileParentChanged: return L"ProfileParentChanged";
+        case ProfileEventType::ProfilesImported:     return L"ProfilesImported";
+        case ProfileEventType::Barrier:              return L"Barrier";
+    }
+    return L"Unknown";
+}
+
+// ======================================================================
+// EVENT PROCESSING
+// ======================================================================
+
+// Append a processed event to the bounded event log
+static void AppendToEventLog(const ProfileEvent& event) {
+    if (event.type == ProfileEventType::Barrier) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(eventLogMutex);
+    eventLog.push_back(event);
+    while (eventLog.size() > PROFILE_EVENT_LOG_CAPACITY) {
+        eventLog.pop_front();
+    }
+}
+
+// Process a batch of events (oldest first), publish the resulting state and wake the waiters
+static void ProcessEventBatch(ProfileEventNode* batch) {
+    if (!batch) {
+        return;
+    }
+
+    // Recursive: a producer of a stopped engine holds it across the queued events and its own
+    // (handlers run under the storage lock and must not submit events)
+    std::lock_guard<std::recursive_mutex> processLock(engineProcessMutex);
+    batchApplyFields = 0;
+    batchRefreshUi = false;
+
+    // One hold of the profile storage lock for the whole batch: readers wait for at most one
+    // batch, not for every event and once more for the snapshot
+    ULONGLONG lastSequence = 0;
+    LatencyTrace applyTrace;
+    auto snapshot = std::make_shared<ProfileStateSnapshot>();
+    {
+        std::shared_ptr<const ProfileStateSnapshot> previous = std::atomic_load(&publishedSnapshot);
+        std::lock_guard<std::mutex> lock(appProfilesMutex);
+        for (ProfileEventNode* node = batch; node; node = node->next) {
+            const LatencyTrace& trace = node->event.trace;
+            ULONGLONG dispatchStart = trace.id ? ReadTraceClock() : 0;
+            DWORD applyFieldsBefore = batchApplyFields;
+
+            node->event.sequence = lastSequence = ++eventSequence;
+            node->result = DispatchProfileEventInternal(node->event);
+
+            if (trace.id) {
+                RecordLatencySpan(LatencyStage::EventQueue, trace.id, node->event.queuedMicros, dispatchStart);
+                RecordLatencySpan(LatencyStage::Decision, trace.id, dispatchStart, ReadTraceClock());
+                if (batchApplyFields != applyFieldsBefore) {
+                    applyTrace = trace; // This event changed the keyboard colors
+                }
+            }
+        }
+        BuildProfileStateSnapshotInternal(*snapshot, *previous);
+    }
+    snapshot->sequence = lastSequence;
+
+    // Log the batch outside the storage lock
+    std::vector<std::pair<std::shared_ptr<std::promise<bool>>, bool>> completions;
+    while (batch) {
+        ProfileEventNode* node = batch;
+        batch = batch->next;
+        AppendToEventLog(node->event);
+
+#ifdef ENABLE_DEBUG_LOGGING
+        std::wstringstream debugMsg;
+        debugMsg << L"[DEBUG] Profile event #" << node->event.sequence << L" "
+                 << GetProfileEventTypeName(node->event.type) << L" " << node->event.appName
+                 << L" -> " << (node->result ? L"TRUE" : L"FALSE") << L"\n";
+        OutputDebugStringW(debugMsg.str().c_str());
+#endif
+
+        if (node->completion) {
+            completions.emplace_back(node->completion, node->result);
+        }
+        delete node;
+    }
+
+    // Publish the new state before anyone is told about it
+    std::atomic_store(&publishedSnapshot, snapshot);
+
+    if (applyTrace.id) {
+        pendingApplyTraceStart = applyTrace.startMicros;
+        pendingApplyPublishedMicros = ReadTraceClock();
+        pendingApplyTraceId = applyTrace.id;
+    }
+
+    // Coalesce color updates: only post when no update is already waiting for the UI thread
+    if (batchApplyFields != 0 && pendingApplyFields.fetch_or(batchApplyFields) == 0 && mainWindowHandle) {
+        PostMessage(mainWindowHandle, WM_APPLY_PROFILE_FRAME, 0, 0);
+    }
+    if (batchRefreshUi && mainWindowHandle) {
+        PostMessage(mainWindowHandle, WM_UPDATE_PROFILE_COMBO, 0, 0);
+    }
+
+    for (auto& completion : completions) {
+        completion.first->set_value(completion.second);
+    }
+
+    // The persistence worker saves the activation history snapshot on its own schedule
+    ScheduleActivationHistoryWrite();
+}
+
+// Take every queued event in arrival order
+static ProfileEventNode* TakePendingEvents() {
+    ProfileEventNode* newestFirst = pendingEvents.exchange(nullptr, std::memory_order_acquire);
+
+    // Reverse into FIFO order
+    ProfileEventNode* oldestFirst = nullptr;
+    while (newestFirst) {
+        ProfileEventNode* next = newestFirst->next;
+        newestFirst->next = oldestFirst;
+        oldestFirst = newestFirst;
+        newestFirst = next;
+    }
+    return oldestFirst;
+}
+
+// Engine thread function
+static void ProfileEngineThreadProc() {
+    engineThreadId = GetCurrentThreadId();
+    while (!engineStopRequested) {
+        WaitForSingleObject(engineWakeEvent, INFINITE);
+        ProcessEventBatch(TakePendingEvents());
+    }
+    ProcessEventBatch(TakePendingEvents()); // Events queued while stopping
+}
+
+// Queue an event, or process it right away if the engine is not running
+static void SubmitProfileEvent(ProfileEventNode* node) {
+    if (node->event.trace.id) {
+        node->event.queuedMicros = ReadTraceClock();
+    }
+
+    if (!IsProfileEngineThread()) {
+        // The producer announces itself before it checks the flag, and StopProfileEngine clears
+        // the flag before it waits for announced producers: either the producer sees the engine
+        // stopping, or its push lands before the final drain (both sides sequentially consistent)
+        engineProducersInFlight.fetch_add(1);
+        if (engineAcceptingEvents.load()) {
+            node->next = pendingEvents.load(std::memory_order_relaxed);
+            while (!pendingEvents.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+            }
+            SetEvent(engineWakeEvent);
+            engineProducersInFlight.fetch_sub(1);
+            return;
+        }
+        engineProducersInFlight.fetch_sub(1);
+
+        // Engine stopped: events still queued go first, so this producer's events keep their order
+        std::lock_guard<std::recursive_mutex> processLock(engineProcessMutex);
+        ProcessEventBatch(TakePendingEvents());
+        node->next = nullptr;
+        ProcessEventBatch(node);
+        return;
+    }
+
+    node->next = nullptr;
+    ProcessEventBatch(node);
+}
+
+// ======================================================================
+// PUBLIC API
+// ======================================================================
+
+void StartProfileEngine(HWND hMainWindow) {
+    std::lock_guard<std::mutex> lock(engineLifetimeMutex);
+    if (engineRunning) {
+        return;
+    }
+    mainWindowHandle = hMainWindow;
+    engineWakeEvent = CreateEventW(NULL, FALSE, FALSE, NULL);
+    engineStopRequested = false;
+    engineThread = std::thread(ProfileEngineThreadProc);
+    engineRunning = true;
+    engineAcceptingEvents = true;
+}
+
+void StopProfileEngine() {
+    std::lock_guard<std::mutex> lock(engineLifetimeMutex);
+    if (!engineRunning) {
+        return;
+    }
+    engineRunning = false;
+    engineAcceptingEvents = false; // New events are processed by their producers from now on
+
+    // Producers that saw the engine accepting finish their push (a few instructions) before the
+    // final drain, and before the wake event they signal is closed
+    while (engineProducersInFlight.load() != 0) {
+        std::this_thread::yield();
+    }
+    engineStopRequested = true;
+    SetEvent(engineWakeEvent);
+    if (engineThread.joinable()) {
+        engineThread.join();
+    }
+    engineThreadId = 0;
+    CloseHandle(engineWakeEvent);
+    engineWakeEvent = nullptr;
+}
+
+bool IsProfileEngineThread() {
+    return engineThreadId != 0 && GetCurrentThreadId() == engineThreadId;
+}
+
+void PostProfileEvent(ProfileEvent event) {
+    ProfileEventNode* node = new ProfileEventNode();
+    node->event = std::move(event);
+    SubmitProfileEvent(node);
+}
+
+bool SendProfileEvent(ProfileEvent event) {
+    ProfileEventNode* node = new ProfileEventNode();
+    node->event = std::move(event);
+    node->completion = std::make_shared<std::promise<bool>>();
+    std::future<bool> result = node->completion->get_future();
+    SubmitProfileEvent(node);
+    return result.get();
+}
+
+void FlushProfileEngine() {
+    SendProfileEvent(ProfileEvent());
+}
+
+std::shared_ptr<const ProfileStateSnapshot> GetProfileStateSnapshot() {
+    return std::atomic_load(&publishedSnapshot);
+}
+
+DWORD TakePendingProfileApply(LatencyTrace* trace, ULONGLONG* publishedMicros) {
+    DWORD fields = pendingApplyFields.exchange(0);
+    ULONGLONG traceId = pendingApplyTraceId.exchange(0);
+    if (trace) {
+        trace->id = traceId;
+        trace->startMicros = pendingApplyTraceStart;
+    }
+    if (publishedMicros) {
+        *publishedMicros = pendingApplyPublishedMicros;
+    }
+    return fields;
+}
+
+void RequestProfileApplyInternal(DWORD fields) {
+    batchApplyFields |= fields;
+}
+
+void RequestProfileUiRefreshInternal() {
+    batchRefreshUi = true;
+}
+
+std::vector<ProfileEvent> GetProfileEventLog() {
+    std::lock_guard<std::mutex> lock(eventLogMutex);
+    return std::vector<ProfileEvent>(eventLog.begin(), eventLog.end());
+}
+
+// Replay logged events in their original order (starting from the same stored profiles
+// and an empty activation history gives the same decisions)
+void ReplayProfileEvents(const std::vector<ProfileEvent>& events) {
+    for (const auto& event : events) {
+        ProfileEvent replayed = event;
+        replayed.sequence = 0;
+        replayed.trace = LatencyTrace();
+        PostProfileEvent(std::move(replayed));
+    }
+    FlushProfileEngine();
+}
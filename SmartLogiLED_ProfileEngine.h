@@ -0,0 +1,82 @@
+// SmartLogiLED_ProfileEngine.h : Header file for the profile engine (event queue and state snapshots).
+//
+
+#pragma once
+
+#include "framework.h"
+#include "SmartLogiLED_Types.h"
+#include "SmartLogiLED_LatencyTrace.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Events consumed by the profile engine
+enum class ProfileEventType {
+    AppStarted,             // appName
+    AppStopped,             // appName
+    RunningAppsScanned,     // names = all visible processes
+    ProfileAdded,           // appName, color, value = lockKeysEnabled, isAppRunning
+    ProfileRemoved,         // appName
+    ProfileFieldChanged,    // appName, field = PROFILE_FIELD_*, color / value / keys
+    ProfileParentChanged,   // appName, parentName, value = override mask
+    ProfilesImported,       // profiles (parentName / overrideMask as read from the files), names = all visible processes
+    Barrier                 // No state change - used to wait for the queue to drain
+};
+
+// One profile event. Everything the engine needs to decide is carried in the event
+// (including the running state sampled by the producer), so a logged sequence of
+// events can be replayed against the same stored profiles.
+struct ProfileEvent {
+    ProfileEventType type = ProfileEventType::Barrier;
+    std::wstring appName;
+    std::wstring parentName;
+    std::vector<std::wstring> names;
+    std::vector<LogiLed::KeyName> keys;
+    std::vector<AppColorProfile> profiles; // ProfilesImported only
+    COLORREF color = 0;
+    DWORD field = 0;            // PROFILE_FIELD_* changed by ProfileFieldChanged
+    DWORD value = 0;            // lockKeysEnabled / override mask / KEY_EFFECT_* / MODIFIER_LAYER_*
+    bool isAppRunning = false;
+    ULONGLONG sequence = 0;     // Assigned by the engine when the event is processed
+    LatencyTrace trace;         // Set by the producer when latency tracing is on
+    ULONGLONG queuedMicros = 0; // Trace clock when the event was queued (traced events only)
+};
+
+// State published by the engine after every batch of events (read without locks)
+struct ProfileStateSnapshot {
+    ULONGLONG sequence = 0;             // Last event included in this snapshot
+    bool hasDisplayedProfile = false;
+    AppColorProfile displayedFrame;     // Flattened frame of the displayed profile
+    ULONGLONG catalogVersion = 0;       // GetProfileCatalogVersion() the names were read at
+    std::shared_ptr<const std::vector<std::wstring>> profileNames; // All stored profiles (shared while the catalog is unchanged)
+};
+
+// Engine lifetime (events submitted while the engine is stopped are processed on the calling thread)
+void StartProfileEngine(HWND hMainWindow);
+void StopProfileEngine();
+bool IsProfileEngineThread();
+
+// Producers - never block on the engine's state
+void PostProfileEvent(ProfileEvent event);
+bool SendProfileEvent(ProfileEvent event);  // Waits until the event is processed and published; returns the handler result
+void FlushProfileEngine();                  // Waits until every event queued so far is processed
+
+// Published state
+std::shared_ptr<const ProfileStateSnapshot> GetProfileStateSnapshot(); // Hold it for as long as its frame is used
+
+// Profile colors requested by the engine; taken and pushed to the keyboard by the UI thread
+// (trace / publishedMicros receive the traced switch that requested them, if any)
+DWORD TakePendingProfileApply(LatencyTrace* trace = nullptr, ULONGLONG* publishedMicros = nullptr);
+
+// Event log and replay
+std::vector<ProfileEvent> GetProfileEventLog();
+void ReplayProfileEvents(const std::vector<ProfileEvent>& events);
+const wchar_t* GetProfileEventTypeName(ProfileEventType type);
+
+// Called by event handlers on the engine thread
+void RequestProfileApplyInternal(DWORD fields);   // PROFILE_FIELD_* of the displayed frame to push to the keyboard
+void RequestProfileUiRefreshInternal();           // Refresh the profile combo box and label
+
+// Implemented by the AppProfiles module (called with the appProfilesMutex locked, once per batch)
+bool DispatchProfileEventInternal(const ProfileEvent& event);
+void BuildProfileStateSnapshotInternal(ProfileStateSnapshot& snapshot, const ProfileStateSnapshot& previous);
@@ -0,0 +1,275 @@
+// SmartLogiLED_ProfileInheritance.cpp : Contains layered profile inheritance (parent templates and lazy flattening).
+//
+// A profile may name a parent profile (a template such as a shared WASD layout) and only
+// store the fields it overrides. The effective "frame" that is pushed to the keyboard is
+// flattened on first use and cached; editing a profile invalidates its own frame and the
+// frames of every profile inheriting from it.
+
+#include "framework.h"
+#include "SmartLogiLED_ProfileInheritance.h"
+#include "SmartLogiLED_Constants.h"
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <sstream>
+
+// Profile storage and helpers from the AppProfiles module
+extern std::vector<std::unique_ptr<AppColorProfile>> appColorProfiles;
+AppColorProfile* FindProfileByNameInternal(const std::wstring& appName);
+void RemoveKeysFromListInternal(std::vector<LogiLed::KeyName>& targetList, const std::vector<LogiLed::KeyName>& sourceList);
+
+// Cached flattened frame of an inheriting profile
+struct ResolvedProfileFrame {
+    AppColorProfile frame;
+    bool valid = false;
+};
+
+// Module-specific variables (all keyed by lower-case profile name)
+static std::unordered_map<std::wstring, ResolvedProfileFrame> resolvedProfileCache;
+static std::unordered_map<std::wstring, std::vector<std::wstring>> inheritanceChildren; // parent -> direct children
+
+// Helper function for case-insensitive profile keys
+static std::wstring ToProfileKey(const std::wstring& name) {
+    std::wstring key = name;
+    std::transform(key.begin(), key.end(), key.begin(), ::towlower);
+    return key;
+}
+
+// Copy every field the profile does not override from the resolved parent frame
+static void InheritFieldsFromParent(AppColorProfile& frame, const AppColorProfile& parentFrame, DWORD overrideMask) {
+    if (!(overrideMask & PROFILE_FIELD_APP_COLOR)) {
+        frame.appColor = parentFrame.appColor;
+    }
+    if (!(overrideMask & PROFILE_FIELD_HIGHLIGHT_COLOR)) {
+        frame.appHighlightColor = parentFrame.appHighlightColor;
+    }
+    if (!(overrideMask & PROFILE_FIELD_ACTION_COLOR)) {
+        frame.appActionColor = parentFrame.appActionColor;
+    }
+    if (!(overrideMask & PROFILE_FIELD_LOCK_KEYS_ENABLED)) {
+        frame.lockKeysEnabled = parentFrame.lockKeysEnabled;
+    }
+    if (!(overrideMask & PROFILE_FIELD_HIGHLIGHT_KEYS)) {
+        frame.highlightKeys = parentFrame.highlightKeys;
+    }
+    if (!(overrideMask & PROFILE_FIELD_ACTION_KEYS)) {
+        frame.actionKeys = parentFrame.actionKeys;
+    }
+    if (!(overrideMask & PROFILE_FIELD_KEY_EFFECT)) {
+        frame.keyEffect = parentFrame.keyEffect;
+    }
+    if (!(overrideMask & PROFILE_FIELD_MODIFIER_LAYER)) {
+        frame.modifierLayer = parentFrame.modifierLayer;
+        frame.appModifierColor = parentFrame.appModifierColor;
+    }
+
+    // Keys assigned by the profile itself win over keys inherited into the other group,
+    // so highlight and action lists stay mutually exclusive in the flattened frame
+    bool ownsHighlightKeys = (overrideMask & PROFILE_FIELD_HIGHLIGHT_KEYS) != 0;
+    bool ownsActionKeys = (overrideMask & PROFILE_FIELD_ACTION_KEYS) != 0;
+    if (ownsHighlightKeys && !ownsActionKeys) {
+        RemoveKeysFromListInternal(frame.actionKeys, frame.highlightKeys);
+    } else if (ownsActionKeys && !ownsHighlightKeys) {
+        RemoveKeysFromListInternal(frame.highlightKeys, frame.actionKeys);
+    }
+}
+
+// Flatten a profile along its parent chain, reusing cached parent frames (INTERNAL - NO LOCK)
+static AppColorProfile* ResolveProfileAtDepthInternal(AppColorProfile* profile, int depth) {
+    if (!profile) {
+        return nullptr;
+    }
+
+    // Standalone profiles (or profiles overriding everything) are their own frame - no copy needed
+    if (profile->parentName.empty() || (profile->overrideMask & PROFILE_FIELD_ALL) == PROFILE_FIELD_ALL) {
+        return profile;
+    }
+
+    // Unordered map nodes are stable, so this reference survives inserts made while resolving parents
+    ResolvedProfileFrame& entry = resolvedProfileCache[ToProfileKey(profile->appName)];
+    if (!entry.valid) {
+        entry.frame = *profile;
+
+        AppColorProfile* parent = FindProfileByNameInternal(profile->parentName);
+        if (parent && parent != profile && depth < MAX_PROFILE_INHERITANCE_DEPTH) {
+            AppColorProfile* parentFrame = ResolveProfileAtDepthInternal(parent, depth + 1);
+            InheritFieldsFromParent(entry.frame, *parentFrame, profile->overrideMask);
+        }
+#ifdef ENABLE_DEBUG_LOGGING
+        else {
+            std::wstringstream debugMsg;
+            debugMsg << L"[DEBUG] Parent profile '" << profile->parentName << L"' of " << profile->appName
+                     << L" not available - using the profile's own values\n";
+            OutputDebugStringW(debugMsg.str().c_str());
+        }
+#endif
+        entry.valid = true;
+
+#ifdef ENABLE_DEBUG_LOGGING
+        std::wstringstream debugMsg;
+        debugMsg << L"[DEBUG] Flattened profile " << profile->appName << L" (parent: " << profile->parentName
+                 << L", overrideMask: 0x" << std::hex << profile->overrideMask << L")\n";
+        OutputDebugStringW(debugMsg.str().c_str());
+#endif
+    }
+
+    // Runtime state always comes from the stored profile; only touch the cached frame when it is stale
+    if (entry.frame.isAppRunning != profile->isAppRunning) {
+        entry.frame.isAppRunning = profile->isAppRunning;
+    }
+    if (entry.frame.isProfileCurrInUse != profile->isProfileCurrInUse) {
+        entry.frame.isProfileCurrInUse = profile->isProfileCurrInUse;
+    }
+    return &entry.frame;
+}
+
+// Get the flattened frame of a profile (INTERNAL - NO LOCK)
+AppColorProfile* ResolveProfileInternal(AppColorProfile* profile) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+    return ResolveProfileAtDepthInternal(profile, 0);
+}
+
+// Invalidate the cached frame of a profile and of every profile inheriting from it (INTERNAL - NO LOCK)
+void InvalidateResolvedProfileInternal(const std::wstring& appName) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    std::vector<std::wstring> pending = { ToProfileKey(appName) };
+    std::unordered_set<std::wstring> visited;
+
+    while (!pending.empty()) {
+        std::wstring key = pending.back();
+        pending.pop_back();
+        if (!visited.insert(key).second) {
+            continue; // Already invalidated (guards against broken chains)
+        }
+
+        auto cached = resolvedProfileCache.find(key);
+        if (cached != resolvedProfileCache.end()) {
+            cached->second.valid = false;
+        }
+
+        auto children = inheritanceChildren.find(key);
+        if (children != inheritanceChildren.end()) {
+            pending.insert(pending.end(), children->second.begin(), children->second.end());
+        }
+    }
+}
+
+// Drop the cached frame of a removed profile (INTERNAL - NO LOCK)
+void RemoveResolvedProfileInternal(const std::wstring& appName) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    // Children fall back to their own values until the parent exists again
+    InvalidateResolvedProfileInternal(appName);
+    resolvedProfileCache.erase(ToProfileKey(appName));
+    RebuildInheritanceIndexInternal();
+}
+
+// Rebuild the parent -> children index from the stored profiles (INTERNAL - NO LOCK)
+void RebuildInheritanceIndexInternal() {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    inheritanceChildren.clear();
+    for (auto& entry : resolvedProfileCache) {
+        entry.second.valid = false;
+    }
+
+    for (const auto& profile : appColorProfiles) {
+        if (!profile->parentName.empty()) {
+            inheritanceChildren[ToProfileKey(profile->parentName)].push_back(ToProfileKey(profile->appName));
+        }
+    }
+}
+
+// Register a profile that was just loaded into memory with its parent (INTERNAL - NO LOCK)
+void LinkProfileToParentInternal(const AppColorProfile& profile) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    if (!profile.parentName.empty()) {
+        auto& children = inheritanceChildren[ToProfileKey(profile.parentName)];
+        std::wstring profileKey = ToProfileKey(profile.appName);
+        if (std::find(children.begin(), children.end(), profileKey) == children.end()) {
+            children.push_back(profileKey);
+        }
+    }
+}
+
+// Check whether a profile is (or inherits from) the named profile (INTERNAL - NO LOCK)
+bool IsProfileInInheritanceChainInternal(const AppColorProfile* profile, const std::wstring& ancestorName) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    std::wstring ancestorKey = ToProfileKey(ancestorName);
+    for (int depth = 0; profile && depth <= MAX_PROFILE_INHERITANCE_DEPTH; ++depth) {
+        if (ToProfileKey(profile->appName) == ancestorKey) {
+            return true;
+        }
+        if (profile->parentName.empty()) {
+            break;
+        }
+        profile = FindProfileByNameInternal(profile->parentName);
+    }
+    return false;
+}
+
+// Check whether making parentName the parent of appName would create a loop or an over-long chain (INTERNAL - NO LOCK)
+bool WouldCreateInheritanceCycleInternal(const std::wstring& appName, const std::wstring& parentName) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    if (parentName.empty()) {
+        return false;
+    }
+
+    std::wstring appKey = ToProfileKey(appName);
+    std::wstring currentName = parentName;
+    for (int depth = 0; depth < MAX_PROFILE_INHERITANCE_DEPTH; ++depth) {
+        if (ToProfileKey(currentName) == appKey) {
+            return true;
+        }
+        AppColorProfile* current = FindProfileByNameInternal(currentName);
+        if (!current || current->parentName.empty()) {
+            return false; // Chain ends (a missing parent is allowed and resolved later)
+        }
+        currentName = current->parentName;
+    }
+    return true; // Chain too deep
+}
+
+// Attach a profile to a parent template (or detach it with an empty name) (INTERNAL - NO LOCK)
+void SetProfileParentInternal(AppColorProfile& profile, const std::wstring& parentName, DWORD overrideMask) {
+    // Note: This function assumes the appProfilesMutex is already locked by the caller
+
+    std::wstring profileKey = ToProfileKey(profile.appName);
+
+    // Detaching keeps the colors and keys the profile currently shows
+    if (parentName.empty() && !profile.parentName.empty()) {
+        AppColorProfile* frame = ResolveProfileInternal(&profile);
+        if (frame && frame != &profile) {
+            profile.appColor = frame->appColor;
+            profile.appHighlightColor = frame->appHighlightColor;
+            profile.appActionColor = frame->appActionColor;
+            profile.lockKeysEnabled = frame->lockKeysEnabled;
+            profile.highlightKeys = frame->highlightKeys;
+            profile.actionKeys = frame->actionKeys;
+            profile.keyEffect = frame->keyEffect;
+            profile.modifierLayer = frame->modifierLayer;
+            profile.appModifierColor = frame->appModifierColor;
+        }
+    }
+
+    // Unlink from the previous parent
+    if (!profile.parentName.empty()) {
+        auto children = inheritanceChildren.find(ToProfileKey(profile.parentName));
+        if (children != inheritanceChildren.end()) {
+            auto& list = children->second;
+            list.erase(std::remove(list.begin(), list.end(), profileKey), list.end());
+        }
+    }
+
+    profile.parentName = parentName;
+    profile.overrideMask = parentName.empty() ? PROFILE_FIELD_ALL : (overrideMask & PROFILE_FIELD_ALL);
+    LinkProfileToParentInternal(profile);
+
+    InvalidateResolvedProfileInternal(profile.appName);
+}
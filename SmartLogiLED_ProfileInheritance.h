@@ -0,0 +1,23 @@
+// SmartLogiLED_ProfileInheritance.h : Header file for layered profile inheritance.
+//
+
+#pragma once
+
+#include "framework.h"
+#include "SmartLogiLED_Types.h"
+#include <string>
+
+// Resolved (flattened) profile frames
+// A standalone profile is its own frame; an inheriting profile is flattened lazily along
+// its parent chain and cached until something in that chain changes.
+// All functions here assume the appProfilesMutex is already locked by the caller.
+AppColorProfile* ResolveProfileInternal(AppColorProfile* profile);
+void InvalidateResolvedProfileInternal(const std::wstring& appName);
+void RemoveResolvedProfileInternal(const std::wstring& appName);
+void RebuildInheritanceIndexInternal();
+void LinkProfileToParentInternal(const AppColorProfile& profile);
+
+// Inheritance chain helpers (INTERNAL - ASSUME MUTEX LOCKED)
+bool IsProfileInInheritanceChainInternal(const AppColorProfile* profile, const std::wstring& ancestorName);
+bool WouldCreateInheritanceCycleInternal(const std::wstring& appName, const std::wstring& parentName);
+void SetProfileParentInternal(AppColorProfile& profile, const std::wstring& parentName, DWORD overrideMask);
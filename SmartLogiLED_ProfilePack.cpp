@@ -0,0 +1,272 @@
+// SmartLogiLED_ProfilePack.cpp : Contains the read-only profile pack.
+//
+// A pack is one little-endian file, written once and then only memory-mapped:
+//
+//   Header        ProfilePackHeader (magic, version, section offsets, checksum)
+//   Index         One ProfilePackIndexEntry per profile, sorted by name hash
+//   String table  UTF-16 names, null-terminated, back to back (lowercase lookup keys,
+//                 display names and parent names)
+//   Records       One ProfileStoreRecord per profile, as in the profile store
+//
+// Opening a pack checks the header and the index; a lookup hashes the lowercase name,
+// binary-searches the index, compares the key and decodes only the matching record. Nothing
+// else is read, so a pack of any size costs no memory beyond the pages a lookup touches.
+
+#include "SmartLogiLED_ProfilePack.h"
+#include "SmartLogiLED_ProfileRecord.h"
+#include "SmartLogiLED_Platform.h"
+#include "SmartLogiLED_Constants.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <unordered_set>
+
+// File header
+struct ProfilePackHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t profileCount;
+    uint32_t recordSize;
+    uint32_t indexOffset;
+    uint32_t stringTableOffset;
+    uint32_t stringTableSize;       // In bytes
+    uint32_t recordsOffset;
+    uint32_t checksum;              // FNV-1a of the index and the string table
+    uint32_t reserved;
+};
+
+// Index entry (string offsets are in UTF-16 units into the string table)
+struct ProfilePackIndexEntry {
+    uint64_t nameHash;              // FNV-1a of the lowercase name (UTF-16, without the terminator)
+    uint32_t keyOffset;             // Lowercase name
+    uint32_t recordIndex;
+};
+
+static_assert(sizeof(ProfilePackHeader) == 40, "Profile pack header layout changed");
+static_assert(sizeof(ProfilePackIndexEntry) == 16, "Profile pack index layout changed");
+
+// Module-specific variables
+static std::mutex profilePackMutex;
+static MappedFile packFile;
+static const ProfilePackIndexEntry* packIndex = nullptr;
+static const char16_t* packStrings = nullptr;
+static size_t packStringUnits = 0;
+static const uint8_t* packRecords = nullptr;
+static uint32_t packProfileCount = 0;
+
+// ======================================================================
+// ENCODING HELPERS
+// ======================================================================
+
+static uint32_t ComputePackChecksum(const uint8_t* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Hash of a lookup key (units include the terminator, which is not hashed)
+static uint64_t HashPackKey(const std::vector<char16_t>& key) {
+    uint64_t hash = 14695981039346656037ull;
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(key.data());
+    for (size_t i = 0; i < (key.size() - 1) * sizeof(char16_t); ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static std::vector<char16_t> MakePackKey(const std::wstring& appName) {
+    std::vector<char16_t> key;
+    EncodeProfileText(ToLowerStoreName(appName), key);
+    return key;
+}
+
+// Compare a stored key with a lookup key (stored strings are terminated inside the table)
+static bool PackKeyEquals(const char16_t* stored, const std::vector<char16_t>& key) {
+    for (size_t i = 0; i < key.size(); ++i) {
+        if (stored[i] != key[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ======================================================================
+// OPEN PACK
+// ======================================================================
+
+// Forget the open pack (INTERNAL - ASSUMES PACK LOCKED)
+static void ClosePackInternal() {
+    UnmapFile(packFile);
+    packIndex = nullptr;
+    packStrings = nullptr;
+    packStringUnits = 0;
+    packRecords = nullptr;
+    packProfileCount = 0;
+}
+
+bool OpenProfilePack(const std::wstring& filePath) {
+    std::lock_guard<std::mutex> lock(profilePackMutex);
+    ClosePackInternal();
+
+    MappedFile file;
+    if (!MapFileReadOnly(filePath, file)) {
+        return false;
+    }
+
+    // Every section must lie inside the file, in order and aligned for direct reads
+    ProfilePackHeader header{};
+    bool valid = file.size >= sizeof(header);
+    if (valid) {
+        memcpy(&header, file.data, sizeof(header));
+        uint64_t indexEnd = static_cast<uint64_t>(header.indexOffset) + static_cast<uint64_t>(header.profileCount) * sizeof(ProfilePackIndexEntry);
+        uint64_t stringTableEnd = static_cast<uint64_t>(header.stringTableOffset) + header.stringTableSize;
+        uint64_t recordsEnd = static_cast<uint64_t>(header.recordsOffset) + static_cast<uint64_t>(header.profileCount) * sizeof(ProfileStoreRecord);
+        valid = header.magic == PROFILE_PACK_MAGIC && header.version == PROFILE_PACK_VERSION &&
+                header.headerSize == sizeof(ProfilePackHeader) && header.recordSize == sizeof(ProfileStoreRecord) &&
+                header.indexOffset >= sizeof(ProfilePackHeader) && header.indexOffset % 8 == 0 &&
+                header.stringTableOffset >= indexEnd && header.stringTableSize % sizeof(char16_t) == 0 &&
+                header.recordsOffset >= stringTableEnd && header.recordsOffset % 8 == 0 && recordsEnd <= file.size;
+    }
+
+    // The string table ends with a terminator, so every string read from it stops inside it
+    const char16_t* strings = nullptr;
+    size_t stringUnits = 0;
+    if (valid && header.profileCount > 0) {
+        strings = reinterpret_cast<const char16_t*>(file.data + header.stringTableOffset);
+        stringUnits = header.stringTableSize / sizeof(char16_t);
+        valid = stringUnits > 0 && strings[stringUnits - 1] == u'\0' &&
+                ComputePackChecksum(file.data + header.indexOffset, header.stringTableOffset + header.stringTableSize - header.indexOffset) == header.checksum;
+    }
+
+    const ProfilePackIndexEntry* index = valid ? reinterpret_cast<const ProfilePackIndexEntry*>(file.data + header.indexOffset) : nullptr;
+    for (uint32_t i = 0; valid && i < header.profileCount; ++i) {
+        valid = index[i].keyOffset < stringUnits && index[i].recordIndex < header.profileCount;
+    }
+
+    if (!valid) {
+        UnmapFile(file);
+        return false;
+    }
+
+    packFile = file;
+    packIndex = index;
+    packStrings = strings;
+    packStringUnits = stringUnits;
+    packRecords = file.data + header.recordsOffset;
+    packProfileCount = header.profileCount;
+    return true;
+}
+
+void CloseProfilePack() {
+    std::lock_guard<std::mutex> lock(profilePackMutex);
+    ClosePackInternal();
+}
+
+size_t GetPackedProfileCount() {
+    std::lock_guard<std::mutex> lock(profilePackMutex);
+    return packProfileCount;
+}
+
+bool GetPackedProfile(const std::wstring& appName, StoredProfile& profile) {
+    std::vector<char16_t> key = MakePackKey(appName);
+    uint64_t hash = HashPackKey(key);
+
+    std::lock_guard<std::mutex> lock(profilePackMutex);
+    const ProfilePackIndexEntry* end = packIndex + packProfileCount;
+    const ProfilePackIndexEntry* entry = std::lower_bound(packIndex, end, hash,
+        [](const ProfilePackIndexEntry& candidate, uint64_t value) {
+            return candidate.nameHash < value;
+        });
+    for (; entry != end && entry->nameHash == hash; ++entry) {
+        if (!PackKeyEquals(packStrings + entry->keyOffset, key)) {
+            continue;
+        }
+
+        ProfileStoreRecord record;
+        memcpy(&record, packRecords + static_cast<size_t>(entry->recordIndex) * sizeof(ProfileStoreRecord), sizeof(record));
+        if (record.nameOffset >= packStringUnits || (record.parentOffset != NO_STRING && record.parentOffset >= packStringUnits)) {
+            return false; // Damaged record
+        }
+        profile.appName = DecodeProfileText(packStrings + record.nameOffset);
+        profile.parentName = record.parentOffset != NO_STRING ? DecodeProfileText(packStrings + record.parentOffset) : std::wstring();
+        DecodeProfileRecord(record, profile);
+        return true;
+    }
+    return false;
+}
+
+// ======================================================================
+// WRITE PACK
+// ======================================================================
+
+bool WriteProfilePack(const std::wstring& filePath, const std::vector<StoredProfile>& profiles) {
+    std::vector<ProfilePackIndexEntry> index;
+    std::vector<char16_t> strings;
+    std::vector<ProfileStoreRecord> records;
+    std::unordered_set<std::wstring> packedNames;
+    index.reserve(profiles.size());
+    records.reserve(profiles.size());
+
+    for (const auto& profile : profiles) {
+        std::wstring lowerName = ToLowerStoreName(profile.appName);
+        if (profile.appName.empty() || !packedNames.insert(lowerName).second) {
+            continue;
+        }
+
+        ProfilePackIndexEntry entry{};
+        std::vector<char16_t> key = MakePackKey(profile.appName);
+        entry.nameHash = HashPackKey(key);
+        entry.keyOffset = static_cast<uint32_t>(strings.size());
+        entry.recordIndex = static_cast<uint32_t>(records.size());
+        strings.insert(strings.end(), key.begin(), key.end());
+
+        ProfileStoreRecord record{};
+        EncodeProfileRecord(profile, record);
+        if (lowerName == profile.appName) {
+            record.nameOffset = entry.keyOffset; // Already lowercase - share the key
+        } else {
+            record.nameOffset = static_cast<uint32_t>(strings.size());
+            EncodeProfileText(profile.appName, strings);
+        }
+        record.parentOffset = NO_STRING;
+        if (!profile.parentName.empty()) {
+            record.parentOffset = static_cast<uint32_t>(strings.size());
+            EncodeProfileText(profile.parentName, strings);
+        }
+        index.push_back(entry);
+        records.push_back(record);
+    }
+
+    // Sort by hash, then by key, so equal hashes sit next to each other
+    std::sort(index.begin(), index.end(),
+        [&strings](const ProfilePackIndexEntry& a, const ProfilePackIndexEntry& b) {
+            if (a.nameHash != b.nameHash) {
+                return a.nameHash < b.nameHash;
+            }
+            return std::u16string(&strings[a.keyOffset]) < std::u16string(&strings[b.keyOffset]);
+        });
+
+    ProfilePackHeader header{};
+    header.magic = PROFILE_PACK_MAGIC;
+    header.version = PROFILE_PACK_VERSION;
+    header.headerSize = sizeof(ProfilePackHeader);
+    header.profileCount = static_cast<uint32_t>(records.size());
+    header.recordSize = sizeof(ProfileStoreRecord);
+    header.indexOffset = sizeof(ProfilePackHeader);
+    header.stringTableOffset = header.indexOffset + static_cast<uint32_t>(index.size() * sizeof(ProfilePackIndexEntry));
+    header.stringTableSize = static_cast<uint32_t>(strings.size() * sizeof(char16_t));
+    header.recordsOffset = (header.stringTableOffset + header.stringTableSize + 7) & ~7u; // 8-byte aligned records
+
+    std::vector<uint8_t> image(header.recordsOffset + records.size() * sizeof(ProfileStoreRecord), 0);
+    if (!index.empty()) {
+        memcpy(image.data() + header.indexOffset, index.data(), index.size() * sizeof(ProfilePackIndexEntry));
+        memcpy(image.data() + header.stringTableOffset, strings.data(), header.stringTableSize);
+        memcpy(image.data() + header.recordsOffset, records.data(), records.size() * sizeof(ProfileStoreRecord));
+    }
+    header.checksum = ComputePackChecksum(image.data() + header.indexOffset, header.stringTableOffset + header.stringTableSize - header.indexOffset);
+    memcpy(image.data(), &header, sizeof(header));
+    return WriteFileAtomically(filePath, image.data(), image.size());
+}
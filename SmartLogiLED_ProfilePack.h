@@ -0,0 +1,21 @@
+// SmartLogiLED_ProfilePack.h : Header file for read-only profile packs.
+//
+// A profile pack is one file holding a whole library of profiles, built from a folder of
+// profile INI files (see Tools/PackTool). The app maps it read-only and decodes a profile
+// only when one is looked up by name. Like the profile store, packs are portable.
+
+#pragma once
+
+#include "SmartLogiLED_ProfileStore.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Open pack (all functions are thread-safe)
+bool OpenProfilePack(const std::wstring& filePath);    // Map and check the file; false (no pack) if missing or invalid
+void CloseProfilePack();
+size_t GetPackedProfileCount();
+bool GetPackedProfile(const std::wstring& appName, StoredProfile& profile); // Names are matched case-insensitively
+
+// Write a pack file atomically (the first of several profiles with the same name wins)
+bool WriteProfilePack(const std::wstring& filePath, const std::vector<StoredProfile>& profiles);
@@ -0,0 +1,108 @@
+// SmartLogiLED_ProfileRecord.cpp : Contains the record helpers shared by the profile store and profile packs.
+
+#include "SmartLogiLED_ProfileRecord.h"
+#include <cstring>
+#include <cwctype>
+
+static int GetKeyBit(uint32_t key) {
+    if (key < KEY_BIT_G_KEYS) {
+        return static_cast<int>(key);
+    }
+    if (key >= 0xFFF1 && key <= 0xFFF9) {
+        return static_cast<int>(KEY_BIT_G_KEYS + (key - 0xFFF1));
+    }
+    if (key >= 0xFFFF1 && key <= 0xFFFF2) {
+        return static_cast<int>(KEY_BIT_G_LOGO + (key - 0xFFFF1));
+    }
+    return -1; // Not a Logitech key name
+}
+
+static uint32_t GetKeyFromBit(uint32_t bit) {
+    if (bit < KEY_BIT_G_KEYS) {
+        return bit;
+    }
+    if (bit < KEY_BIT_G_LOGO) {
+        return 0xFFF1 + (bit - KEY_BIT_G_KEYS);
+    }
+    return 0xFFFF1 + (bit - KEY_BIT_G_LOGO);
+}
+
+static void EncodeKeyBitset(const std::vector<uint32_t>& keys, uint64_t* bitset) {
+    memset(bitset, 0, KEY_BITSET_WORDS * sizeof(uint64_t));
+    for (uint32_t key : keys) {
+        int bit = GetKeyBit(key);
+        if (bit >= 0) {
+            bitset[bit / 64] |= 1ULL << (bit % 64);
+        }
+    }
+}
+
+static void DecodeKeyBitset(const uint64_t* bitset, std::vector<uint32_t>& keys) {
+    keys.clear();
+    for (uint32_t bit = 0; bit < KEY_BIT_COUNT; ++bit) {
+        if (bitset[bit / 64] & (1ULL << (bit % 64))) {
+            keys.push_back(GetKeyFromBit(bit));
+        }
+    }
+}
+
+void EncodeProfileRecord(const StoredProfile& profile, ProfileStoreRecord& record) {
+    record.appColor = profile.appColor;
+    record.highlightColor = profile.highlightColor;
+    record.actionColor = profile.actionColor;
+    record.overrideMask = profile.overrideMask;
+    record.flags = profile.lockKeysEnabled ? RECORD_FLAG_LOCK_KEYS_ENABLED : 0;
+    record.flags |= (profile.keyEffect << RECORD_FLAG_KEY_EFFECT_SHIFT) & RECORD_FLAG_KEY_EFFECT_MASK;
+    record.flags |= (profile.modifierLayer << RECORD_FLAG_MODIFIER_LAYER_SHIFT) & RECORD_FLAG_MODIFIER_LAYER_MASK;
+    record.modifierColor = profile.modifierLayer != 0 ? profile.modifierColor : 0; // Profiles without a layer keep their old hash
+    EncodeKeyBitset(profile.highlightKeys, record.highlightKeys);
+    EncodeKeyBitset(profile.actionKeys, record.actionKeys);
+}
+
+void DecodeProfileRecord(const ProfileStoreRecord& record, StoredProfile& profile) {
+    profile.appColor = record.appColor;
+    profile.highlightColor = record.highlightColor;
+    profile.actionColor = record.actionColor;
+    profile.overrideMask = record.overrideMask;
+    profile.lockKeysEnabled = (record.flags & RECORD_FLAG_LOCK_KEYS_ENABLED) != 0;
+    profile.keyEffect = (record.flags & RECORD_FLAG_KEY_EFFECT_MASK) >> RECORD_FLAG_KEY_EFFECT_SHIFT;
+    profile.modifierLayer = (record.flags & RECORD_FLAG_MODIFIER_LAYER_MASK) >> RECORD_FLAG_MODIFIER_LAYER_SHIFT;
+    profile.modifierColor = profile.modifierLayer != 0 ? record.modifierColor : StoredProfile().modifierColor;
+    DecodeKeyBitset(record.highlightKeys, profile.highlightKeys);
+    DecodeKeyBitset(record.actionKeys, profile.actionKeys);
+}
+
+// Append text as null-terminated UTF-16
+void EncodeProfileText(const std::wstring& text, std::vector<char16_t>& units) {
+    for (wchar_t wch : text) {
+        uint32_t cp = static_cast<uint32_t>(wch);
+        if (cp >= 0x10000 && cp <= 0x10FFFF) {
+            cp -= 0x10000;
+            units.push_back(static_cast<char16_t>(0xD800 + (cp >> 10)));
+            units.push_back(static_cast<char16_t>(0xDC00 + (cp & 0x3FF)));
+        } else {
+            units.push_back(static_cast<char16_t>(cp));
+        }
+    }
+    units.push_back(u'\0');
+}
+
+std::wstring DecodeProfileText(const char16_t* units) {
+    std::wstring text;
+    for (const char16_t* unit = units; *unit; ++unit) {
+        uint32_t cp = *unit;
+        if (sizeof(wchar_t) > 2 && cp >= 0xD800 && cp < 0xDC00 && unit[1] >= 0xDC00 && unit[1] < 0xE000) {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (*++unit - 0xDC00);
+        }
+        text.push_back(static_cast<wchar_t>(cp));
+    }
+    return text;
+}
+
+std::wstring ToLowerStoreName(const std::wstring& name) {
+    std::wstring lower = name;
+    for (auto& ch : lower) {
+        ch = static_cast<wchar_t>(std::towlower(ch));
+    }
+    return lower;
+}
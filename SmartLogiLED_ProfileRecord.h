@@ -0,0 +1,49 @@
+// SmartLogiLED_ProfileRecord.h : Header file for the fixed-size profile record.
+//
+// The binary profile store and profile packs share this record layout and its helpers.
+// Like the store, the record is portable (no Win32 types).
+
+#pragma once
+
+#include "SmartLogiLED_ProfileStore.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Key bitsets: scan codes 0x000-0x1FF, then G_1-G_9, then G_LOGO and G_BADGE
+static const uint32_t KEY_BIT_G_KEYS = 0x200;
+static const uint32_t KEY_BIT_G_LOGO = 0x209;
+static const uint32_t KEY_BIT_COUNT = 0x20B;
+static const uint32_t KEY_BITSET_WORDS = (KEY_BIT_COUNT + 63) / 64;
+
+static const uint32_t NO_STRING = 0xFFFFFFFF;
+static const uint32_t RECORD_FLAG_LOCK_KEYS_ENABLED = 0x0001;
+static const uint32_t RECORD_FLAG_KEY_EFFECT_SHIFT = 8;      // Bits 8-11: KEY_EFFECT_* (0 in files written before key effects)
+static const uint32_t RECORD_FLAG_KEY_EFFECT_MASK = 0x0F00;
+static const uint32_t RECORD_FLAG_MODIFIER_LAYER_SHIFT = 16; // Bits 16-21: MODIFIER_LAYER_* (0 in files written before modifier layers)
+static const uint32_t RECORD_FLAG_MODIFIER_LAYER_MASK = 0x003F0000;
+
+// One stored profile (string offsets are in UTF-16 units into the file's string table)
+struct ProfileStoreRecord {
+    uint32_t nameOffset;
+    uint32_t parentOffset;          // NO_STRING = standalone profile
+    uint32_t appColor;
+    uint32_t highlightColor;
+    uint32_t actionColor;
+    uint32_t overrideMask;
+    uint32_t flags;
+    uint32_t modifierColor;         // Only written with a modifier layer (0 in older files)
+    uint64_t highlightKeys[KEY_BITSET_WORDS];
+    uint64_t actionKeys[KEY_BITSET_WORDS];
+};
+
+static_assert(sizeof(ProfileStoreRecord) == 176, "Profile store record layout changed");
+
+// Record values <-> stored profile (names and string offsets are left alone)
+void EncodeProfileRecord(const StoredProfile& profile, ProfileStoreRecord& record);
+void DecodeProfileRecord(const ProfileStoreRecord& record, StoredProfile& profile);
+
+// Names as null-terminated UTF-16
+void EncodeProfileText(const std::wstring& text, std::vector<char16_t>& units);
+std::wstring DecodeProfileText(const char16_t* units);
+std::wstring ToLowerStoreName(const std::wstring& name);
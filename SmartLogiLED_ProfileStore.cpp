@@ -0,0 +1,768 @@
+// SmartLogiLED_ProfileStore.cpp : Contains the binary profile store.
+//
+// All profiles live in one versioned file (little-endian):
+//
+//   Header        ProfileStoreHeader (magic, version, section offsets, checksum, journal fold point)
+//   String table  UTF-16 names, null-terminated, back to back
+//   Records       One fixed-size ProfileStoreRecord per profile (colors, flags, key bitsets)
+//
+// The file is memory-mapped and parsed in one pass when the store is opened, and replaced
+// as a whole (temp file + rename) on commit. In memory the store keeps the same compact
+// layout, so a profile costs its record plus its name until it is materialized.
+//
+// Edits between commits are queued in memory and appended to a journal next to the store
+// file by the next sync or commit (never while the store lock is held), one checksummed
+// record per put or remove:
+//
+//   ProfileJournalFileHeader   Once per file (magic, version, checksum of the store file it extends)
+//   ProfileJournalRecordHeader (magic, sequence, operation, size, CRC-32)
+//   ProfileStoreRecord         Put only (string offsets unused)
+//   Name, parent               UTF-16, null-terminated, padded to 8 bytes
+//
+// Opening the store replays the journal up to the first torn or corrupt record. A commit
+// (compaction) writes the store file and restarts the journal, stamped with the new file's
+// checksum. A commit that keeps the journal (see below) records the journal's stamp and the
+// next sequence in the store header instead, so only the records after it are replayed.
+// A journal that matches neither is refused: its records were made against another store
+// file (a restored or replaced one), and replaying them could bring back removed profiles
+// or undo newer edits.
+//
+// Every commit also leaves a backup copy of the store file. The journal is only restarted
+// once both copies are written, so backup plus journal always hold every edit and a
+// damaged store file can be rebuilt from them.
+
+#include "SmartLogiLED_ProfileStore.h"
+#include "SmartLogiLED_ProfileRecord.h"
+#include "SmartLogiLED_Platform.h"
+#include "SmartLogiLED_Constants.h"
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+// File header
+struct ProfileStoreHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t recordCount;
+    uint32_t recordSize;
+    uint32_t stringTableOffset;
+    uint32_t stringTableSize;       // In bytes
+    uint32_t recordsOffset;
+    uint32_t checksum;              // FNV-1a of everything after the header
+    uint32_t journalStamp;          // Version 2: stamp of the journal whose records are folded in up to...
+    uint32_t journalSequence;       // ...this sequence (the first record not contained in the file)
+};
+
+// Journal file header (followed by the records)
+struct ProfileJournalFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t storeChecksum;         // Stamp: checksum of the store file the journal extends
+    uint32_t reserved;
+};
+
+// Journal record header (followed by the operation's payload)
+struct ProfileJournalRecordHeader {
+    uint32_t magic;
+    uint32_t sequence;              // Consecutive - replay stops at a gap
+    uint32_t operation;             // JOURNAL_OPERATION_*
+    uint32_t recordSize;            // In bytes, including this header and the padding
+    uint32_t nameLength;            // UTF-16 units, including the terminator
+    uint32_t parentLength;          // 0 = standalone profile
+    uint32_t checksum;              // CRC-32 of the whole record with this field set to 0
+    uint32_t reserved;
+};
+
+static const uint32_t JOURNAL_OPERATION_PUT = 1;
+static const uint32_t JOURNAL_OPERATION_REMOVE = 2;
+
+static const size_t PROFILE_STORE_HEADER_V1_SIZE = 32;
+
+static_assert(sizeof(ProfileStoreHeader) == 40, "Profile store header layout changed");
+static_assert(sizeof(ProfileJournalFileHeader) == 16, "Profile journal file header layout changed");
+static_assert(sizeof(ProfileJournalRecordHeader) == 32, "Profile journal record layout changed");
+
+// Module-specific variables
+static std::mutex profileStoreMutex;
+static std::mutex profileStoreCommitMutex;                  // Keeps commits in order
+static std::wstring profileStorePath;
+static std::vector<char16_t> storeStrings;                  // String table
+static std::vector<ProfileStoreRecord> storeRecords;
+static std::vector<uint64_t> storeRecordHashes;             // Content hash per record (detects unchanged saves)
+static std::unordered_map<std::wstring, uint32_t> storeRecordByName; // Lowercase name -> record index
+static size_t storeUnusedStringUnits = 0;                   // Text of replaced or removed names
+static bool storeDirty = false;                             // Store file is older than the in-memory store
+
+// Edit journal: records are queued under profileStoreMutex and written to the file only under
+// profileStoreCommitMutex, so puts and removes never wait on the disk
+static AppendOnlyFile journalFile;                          // Written, opened and closed under profileStoreCommitMutex
+static bool journalWritable = false;                        // False = edits wait in memory for the next commit
+static uint32_t journalNextSequence = 0;
+static uint32_t journalStamp = 0;                           // Stamp of the journal file on disk (under profileStoreCommitMutex)
+static bool journalStamped = false;                         // False = no journal file this store extends
+static std::vector<uint8_t> journalPending;                 // Records not written to the journal file yet
+
+// ======================================================================
+// ENCODING HELPERS
+// ======================================================================
+
+static uint32_t ComputeJournalChecksum(const uint8_t* data, size_t size) {
+    static const std::array<uint32_t, 256> crcTable = [] {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+            }
+            table[i] = crc;
+        }
+        return table;
+    }();
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static uint32_t ComputeStoreChecksum(const uint8_t* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Content hash of a profile: everything in its record except the string offsets, plus the name texts
+static const uint64_t PROFILE_HASH_SEED = 14695981039346656037ull;
+
+static uint64_t HashStoreBytes(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static uint64_t HashStoreText(uint64_t hash, const char16_t* text) {
+    for (; *text; ++text) {
+        hash = HashStoreBytes(hash, text, sizeof(char16_t));
+    }
+    return HashStoreBytes(hash, text, sizeof(char16_t)); // Terminator separates name and parent
+}
+
+static uint64_t HashStoreText(uint64_t hash, const std::wstring& text) {
+    for (wchar_t wch : text) {
+        uint32_t cp = static_cast<uint32_t>(wch);
+        if (cp >= 0x10000 && cp <= 0x10FFFF) {
+            cp -= 0x10000;
+            char16_t units[2] = { static_cast<char16_t>(0xD800 + (cp >> 10)), static_cast<char16_t>(0xDC00 + (cp & 0x3FF)) };
+            hash = HashStoreBytes(hash, units, sizeof(units));
+        } else {
+            char16_t unit = static_cast<char16_t>(cp);
+            hash = HashStoreBytes(hash, &unit, sizeof(unit));
+        }
+    }
+    char16_t terminator = u'\0';
+    return HashStoreBytes(hash, &terminator, sizeof(terminator));
+}
+
+static uint64_t HashStoreRecordValues(const ProfileStoreRecord& record) {
+    return HashStoreBytes(PROFILE_HASH_SEED, &record.appColor, sizeof(record) - offsetof(ProfileStoreRecord, appColor));
+}
+
+// Append a name to the string table as UTF-16 (INTERNAL - ASSUMES STORE LOCKED)
+static uint32_t AppendStoreStringInternal(const std::wstring& text) {
+    uint32_t offset = static_cast<uint32_t>(storeStrings.size());
+    EncodeProfileText(text, storeStrings);
+    return offset;
+}
+
+// Read a name from the string table (INTERNAL - ASSUMES STORE LOCKED)
+static std::wstring GetStoreStringInternal(uint32_t offset) {
+    if (offset == NO_STRING) {
+        return std::wstring();
+    }
+    return DecodeProfileText(&storeStrings[offset]);
+}
+
+static size_t GetStoreStringLength(const char16_t* text) {
+    size_t length = 0;
+    while (text[length]) {
+        ++length;
+    }
+    return length;
+}
+
+// Drop all store contents (INTERNAL - ASSUMES STORE LOCKED)
+static void ClearStoreInternal() {
+    storeStrings.clear();
+    storeRecords.clear();
+    storeRecordHashes.clear();
+    storeRecordByName.clear();
+    storeUnusedStringUnits = 0;
+    storeDirty = false;
+}
+
+// ======================================================================
+// FILE FORMAT
+// ======================================================================
+
+// Validate a store file image and load it (INTERNAL - ASSUMES STORE LOCKED)
+static bool ParseStoreImageInternal(const uint8_t* data, size_t size, ProfileStoreHeader& header) {
+    if (size < PROFILE_STORE_HEADER_V1_SIZE) {
+        return false;
+    }
+    header = ProfileStoreHeader{};
+    memcpy(&header, data, PROFILE_STORE_HEADER_V1_SIZE);
+
+    // Newer minor versions may append fields to the header and records; older readers skip them
+    size_t knownHeaderSize = header.version >= 2 ? sizeof(ProfileStoreHeader) : PROFILE_STORE_HEADER_V1_SIZE;
+    if (header.magic != PROFILE_STORE_MAGIC || header.version == 0 || header.version > PROFILE_STORE_VERSION ||
+        header.headerSize < knownHeaderSize || header.headerSize > size || header.recordSize < sizeof(ProfileStoreRecord) ||
+        header.stringTableSize % sizeof(char16_t) != 0) {
+        return false;
+    }
+    memcpy(&header, data, knownHeaderSize);
+    uint64_t stringTableEnd = static_cast<uint64_t>(header.stringTableOffset) + header.stringTableSize;
+    uint64_t recordsEnd = static_cast<uint64_t>(header.recordsOffset) + static_cast<uint64_t>(header.recordCount) * header.recordSize;
+    if (header.stringTableOffset < header.headerSize || stringTableEnd > size ||
+        header.recordsOffset < header.headerSize || recordsEnd > size) {
+        return false;
+    }
+    if (ComputeStoreChecksum(data + header.headerSize, size - header.headerSize) != header.checksum) {
+        return false;
+    }
+
+    // String table (must end with a terminator, so every valid offset names a complete string)
+    size_t stringUnits = header.stringTableSize / sizeof(char16_t);
+    storeStrings.resize(stringUnits);
+    memcpy(storeStrings.data(), data + header.stringTableOffset, header.stringTableSize);
+    if (stringUnits > 0 && storeStrings.back() != u'\0') {
+        return false;
+    }
+
+    // Records
+    storeRecords.resize(header.recordCount);
+    storeRecordHashes.resize(header.recordCount);
+    storeRecordByName.reserve(header.recordCount);
+    size_t usedStringUnits = 0;
+    for (uint32_t i = 0; i < header.recordCount; ++i) {
+        ProfileStoreRecord& record = storeRecords[i];
+        memcpy(&record, data + header.recordsOffset + static_cast<size_t>(i) * header.recordSize, sizeof(record));
+        if (record.nameOffset >= stringUnits || (record.parentOffset != NO_STRING && record.parentOffset >= stringUnits)) {
+            return false;
+        }
+        usedStringUnits += GetStoreStringLength(&storeStrings[record.nameOffset]) + 1;
+        uint64_t hash = HashStoreText(HashStoreRecordValues(record), &storeStrings[record.nameOffset]);
+        if (record.parentOffset != NO_STRING) {
+            usedStringUnits += GetStoreStringLength(&storeStrings[record.parentOffset]) + 1;
+            hash = HashStoreText(hash, &storeStrings[record.parentOffset]);
+        } else {
+            hash = HashStoreText(hash, u"");
+        }
+        storeRecordHashes[i] = hash;
+        storeRecordByName[ToLowerStoreName(GetStoreStringInternal(record.nameOffset))] = i;
+    }
+    storeUnusedStringUnits = stringUnits > usedStringUnits ? stringUnits - usedStringUnits : 0;
+    return true;
+}
+
+// Build the store file image, dropping unused string table text (INTERNAL - ASSUMES BOTH STORE LOCKS HELD)
+static std::vector<uint8_t> SerializeStoreImageInternal() {
+    if (storeUnusedStringUnits > 0) {
+        std::vector<char16_t> usedStrings;
+        usedStrings.swap(storeStrings);
+        storeStrings.reserve(usedStrings.size() - storeUnusedStringUnits);
+        for (auto& record : storeRecords) {
+            uint32_t nameOffset = static_cast<uint32_t>(storeStrings.size());
+            storeStrings.insert(storeStrings.end(), &usedStrings[record.nameOffset],
+                                &usedStrings[record.nameOffset] + GetStoreStringLength(&usedStrings[record.nameOffset]) + 1);
+            record.nameOffset = nameOffset;
+            if (record.parentOffset != NO_STRING) {
+                uint32_t parentOffset = static_cast<uint32_t>(storeStrings.size());
+                storeStrings.insert(storeStrings.end(), &usedStrings[record.parentOffset],
+                                    &usedStrings[record.parentOffset] + GetStoreStringLength(&usedStrings[record.parentOffset]) + 1);
+                record.parentOffset = parentOffset;
+            }
+        }
+        storeUnusedStringUnits = 0;
+    }
+
+    ProfileStoreHeader header{};
+    header.magic = PROFILE_STORE_MAGIC;
+    header.version = PROFILE_STORE_VERSION;
+    header.headerSize = sizeof(ProfileStoreHeader);
+    header.recordCount = static_cast<uint32_t>(storeRecords.size());
+    header.recordSize = sizeof(ProfileStoreRecord);
+    header.stringTableOffset = sizeof(ProfileStoreHeader);
+    header.stringTableSize = static_cast<uint32_t>(storeStrings.size() * sizeof(char16_t));
+    header.recordsOffset = (header.stringTableOffset + header.stringTableSize + 7) & ~7u; // 8-byte aligned records
+
+    std::vector<uint8_t> image(header.recordsOffset + storeRecords.size() * sizeof(ProfileStoreRecord), 0);
+    if (!storeStrings.empty()) {
+        memcpy(image.data() + header.stringTableOffset, storeStrings.data(), header.stringTableSize);
+    }
+    if (!storeRecords.empty()) {
+        memcpy(image.data() + header.recordsOffset, storeRecords.data(), storeRecords.size() * sizeof(ProfileStoreRecord));
+    }
+    header.checksum = ComputeStoreChecksum(image.data() + sizeof(header), image.size() - sizeof(header));
+
+    // Records queued so far are in the image. Without a journal file the image names itself,
+    // so the journal restarted for it is replayed from the same point.
+    header.journalStamp = journalStamped ? journalStamp : header.checksum;
+    header.journalSequence = journalNextSequence;
+    memcpy(image.data(), &header, sizeof(header));
+    return image;
+}
+
+// Add or replace a record with the given values (INTERNAL - ASSUMES STORE LOCKED)
+static bool PutStoreRecordInternal(const ProfileStoreRecord& values, const std::wstring& appName, const std::wstring& parentName) {
+    ProfileStoreRecord record = values;
+    uint64_t hash = HashStoreText(HashStoreText(HashStoreRecordValues(record), appName), parentName);
+
+    std::wstring key = ToLowerStoreName(appName);
+    auto it = storeRecordByName.find(key);
+    if (it != storeRecordByName.end()) {
+        if (storeRecordHashes[it->second] == hash) {
+            return false; // Unchanged - nothing to write
+        }
+        storeRecordHashes[it->second] = hash;
+
+        // Reuse the stored strings when they did not change
+        ProfileStoreRecord& existing = storeRecords[it->second];
+        if (GetStoreStringInternal(existing.nameOffset) == appName) {
+            record.nameOffset = existing.nameOffset;
+        } else {
+            storeUnusedStringUnits += GetStoreStringLength(&storeStrings[existing.nameOffset]) + 1;
+            record.nameOffset = AppendStoreStringInternal(appName);
+        }
+        if (existing.parentOffset != NO_STRING && GetStoreStringInternal(existing.parentOffset) == parentName) {
+            record.parentOffset = existing.parentOffset;
+        } else {
+            if (existing.parentOffset != NO_STRING) {
+                storeUnusedStringUnits += GetStoreStringLength(&storeStrings[existing.parentOffset]) + 1;
+            }
+            record.parentOffset = parentName.empty() ? NO_STRING : AppendStoreStringInternal(parentName);
+        }
+        existing = record;
+    } else {
+        record.nameOffset = AppendStoreStringInternal(appName);
+        record.parentOffset = parentName.empty() ? NO_STRING : AppendStoreStringInternal(parentName);
+        storeRecordByName[key] = static_cast<uint32_t>(storeRecords.size());
+        storeRecords.push_back(record);
+        storeRecordHashes.push_back(hash);
+    }
+    storeDirty = true;
+    return true;
+}
+
+// Remove a record (INTERNAL - ASSUMES STORE LOCKED)
+static bool RemoveStoreRecordInternal(const std::wstring& appName) {
+    auto it = storeRecordByName.find(ToLowerStoreName(appName));
+    if (it == storeRecordByName.end()) {
+        return false;
+    }
+
+    uint32_t index = it->second;
+    const ProfileStoreRecord& removed = storeRecords[index];
+    storeUnusedStringUnits += GetStoreStringLength(&storeStrings[removed.nameOffset]) + 1;
+    if (removed.parentOffset != NO_STRING) {
+        storeUnusedStringUnits += GetStoreStringLength(&storeStrings[removed.parentOffset]) + 1;
+    }
+    storeRecordByName.erase(it);
+
+    // Move the last record into the gap
+    if (index + 1 != storeRecords.size()) {
+        storeRecords[index] = storeRecords.back();
+        storeRecordHashes[index] = storeRecordHashes.back();
+        storeRecordByName[ToLowerStoreName(GetStoreStringInternal(storeRecords[index].nameOffset))] = index;
+    }
+    storeRecords.pop_back();
+    storeRecordHashes.pop_back();
+    storeDirty = true;
+    return true;
+}
+
+// ======================================================================
+// EDIT JOURNAL
+// ======================================================================
+
+// Append one edit to the journal (INTERNAL - ASSUMES STORE LOCKED)
+static void AppendJournalRecordInternal(uint32_t operation, const ProfileStoreRecord* record,
+                                        const std::wstring& appName, const std::wstring& parentName) {
+    if (!journalWritable) {
+        return; // The edit is written with the next commit
+    }
+
+    std::vector<char16_t> names;
+    EncodeProfileText(appName, names);
+    uint32_t nameLength = static_cast<uint32_t>(names.size());
+    if (!parentName.empty()) {
+        EncodeProfileText(parentName, names);
+    }
+
+    ProfileJournalRecordHeader header{};
+    header.magic = PROFILE_JOURNAL_MAGIC;
+    header.sequence = journalNextSequence;
+    header.operation = operation;
+    header.nameLength = nameLength;
+    header.parentLength = static_cast<uint32_t>(names.size()) - nameLength;
+    std::vector<uint8_t> bytes(sizeof(header), 0);
+    if (record) {
+        ProfileStoreRecord values = *record;
+        values.nameOffset = values.parentOffset = 0;
+        const uint8_t* valueBytes = reinterpret_cast<const uint8_t*>(&values);
+        bytes.insert(bytes.end(), valueBytes, valueBytes + sizeof(values));
+    }
+    const uint8_t* nameBytes = reinterpret_cast<const uint8_t*>(names.data());
+    bytes.insert(bytes.end(), nameBytes, nameBytes + names.size() * sizeof(char16_t));
+    bytes.resize((bytes.size() + 7) & ~static_cast<size_t>(7), 0);
+
+    header.recordSize = static_cast<uint32_t>(bytes.size());
+    memcpy(bytes.data(), &header, sizeof(header));
+    header.checksum = ComputeJournalChecksum(bytes.data(), bytes.size());
+    memcpy(bytes.data(), &header, sizeof(header));
+
+    journalPending.insert(journalPending.end(), bytes.begin(), bytes.end());
+    ++journalNextSequence;
+}
+
+// Append the queued records to the journal file (INTERNAL - ASSUMES COMMIT LOCK HELD, STORE LOCK NOT HELD)
+static bool WritePendingJournalRecordsInternal() {
+    std::vector<uint8_t> records;
+    {
+        std::lock_guard<std::mutex> lock(profileStoreMutex);
+        if (!journalWritable) {
+            journalPending.clear(); // Kept by the next commit instead
+            return true;
+        }
+        records.swap(journalPending);
+    }
+    if (records.empty() || AppendToFile(journalFile, records.data(), records.size())) {
+        return true;
+    }
+
+    // A partly written record would hide everything appended after it - stop journaling
+    // until the next commit restarts the journal (the store stays dirty, so nothing is lost)
+    std::lock_guard<std::mutex> lock(profileStoreMutex);
+    journalWritable = false;
+    journalPending.clear();
+    return false;
+}
+
+// Apply the valid records of a journal image, skipping records before firstSequence when the
+// store file already contains them; returns the size of the valid part (INTERNAL - ASSUMES STORE LOCKED)
+static size_t ReplayJournalImageInternal(const uint8_t* data, size_t size, size_t position,
+                                         bool skipFolded, uint32_t firstSequence) {
+    bool firstRecord = true;
+    while (size - position >= sizeof(ProfileJournalRecordHeader)) {
+        ProfileJournalRecordHeader header;
+        memcpy(&header, data + position, sizeof(header));
+
+        // Validate the framing before trusting any length
+        uint64_t namesSize = (static_cast<uint64_t>(header.nameLength) + header.parentLength) * sizeof(char16_t);
+        uint64_t payloadSize = (header.operation == JOURNAL_OPERATION_PUT ? sizeof(ProfileStoreRecord) : 0) + namesSize;
+        if (header.magic != PROFILE_JOURNAL_MAGIC || header.recordSize % 8 != 0 || header.recordSize > size - position ||
+            sizeof(header) + payloadSize > header.recordSize || header.nameLength == 0 ||
+            (header.operation != JOURNAL_OPERATION_PUT && (header.operation != JOURNAL_OPERATION_REMOVE || header.parentLength != 0)) ||
+            (!firstRecord && header.sequence != journalNextSequence)) {
+            break;
+        }
+        std::vector<uint8_t> bytes(data + position, data + position + header.recordSize);
+        memset(bytes.data() + offsetof(ProfileJournalRecordHeader, checksum), 0, sizeof(header.checksum));
+        if (ComputeJournalChecksum(bytes.data(), bytes.size()) != header.checksum) {
+            break;
+        }
+
+        const uint8_t* payload = bytes.data() + sizeof(header);
+        ProfileStoreRecord record{};
+        if (header.operation == JOURNAL_OPERATION_PUT) {
+            memcpy(&record, payload, sizeof(record));
+            payload += sizeof(record);
+        }
+        std::vector<char16_t> names(header.nameLength + header.parentLength);
+        memcpy(names.data(), payload, names.size() * sizeof(char16_t));
+        if (names[header.nameLength - 1] != u'\0' || (header.parentLength > 0 && names.back() != u'\0')) {
+            break;
+        }
+        std::wstring appName = DecodeProfileText(names.data());
+        std::wstring parentName = header.parentLength > 0 ? DecodeProfileText(&names[header.nameLength]) : std::wstring();
+
+        if (skipFolded && static_cast<int32_t>(header.sequence - firstSequence) < 0) {
+            // Folded into the store file by a commit that kept this journal
+        } else if (header.operation == JOURNAL_OPERATION_PUT) {
+            PutStoreRecordInternal(record, appName, parentName);
+        } else {
+            RemoveStoreRecordInternal(appName);
+        }
+        journalNextSequence = header.sequence + 1;
+        firstRecord = false;
+        position += header.recordSize;
+    }
+    return position;
+}
+
+// Replace the journal file with an empty one stamped with the store file it extends and open it
+// for appending (INTERNAL - ASSUMES COMMIT LOCK HELD)
+static bool StartJournalInternal(const std::wstring& journalPath, uint32_t storeChecksum) {
+    ProfileJournalFileHeader header{};
+    header.magic = PROFILE_JOURNAL_FILE_MAGIC;
+    header.version = PROFILE_JOURNAL_VERSION;
+    header.headerSize = sizeof(ProfileJournalFileHeader);
+    header.storeChecksum = storeChecksum;
+    if (!WriteFileAtomically(journalPath, &header, sizeof(header))) {
+        return false; // The old journal file is still in place
+    }
+    journalStamp = storeChecksum;
+    journalStamped = true;
+    return OpenAppendOnlyFile(journalPath, journalFile);
+}
+
+// Replay the journal of the opened store file and continue appending to it (INTERNAL - ASSUMES BOTH STORE LOCKS HELD)
+static void OpenJournalInternal(const std::wstring& journalPath, const ProfileStoreHeader& store) {
+    journalStamped = false;
+    journalNextSequence = store.journalSequence;
+
+    MappedFile file;
+    if (!MapFileReadOnly(journalPath, file)) {
+        journalWritable = StartJournalInternal(journalPath, store.checksum); // No journal yet
+        return;
+    }
+
+    // Only replay a journal that extends this store file
+    ProfileJournalFileHeader header{};
+    if (file.size >= sizeof(header)) {
+        memcpy(&header, file.data, sizeof(header));
+    }
+    bool stamped = header.magic == PROFILE_JOURNAL_FILE_MAGIC && header.version != 0 &&
+                   header.headerSize >= sizeof(header) && header.headerSize % 8 == 0 && header.headerSize <= file.size;
+    bool skipFolded = stamped && store.version >= 2 && header.storeChecksum == store.journalStamp;
+    bool extendsStore = skipFolded || (stamped && header.storeChecksum == store.checksum);
+    bool legacy = !stamped && store.version < 2; // Unstamped journal written with a version 1 store file
+    if (!extendsStore && !legacy) {
+        UnmapFile(file);
+        storeDirty = true; // The next sync commits and restarts the journal for this store file
+        return;
+    }
+
+    size_t recordsOffset = stamped ? header.headerSize : 0;
+    size_t validSize = ReplayJournalImageInternal(file.data, file.size, recordsOffset, skipFolded, store.journalSequence);
+    bool torn = validSize < file.size;
+    std::vector<uint8_t> validPart;
+    if (torn) {
+        validPart.assign(file.data, file.data + validSize);
+    }
+    UnmapFile(file);
+
+    if (legacy) {
+        storeDirty = true; // Appends would go to an unstamped journal - the next sync commits and restarts it
+        return;
+    }
+    journalStamp = header.storeChecksum;
+    journalStamped = true;
+
+    // A journal whose records end before the store file's fold point lost records the file holds;
+    // records appended to it now would be skipped as folded at the next start
+    if (skipFolded && validSize > recordsOffset && static_cast<int32_t>(journalNextSequence - store.journalSequence) < 0) {
+        storeDirty = true;
+        return;
+    }
+    if (validSize == recordsOffset) {
+        journalNextSequence = store.journalSequence; // No records - continue after the fold point
+    }
+
+    // Cut off a torn tail (the app stopped in the middle of an append), so new records follow valid ones
+    if (torn && !WriteFileAtomically(journalPath, validPart.data(), validPart.size())) {
+        return; // Journal stays off - edits are kept by commits only
+    }
+    journalWritable = OpenAppendOnlyFile(journalPath, journalFile);
+}
+
+// Stop journaling (INTERNAL - ASSUMES STORE LOCKED)
+static void CloseJournalInternal() {
+    CloseAppendOnlyFile(journalFile);
+    journalWritable = false;
+    journalPending.clear();
+}
+
+// ======================================================================
+// PUBLIC API
+// ======================================================================
+
+// Load a store image and replay the journal of filePath on top (INTERNAL - ASSUMES BOTH STORE LOCKS HELD)
+static bool OpenStoreImageInternal(const std::wstring& imagePath, const std::wstring& filePath) {
+    CloseJournalInternal();
+    ClearStoreInternal();
+    profileStorePath = filePath;
+
+    MappedFile file;
+    if (!MapFileReadOnly(imagePath, file)) {
+        return false;
+    }
+    ProfileStoreHeader header;
+    bool parsed = ParseStoreImageInternal(file.data, file.size, header);
+    UnmapFile(file); // The store keeps its own copy, so the file can be replaced on commit
+
+    if (!parsed) {
+        ClearStoreInternal();
+        return false;
+    }
+
+    // Edits made after the last commit (replayed edits leave the store dirty, so the next commit folds them in)
+    OpenJournalInternal(filePath + PROFILE_JOURNAL_FILE_SUFFIX, header);
+    return true;
+}
+
+bool OpenProfileStore(const std::wstring& filePath) {
+    std::lock_guard<std::mutex> commitLock(profileStoreCommitMutex);
+    std::lock_guard<std::mutex> lock(profileStoreMutex);
+    return OpenStoreImageInternal(filePath, filePath);
+}
+
+bool RecoverProfileStore(const std::wstring& filePath) {
+    std::lock_guard<std::mutex> commitLock(profileStoreCommitMutex);
+    std::lock_guard<std::mutex> lock(profileStoreMutex);
+    if (!OpenStoreImageInternal(filePath + PROFILE_STORE_BACKUP_SUFFIX, filePath)) {
+        return false;
+    }
+    storeDirty = true; // The next commit replaces the damaged store file
+    return true;
+}
+
+void ResetProfileStore(const std::wstring& filePath) {
+    std::lock_guard<std::mutex> commitLock(profileStoreCommitMutex);
+    std::lock_guard<std::mutex> lock(profileStoreMutex);
+    CloseJournalInternal(); // Restarted by the first commit
+    journalStamped = false; // A journal file left on disk belongs to another store
+    ClearStoreInternal();
+    profileStorePath = filePath;
+    storeDirty = true;
+}
+
+bool CommitProfileStore() {
+    std::lock_guard<std::mutex> commitLock(profileStoreCommitMutex);
+
+    std::vector<uint8_t> image;
+    std::wstring filePath;
+    size_t pendingInImage = 0;
+    {
+        std::lock_guard<std::mutex> lock(profileStoreMutex);
+        if (!storeDirty || profileStorePath.empty()) {
+            return true;
+        }
+        image = SerializeStoreImageInternal();
+        filePath = profileStorePath;
+        storeDirty = false;
+        pendingInImage = journalPending.size();
+    }
+
+    // Write without holding the store lock - readers keep using the in-memory copy and
+    // edits keep being queued for the journal
+    bool written = WriteFileAtomically(filePath, image.data(), image.size());
+    bool backedUp = written && WriteFileAtomically(filePath + PROFILE_STORE_BACKUP_SUFFIX, image.data(), image.size());
+
+    if (!written) {
+        std::lock_guard<std::mutex> lock(profileStoreMutex);
+        storeDirty = true;
+        return false; // Queued records still go to the current journal
+    }
+
+    if (!backedUp) {
+        // The backup is older than the store file - keep the full journal so backup plus
+        // journal still hold every edit (the backup is written again at the next commit)
+        WritePendingJournalRecordsInternal();
+        return true;
+    }
+
+    // The store file contains every record queued before it was serialized - restart the
+    // journal with the records queued while the file was written
+    {
+        std::lock_guard<std::mutex> lock(profileStoreMutex);
+        journalPending.erase(journalPending.begin(), journalPending.begin() + pendingInImage);
+    }
+    uint32_t imageChecksum;
+    memcpy(&imageChecksum, image.data() + offsetof(ProfileStoreHeader, checksum), sizeof(imageChecksum));
+    CloseAppendOnlyFile(journalFile);
+    bool restarted = StartJournalInternal(filePath + PROFILE_JOURNAL_FILE_SUFFIX, imageChecksum);
+    {
+        std::lock_guard<std::mutex> lock(profileStoreMutex);
+        journalWritable = restarted;
+    }
+    WritePendingJournalRecordsInternal();
+    return true;
+}
+
+bool SyncProfileStore() {
+    std::unique_lock<std::mutex> commitLock(profileStoreCommitMutex);
+    bool appended = WritePendingJournalRecordsInternal();
+    bool compactionDue = false;
+    bool journalOpen = false;
+    {
+        std::lock_guard<std::mutex> lock(profileStoreMutex);
+        compactionDue = storeDirty && (!journalWritable || journalFile.size >= PROFILE_JOURNAL_COMPACT_BYTES);
+        journalOpen = journalWritable;
+    }
+    if (!compactionDue) {
+        // The journal file is only touched under the commit lock, so it is flushed without blocking edits
+        return appended && (!journalOpen || FlushAppendOnlyFile(journalFile));
+    }
+    commitLock.unlock();
+    return CommitProfileStore();
+}
+
+std::vector<std::wstring> GetStoredProfileNames() {
+    std::lock_guard<std::mutex> lock(profileStoreMutex);
+    std::vector<std::wstring> names;
+    names.reserve(storeRecords.size());
+    for (const auto& record : storeRecords) {
+        names.push_back(GetStoreStringInternal(record.nameOffset));
+    }
+    return names;
+}
+
+size_t GetStoredProfileCount() {
+    std::lock_guard<std::mutex> lock(profileStoreMutex);
+    return storeRecords.size();
+}
+
+bool GetStoredProfile(const std::wstring& appName, StoredProfile& profile) {
+    std::lock_guard<std::mutex> lock(profileStoreMutex);
+    auto it = storeRecordByName.find(ToLowerStoreName(appName));
+    if (it == storeRecordByName.end()) {
+        return false;
+    }
+
+    const ProfileStoreRecord& record = storeRecords[it->second];
+    profile.appName = GetStoreStringInternal(record.nameOffset);
+    profile.parentName = GetStoreStringInternal(record.parentOffset);
+    DecodeProfileRecord(record, profile);
+    return true;
+}
+
+bool PutStoredProfile(const StoredProfile& profile) {
+    std::lock_guard<std::mutex> lock(profileStoreMutex);
+
+    ProfileStoreRecord record{};
+    EncodeProfileRecord(profile, record);
+
+    if (!PutStoreRecordInternal(record, profile.appName, profile.parentName)) {
+        return false;
+    }
+    AppendJournalRecordInternal(JOURNAL_OPERATION_PUT, &record, profile.appName, profile.parentName);
+    return true;
+}
+
+bool RemoveStoredProfile(const std::wstring& appName) {
+    std::lock_guard<std::mutex> lock(profileStoreMutex);
+    if (!RemoveStoreRecordInternal(appName)) {
+        return false;
+    }
+    AppendJournalRecordInternal(JOURNAL_OPERATION_REMOVE, nullptr, appName, std::wstring());
+    return true;
+}
\ No newline at end of file
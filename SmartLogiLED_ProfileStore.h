@@ -0,0 +1,41 @@
+// SmartLogiLED_ProfileStore.h : Header file for the binary profile store.
+//
+// The store is portable (no Win32 types), so it can be built and benchmarked outside the app.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Stored form of one profile (colors are COLORREF values, keys are LogiLed::KeyName values)
+struct StoredProfile {
+    std::wstring appName;
+    std::wstring parentName;        // Empty = standalone profile
+    uint32_t appColor = 0;
+    uint32_t highlightColor = 0;
+    uint32_t actionColor = 0;
+    uint32_t overrideMask = 0;      // PROFILE_FIELD_*
+    bool lockKeysEnabled = true;
+    uint32_t keyEffect = 0;         // KEY_EFFECT_*
+    uint32_t modifierLayer = 0;     // MODIFIER_LAYER_*
+    uint32_t modifierColor = 0xFFFFFF;
+    std::vector<uint32_t> highlightKeys; // Kept as a bitset - read back in ascending key order
+    std::vector<uint32_t> actionKeys;
+};
+
+// Store file and its edit journal (all functions are thread-safe; puts and removes are queued for the journal,
+// which only SyncProfileStore and CommitProfileStore write to)
+bool OpenProfileStore(const std::wstring& filePath);   // Map and parse the file in one pass; false (empty store) if missing or invalid
+bool RecoverProfileStore(const std::wstring& filePath); // Open the backup of the last commit and replay the journal on top; false if that fails too
+void ResetProfileStore(const std::wstring& filePath);  // Start an empty store that is written to filePath on commit
+bool CommitProfileStore();                             // Write the file atomically if anything changed and restart the journal
+bool SyncProfileStore();                               // Flush the edit journal to disk; commits instead once the journal is due for compaction
+
+// Stored profiles (names are matched case-insensitively)
+std::vector<std::wstring> GetStoredProfileNames();
+size_t GetStoredProfileCount();
+bool GetStoredProfile(const std::wstring& appName, StoredProfile& profile);
+bool PutStoredProfile(const StoredProfile& profile);   // Add or replace; false if the stored content is already identical
+bool RemoveStoredProfile(const std::wstring& appName);
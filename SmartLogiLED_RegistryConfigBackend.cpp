@@ -0,0 +1,112 @@
+// SmartLogiLED_RegistryConfigBackend.cpp : Contains the registry configuration backend.
+//
+
+#include "framework.h"
+#include "SmartLogiLED_ConfigBackend.h"
+#include "SmartLogiLED_Platform.h"
+#include "SmartLogiLED_Constants.h"
+#include <shlobj.h>
+
+// Settings under a key of HKEY_CURRENT_USER (Software\SmartLogiLED for the app)
+class RegistryConfigBackend : public IConfigBackend {
+public:
+    RegistryConfigBackend(const std::wstring& keyPath, const std::wstring& profileStoreDirectory)
+        : keyPath(keyPath), profileStoreDirectory(profileStoreDirectory) {
+    }
+
+    const wchar_t* GetName() const override {
+        return L"Registry";
+    }
+
+    bool ReadNumber(const wchar_t* valueName, uint32_t& value) override {
+        HKEY hKey;
+        if (RegOpenKeyExW(HKEY_CURRENT_USER, keyPath.c_str(), 0, KEY_READ, &hKey) != ERROR_SUCCESS) {
+            return false;
+        }
+        DWORD data = 0;
+        DWORD size = sizeof(data);
+        DWORD type = REG_DWORD;
+        bool found = RegQueryValueExW(hKey, valueName, NULL, &type, reinterpret_cast<LPBYTE>(&data), &size) == ERROR_SUCCESS &&
+                     type == REG_DWORD;
+        RegCloseKey(hKey);
+        if (found) {
+            value = data;
+        }
+        return found;
+    }
+
+    bool WriteNumber(const wchar_t* valueName, uint32_t value) override {
+        HKEY hKey;
+        if (RegCreateKeyExW(HKEY_CURRENT_USER, keyPath.c_str(), 0, NULL,
+                            REG_OPTION_NON_VOLATILE, KEY_WRITE, NULL, &hKey, NULL) != ERROR_SUCCESS) {
+            return false;
+        }
+        DWORD data = value;
+        bool written = RegSetValueExW(hKey, valueName, 0, REG_DWORD,
+                                      reinterpret_cast<const BYTE*>(&data), sizeof(data)) == ERROR_SUCCESS;
+        RegCloseKey(hKey);
+        return written;
+    }
+
+    bool ReadBinary(const wchar_t* valueName, std::vector<uint8_t>& data) override {
+        HKEY hKey;
+        if (RegOpenKeyExW(HKEY_CURRENT_USER, keyPath.c_str(), 0, KEY_READ, &hKey) != ERROR_SUCCESS) {
+            return false;
+        }
+        DWORD type = 0;
+        DWORD dataSize = 0;
+        bool found = RegQueryValueExW(hKey, valueName, NULL, &type, NULL, &dataSize) == ERROR_SUCCESS && type == REG_BINARY;
+        if (found) {
+            data.resize(dataSize);
+            found = dataSize == 0 ||
+                    RegQueryValueExW(hKey, valueName, NULL, &type, data.data(), &dataSize) == ERROR_SUCCESS;
+        }
+        RegCloseKey(hKey);
+        return found;
+    }
+
+    bool WriteBinary(const wchar_t* valueName, const std::vector<uint8_t>& data) override {
+        HKEY hKey;
+        if (RegCreateKeyExW(HKEY_CURRENT_USER, keyPath.c_str(), 0, NULL,
+                            REG_OPTION_NON_VOLATILE, KEY_WRITE, NULL, &hKey, NULL) != ERROR_SUCCESS) {
+            return false;
+        }
+        bool written = RegSetValueExW(hKey, valueName, 0, REG_BINARY,
+                                      data.data(), static_cast<DWORD>(data.size())) == ERROR_SUCCESS;
+        RegCloseKey(hKey);
+        return written;
+    }
+
+    // %LOCALAPPDATA%\SmartLogiLED\Profiles.slp (next to the executable as a fallback) unless a directory was given
+    std::wstring GetProfileStorePath() override {
+        if (!profileStoreDirectory.empty()) {
+            CreateDirectoryIfMissing(profileStoreDirectory);
+            return profileStoreDirectory + L"\\" + PROFILE_STORE_FILE_NAME;
+        }
+
+        wchar_t appDataPath[MAX_PATH] = {0};
+        std::wstring directory;
+        if (SUCCEEDED(SHGetFolderPathW(nullptr, CSIDL_LOCAL_APPDATA, nullptr, 0, appDataPath))) {
+            directory = std::wstring(appDataPath) + L"\\" + PROFILE_STORE_DIRECTORY;
+            if (!CreateDirectoryIfMissing(directory)) {
+                directory.clear();
+            }
+        }
+        if (directory.empty()) {
+            directory = GetApplicationDirectory();
+        }
+        return directory + L"\\" + PROFILE_STORE_FILE_NAME;
+    }
+
+private:
+    std::wstring keyPath;
+    std::wstring profileStoreDirectory;     // Empty = default location
+};
+
+std::unique_ptr<IConfigBackend> CreateRegistryConfigBackend() {
+    return std::unique_ptr<IConfigBackend>(new RegistryConfigBackend(SMARTLOGILED_REGISTRY_ROOT, std::wstring()));
+}
+
+std::unique_ptr<IConfigBackend> CreateRegistryConfigBackend(const std::wstring& keyPath, const std::wstring& profileStoreDirectory) {
+    return std::unique_ptr<IConfigBackend>(new RegistryConfigBackend(keyPath, profileStoreDirectory));
+}
@@ -0,0 +1,67 @@
+// SmartLogiLED_StartupTiming.cpp : Contains the cold start phase timing.
+//
+// The time to the first correct frame (the profile of the running app on the keyboard) is
+// logged on every start, together with the time each startup phase finished.
+
+#include "framework.h"
+#include "SmartLogiLED_StartupTiming.h"
+#include "SmartLogiLED_LatencyTrace.h"
+#include <atomic>
+#include <iomanip>
+#include <sstream>
+
+// Module-specific variables
+static ULONGLONG startupBeginMicros = 0;
+static std::atomic<ULONGLONG> phaseEndMicros[static_cast<size_t>(StartupPhase::Count)];
+
+static const wchar_t* GetStartupPhaseName(StartupPhase phase) {
+    switch (phase) {
+        case StartupPhase::ProfilesLoaded:      return L"profiles loaded";
+        case StartupPhase::ProcessesScanned:    return L"processes scanned";
+        case StartupPhase::RunningAppsResolved: return L"running apps resolved";
+        case StartupPhase::LedInitialized:      return L"LED SDK ready";
+        case StartupPhase::FirstFrame:          return L"first frame";
+        case StartupPhase::Count:               break;
+    }
+    return L"unknown";
+}
+
+static bool IsStartupPhaseDone(StartupPhase phase) {
+    return phaseEndMicros[static_cast<size_t>(phase)].load() != 0;
+}
+
+void BeginStartupTiming() {
+    // Start at the creation of the process, so loader and CRT startup are included
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        startupBeginMicros = TraceClockFromFileTime((static_cast<ULONGLONG>(creationTime.dwHighDateTime) << 32) | creationTime.dwLowDateTime);
+    }
+    if (startupBeginMicros == 0) {
+        startupBeginMicros = ReadTraceClock();
+    }
+}
+
+void MarkStartupPhase(StartupPhase phase) {
+    ULONGLONG expected = 0;
+    phaseEndMicros[static_cast<size_t>(phase)].compare_exchange_strong(expected, ReadTraceClock());
+}
+
+void NotifyStartupFramePushed() {
+    if (IsStartupPhaseDone(StartupPhase::FirstFrame) ||
+        !IsStartupPhaseDone(StartupPhase::LedInitialized) ||
+        !IsStartupPhaseDone(StartupPhase::RunningAppsResolved)) {
+        return;
+    }
+    MarkStartupPhase(StartupPhase::FirstFrame);
+
+    // Logged on every start (not only with ENABLE_DEBUG_LOGGING)
+    std::wstringstream message;
+    message << std::fixed << std::setprecision(1) << L"[STARTUP] First correct frame after "
+            << (phaseEndMicros[static_cast<size_t>(StartupPhase::FirstFrame)] - startupBeginMicros) / 1000.0 << L" ms (";
+    for (size_t i = 0; i < static_cast<size_t>(StartupPhase::FirstFrame); ++i) {
+        message << (i ? L", " : L"") << GetStartupPhaseName(static_cast<StartupPhase>(i)) << L" "
+                << (phaseEndMicros[i] - startupBeginMicros) / 1000.0 << L" ms";
+    }
+    message << L")\n";
+    OutputDebugStringW(message.str().c_str());
+}
@@ -0,0 +1,23 @@
+// SmartLogiLED_StartupTiming.h : Header file for cold start phase timing.
+//
+
+#pragma once
+
+#include "framework.h"
+
+// Cold start phases (phases without a dependency on each other run in parallel)
+enum class StartupPhase {
+    ProfilesLoaded,         // Profile store opened and the profile catalog built
+    ProcessesScanned,       // One snapshot of the running processes taken
+    RunningAppsResolved,    // Running flags of all profiles set from the snapshot
+    LedInitialized,         // Logitech LED SDK ready (after the G HUB wait)
+    FirstFrame,             // First full frame pushed with the above done
+    Count
+};
+
+// Times are measured from the creation of the process
+void BeginStartupTiming();
+void MarkStartupPhase(StartupPhase phase);     // Only the first mark of each phase counts (thread-safe)
+
+// Called after a full frame was pushed to the keyboard - logs the startup timing once the frame is correct
+void NotifyStartupFramePushed();
@@ -3,11 +3,38 @@
 
 #pragma once
 
-#include "framework.h"
+#include "SmartLogiLED_WinTypes.h"
 #include "LogitechLEDLib.h"
 #include <string>
 #include <vector>
 
+// Profile fields that can be inherited from a parent template (bits of AppColorProfile::overrideMask)
+#define PROFILE_FIELD_APP_COLOR         0x0001
+#define PROFILE_FIELD_HIGHLIGHT_COLOR   0x0002
+#define PROFILE_FIELD_ACTION_COLOR      0x0004
+#define PROFILE_FIELD_LOCK_KEYS_ENABLED 0x0008
+#define PROFILE_FIELD_HIGHLIGHT_KEYS    0x0010
+#define PROFILE_FIELD_ACTION_KEYS       0x0020
+#define PROFILE_FIELD_KEY_EFFECT        0x0040
+#define PROFILE_FIELD_MODIFIER_LAYER    0x0080  // modifierLayer and appModifierColor
+#define PROFILE_FIELD_ALL               0x00FF
+
+// Reactive key effects (AppColorProfile::keyEffect)
+#define KEY_EFFECT_NONE     0   // Keys keep the profile colors
+#define KEY_EFFECT_FADE     1   // A pressed key lights up in the highlight color and fades back
+#define KEY_EFFECT_RIPPLE   2   // A ring in the highlight color spreads from the pressed key
+#define KEY_EFFECT_COUNT    3
+
+// Modifier layer (AppColorProfile::modifierLayer): two bits per modifier name the key groups that
+// light up in appModifierColor while the modifier is held
+#define MODIFIER_LAYER_HIGHLIGHT_KEYS   0x1
+#define MODIFIER_LAYER_ACTION_KEYS      0x2
+#define MODIFIER_LAYER_SHIFT            0   // Bit position of each modifier's groups
+#define MODIFIER_LAYER_CTRL             2
+#define MODIFIER_LAYER_ALT              4
+#define MODIFIER_LAYER_ALL              0x3F
+#define MODIFIER_LAYER_GROUPS(layer, modifier) (((layer) >> (modifier)) & 0x3)
+
 // App monitoring structure
 struct AppColorProfile {
     std::wstring appName;       // Application executable name (e.g., L"notepad.exe")
@@ -19,6 +46,12 @@ struct AppColorProfile {
     bool lockKeysEnabled = true;        // Whether lock keys feature is enabled for this profile
     std::vector<LogiLed::KeyName> highlightKeys; // list of keys which use the appHighlightColor
     std::vector<LogiLed::KeyName> actionKeys; // list of keys which use the appActionColor
+    DWORD keyEffect = KEY_EFFECT_NONE;      // Reactive effect on key presses (KEY_EFFECT_*)
+    DWORD modifierLayer = 0;                // Key groups lit while Shift/Ctrl/Alt is held (MODIFIER_LAYER_*)
+    COLORREF appModifierColor = RGB(255, 255, 255); // Color of the modifier layer keys
+    std::wstring parentName;    // Template profile this profile inherits from (empty = standalone profile)
+    DWORD overrideMask = PROFILE_FIELD_ALL; // PROFILE_FIELD_* set on this profile; all other fields come from the parent
+    bool isPackProfile = false;             // Read from the profile pack and not in the profile store (until edited)
 };
 
 // Message data structure for process communication
@@ -33,4 +66,9 @@ struct ProcessMessageData {
 #define WM_APP_STARTED (WM_USER + 102)
 #define WM_APP_STOPPED (WM_USER + 103)
 #define WM_PROCESS_LIST_UPDATE (WM_USER + 104)
-#define WM_SHOW_EXISTING_INSTANCE (WM_USER + 105)
\ No newline at end of file
+#define WM_SHOW_EXISTING_INSTANCE (WM_USER + 105)
+#define WM_APPLY_PROFILE_FRAME (WM_USER + 106)
+#define WM_PROFILE_EXPORT_PROGRESS (WM_USER + 107) // wParam = profiles done, lParam = total
+#define WM_PROFILE_EXPORT_DONE (WM_USER + 108)     // wParam = 1 if errors, lParam = std::wstring* report (freed by the window)
+#define WM_KEY_CAPTURED (WM_USER + 109)            // Key dialogs: wParam = virtual key, lParam = KBDLLHOOKSTRUCT flags
+#define WM_MODIFIER_LAYER_CHANGED (WM_USER + 110)  // Hook worker: a modifier the displayed profile's layer uses went down or up
\ No newline at end of file
@@ -0,0 +1,114 @@
+// SmartLogiLED_Bench.cpp : Contains the command-line benchmark of the storage and keyboard hot paths.
+//
+// Usage: SmartLogiLED_Bench [group...]
+//
+// Runs the application's own code without the LED SDK and without touching the settings
+// (files go to a temporary folder, registry values to a key of their own). Without
+// arguments every group runs:
+// - config: settings and 1k/10k profiles through the file backend (and the registry
+//   backend on Windows): save, load, journaled edits and journal replay
+// - keys: config name -> key, key -> config name and virtual key -> key lookups, against
+//   the wide string comparisons and allocations they replaced
+// - ini: 1k and 10k profile files parsed in memory, with the widen-and-getline parser the
+//   import used before, and mapped from a folder like an import
+// - heatmap: key events counted by the hook side, alone and while the frame timer
+//   aggregates, and heatmap frames (aggregation and gradient) at 1000 keys/s
+// - effects: fade and ripple frames (queue drain, expiry, intensities, blending) at a
+//   sustained 20 keys/s and in bursts of 200 keys/s
+
+#include "SmartLogiLED_Bench.h"
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <system_error>
+
+// Benchmark groups
+struct BenchGroup {
+    const char* name;
+    bool (*run)();
+};
+
+static const BenchGroup benchGroups[] = {
+    { "config", RunConfigBenchmark },
+    { "keys", RunKeyBenchmark },
+    { "ini", RunIniBenchmark },
+    { "heatmap", RunHeatmapBenchmark },
+    { "effects", RunEffectBenchmark },
+};
+
+std::wstring CreateBenchDirectory(const char* name) {
+    std::error_code error;
+    std::filesystem::path directory = std::filesystem::temp_directory_path(error) / "SmartLogiLED_Bench" / name;
+    std::filesystem::remove_all(directory, error);
+    std::filesystem::create_directories(directory, error);
+    return (directory / "").wstring();
+}
+
+void RemoveBenchDirectory(const std::wstring& directory) {
+    std::error_code error;
+    std::filesystem::remove_all(std::filesystem::path(directory), error);
+}
+
+std::vector<DWORD> BuildTypedKeys(size_t count) {
+    static const DWORD otherKeys[] = {
+        VK_SPACE, VK_SPACE, VK_SPACE, VK_RETURN, VK_BACK, VK_TAB, VK_OEM_PERIOD, VK_OEM_COMMA,
+        VK_LSHIFT, VK_LCONTROL, '0', '1', '2', '3', '4', '5', '6', '7', '8', '9'
+    };
+    const size_t otherCount = sizeof(otherKeys) / sizeof(otherKeys[0]);
+
+    std::minstd_rand random(42);
+    std::vector<DWORD> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        size_t pick = random() % (26 * 3 + otherCount);
+        keys.push_back(pick < 26 * 3 ? static_cast<DWORD>('A' + pick % 26) : otherKeys[pick - 26 * 3]);
+    }
+    return keys;
+}
+
+InputKeyEvent MakeKeyEvent(DWORD vkCode, bool keyDown, DWORD time) {
+    InputKeyEvent event;
+    event.vkCode = vkCode;
+    event.keyDown = keyDown;
+    event.time = time;
+    return event;
+}
+
+// Group names are ASCII
+static std::wstring ToBenchText(const char* text) {
+    return std::wstring(text, text + strlen(text));
+}
+
+static void PrintUsage() {
+    fwprintf(stderr, L"Usage: SmartLogiLED_Bench [group...]\nGroups:");
+    for (const BenchGroup& group : benchGroups) {
+        fwprintf(stderr, L" %ls", ToBenchText(group.name).c_str());
+    }
+    fwprintf(stderr, L"\n");
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        bool known = false;
+        for (const BenchGroup& group : benchGroups) {
+            known = known || strcmp(argv[i], group.name) == 0;
+        }
+        if (!known) {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    bool passed = true;
+    for (const BenchGroup& group : benchGroups) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc && !selected; ++i) {
+            selected = strcmp(argv[i], group.name) == 0;
+        }
+        if (selected && !group.run()) {
+            fwprintf(stderr, L"Benchmark group %ls gave wrong results\n", ToBenchText(group.name).c_str());
+            passed = false;
+        }
+    }
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+// SmartLogiLED_Bench.h : Header file for the command-line benchmark.
+//
+// Each benchmark group lives in its own source file and is listed in SmartLogiLED_Bench.cpp.
+
+#pragma once
+
+#include "../../SmartLogiLED_WinTypes.h"
+#include "../../SmartLogiLED_InputSource.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock BenchClock;
+
+inline double GetSecondsSince(BenchClock::time_point start) {
+    return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+// Frame times of one run
+struct BenchFrameTimes {
+    double totalSeconds = 0.0;
+    double maxSeconds = 0.0;
+    size_t frames = 0;
+
+    void Add(double seconds) {
+        totalSeconds += seconds;
+        maxSeconds = (std::max)(maxSeconds, seconds);
+        ++frames;
+    }
+};
+
+inline void PrintFrameTimes(const wchar_t* name, const BenchFrameTimes& times) {
+    wprintf(L"  %-34ls avg %8.2f us, max %8.2f us (%zu frames)\n", name,
+            times.frames ? times.totalSeconds * 1e6 / times.frames : 0.0, times.maxSeconds * 1e6, times.frames);
+}
+
+// Empty temporary folder for one benchmark (with a trailing separator), removed again by RemoveBenchDirectory
+std::wstring CreateBenchDirectory(const char* name);
+void RemoveBenchDirectory(const std::wstring& directory);
+
+// Synthetic typing: virtual keys of ordinary text (letters weighted over digits, space,
+// punctuation and editing keys), always the same sequence
+std::vector<DWORD> BuildTypedKeys(size_t count);
+InputKeyEvent MakeKeyEvent(DWORD vkCode, bool keyDown, DWORD time);
+
+// Benchmark groups; false if the code under test gave wrong results
+bool RunConfigBenchmark();
+bool RunKeyBenchmark();
+bool RunIniBenchmark();
+bool RunHeatmapBenchmark();
+bool RunEffectBenchmark();
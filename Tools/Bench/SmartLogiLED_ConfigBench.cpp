@@ -0,0 +1,161 @@
+// SmartLogiLED_ConfigBench.cpp : Contains the configuration backend benchmark.
+//
+// For each backend and for 1k and 10k profiles:
+// - Save: put every profile into an empty store and commit it to the backend's store file
+// - Load: open the store file and read every profile back
+// - Edit: change 10% of the profiles, each followed by a journal sync (as the persistence worker does)
+// - Replay: open the store file again with those edits in the journal
+// - Settings: write and read a number and the activation history blob
+//
+// Both backends keep profiles in the binary profile store; they differ in where the store
+// file lives and in how the settings are kept (see SmartLogiLED_ConfigBackend.h).
+
+#include "SmartLogiLED_Bench.h"
+#include "../../SmartLogiLED_ConfigBackend.h"
+#include "../../SmartLogiLED_ProfileStore.h"
+#include "../../SmartLogiLED_Constants.h"
+#include <memory>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#define BENCH_REGISTRY_KEY L"Software\\SmartLogiLED_Bench"
+#endif
+
+#define BENCH_EDIT_PERCENT 10
+#define BENCH_SETTINGS_ROUNDS 200
+#define BENCH_HISTORY_BYTES 256
+
+// Profile as the dialogs create them: colors, lock keys setting, a few highlight and action keys
+static StoredProfile BuildBenchProfile(size_t index) {
+    static const uint32_t highlightChoices[] = { 0x11, 0x1E, 0x1F, 0x20, 0x3B, 0x3F, 0x43, 0x44, 0x39, 0x1C, 0x11C, 0x148 };
+    const size_t choiceCount = sizeof(highlightChoices) / sizeof(highlightChoices[0]);
+
+    StoredProfile profile;
+    profile.appName = L"benchapp" + std::to_wstring(index) + L".exe";
+    profile.appColor = static_cast<uint32_t>((index * 7 % 256) | (index * 13 % 256) << 8 | (index * 29 % 256) << 16);
+    profile.highlightColor = 0x0000FF;
+    profile.actionColor = 0x00FFFF;
+    profile.lockKeysEnabled = (index % 3) != 0;
+    profile.keyEffect = static_cast<uint32_t>(index % 3);
+    for (size_t k = 0; k < 1 + index % 6; ++k) {
+        profile.highlightKeys.push_back(highlightChoices[(index + k) % choiceCount]);
+    }
+    profile.actionKeys.push_back(0x01); // ESC
+    if (index % 10 == 9) {
+        profile.parentName = L"benchapp" + std::to_wstring(index - 1) + L".exe";
+    }
+    return profile;
+}
+
+static bool RunProfileStoreBenchmark(IConfigBackend& backend, size_t profileCount) {
+    std::vector<StoredProfile> profiles;
+    profiles.reserve(profileCount);
+    for (size_t i = 0; i < profileCount; ++i) {
+        profiles.push_back(BuildBenchProfile(i));
+    }
+    std::wstring storePath = backend.GetProfileStorePath();
+
+    // Save: every profile into an empty store, then one commit
+    BenchClock::time_point start = BenchClock::now();
+    ResetProfileStore(storePath);
+    for (const auto& profile : profiles) {
+        PutStoredProfile(profile);
+    }
+    bool committed = CommitProfileStore();
+    double saveSeconds = GetSecondsSince(start);
+
+    // Load: map and parse the file, then read every profile
+    size_t loadedCount = 0;
+    start = BenchClock::now();
+    bool opened = OpenProfileStore(storePath);
+    for (const auto& appName : GetStoredProfileNames()) {
+        StoredProfile profile;
+        loadedCount += GetStoredProfile(appName, profile) ? 1 : 0;
+    }
+    double loadSeconds = GetSecondsSince(start);
+
+    // Edit: one journaled put per changed profile, synced like a quiet period in the app
+    size_t editCount = profileCount * BENCH_EDIT_PERCENT / 100;
+    bool synced = true;
+    start = BenchClock::now();
+    for (size_t i = 0; i < editCount; ++i) {
+        StoredProfile profile = profiles[i * profileCount / editCount];
+        profile.appColor ^= 0xFFFFFF;
+        PutStoredProfile(profile);
+        synced = SyncProfileStore() && synced;
+    }
+    double editSeconds = GetSecondsSince(start);
+
+    // Replay: the edits are only in the journal until the next commit
+    start = BenchClock::now();
+    bool reopened = OpenProfileStore(storePath);
+    double replaySeconds = GetSecondsSince(start);
+    StoredProfile edited;
+    bool replayed = GetStoredProfile(profiles[0].appName, edited) && edited.appColor == (profiles[0].appColor ^ 0xFFFFFF);
+
+    wprintf(L"  %-34ls %8.2f ms, %10.0f profiles/s\n", L"Save (put + commit)", saveSeconds * 1e3, profileCount / saveSeconds);
+    wprintf(L"  %-34ls %8.2f ms, %10.0f profiles/s\n", L"Load (open + get)", loadSeconds * 1e3, profileCount / loadSeconds);
+    wprintf(L"  %-34ls %8.2f us per edit (%zu edits)\n", L"Edit (put + journal sync)", editSeconds * 1e6 / editCount, editCount);
+    wprintf(L"  %-34ls %8.2f ms\n", L"Open with journal replay", replaySeconds * 1e3);
+    return committed && opened && loadedCount == profileCount && synced && reopened && replayed &&
+           GetStoredProfileCount() == profileCount;
+}
+
+static bool RunSettingsBenchmark(IConfigBackend& backend) {
+    std::vector<uint8_t> history(BENCH_HISTORY_BYTES);
+    for (size_t i = 0; i < history.size(); ++i) {
+        history[i] = static_cast<uint8_t>(i * 31);
+    }
+
+    bool written = true;
+    BenchClock::time_point start = BenchClock::now();
+    for (uint32_t i = 0; i < BENCH_SETTINGS_ROUNDS; ++i) {
+        written = backend.WriteNumber(REGISTRY_VALUE_START_MINIMIZED, i & 1) && written;
+        written = backend.WriteBinary(REGISTRY_VALUE_ACTIVATION_HISTORY, history) && written;
+    }
+    double writeSeconds = GetSecondsSince(start);
+
+    bool read = true;
+    start = BenchClock::now();
+    for (uint32_t i = 0; i < BENCH_SETTINGS_ROUNDS; ++i) {
+        uint32_t value = 0;
+        std::vector<uint8_t> data;
+        read = backend.ReadNumber(REGISTRY_VALUE_START_MINIMIZED, value) && backend.ReadBinary(REGISTRY_VALUE_ACTIVATION_HISTORY, data) &&
+               data == history && read;
+    }
+    double readSeconds = GetSecondsSince(start);
+
+    wprintf(L"  %-34ls %8.2f us write, %8.2f us read (number + %d byte blob)\n", L"Settings",
+            writeSeconds * 1e6 / BENCH_SETTINGS_ROUNDS, readSeconds * 1e6 / BENCH_SETTINGS_ROUNDS, BENCH_HISTORY_BYTES);
+    return written && read;
+}
+
+static bool RunBackendBenchmark(IConfigBackend& backend) {
+    bool passed = true;
+    for (size_t profileCount : { static_cast<size_t>(1000), static_cast<size_t>(10000) }) {
+        wprintf(L"Config backend %ls (%zu profiles)\n", backend.GetName(), profileCount);
+        passed = RunProfileStoreBenchmark(backend, profileCount) && passed;
+    }
+    wprintf(L"Config backend %ls\n", backend.GetName());
+    return RunSettingsBenchmark(backend) && passed;
+}
+
+bool RunConfigBenchmark() {
+    std::wstring directory = CreateBenchDirectory("Config");
+    bool passed = true;
+    {
+        std::unique_ptr<IConfigBackend> fileBackend = CreateFileConfigBackend(directory + L"File");
+        passed = RunBackendBenchmark(*fileBackend) && passed;
+    }
+#ifdef _WIN32
+    {
+        std::unique_ptr<IConfigBackend> registryBackend = CreateRegistryConfigBackend(BENCH_REGISTRY_KEY, directory + L"Registry");
+        passed = RunBackendBenchmark(*registryBackend) && passed;
+    }
+    RegDeleteTreeW(HKEY_CURRENT_USER, BENCH_REGISTRY_KEY);
+#endif
+    ResetProfileStore(std::wstring()); // Close the journal before the folder is removed
+    RemoveBenchDirectory(directory);
+    return passed;
+}
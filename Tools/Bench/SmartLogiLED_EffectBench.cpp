@@ -0,0 +1,76 @@
+// SmartLogiLED_EffectBench.cpp : Contains the reactive key effect benchmark.
+//
+// Fade and ripple frames (queue drain, expiry, intensities, blending over the profile color)
+// for a sustained 20 keys/s and for bursts of 200 keys/s. Presses are queued at their own
+// times between frames like the hook queues them; keys whose color changed are counted as
+// the ones the application sends to the SDK.
+
+#include "SmartLogiLED_Bench.h"
+#include "../../SmartLogiLED_KeyEffectBuffer.h"
+#include "../../SmartLogiLED_Constants.h"
+#include <vector>
+
+#define BENCH_TYPED_KEYS 10000
+#define BENCH_FRAMES 3000
+
+static void RunKeyEffectFrames(const std::vector<DWORD>& typedKeys, DWORD effect, const wchar_t* name, unsigned keysPerSecond) {
+    ResetKeyEffectIndex();
+    ClearKeyEffectBuffer();
+    ULONGLONG queuedBefore, droppedBefore, replacedBefore;
+    GetKeyEffectBufferStatistics(queuedBefore, droppedBefore, replacedBefore);
+
+    const COLORREF baseColor = RGB(0, 64, 128);
+    float intensities[KEY_EFFECT_LAYOUT_KEYS];
+    COLORREF painted[KEY_EFFECT_LAYOUT_KEYS];
+    std::fill(painted, painted + KEY_EFFECT_LAYOUT_KEYS, baseColor);
+    BenchFrameTimes frameTimes;
+    size_t maxActive = 0;
+    size_t changedKeys = 0;
+    size_t next = 0;
+    DWORD now = 1000;
+    double nextPressTime = now;
+    for (size_t frame = 0; frame < BENCH_FRAMES; ++frame) {
+        // Presses that fell into the last frame interval, queued by the hook at their own times
+        now += KEY_EFFECT_FRAME_INTERVAL_MS;
+        for (; nextPressTime <= now; nextPressTime += 1000.0 / keysPerSecond, next = (next + 1) % typedKeys.size()) {
+            DWORD pressTime = static_cast<DWORD>(nextPressTime);
+            QueueKeyEffectPress(MakeKeyEvent(typedKeys[next], true, pressTime));
+            QueueKeyEffectPress(MakeKeyEvent(typedKeys[next], false, pressTime));
+        }
+
+        BenchClock::time_point start = BenchClock::now();
+        DrainKeyEffectQueue(effect);
+        ExpireKeyEffects(effect, now);
+        ComputeKeyEffectIntensities(effect, now, intensities);
+        for (size_t k = 0; k < KEY_EFFECT_LAYOUT_KEYS; ++k) {
+            COLORREF color = intensities[k] > 0.0f ? BlendKeyEffectColor(baseColor, RGB(255, 255, 255), intensities[k]) : baseColor;
+            if (color != painted[k]) {
+                painted[k] = color; // The application sends this key to the SDK
+                ++changedKeys;
+            }
+        }
+        frameTimes.Add(GetSecondsSince(start));
+        maxActive = (std::max)(maxActive, GetActiveKeyEffectCount());
+    }
+
+    ULONGLONG queued, dropped, replaced;
+    GetKeyEffectBufferStatistics(queued, dropped, replaced);
+    wchar_t label[64];
+    swprintf(label, 64, L"%ls at %u keys/s", name, keysPerSecond);
+    PrintFrameTimes(label, frameTimes);
+    wprintf(L"  %-34ls %zu of %d effects active at most, %.1f keys changed per frame\n", L"", maxActive, KEY_EFFECT_MAX_ACTIVE,
+            static_cast<double>(changedKeys) / BENCH_FRAMES);
+    wprintf(L"  %-34ls %llu presses queued, %llu dropped, %llu effects replaced\n", L"", queued - queuedBefore,
+            dropped - droppedBefore, replaced - replacedBefore);
+}
+
+bool RunEffectBenchmark() {
+    std::vector<DWORD> typedKeys = BuildTypedKeys(BENCH_TYPED_KEYS);
+    wprintf(L"Key effects (%d layout keys, %d ms frames)\n", KEY_EFFECT_LAYOUT_KEYS, KEY_EFFECT_FRAME_INTERVAL_MS);
+    for (unsigned keysPerSecond : { 20u, 200u }) {
+        RunKeyEffectFrames(typedKeys, KEY_EFFECT_FADE, L"Fade", keysPerSecond);
+        RunKeyEffectFrames(typedKeys, KEY_EFFECT_RIPPLE, L"Ripple", keysPerSecond);
+    }
+    ClearKeyEffectBuffer();
+    return true;
+}
@@ -0,0 +1,88 @@
+// SmartLogiLED_HeatmapBench.cpp : Contains the typing heatmap benchmark.
+//
+// - Count: key events through the hook-side counter as fast as they can be counted
+// - Count while aggregating: the same stream on a second thread while the frame timer side
+//   folds the counters in a loop; the heat values must match the single-threaded run
+// - Frames: one frame interval of presses at 1000 keys/s, then aggregation and the gradient,
+//   counting the keys whose color changed (the only ones the application sends to the SDK)
+
+#include "SmartLogiLED_Bench.h"
+#include "../../SmartLogiLED_HeatmapCounters.h"
+#include "../../SmartLogiLED_Constants.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#define BENCH_TYPED_KEYS 100000             // Key presses of the synthetic typing stream
+#define BENCH_HEATMAP_KEYS_PER_SECOND 1000
+#define BENCH_FRAMES 3000
+
+static void CountTypedKeys(const std::vector<DWORD>& typedKeys) {
+    for (DWORD vkCode : typedKeys) {
+        CountHeatmapKeyEvent(MakeKeyEvent(vkCode, true, 0));
+        CountHeatmapKeyEvent(MakeKeyEvent(vkCode, false, 0));
+    }
+}
+
+bool RunHeatmapBenchmark() {
+    std::vector<DWORD> typedKeys = BuildTypedKeys(BENCH_TYPED_KEYS);
+
+    // Hook side alone; aggregating without elapsed time adds the counts without decay
+    ResetHeatmapCounters();
+    BenchClock::time_point start = BenchClock::now();
+    CountTypedKeys(typedKeys);
+    double countSeconds = GetSecondsSince(start);
+    AggregateHeatmapCounts(0.0);
+    std::vector<uint8_t> expectedImage = BuildHeatmapImage(0);
+
+    // Hook side on its own thread while the frame timer side keeps folding the counters
+    ResetHeatmapCounters();
+    std::atomic<bool> counting(true);
+    size_t aggregations = 0;
+    start = BenchClock::now();
+    std::thread producer([&typedKeys, &counting] {
+        CountTypedKeys(typedKeys);
+        counting.store(false, std::memory_order_release);
+    });
+    while (counting.load(std::memory_order_acquire)) {
+        AggregateHeatmapCounts(0.0);
+        ++aggregations;
+    }
+    producer.join();
+    double concurrentSeconds = GetSecondsSince(start);
+    AggregateHeatmapCounts(0.0);
+    bool noLostCounts = BuildHeatmapImage(0) == expectedImage;
+
+    // Frame timer at BENCH_HEATMAP_KEYS_PER_SECOND
+    ResetHeatmapCounters();
+    const size_t pressesPerFrame = BENCH_HEATMAP_KEYS_PER_SECOND * HEATMAP_FRAME_INTERVAL_MS / 1000;
+    COLORREF colors[HEATMAP_MAX_KEYS];
+    COLORREF painted[HEATMAP_MAX_KEYS] = {};
+    BenchFrameTimes frameTimes;
+    size_t changedKeys = 0;
+    size_t next = 0;
+    for (size_t frame = 0; frame < BENCH_FRAMES; ++frame) {
+        for (size_t i = 0; i < pressesPerFrame; ++i, next = (next + 1) % typedKeys.size()) {
+            CountHeatmapKeyEvent(MakeKeyEvent(typedKeys[next], true, 0));
+            CountHeatmapKeyEvent(MakeKeyEvent(typedKeys[next], false, 0));
+        }
+        start = BenchClock::now();
+        AggregateHeatmapCounts(HEATMAP_FRAME_INTERVAL_MS / 1000.0);
+        ComputeHeatmapColors(colors);
+        for (size_t k = 0; k < GetHeatmapKeyCount(); ++k) {
+            if (colors[k] != painted[k]) {
+                painted[k] = colors[k]; // The application sends this key to the SDK
+                ++changedKeys;
+            }
+        }
+        frameTimes.Add(GetSecondsSince(start));
+    }
+
+    wprintf(L"Typing heatmap (%zu keys)\n", GetHeatmapKeyCount());
+    wprintf(L"  %-34ls %8.1f ns per key event\n", L"Count key event (hook)", countSeconds * 1e9 / (typedKeys.size() * 2));
+    wprintf(L"  %-34ls %8.1f ns per key event, %zu aggregations, %ls\n", L"Count while aggregating",
+            concurrentSeconds * 1e9 / (typedKeys.size() * 2), aggregations, noLostCounts ? L"no lost counts" : L"COUNTS LOST");
+    PrintFrameTimes(L"Frame at 1000 keys/s", frameTimes);
+    wprintf(L"  %-34ls %zu keys sent instead of %zu for full frames\n", L"", changedKeys, GetHeatmapKeyCount() * BENCH_FRAMES);
+    return noLostCounts;
+}
@@ -0,0 +1,196 @@
+// SmartLogiLED_IniBench.cpp : Contains the profile INI parsing benchmark.
+//
+// For 1k and 10k generated profile files (as the export writes them):
+// - Parse in memory: the single-pass parser over the UTF-8 bytes
+// - Widen and getline: the approach it replaced (whole file widened, split with wstringstream,
+//   wide substrings per key and value, key names resolved through a wide string compare chain)
+// - Map and parse files: the folder import path, one mapped file per profile
+
+#include "SmartLogiLED_Bench.h"
+#include "../../SmartLogiLED_IniParser.h"
+#include "../../SmartLogiLED_KeyMapping.h"
+#include "../../SmartLogiLED_Platform.h"
+#include "../../SmartLogiLED_Constants.h"
+#include <cwchar>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+// Profile file as the export writes it (section, keys in order), with varying colors and key lists
+static std::string BuildProfileIni(size_t index) {
+    static const LogiLed::KeyName highlightChoices[] = {
+        LogiLed::KeyName::W, LogiLed::KeyName::A, LogiLed::KeyName::S, LogiLed::KeyName::D,
+        LogiLed::KeyName::F1, LogiLed::KeyName::F5, LogiLed::KeyName::F9, LogiLed::KeyName::F10,
+        LogiLed::KeyName::SPACE, LogiLed::KeyName::ENTER, LogiLed::KeyName::NUM_ENTER, LogiLed::KeyName::ARROW_UP
+    };
+    const size_t choiceCount = sizeof(highlightChoices) / sizeof(highlightChoices[0]);
+
+    AppColorProfile profile;
+    profile.appName = L"benchapp" + std::to_wstring(index) + L".exe";
+    profile.appColor = RGB(index * 7 % 256, index * 13 % 256, index * 29 % 256);
+    profile.appHighlightColor = RGB(255, index % 256, 0);
+    profile.lockKeysEnabled = (index % 3) != 0;
+    profile.keyEffect = static_cast<DWORD>(index % 3);
+    for (size_t k = 0; k < 1 + index % 6; ++k) {
+        profile.highlightKeys.push_back(highlightChoices[(index + k) % choiceCount]);
+    }
+    profile.actionKeys.push_back(LogiLed::KeyName::ESC);
+
+    std::string content = PROFILE_INI_SECTION "\n";
+    for (int i = 0; i < static_cast<int>(ProfileIniKey::Count); ++i) {
+        ProfileIniKey key = static_cast<ProfileIniKey>(i);
+        if (ShouldWriteProfileIniKey(profile, key)) {
+            AppendProfileIniLine(content, profile, key);
+        }
+    }
+    content += "\n; SmartLogiLED Profile Export\n";
+    return content;
+}
+
+typedef std::vector<std::pair<std::wstring, LogiLed::KeyName>> BenchKeyNameChain;
+
+static void TrimWide(std::wstring& text, const wchar_t* whitespace) {
+    text.erase(0, text.find_first_not_of(whitespace));
+    text.erase(text.find_last_not_of(whitespace) + 1);
+}
+
+static void ParseWideKeyList(const std::wstring& value, const BenchKeyNameChain& keyNames, std::vector<LogiLed::KeyName>& keys) {
+    std::wstringstream keyStream(value);
+    std::wstring keyName;
+    while (std::getline(keyStream, keyName, L',')) {
+        TrimWide(keyName, L" \t");
+        for (const auto& entry : keyNames) {
+            if (keyName == entry.first) {
+                keys.push_back(entry.second);
+                break;
+            }
+        }
+    }
+}
+
+// The replaced import parser, reduced to the fields the generated files contain
+static bool ParseProfileIniWide(const std::string& text, const BenchKeyNameChain& keyNames, AppColorProfile& profile) {
+    std::wstringstream ss(Utf8ToWide(text));
+    std::wstring line;
+    bool inProfileSection = false;
+    bool valid = false;
+    while (std::getline(ss, line)) {
+        TrimWide(line, L" \t\r\n");
+        if (line.empty() || line[0] == L';') {
+            continue;
+        }
+        if (line[0] == L'[') {
+            inProfileSection = line == L"[SmartLogiLED Profile]";
+            continue;
+        }
+        size_t equalPos = line.find(L'=');
+        if (!inProfileSection || equalPos == std::wstring::npos) {
+            continue;
+        }
+        std::wstring key = line.substr(0, equalPos);
+        std::wstring value = line.substr(equalPos + 1);
+        TrimWide(key, L" \t");
+        TrimWide(value, L" \t");
+        if (key == L"AppName") {
+            profile.appName = value;
+            valid = true;
+        } else if (key == L"AppColor") {
+            profile.appColor = static_cast<COLORREF>(std::wcstoul(value.c_str(), nullptr, 16));
+        } else if (key == L"AppHighlightColor") {
+            profile.appHighlightColor = static_cast<COLORREF>(std::wcstoul(value.c_str(), nullptr, 16));
+        } else if (key == L"AppActionColor") {
+            profile.appActionColor = static_cast<COLORREF>(std::wcstoul(value.c_str(), nullptr, 16));
+        } else if (key == L"LockKeysEnabled") {
+            profile.lockKeysEnabled = value == L"1";
+        } else if (key == L"HighlightKeys") {
+            ParseWideKeyList(value, keyNames, profile.highlightKeys);
+        } else if (key == L"ActionKeys") {
+            ParseWideKeyList(value, keyNames, profile.actionKeys);
+        } else if (key == L"KeyEffect") {
+            profile.keyEffect = static_cast<DWORD>(std::wcstoul(value.c_str(), nullptr, 10));
+        }
+    }
+    return valid;
+}
+
+static bool RunIniFileBenchmark(const std::wstring& directory, size_t profileCount, const BenchKeyNameChain& keyNames) {
+    std::vector<std::string> texts;
+    size_t totalBytes = 0;
+    for (size_t i = 0; i < profileCount; ++i) {
+        texts.push_back(BuildProfileIni(i));
+        totalBytes += texts.back().size();
+    }
+
+    // Parser alone, on text already in memory
+    size_t validCount = 0;
+    size_t keyCount = 0;
+    BenchClock::time_point start = BenchClock::now();
+    for (const auto& text : texts) {
+        AppColorProfile profile;
+        validCount += ParseProfileIni(text, profile).valid ? 1 : 0;
+        keyCount += profile.highlightKeys.size() + profile.actionKeys.size();
+    }
+    double parseSeconds = GetSecondsSince(start);
+
+    size_t wideValidCount = 0;
+    size_t wideKeyCount = 0;
+    start = BenchClock::now();
+    for (const auto& text : texts) {
+        AppColorProfile profile;
+        wideValidCount += ParseProfileIniWide(text, keyNames, profile) ? 1 : 0;
+        wideKeyCount += profile.highlightKeys.size() + profile.actionKeys.size();
+    }
+    double wideSeconds = GetSecondsSince(start);
+
+    // Folder import path: map and parse one file per profile
+    std::vector<std::wstring> filePaths;
+    for (size_t i = 0; i < profileCount; ++i) {
+        filePaths.push_back(directory + L"profile" + std::to_wstring(i) + L".ini");
+        if (!WriteFileAtomically(filePaths.back(), texts[i].data(), texts[i].size())) {
+            fwprintf(stderr, L"Could not write %ls\n", filePaths.back().c_str());
+            return false;
+        }
+    }
+
+    size_t mappedValidCount = 0;
+    start = BenchClock::now();
+    for (const auto& filePath : filePaths) {
+        MappedFile iniFile;
+        if (!MapFileReadOnly(filePath, iniFile)) {
+            continue;
+        }
+        AppColorProfile profile;
+        mappedValidCount += ParseProfileIni(std::string_view(reinterpret_cast<const char*>(iniFile.data), iniFile.size), profile).valid ? 1 : 0;
+        UnmapFile(iniFile);
+    }
+    double mappedSeconds = GetSecondsSince(start);
+
+    double megabytes = totalBytes / (1024.0 * 1024.0);
+    wprintf(L"INI parsing (%zu profiles, %.2f MB)\n", profileCount, megabytes);
+    wprintf(L"  %-34ls %8.1f MB/s, %10.0f profiles/s (%zu valid)\n", L"Parse in memory",
+            megabytes / parseSeconds, profileCount / parseSeconds, validCount);
+    wprintf(L"  %-34ls %8.1f MB/s, %10.0f profiles/s (%zu valid)\n", L"Widen and getline (replaced)",
+            megabytes / wideSeconds, profileCount / wideSeconds, wideValidCount);
+    wprintf(L"  %-34ls %8.1f MB/s, %10.0f profiles/s (%zu valid)\n", L"Map and parse files",
+            megabytes / mappedSeconds, profileCount / mappedSeconds, mappedValidCount);
+    return validCount == profileCount && wideValidCount == profileCount && mappedValidCount == profileCount &&
+           keyCount == wideKeyCount;
+}
+
+bool RunIniBenchmark() {
+    BenchKeyNameChain keyNames; // One comparison per key, like the former if chain
+    for (size_t keyName = 0; keyName < KEYBOARD_HOOK_PRESS_KEY_COUNT; ++keyName) {
+        LogiLed::KeyName key = static_cast<LogiLed::KeyName>(keyName);
+        if (IsLogiLedKeyKnown(key)) {
+            keyNames.emplace_back(LogiLedKeyToDisplayName(key), key);
+        }
+    }
+
+    bool passed = true;
+    for (size_t profileCount : { static_cast<size_t>(1000), static_cast<size_t>(10000) }) {
+        std::wstring directory = CreateBenchDirectory("Ini");
+        passed = RunIniFileBenchmark(directory, profileCount, keyNames) && passed;
+        RemoveBenchDirectory(directory);
+    }
+    return passed;
+}
@@ -0,0 +1,93 @@
+// SmartLogiLED_KeyBench.cpp : Contains the key descriptor lookup benchmark.
+//
+// Times the lookups of the key descriptor table against the approaches they replaced:
+// - Config name -> key: perfect hash over UTF-8 names, against a chain of wide string
+//   comparisons in table order (the former DisplayNameToLogiLedKey)
+// - Key -> name: string view from a direct array, against a freshly allocated wide string
+//   (LogiLedKeyToDisplayName, the former form of every key -> name lookup)
+// - Virtual key -> key: one read from the active layout table
+
+#include "SmartLogiLED_Bench.h"
+#include "../../SmartLogiLED_KeyMapping.h"
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#define BENCH_LOOKUP_ROUNDS 20000
+
+bool RunKeyBenchmark() {
+    std::vector<LogiLed::KeyName> keys;
+    std::vector<std::string_view> names;
+    std::vector<std::wstring> wideNames;
+    std::vector<std::pair<std::wstring, LogiLed::KeyName>> nameChain; // One comparison per key, like the former if chain
+    for (size_t keyName = 0; keyName < KEYBOARD_HOOK_PRESS_KEY_COUNT; ++keyName) {
+        LogiLed::KeyName key = static_cast<LogiLed::KeyName>(keyName);
+        if (IsLogiLedKeyKnown(key)) {
+            keys.push_back(key);
+            names.push_back(LogiLedKeyToConfigName(key));
+            wideNames.push_back(LogiLedKeyToDisplayName(key));
+            nameChain.emplace_back(wideNames.back(), key);
+        }
+    }
+
+    // The checksum keeps the lookups from being optimized away; both sides of each pair must agree
+    size_t checksum = 0;
+    size_t baselineChecksum = 0;
+    BenchClock::time_point start = BenchClock::now();
+    for (size_t round = 0; round < BENCH_LOOKUP_ROUNDS; ++round) {
+        for (std::string_view name : names) {
+            LogiLed::KeyName key;
+            checksum += DisplayNameToLogiLedKey(name, key) ? static_cast<size_t>(key) : 0;
+        }
+    }
+    double nameSeconds = GetSecondsSince(start);
+
+    start = BenchClock::now();
+    for (size_t round = 0; round < BENCH_LOOKUP_ROUNDS; ++round) {
+        for (const std::wstring& name : wideNames) {
+            for (const auto& entry : nameChain) {
+                if (name == entry.first) {
+                    baselineChecksum += static_cast<size_t>(entry.second);
+                    break;
+                }
+            }
+        }
+    }
+    double nameChainSeconds = GetSecondsSince(start);
+
+    start = BenchClock::now();
+    for (size_t round = 0; round < BENCH_LOOKUP_ROUNDS; ++round) {
+        for (LogiLed::KeyName key : keys) {
+            checksum += LogiLedKeyToConfigName(key).size();
+        }
+    }
+    double keySeconds = GetSecondsSince(start);
+
+    start = BenchClock::now();
+    for (size_t round = 0; round < BENCH_LOOKUP_ROUNDS; ++round) {
+        for (LogiLed::KeyName key : keys) {
+            baselineChecksum += LogiLedKeyToDisplayName(key).size();
+        }
+    }
+    double keyAllocatingSeconds = GetSecondsSince(start);
+
+    size_t virtualKeyChecksum = 0;
+    start = BenchClock::now();
+    for (size_t round = 0; round < BENCH_LOOKUP_ROUNDS; ++round) {
+        for (DWORD vkCode = 1; vkCode < 0xFF; ++vkCode) {
+            LogiLed::KeyName key;
+            virtualKeyChecksum += TranslateVirtualKey(vkCode, round & 1 ? INPUT_KEY_FLAG_EXTENDED : 0, key) ? static_cast<size_t>(key) : 0;
+        }
+    }
+    double virtualKeySeconds = GetSecondsSince(start);
+
+    double nameLookups = static_cast<double>(BENCH_LOOKUP_ROUNDS) * names.size();
+    double virtualKeyLookups = static_cast<double>(BENCH_LOOKUP_ROUNDS) * 0xFE;
+    wprintf(L"Key descriptors (%zu keys, checksum %zu)\n", keys.size(), checksum + virtualKeyChecksum);
+    wprintf(L"  %-34ls %8.1f M lookups/s\n", L"Config name -> key (hash)", nameLookups / nameSeconds / 1e6);
+    wprintf(L"  %-34ls %8.1f M lookups/s\n", L"Config name -> key (compare chain)", nameLookups / nameChainSeconds / 1e6);
+    wprintf(L"  %-34ls %8.1f M lookups/s\n", L"Key -> config name (view)", nameLookups / keySeconds / 1e6);
+    wprintf(L"  %-34ls %8.1f M lookups/s\n", L"Key -> display name (wstring)", nameLookups / keyAllocatingSeconds / 1e6);
+    wprintf(L"  %-34ls %8.1f M lookups/s\n", L"Virtual key -> key", virtualKeyLookups / virtualKeySeconds / 1e6);
+    return checksum == baselineChecksum;
+}
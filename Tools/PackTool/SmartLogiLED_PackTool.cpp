@@ -0,0 +1,113 @@
+// SmartLogiLED_PackTool.cpp : Contains the command-line tool that builds a profile pack.
+//
+// Usage: SmartLogiLED_PackTool <ini-folder> <pack-file>
+//
+// Every *.ini file in the folder is parsed like a folder import in the app: files are taken
+// in name order, the first file of an app wins and invalid files are reported and skipped.
+// Copy the pack next to the profile store as Library.slpk to use it in the app.
+
+#include "../../SmartLogiLED_IniParser.h"
+#include "../../SmartLogiLED_ProfilePack.h"
+#include "../../SmartLogiLED_Platform.h"
+#include <algorithm>
+#include <cstdio>
+#include <cwctype>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Profile INI files of a folder, sorted by name
+static std::vector<std::wstring> EnumerateProfileIniFiles(const std::wstring& directory) {
+    std::vector<std::wstring> fileNames;
+    WIN32_FIND_DATAW findData;
+    HANDLE hFind = FindFirstFileW((directory + L"*.ini").c_str(), &findData);
+    if (hFind != INVALID_HANDLE_VALUE) {
+        do {
+            if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+                fileNames.push_back(findData.cFileName);
+            }
+        } while (FindNextFileW(hFind, &findData));
+        FindClose(hFind);
+    }
+    std::sort(fileNames.begin(), fileNames.end(), [](const std::wstring& a, const std::wstring& b) {
+        return _wcsicmp(a.c_str(), b.c_str()) < 0;
+    });
+    return fileNames;
+}
+
+// Stored form of a parsed profile (as the app stores it)
+static StoredProfile ToStoredProfile(const AppColorProfile& profile) {
+    StoredProfile stored;
+    stored.appName = profile.appName;
+    stored.parentName = profile.parentName;
+    stored.appColor = static_cast<uint32_t>(profile.appColor);
+    stored.highlightColor = static_cast<uint32_t>(profile.appHighlightColor);
+    stored.actionColor = static_cast<uint32_t>(profile.appActionColor);
+    stored.overrideMask = profile.parentName.empty() ? PROFILE_FIELD_ALL : profile.overrideMask;
+    stored.lockKeysEnabled = profile.lockKeysEnabled;
+    stored.keyEffect = profile.keyEffect;
+    stored.modifierLayer = profile.modifierLayer;
+    stored.modifierColor = static_cast<uint32_t>(profile.appModifierColor);
+    stored.highlightKeys.assign(profile.highlightKeys.begin(), profile.highlightKeys.end());
+    stored.actionKeys.assign(profile.actionKeys.begin(), profile.actionKeys.end());
+    return stored;
+}
+
+int wmain(int argc, wchar_t* argv[]) {
+    if (argc != 3) {
+        fwprintf(stderr, L"Usage: SmartLogiLED_PackTool <ini-folder> <pack-file>\n");
+        return 2;
+    }
+
+    std::wstring directory = argv[1];
+    if (!directory.empty() && directory.back() != L'\\' && directory.back() != L'/') {
+        directory += L'\\';
+    }
+    std::vector<std::wstring> fileNames = EnumerateProfileIniFiles(directory);
+    if (fileNames.empty()) {
+        fwprintf(stderr, L"No profile INI files found in %ls\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<StoredProfile> profiles;
+    std::unordered_set<std::wstring> packedNames; // Lower-case app names
+    size_t skippedCount = 0;
+    for (const auto& fileName : fileNames) {
+        AppColorProfile profile;
+        ProfileIniParseResult parseResult;
+        MappedFile iniFile;
+        if (MapFileReadOnly(directory + fileName, iniFile)) {
+            parseResult = ParseProfileIni(std::string_view(reinterpret_cast<const char*>(iniFile.data), iniFile.size), profile);
+            UnmapFile(iniFile);
+        } else {
+            parseResult.problems = L"The file could not be read or is empty.\n";
+        }
+
+        if (!parseResult.problems.empty()) {
+            fwprintf(stderr, L"%ls:\n%ls", fileName.c_str(), parseResult.problems.c_str());
+        }
+        if (!parseResult.valid) {
+            ++skippedCount;
+            continue;
+        }
+
+        std::wstring lowerName = profile.appName;
+        std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::towlower);
+        if (!packedNames.insert(lowerName).second) {
+            fwprintf(stderr, L"%ls: %ls is already packed from an earlier file - skipped\n", fileName.c_str(), profile.appName.c_str());
+            ++skippedCount;
+            continue;
+        }
+        if (!profile.parentName.empty()) {
+            profile.overrideMask = parseResult.presentFields; // Only listed fields override the parent
+        }
+        profiles.push_back(ToStoredProfile(profile));
+    }
+
+    if (!WriteProfilePack(argv[2], profiles)) {
+        fwprintf(stderr, L"Could not write %ls\n", argv[2]);
+        return 1;
+    }
+    wprintf(L"Packed %zu profiles from %zu files into %ls (%zu skipped)\n", profiles.size(), fileNames.size(), argv[2], skippedCount);
+    return 0;
+}
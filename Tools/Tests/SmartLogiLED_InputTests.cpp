@@ -0,0 +1,273 @@
+// SmartLogiLED_InputTests.cpp : Contains the tests of the keyboard hook multiplexer and the input sources.
+//
+// The multiplexer tests drive it from a source the test calls directly, with subscribers that
+// record what reaches them inline and on the worker. The evdev test (Linux) feeds the evdev
+// source input_event records through a pipe in place of a keyboard device.
+
+#include "SmartLogiLED_Tests.h"
+#include "../../SmartLogiLED_KeyboardHook.h"
+#include "../../SmartLogiLED_InputSource.h"
+#include "../../SmartLogiLED_Constants.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/input.h>
+#include <unistd.h>
+#endif
+
+#define TEST_EVENT_CAPACITY 64
+#define TEST_WAIT_MS 2000
+
+// Source driven by the test: each event goes to the sink on the calling thread
+class TestInputSource : public IInputEventSource {
+public:
+    const wchar_t* GetName() const override {
+        return L"Test";
+    }
+
+    bool Start(InputKeyEventSink eventSink) override {
+        sink = eventSink;
+        return true;
+    }
+
+    void Stop() override {
+        sink = nullptr;
+    }
+
+    bool IsRunning() const override {
+        return sink != nullptr;
+    }
+
+    void SetKeyCapture(bool enabled) override {
+        capture = enabled;
+    }
+
+    uint32_t ReadLockKeyStates() override {
+        return 0;
+    }
+
+    bool IsKeyDown(uint32_t) override {
+        return false;
+    }
+
+    uint32_t GetSinkTimeoutMs() override {
+        return 0;
+    }
+
+    // True if the multiplexer swallowed the key
+    bool Send(uint32_t vkCode, bool keyDown) {
+        InputKeyEvent event;
+        event.vkCode = vkCode;
+        event.keyDown = keyDown;
+        return sink && sink(event);
+    }
+
+    InputKeyEventSink sink = nullptr;
+    bool capture = false;
+};
+
+// Events seen by the inline handler (on the source's thread)
+static InputKeyEvent inlineEvents[TEST_EVENT_CAPACITY];
+static std::atomic<size_t> inlineEventCount{ 0 };
+
+// Events seen by the worker handlers
+static std::mutex workerEventMutex;
+static std::condition_variable workerEventCondition;
+static std::vector<KeyboardHookEvent> workerEvents;
+
+static void RecordInlineEvent(const InputKeyEvent& keyEvent) {
+    size_t index = inlineEventCount.load(std::memory_order_relaxed);
+    if (index < TEST_EVENT_CAPACITY) {
+        inlineEvents[index] = keyEvent;
+        inlineEventCount.store(index + 1, std::memory_order_release);
+    }
+}
+
+static void RecordWorkerEvent(const KeyboardHookEvent& event) {
+    {
+        std::lock_guard<std::mutex> lock(workerEventMutex);
+        workerEvents.push_back(event);
+    }
+    workerEventCondition.notify_all();
+}
+
+static bool IsLockKey(DWORD vkCode) {
+    return vkCode == VK_CAPITAL || vkCode == VK_NUMLOCK || vkCode == VK_SCROLL;
+}
+
+static void ResetRecordedEvents() {
+    inlineEventCount = 0;
+    std::lock_guard<std::mutex> lock(workerEventMutex);
+    workerEvents.clear();
+}
+
+static bool WaitForInlineEvents(size_t count) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TEST_WAIT_MS);
+    while (inlineEventCount.load(std::memory_order_acquire) < count && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return inlineEventCount.load(std::memory_order_acquire) >= count;
+}
+
+static std::vector<KeyboardHookEvent> WaitForWorkerEvents(size_t count) {
+    std::unique_lock<std::mutex> lock(workerEventMutex);
+    workerEventCondition.wait_for(lock, std::chrono::milliseconds(TEST_WAIT_MS), [count] { return workerEvents.size() >= count; });
+    return workerEvents;
+}
+
+static DWORD GetClientBit(KeyboardHookClient client) {
+    return 1u << static_cast<size_t>(client);
+}
+
+// Inline handlers see every key, worker handlers only the keys they filter for
+static void TestMultiplexerDispatch() {
+    BeginTest("MultiplexerDispatch");
+    TestInputSource* source = new TestInputSource();
+    SetInputEventSource(std::unique_ptr<IInputEventSource>(source));
+    ResetRecordedEvents();
+
+    KeyboardHookSubscriber counter;
+    counter.inlineHandler = RecordInlineEvent;
+    SubscribeKeyboardHook(KeyboardHookClient::Heatmap, counter);
+    KeyboardHookSubscriber lockKeys;
+    lockKeys.wantsKey = IsLockKey;
+    lockKeys.handler = RecordWorkerEvent;
+    lockKeys.keyDownOnly = true;
+    SubscribeKeyboardHook(KeyboardHookClient::LockKeys, lockKeys);
+
+    TEST_CHECK(!IsKeyboardHookInstalled());
+    SetKeyboardHookSubscriberEnabled(KeyboardHookClient::Heatmap, true);
+    SetKeyboardHookSubscriberEnabled(KeyboardHookClient::LockKeys, true);
+    TEST_CHECK(IsKeyboardHookInstalled() && source->IsRunning());
+
+    TEST_CHECK(!source->Send('A', true));
+    TEST_CHECK(!source->Send('A', false));
+    TEST_CHECK(!source->Send(VK_CAPITAL, true));
+    TEST_CHECK(!source->Send(VK_CAPITAL, false));
+
+    TEST_CHECK(inlineEventCount == 4);
+    TEST_CHECK(inlineEvents[0].vkCode == 'A' && inlineEvents[0].keyDown && inlineEvents[0].time != 0); // Stamped on arrival
+    TEST_CHECK(inlineEvents[3].vkCode == VK_CAPITAL && !inlineEvents[3].keyDown);
+    std::vector<KeyboardHookEvent> events = WaitForWorkerEvents(1);
+    TEST_CHECK(events.size() == 1);
+    if (!events.empty()) {
+        TEST_CHECK(events[0].vkCode == VK_CAPITAL && events[0].keyDown);
+        TEST_CHECK(events[0].clients == GetClientBit(KeyboardHookClient::LockKeys));
+        TEST_CHECK(events[0].timeMicros != 0);
+    }
+
+    SetKeyboardHookSubscriberEnabled(KeyboardHookClient::Heatmap, false);
+    TEST_CHECK(IsKeyboardHookInstalled());
+    SetKeyboardHookSubscriberEnabled(KeyboardHookClient::LockKeys, false);
+    TEST_CHECK(!IsKeyboardHookInstalled() && !source->IsRunning());
+}
+
+// A capturing subscriber swallows key downs, and nobody else sees them; key ups pass
+static void TestMultiplexerKeyCapture() {
+    BeginTest("MultiplexerKeyCapture");
+    TestInputSource* source = new TestInputSource();
+    SetInputEventSource(std::unique_ptr<IInputEventSource>(source));
+    ResetRecordedEvents();
+
+    KeyboardHookSubscriber counter;
+    counter.inlineHandler = RecordInlineEvent;
+    SubscribeKeyboardHook(KeyboardHookClient::Heatmap, counter);
+    KeyboardHookSubscriber dialog;
+    dialog.handler = RecordWorkerEvent;
+    dialog.keyDownOnly = true;
+    dialog.swallowKeyDown = true;
+    SubscribeKeyboardHook(KeyboardHookClient::HighlightKeysDialog, dialog);
+
+    SetKeyboardHookSubscriberEnabled(KeyboardHookClient::Heatmap, true);
+    TEST_CHECK(!source->capture);
+    SetKeyboardHookSubscriberEnabled(KeyboardHookClient::HighlightKeysDialog, true);
+    TEST_CHECK(source->capture);
+
+    TEST_CHECK(source->Send('B', true));
+    TEST_CHECK(inlineEventCount == 0);
+    TEST_CHECK(!source->Send('B', false));
+    TEST_CHECK(inlineEventCount == 1 && !inlineEvents[0].keyDown);
+    std::vector<KeyboardHookEvent> events = WaitForWorkerEvents(1);
+    TEST_CHECK(events.size() == 1);
+    if (!events.empty()) {
+        TEST_CHECK(events[0].vkCode == 'B' && events[0].clients == GetClientBit(KeyboardHookClient::HighlightKeysDialog));
+    }
+
+    SetKeyboardHookSubscriberEnabled(KeyboardHookClient::HighlightKeysDialog, false);
+    TEST_CHECK(!source->capture);
+    TEST_CHECK(!source->Send('B', true));
+    TEST_CHECK(inlineEventCount == 2);
+    SetKeyboardHookSubscriberEnabled(KeyboardHookClient::Heatmap, false);
+    SubscribeKeyboardHook(KeyboardHookClient::HighlightKeysDialog, KeyboardHookSubscriber());
+}
+
+#ifdef __linux__
+static input_event MakeEvdevEvent(uint16_t type, uint16_t code, int32_t value) {
+    input_event event{};
+    event.type = type;
+    event.code = code;
+    event.value = value;
+    return event;
+}
+
+// Linux key codes become the virtual keys and extended flags of the Windows hook; EV_LED sets the lock states
+static void TestEvdevSource() {
+    BeginTest("EvdevSource");
+    int pipeDescriptors[2];
+    if (!TEST_CHECK(pipe(pipeDescriptors) == 0)) {
+        return;
+    }
+    std::vector<int> keyboards(1, pipeDescriptors[0]);
+    SetInputEventSource(CreateEvdevInputSource(keyboards));
+    ResetRecordedEvents();
+
+    KeyboardHookSubscriber counter;
+    counter.inlineHandler = RecordInlineEvent;
+    SubscribeKeyboardHook(KeyboardHookClient::Heatmap, counter);
+    SetKeyboardHookSubscriberEnabled(KeyboardHookClient::Heatmap, true);
+    TEST_CHECK(IsKeyboardHookInstalled());
+
+    const input_event events[] = {
+        MakeEvdevEvent(EV_KEY, KEY_A, 1), MakeEvdevEvent(EV_SYN, SYN_REPORT, 0),
+        MakeEvdevEvent(EV_KEY, KEY_A, 2),                   // Auto-repeat
+        MakeEvdevEvent(EV_KEY, KEY_A, 0),
+        MakeEvdevEvent(EV_KEY, KEY_RIGHTCTRL, 1),
+        MakeEvdevEvent(EV_KEY, KEY_KPENTER, 1),
+        MakeEvdevEvent(EV_KEY, KEY_MUTE, 1),                // Not a keyboard key of the hook
+        MakeEvdevEvent(EV_LED, LED_CAPSL, 1),
+        MakeEvdevEvent(EV_KEY, KEY_Z, 1)
+    };
+    TEST_CHECK(write(pipeDescriptors[1], events, sizeof(events)) == static_cast<ssize_t>(sizeof(events)));
+
+    TEST_CHECK(WaitForInlineEvents(6));
+    TEST_CHECK(inlineEventCount == 6);
+    if (inlineEventCount == 6) {
+        TEST_CHECK(inlineEvents[0].vkCode == 'A' && inlineEvents[0].keyDown && inlineEvents[0].flags == 0);
+        TEST_CHECK(inlineEvents[1].vkCode == 'A' && inlineEvents[1].keyDown);
+        TEST_CHECK(inlineEvents[2].vkCode == 'A' && !inlineEvents[2].keyDown);
+        TEST_CHECK(inlineEvents[3].vkCode == VK_RCONTROL && inlineEvents[3].flags == INPUT_KEY_FLAG_EXTENDED);
+        TEST_CHECK(inlineEvents[4].vkCode == VK_RETURN && inlineEvents[4].flags == INPUT_KEY_FLAG_EXTENDED);
+        TEST_CHECK(inlineEvents[5].vkCode == 'Z');
+    }
+    TEST_CHECK(GetInputEventSource().ReadLockKeyStates() == LOCK_KEY_STATE_CAPS);
+
+    SetKeyboardHookSubscriberEnabled(KeyboardHookClient::Heatmap, false);
+    TEST_CHECK(!IsKeyboardHookInstalled() && !GetInputEventSource().IsRunning());
+    close(pipeDescriptors[1]);
+}
+#endif
+
+void RunInputTests() {
+    StartKeyboardHookWorker();
+    TestMultiplexerDispatch();
+    TestMultiplexerKeyCapture();
+#ifdef __linux__
+    TestEvdevSource();
+#endif
+    StopKeyboardHookWorker();
+    SetInputEventSource(CreateReplayInputSource(std::vector<RecordedKeyEvent>(), 0, 1));
+}
@@ -0,0 +1,279 @@
+// SmartLogiLED_ProfileStoreTests.cpp : Contains the tests of the profile store and its edit journal.
+//
+// Each test edits a store the way the app does (puts, removes, syncs and commits), then damages
+// or swaps the files on disk the way a crash or a restored file would, and opens the store again.
+
+#include "SmartLogiLED_Tests.h"
+#include "../../SmartLogiLED_ProfileStore.h"
+#include "../../SmartLogiLED_Constants.h"
+#include <cstring>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/resource.h>
+#endif
+
+// Journal file layout (see SmartLogiLED_ProfileStore.cpp)
+static const size_t JOURNAL_FILE_HEADER_SIZE = 16;
+static const size_t JOURNAL_RECORD_SIZE_OFFSET = 12;
+static const size_t JOURNAL_RECORD_HEADER_SIZE = 32;
+
+static StoredProfile MakeTestProfile(const wchar_t* appName, uint32_t appColor) {
+    StoredProfile profile;
+    profile.appName = appName;
+    profile.appColor = appColor;
+    profile.highlightKeys.push_back(0x11); // W
+    return profile;
+}
+
+static bool HasStoredProfile(const wchar_t* appName) {
+    StoredProfile profile;
+    return GetStoredProfile(appName, profile);
+}
+
+static uint32_t GetStoredAppColor(const wchar_t* appName) {
+    StoredProfile profile;
+    return GetStoredProfile(appName, profile) ? profile.appColor : 0;
+}
+
+// Offsets of the journal records (walks the record sizes, does not validate them)
+static std::vector<size_t> GetJournalRecordOffsets(const std::vector<uint8_t>& journal) {
+    std::vector<size_t> offsets;
+    size_t position = JOURNAL_FILE_HEADER_SIZE;
+    while (journal.size() - position >= JOURNAL_RECORD_HEADER_SIZE) {
+        uint32_t recordSize;
+        memcpy(&recordSize, &journal[position + JOURNAL_RECORD_SIZE_OFFSET], sizeof(recordSize));
+        if (recordSize < JOURNAL_RECORD_HEADER_SIZE || recordSize > journal.size() - position) {
+            break;
+        }
+        offsets.push_back(position);
+        position += recordSize;
+    }
+    return offsets;
+}
+
+// Committed store with profile A and one journal record that puts profile B
+static void CreateStoreWithJournal(const std::wstring& storePath) {
+    ResetProfileStore(storePath);
+    PutStoredProfile(MakeTestProfile(L"a.exe", 1));
+    TEST_CHECK(CommitProfileStore());
+    PutStoredProfile(MakeTestProfile(L"b.exe", 2));
+    TEST_CHECK(SyncProfileStore());
+}
+
+// ======================================================================
+// TORN AND CORRUPT JOURNALS
+// ======================================================================
+
+static void TestJournalReplay() {
+    BeginTest("JournalReplay");
+    std::wstring directory = CreateTestDirectory("JournalReplay");
+    std::wstring storePath = directory + PROFILE_STORE_FILE_NAME;
+
+    CreateStoreWithJournal(storePath);
+    RemoveStoredProfile(L"a.exe");
+    TEST_CHECK(SyncProfileStore());
+
+    TEST_CHECK(OpenProfileStore(storePath));
+    TEST_CHECK(!HasStoredProfile(L"a.exe"));
+    TEST_CHECK(GetStoredAppColor(L"b.exe") == 2);
+    RemoveTestDirectory(directory);
+}
+
+static void TestJournalTornTail() {
+    BeginTest("JournalTornTail");
+    std::wstring directory = CreateTestDirectory("JournalTornTail");
+    std::wstring storePath = directory + PROFILE_STORE_FILE_NAME;
+    std::wstring journalPath = storePath + PROFILE_JOURNAL_FILE_SUFFIX;
+
+    // The app stopped in the middle of appending a copy of the last record
+    CreateStoreWithJournal(storePath);
+    std::vector<uint8_t> journal = ReadTestFile(journalPath);
+    std::vector<size_t> records = GetJournalRecordOffsets(journal);
+    TEST_CHECK(records.size() == 1);
+    size_t validSize = journal.size();
+    if (!records.empty()) {
+        journal.insert(journal.end(), journal.begin() + records[0], journal.begin() + records[0] + JOURNAL_RECORD_HEADER_SIZE + 8);
+    }
+    TEST_CHECK(WriteTestFile(journalPath, journal));
+
+    TEST_CHECK(OpenProfileStore(storePath));
+    TEST_CHECK(HasStoredProfile(L"a.exe"));
+    TEST_CHECK(GetStoredAppColor(L"b.exe") == 2);
+    TEST_CHECK(ReadTestFile(journalPath).size() == validSize);
+
+    // New records follow the valid ones
+    PutStoredProfile(MakeTestProfile(L"c.exe", 3));
+    TEST_CHECK(SyncProfileStore());
+    TEST_CHECK(OpenProfileStore(storePath));
+    TEST_CHECK(GetStoredAppColor(L"b.exe") == 2);
+    TEST_CHECK(GetStoredAppColor(L"c.exe") == 3);
+    RemoveTestDirectory(directory);
+}
+
+static void TestJournalCorruptRecord() {
+    BeginTest("JournalCorruptRecord");
+    std::wstring directory = CreateTestDirectory("JournalCorruptRecord");
+    std::wstring storePath = directory + PROFILE_STORE_FILE_NAME;
+    std::wstring journalPath = storePath + PROFILE_JOURNAL_FILE_SUFFIX;
+
+    // A damaged record hides the records after it (their sequence no longer follows)
+    CreateStoreWithJournal(storePath);
+    PutStoredProfile(MakeTestProfile(L"c.exe", 3));
+    TEST_CHECK(SyncProfileStore());
+    std::vector<uint8_t> journal = ReadTestFile(journalPath);
+    std::vector<size_t> records = GetJournalRecordOffsets(journal);
+    TEST_CHECK(records.size() == 2);
+    if (!records.empty()) {
+        journal[records[0] + JOURNAL_RECORD_HEADER_SIZE + 8] ^= 0xFF; // Record values
+    }
+    TEST_CHECK(WriteTestFile(journalPath, journal));
+
+    TEST_CHECK(OpenProfileStore(storePath));
+    TEST_CHECK(HasStoredProfile(L"a.exe"));
+    TEST_CHECK(!HasStoredProfile(L"b.exe"));
+    TEST_CHECK(!HasStoredProfile(L"c.exe"));
+    RemoveTestDirectory(directory);
+}
+
+// ======================================================================
+// JOURNAL STAMP
+// ======================================================================
+
+static void TestStaleJournalRefused() {
+    BeginTest("StaleJournalRefused");
+    std::wstring directory = CreateTestDirectory("StaleJournalRefused");
+    std::wstring storePath = directory + PROFILE_STORE_FILE_NAME;
+    std::wstring journalPath = storePath + PROFILE_JOURNAL_FILE_SUFFIX;
+
+    // An older store file is restored next to the journal of a newer one
+    ResetProfileStore(storePath);
+    PutStoredProfile(MakeTestProfile(L"a.exe", 1));
+    TEST_CHECK(CommitProfileStore());
+    std::vector<uint8_t> olderStore = ReadTestFile(storePath);
+    PutStoredProfile(MakeTestProfile(L"b.exe", 2));
+    TEST_CHECK(CommitProfileStore());
+    RemoveStoredProfile(L"a.exe");
+    TEST_CHECK(SyncProfileStore());
+    TEST_CHECK(GetJournalRecordOffsets(ReadTestFile(journalPath)).size() == 1);
+    TEST_CHECK(WriteTestFile(storePath, olderStore));
+
+    // The removal was made against the newer file - it must not be replayed
+    TEST_CHECK(OpenProfileStore(storePath));
+    TEST_CHECK(HasStoredProfile(L"a.exe"));
+    TEST_CHECK(!HasStoredProfile(L"b.exe"));
+
+    // The next sync replaces the refused journal with one for this store file
+    PutStoredProfile(MakeTestProfile(L"c.exe", 3));
+    TEST_CHECK(SyncProfileStore());
+    PutStoredProfile(MakeTestProfile(L"d.exe", 4));
+    TEST_CHECK(SyncProfileStore());
+    TEST_CHECK(OpenProfileStore(storePath));
+    TEST_CHECK(HasStoredProfile(L"a.exe"));
+    TEST_CHECK(GetStoredAppColor(L"c.exe") == 3);
+    TEST_CHECK(GetStoredAppColor(L"d.exe") == 4);
+    RemoveTestDirectory(directory);
+}
+
+static void TestUnstampedJournalRefused() {
+    BeginTest("UnstampedJournalRefused");
+    std::wstring directory = CreateTestDirectory("UnstampedJournalRefused");
+    std::wstring storePath = directory + PROFILE_STORE_FILE_NAME;
+    std::wstring journalPath = storePath + PROFILE_JOURNAL_FILE_SUFFIX;
+
+    // Records without the file header cannot be tied to this store file
+    CreateStoreWithJournal(storePath);
+    std::vector<uint8_t> journal = ReadTestFile(journalPath);
+    journal.erase(journal.begin(), journal.begin() + JOURNAL_FILE_HEADER_SIZE);
+    TEST_CHECK(WriteTestFile(journalPath, journal));
+
+    TEST_CHECK(OpenProfileStore(storePath));
+    TEST_CHECK(HasStoredProfile(L"a.exe"));
+    TEST_CHECK(!HasStoredProfile(L"b.exe"));
+    RemoveTestDirectory(directory);
+}
+
+static void TestJournalKeptAfterBackupFailure() {
+    BeginTest("JournalKeptAfterBackupFailure");
+    std::wstring directory = CreateTestDirectory("JournalKeptAfterBackupFailure");
+    std::wstring storePath = directory + PROFILE_STORE_FILE_NAME;
+    std::wstring journalPath = storePath + PROFILE_JOURNAL_FILE_SUFFIX;
+
+    // A folder in place of the backup's temp file makes every backup write fail
+    CreateStoreWithJournal(storePath);
+    TEST_CHECK(CreateTestSubdirectory(storePath + PROFILE_STORE_BACKUP_SUFFIX + L".tmp"));
+    PutStoredProfile(MakeTestProfile(L"c.exe", 3));
+    TEST_CHECK(CommitProfileStore());
+    TEST_CHECK(GetJournalRecordOffsets(ReadTestFile(journalPath)).size() == 2);
+
+    // The store file names the journal it folded in, so the kept journal is still replayed
+    PutStoredProfile(MakeTestProfile(L"d.exe", 4));
+    TEST_CHECK(SyncProfileStore());
+    TEST_CHECK(OpenProfileStore(storePath));
+    TEST_CHECK(HasStoredProfile(L"a.exe"));
+    TEST_CHECK(GetStoredAppColor(L"c.exe") == 3);
+    TEST_CHECK(GetStoredAppColor(L"d.exe") == 4);
+
+    // Backup plus journal still rebuild every edit
+    TEST_CHECK(RecoverProfileStore(storePath));
+    TEST_CHECK(GetStoredAppColor(L"b.exe") == 2);
+    TEST_CHECK(GetStoredAppColor(L"c.exe") == 3);
+    TEST_CHECK(GetStoredAppColor(L"d.exe") == 4);
+    RemoveTestDirectory(directory);
+}
+
+#ifndef _WIN32
+// Limit the size of files this process writes, so appends past it fail (RLIM_INFINITY = no limit)
+static void SetFileSizeLimit(rlim_t limit) {
+    struct rlimit fileSizeLimit;
+    getrlimit(RLIMIT_FSIZE, &fileSizeLimit);
+    fileSizeLimit.rlim_cur = limit == RLIM_INFINITY ? fileSizeLimit.rlim_max : limit;
+    setrlimit(RLIMIT_FSIZE, &fileSizeLimit);
+}
+
+static void TestAppendAndBackupFailure() {
+    BeginTest("AppendAndBackupFailure");
+    std::wstring directory = CreateTestDirectory("AppendAndBackupFailure");
+    std::wstring storePath = directory + PROFILE_STORE_FILE_NAME;
+    std::wstring journalPath = storePath + PROFILE_JOURNAL_FILE_SUFFIX;
+    signal(SIGXFSZ, SIG_IGN); // Writes past the limit fail instead of ending the process
+
+    // Profile C is queued for the journal, but appending it fails
+    CreateStoreWithJournal(storePath);
+    PutStoredProfile(MakeTestProfile(L"c.exe", 3));
+    SetFileSizeLimit(static_cast<rlim_t>(ReadTestFile(journalPath).size()));
+    TEST_CHECK(!SyncProfileStore());
+    SetFileSizeLimit(RLIM_INFINITY);
+
+    // Then the commit that folds C into the store file cannot write the backup, so the journal
+    // is kept - without the record of C, which the store file now holds
+    TEST_CHECK(CreateTestSubdirectory(storePath + PROFILE_STORE_BACKUP_SUFFIX + L".tmp"));
+    TEST_CHECK(SyncProfileStore());
+    TEST_CHECK(OpenProfileStore(storePath));
+    TEST_CHECK(GetStoredAppColor(L"b.exe") == 2);
+    TEST_CHECK(GetStoredAppColor(L"c.exe") == 3);
+
+    // Records appended to that journal would be taken as folded in; edits must still survive
+    PutStoredProfile(MakeTestProfile(L"d.exe", 4));
+    TEST_CHECK(SyncProfileStore());
+    PutStoredProfile(MakeTestProfile(L"e.exe", 5));
+    TEST_CHECK(SyncProfileStore());
+    TEST_CHECK(OpenProfileStore(storePath));
+    TEST_CHECK(GetStoredAppColor(L"c.exe") == 3);
+    TEST_CHECK(GetStoredAppColor(L"d.exe") == 4);
+    TEST_CHECK(GetStoredAppColor(L"e.exe") == 5);
+    RemoveTestDirectory(directory);
+}
+#endif
+
+void RunProfileStoreTests() {
+    TestJournalReplay();
+    TestJournalTornTail();
+    TestJournalCorruptRecord();
+    TestStaleJournalRefused();
+    TestUnstampedJournalRefused();
+    TestJournalKeptAfterBackupFailure();
+#ifndef _WIN32
+    TestAppendAndBackupFailure(); // No portable way to make an append fail on Windows
+#endif
+}
@@ -0,0 +1,71 @@
+// SmartLogiLED_Tests.cpp : Contains the test runner of the portable modules.
+//
+// Usage: SmartLogiLED_Tests
+//
+// Runs every test group and prints each failed check; the exit code is 1 if any check failed.
+
+#include "SmartLogiLED_Tests.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+// Module-specific variables
+static const char* currentTestName = "";
+static size_t testCount = 0;
+static size_t failedCheckCount = 0;
+
+void BeginTest(const char* name) {
+    currentTestName = name;
+    ++testCount;
+}
+
+bool CheckTestCondition(bool passed, const char* expression, const char* file, int line) {
+    if (!passed) {
+        fprintf(stderr, "%s(%d): %s: check failed: %s\n", file, line, currentTestName, expression);
+        ++failedCheckCount;
+    }
+    return passed;
+}
+
+// ======================================================================
+// TEST FILES
+// ======================================================================
+
+std::wstring CreateTestDirectory(const char* name) {
+    std::error_code error;
+    std::filesystem::path directory = std::filesystem::temp_directory_path(error) / "SmartLogiLED_Tests" / name;
+    std::filesystem::remove_all(directory, error);
+    std::filesystem::create_directories(directory, error);
+    return (directory / "").wstring();
+}
+
+void RemoveTestDirectory(const std::wstring& directory) {
+    std::error_code error;
+    std::filesystem::remove_all(std::filesystem::path(directory), error);
+}
+
+std::vector<uint8_t> ReadTestFile(const std::wstring& filePath) {
+    std::ifstream file(std::filesystem::path(filePath), std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+bool WriteTestFile(const std::wstring& filePath, const std::vector<uint8_t>& data) {
+    std::ofstream file(std::filesystem::path(filePath), std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(file);
+}
+
+bool CreateTestSubdirectory(const std::wstring& directoryPath) {
+    std::error_code error;
+    return std::filesystem::create_directory(std::filesystem::path(directoryPath), error);
+}
+
+int main() {
+    RunProfileStoreTests();
+    RunInputTests();
+
+    printf("%zu tests, %zu failed checks\n", testCount, failedCheckCount);
+    return failedCheckCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,27 @@
+// SmartLogiLED_Tests.h : Header file for the tests of the portable modules.
+//
+// The tests link the application's own portable code (no Win32 types, no LED SDK), so they
+// build and run on Windows and Linux. Each test works in its own temporary folder.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Record a failed check with its source line; the test keeps running
+#define TEST_CHECK(condition) CheckTestCondition((condition), #condition, __FILE__, __LINE__)
+
+void BeginTest(const char* name);
+bool CheckTestCondition(bool passed, const char* expression, const char* file, int line);
+
+// Test files (the tests bypass the modules under test to damage or inspect them)
+std::wstring CreateTestDirectory(const char* name);   // Empty temporary folder, with a trailing separator
+void RemoveTestDirectory(const std::wstring& directory);
+std::vector<uint8_t> ReadTestFile(const std::wstring& filePath);
+bool WriteTestFile(const std::wstring& filePath, const std::vector<uint8_t>& data);
+bool CreateTestSubdirectory(const std::wstring& directoryPath);
+
+// Test groups
+void RunProfileStoreTests();
+void RunInputTests();